@@ -36,6 +36,9 @@ extern "C" {
 struct dyad_metadata {
     char *fpath;
     uint32_t owner_rank;
+    // Contents of a small file published in its KVS entry (NULL: not inlined)
+    char *inline_data;
+    size_t inline_len;
 };
 typedef struct dyad_metadata dyad_metadata_t;
 
@@ -49,6 +52,17 @@ typedef struct dyad_metadata dyad_metadata_t;
  */
 DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_produce (dyad_ctx_t *ctx, const char *fname);
 
+/**
+ * @brief Commit the keys of produced files that are batched up in the
+ *        context (see DYAD_PUBLISH_BATCH) to the Flux KVS. Batched keys
+ *        are also flushed once they have waited for DYAD_PUBLISH_MAX_DELAY
+ *        seconds, and by dyad_finalize.
+ * @param[in] ctx    the DYAD context for the operation
+ *
+ * @return An error code from dyad_rc.h
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_flush_publish (dyad_ctx_t *ctx);
+
 /**
  * @brief Obtain DYAD metadata for a file in the consumer-managed directory
  * @param[in]  ctx         the DYAD context for the operation
@@ -65,8 +79,63 @@ DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_get_metadata (dyad_ctx_t *ctx
                                                                  bool should_wait,
                                                                  dyad_metadata_t **mdata);
 
+/**
+ * @brief Obtain DYAD metadata for many files in the consumer-managed
+ *        directory at once. The KVS lookups of all the files are in flight
+ *        concurrently, so that the batch costs about one KVS round trip.
+ * @param[in]  ctx         the DYAD context for the operation
+ * @param[in]  fnames      the names of the files for which metadata is obtained
+ * @param[in]  n           the number of files in fnames
+ * @param[in]  should_wait if true, wait for the files to be produced before
+ * returning
+ * @param[out] mdata       an array of n metadata pointers. The metadata for
+ * fnames[i] is stored in mdata[i], or NULL if it could not be obtained. Each
+ * non-NULL entry must be freed with dyad_free_metadata
+ *
+ * @return DYAD_RC_OK if metadata was obtained for every file, otherwise the
+ * error code of a failed file
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_get_metadata_batch (dyad_ctx_t *ctx,
+                                                                       const char *const *fnames,
+                                                                       size_t n,
+                                                                       bool should_wait,
+                                                                       dyad_metadata_t **mdata);
+
 DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_free_metadata (dyad_metadata_t **mdata);
 
+/**
+ * @brief Fetch part of a file from its producer into memory, without
+ *        storing it in the consumer-managed directory. Only the requested
+ *        range is read by the producer and sent over the DTL. Ranges larger
+ *        than a single transfer of the DTL are fetched in pieces.
+ * @param[in]  ctx        the DYAD context for the operation
+ * @param[in]  mdata      the metadata of the file, from dyad_get_metadata
+ * @param[in]  offset     the offset of the range in the file
+ * @param[in]  length     the length of the range (0: up to the end of the file)
+ * @param[out] file_data  a DTL buffer holding the data of the range, to be
+ * released with dyad_release_data
+ * @param[out] file_len   the number of bytes in file_data, which is less than
+ * length if the range extends past the end of the file
+ *
+ * @return An error code from dyad_rc.h
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_get_data_range (const dyad_ctx_t *ctx,
+                                                                   const dyad_metadata_t *mdata,
+                                                                   off_t offset,
+                                                                   size_t length,
+                                                                   char **file_data,
+                                                                   size_t *file_len);
+
+/**
+ * @brief Give back a buffer obtained from dyad_get_data_range
+ * @param[in]     ctx        the DYAD context for the operation
+ * @param[in,out] file_data  the buffer, set to NULL on return
+ *
+ * @return An error code from dyad_rc.h
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_release_data (const dyad_ctx_t *ctx,
+                                                                 char **file_data);
+
 /**
  * @brief Wrapper function that performs all the common tasks needed
  *        of a consumer
@@ -90,6 +159,56 @@ DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_consume (dyad_ctx_t *ctx, con
 DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t
 dyad_consume_w_metadata (dyad_ctx_t *ctx, const char *fname, const dyad_metadata_t *mdata);
 
+/**
+ * @brief Consume many files at once. The files owned by the same producer
+ *        are fetched with a single RPC, over which the producer streams
+ *        them back one after the other. Each file is stored as soon as it
+ *        arrives. Files too large to be sent that way, as well as local and
+ *        inlined files, are consumed one by one as with dyad_consume.
+ * @param[in] ctx     the DYAD context for the operation
+ * @param[in] fnames  the names of the files being "consumed"
+ * @param[in] n       the number of files in fnames
+ *
+ * @return DYAD_RC_OK if every file was consumed, otherwise the error code
+ * of a failed file
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_consume_many (dyad_ctx_t *ctx,
+                                                                 const char *const *fnames,
+                                                                 size_t n);
+
+/**
+ * @brief Queue a file to be consumed in the background, so that a later
+ *        dyad_consume (e.g., on open) finds it already fetched. The first
+ *        call starts a prefetch thread with a DYAD context of its own.
+ *        dyad_consume waits for a file the thread is fetching, and takes
+ *        a file that is still queued off the queue.
+ * @param[in] ctx    the DYAD context for the operation
+ * @param[in] fname  the name of the file to prefetch
+ *
+ * @return An error code from dyad_rc.h
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_prefetch (dyad_ctx_t *ctx, const char *fname);
+
+/**
+ * @brief Queue many files for prefetching, in order (see dyad_prefetch)
+ * @param[in] ctx     the DYAD context for the operation
+ * @param[in] fnames  the names of the files to prefetch
+ * @param[in] n       the number of files in fnames
+ *
+ * @return An error code from dyad_rc.h
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_prefetch_list (dyad_ctx_t *ctx,
+                                                                  const char *const *fnames,
+                                                                  size_t n);
+
+/**
+ * @brief Wait until all the queued files have been prefetched
+ * @param[in] ctx    the DYAD context for the operation
+ *
+ * @return An error code from dyad_rc.h
+ */
+DYAD_PFA_ANNOTATE DYAD_DLL_EXPORTED dyad_rc_t dyad_prefetch_wait (dyad_ctx_t *ctx);
+
 #ifdef __cplusplus
 }
 #endif
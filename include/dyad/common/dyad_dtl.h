@@ -15,13 +15,14 @@ enum dyad_dtl_mode {
     DYAD_DTL_UCX = 0,
     DYAD_DTL_MARGO = 1,
     DYAD_DTL_FLUX_RPC = 2,
+    DYAD_DTL_SHM = 3,
     DYAD_DTL_DEFAULT = 2,
-    DYAD_DTL_END = 3
+    DYAD_DTL_END = 4
 };
 typedef enum dyad_dtl_mode dyad_dtl_mode_t;
 
 static const char* dyad_dtl_mode_name[DYAD_DTL_END + 1]
-    __attribute__ ((unused)) = {"UCX", "MARGO", "FLUX_RPC", "DTL_UNKNOWN"};
+    __attribute__ ((unused)) = {"UCX", "MARGO", "FLUX_RPC", "SHM", "DTL_UNKNOWN"};
 
 enum dyad_dtl_comm_mode {
     DYAD_COMM_NONE = 0,  // Sanity check value for when
@@ -33,6 +34,16 @@ enum dyad_dtl_comm_mode {
 typedef enum dyad_dtl_comm_mode dyad_dtl_comm_mode_t;
 
 #define DYAD_DTL_RPC_NAME "dyad.fetch"
+// Transfers of up to this many bytes go back in the dyad.fetch stream
+// rather than through UCX or Margo when DYAD_DTL_RPC_MAX is "auto" and
+// the crossover could not be measured
+#define DYAD_DTL_RPC_MAX_DEFAULT (64ul << 10)
+// Node-level coordination of fetches among the consumers of a node,
+// served by the DYAD module of the node's broker
+#define DYAD_CLAIM_RPC_NAME "dyad.claim"
+#define DYAD_COMPLETE_RPC_NAME "dyad.complete"
+// Fetch of several files of the same producer over a single RPC stream
+#define DYAD_FETCH_MANY_RPC_NAME "dyad.fetch_many"
 
 struct dyad_dtl;
 
@@ -22,5 +22,35 @@
 #define DYAD_SYNC_DEBUG_ENV "DYAD_SYNC_DEBUG"
 #define DYAD_SERVICE_MUX_ENV "DYAD_SERVICE_MUX"
 #define DYAD_REINIT_ENV "DYAD_REINIT"
+#define DYAD_DTL_CHUNK_SIZE_ENV "DYAD_DTL_CHUNK_SIZE"
+#define DYAD_DTL_ZERO_COPY_ENV "DYAD_DTL_ZERO_COPY"
+#define DYAD_PUBLISH_BATCH_ENV "DYAD_PUBLISH_BATCH"
+#define DYAD_PUBLISH_MAX_DELAY_ENV "DYAD_PUBLISH_MAX_DELAY"
+#define DYAD_MDATA_CACHE_SIZE_ENV "DYAD_MDATA_CACHE_SIZE"
+#define DYAD_MDATA_CACHE_TTL_ENV "DYAD_MDATA_CACHE_TTL"
+#define DYAD_NODE_DEDUP_ENV "DYAD_NODE_DEDUP"
+#define DYAD_CONS_CACHE_BYTES_ENV "DYAD_CONS_CACHE_BYTES"
+#define DYAD_POSIX_IO_ENV "DYAD_POSIX_IO"
+#define DYAD_URING_DEPTH_ENV "DYAD_URING_DEPTH"
+#define DYAD_URING_DIRECT_MIN_ENV "DYAD_URING_DIRECT_MIN"
+#define DYAD_INLINE_MAX_ENV "DYAD_INLINE_MAX"
+#define DYAD_DTL_RPC_MAX_ENV "DYAD_DTL_RPC_MAX"
+#define DYAD_SEGMENT_MAX_ENV "DYAD_SEGMENT_MAX"
+#define DYAD_COMPRESS_LEVEL_ENV "DYAD_COMPRESS_LEVEL"
+#define DYAD_UCX_EP_CACHE_SIZE_ENV "DYAD_UCX_EP_CACHE_SIZE"
+#define DYAD_UCX_EP_CACHE_TTL_ENV "DYAD_UCX_EP_CACHE_TTL"
+#define DYAD_UCX_RMA_SLOTS_ENV "DYAD_UCX_RMA_SLOTS"
+#define DYAD_UCX_RMA_SLOT_SIZE_ENV "DYAD_UCX_RMA_SLOT_SIZE"
+#define DYAD_UCX_STAGING_BUFS_ENV "DYAD_UCX_STAGING_BUFS"
+#define DYAD_UCX_STAGING_SLOT_SIZE_ENV "DYAD_UCX_STAGING_SLOT_SIZE"
+#define DYAD_UCX_SPIN_COUNT_ENV "DYAD_UCX_SPIN_COUNT"
+#define DYAD_MARGO_BULK_REGIONS_ENV "DYAD_MARGO_BULK_REGIONS"
+#define DYAD_MARGO_REGION_MAX_ENV "DYAD_MARGO_REGION_MAX"
+#define DYAD_MARGO_PULL_SEGMENT_ENV "DYAD_MARGO_PULL_SEGMENT"
+#define DYAD_MARGO_PULL_DEPTH_ENV "DYAD_MARGO_PULL_DEPTH"
+#define DYAD_MARGO_XFER_XSTREAM_ENV "DYAD_MARGO_XFER_XSTREAM"
+#define DYAD_MARGO_PROTOCOL_ENV "DYAD_MARGO_PROTOCOL"
+#define DYAD_MARGO_PROGRESS_THREAD_ENV "DYAD_MARGO_PROGRESS_THREAD"
+#define DYAD_MARGO_RPC_THREADS_ENV "DYAD_MARGO_RPC_THREADS"
 
 #endif  // DYAD_COMMON_DYAD_ENVS_H
@@ -52,6 +52,10 @@ enum dyad_core_return_codes {
     DYAD_RC_BADUNPACK = -2006,     // JSON unpacking failed
     DYAD_RC_RPC_FINISHED = -2007,  // The Flux RPC responded with ENODATA (i.e.,
                                    // end of stream) sooner than expected
+    DYAD_RC_NOCONN = -2008,        // The producer does not know the consumer's
+                                   // DTL connection, so the request must be resent
+    DYAD_RC_TOOBIG = -2009,        // The data is too large to be sent in the
+                                   // RPC stream, so it must go through the DTL
 
     // UCX
     DYAD_RC_UCXINIT_FAIL = -3001,           // UCX initialization failed
@@ -66,6 +70,10 @@ enum dyad_core_return_codes {
     // MARGO
     DYAD_RC_MARGOINIT_FAIL = -4001,  // Margo initialization failed
 
+    // SHM
+    DYAD_RC_SHMINIT_FAIL = -5001,  // Shared-memory DTL initialization failed
+    DYAD_RC_SHMCOMM_FAIL = -5002,  // Passing a shared buffer over the socket failed
+
 };
 
 typedef enum dyad_core_return_codes dyad_rc_t;
@@ -52,6 +52,30 @@ class DyadCtxWrapper(ctypes.Structure):
         ("prod_managed_path", ctypes.c_char_p),
         ("cons_managed_path", ctypes.c_char_p),
         ("relative_to_managed_path", ctypes.c_bool),
+        ("dtl_chunk_size", ctypes.c_size_t),
+        ("dtl_zero_copy", ctypes.c_bool),
+        ("publish_batch", ctypes.c_uint),
+        ("publish_max_delay", ctypes.c_double),
+        ("publish_txn", ctypes.c_void_p),
+        ("publish_pending", ctypes.c_uint),
+        ("publish_txn_start", ctypes.c_double),
+        ("publish_flusher", ctypes.c_void_p),
+        ("publish_flusher_fini", ctypes.c_void_p),
+        ("mdata_cache", ctypes.c_void_p),
+        ("prefetcher", ctypes.c_void_p),
+        ("prefetcher_fini", ctypes.c_void_p),
+        ("node_dedup", ctypes.c_bool),
+        ("cons_cache", ctypes.c_void_p),
+        ("posix_io", ctypes.c_bool),
+        ("uring_depth", ctypes.c_uint),
+        ("uring_direct_min", ctypes.c_size_t),
+        ("uring", ctypes.c_void_p),
+        ("inline_max", ctypes.c_size_t),
+        ("dtl_rpc_max", ctypes.c_size_t),
+        ("dtl_rpc_calibrate", ctypes.c_bool),
+        ("segment_max", ctypes.c_size_t),
+        ("segment_fd", ctypes.c_int),
+        ("compress_level", ctypes.c_int),
     ]
 
 
@@ -59,6 +83,8 @@ class DyadMetadataWrapper(ctypes.Structure):
     _fields_ = [
         ("fpath", ctypes.c_char_p),
         ("owner_rank", ctypes.c_uint32),
+        ("inline_data", ctypes.POINTER(ctypes.c_char)),
+        ("inline_len", ctypes.c_size_t),
     ]
 
 
@@ -88,6 +114,7 @@ class DTLMode(enum.Enum):
     DYAD_DTL_UCX = "UCX"
     DYAD_DTL_MARGO = "MARGO"
     DYAD_DTL_FLUX_RPC = "FLUX_RPC"
+    DYAD_DTL_SHM = "SHM"
 
     def __str__(self):
         return self.value
@@ -186,6 +213,16 @@ class Dyad:
         ]
         self.dyad_get_metadata.restype = ctypes.c_int
 
+        self.dyad_get_metadata_batch = self.dyad_client_lib.dyad_get_metadata_batch
+        self.dyad_get_metadata_batch.argtypes = [
+            ctypes.POINTER(DyadCtxWrapper),
+            ctypes.POINTER(ctypes.c_char_p),
+            ctypes.c_size_t,
+            ctypes.c_bool,
+            ctypes.POINTER(ctypes.POINTER(DyadMetadataWrapper)),
+        ]
+        self.dyad_get_metadata_batch.restype = ctypes.c_int
+
         self.dyad_free_metadata = self.dyad_client_lib.dyad_free_metadata
         self.dyad_free_metadata.argtypes = [
             ctypes.POINTER(ctypes.POINTER(DyadMetadataWrapper))
@@ -207,6 +244,41 @@ class Dyad:
         ]
         self.dyad_consume_w_metadata.restype = ctypes.c_int
 
+        self.dyad_consume_many = self.dyad_client_lib.dyad_consume_many
+        self.dyad_consume_many.argtypes = [
+            ctypes.POINTER(DyadCtxWrapper),
+            ctypes.POINTER(ctypes.c_char_p),
+            ctypes.c_size_t,
+        ]
+        self.dyad_consume_many.restype = ctypes.c_int
+
+        self.dyad_prefetch = self.dyad_client_lib.dyad_prefetch
+        self.dyad_prefetch.argtypes = [
+            ctypes.POINTER(DyadCtxWrapper),
+            ctypes.c_char_p,
+        ]
+        self.dyad_prefetch.restype = ctypes.c_int
+
+        self.dyad_prefetch_list = self.dyad_client_lib.dyad_prefetch_list
+        self.dyad_prefetch_list.argtypes = [
+            ctypes.POINTER(DyadCtxWrapper),
+            ctypes.POINTER(ctypes.c_char_p),
+            ctypes.c_size_t,
+        ]
+        self.dyad_prefetch_list.restype = ctypes.c_int
+
+        self.dyad_prefetch_wait = self.dyad_client_lib.dyad_prefetch_wait
+        self.dyad_prefetch_wait.argtypes = [
+            ctypes.POINTER(DyadCtxWrapper),
+        ]
+        self.dyad_prefetch_wait.restype = ctypes.c_int
+
+        self.dyad_flush_publish = self.dyad_client_lib.dyad_flush_publish
+        self.dyad_flush_publish.argtypes = [
+            ctypes.POINTER(DyadCtxWrapper),
+        ]
+        self.dyad_flush_publish.restype = ctypes.c_int
+
         self.dyad_finalize = self.dyad_ctx_lib.dyad_finalize
         self.dyad_finalize.argtypes = []
         self.dyad_finalize.restype = ctypes.c_int
@@ -334,6 +406,18 @@ class Dyad:
         if int(res) != 0:
             raise RuntimeError("Cannot produce data with DYAD!")
 
+    @dft_log.log
+    def flush_publish(self):
+        if self.dyad_flush_publish is None:
+            warnings.warn(
+                "Trying to flush DYAD publications when libdyad_client.so was not found",
+                RuntimeWarning,
+            )
+            return
+        res = self.dyad_flush_publish(self.ctx)
+        if int(res) != 0:
+            raise RuntimeError("Cannot flush batched DYAD publications!")
+
     @dft_log.log
     def get_metadata(self, fname, should_wait=False, raw=False):
         if self.dyad_get_metadata is None:
@@ -352,6 +436,30 @@ class Dyad:
             return DyadMetadata(mdata, self)
         return mdata
 
+    @dft_log.log
+    def get_metadata_batch(self, fnames, should_wait=False, raw=False):
+        if self.dyad_get_metadata_batch is None:
+            warnings.warn(
+                "Trying to get metadata for files with DYAD when libdyad_client.so was not found",
+                RuntimeWarning,
+            )
+            return None
+        n = len(fnames)
+        c_fnames = (ctypes.c_char_p * n)(*[f.encode() for f in fnames])
+        mdata = (ctypes.POINTER(DyadMetadataWrapper) * n)()
+        # Files whose metadata could not be obtained are reported as None,
+        # so the return code is not needed here
+        self.dyad_get_metadata_batch(self.ctx, c_fnames, n, should_wait, mdata)
+        result = []
+        for m in mdata:
+            if not m:
+                result.append(None)
+            elif raw:
+                result.append(m)
+            else:
+                result.append(DyadMetadata(m, self))
+        return result
+
     @dft_log.log
     def free_metadata(self, metadata_wrapper):
         if self.dyad_free_metadata is None:
@@ -391,6 +499,48 @@ class Dyad:
         if int(res) != 0:
             raise RuntimeError("Cannot consume data with metadata with DYAD!")
 
+    @dft_log.log
+    def consume_many(self, fnames):
+        if self.dyad_consume_many is None:
+            warnings.warn(
+                "Trying to consume with DYAD when libdyad_client.so was not found",
+                RuntimeWarning,
+            )
+            return
+        n = len(fnames)
+        c_fnames = (ctypes.c_char_p * n)(*[f.encode() for f in fnames])
+        res = self.dyad_consume_many(self.ctx, c_fnames, n)
+        if int(res) != 0:
+            raise RuntimeError("Cannot consume data with DYAD!")
+
+    @dft_log.log
+    def prefetch(self, fnames):
+        if self.dyad_prefetch_list is None:
+            warnings.warn(
+                "Trying to prefetch with DYAD when libdyad_client.so was not found",
+                RuntimeWarning,
+            )
+            return
+        if isinstance(fnames, str):
+            fnames = [fnames]
+        n = len(fnames)
+        c_fnames = (ctypes.c_char_p * n)(*[f.encode() for f in fnames])
+        res = self.dyad_prefetch_list(self.ctx, c_fnames, n)
+        if int(res) != 0:
+            raise RuntimeError("Cannot prefetch data with DYAD!")
+
+    @dft_log.log
+    def prefetch_wait(self):
+        if self.dyad_prefetch_wait is None:
+            warnings.warn(
+                "Trying to wait for DYAD prefetching when libdyad_client.so was not found",
+                RuntimeWarning,
+            )
+            return
+        res = self.dyad_prefetch_wait(self.ctx)
+        if int(res) != 0:
+            raise RuntimeError("Cannot wait for DYAD prefetching!")
+
     @dft_log.log
     def finalize(self):
         if not self.initialized:
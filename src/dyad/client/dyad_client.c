@@ -11,12 +11,22 @@
 #include <dyad/common/dyad_profiler.h>
 #include <dyad/client/dyad_client_int.h>
 #include <dyad/dtl/dyad_dtl_api.h>
+#include <dyad/utils/base64/base64.h>
+#include <dyad/utils/compress.h>
+#include <dyad/utils/cons_cache.h>
+#include <dyad/utils/mdata_cache.h>
 #include <dyad/utils/murmur3.h>
+#include <dyad/utils/read_all.h>
+#include <dyad/utils/segment_store.h>
+#include <dyad/utils/uring_io.h>
 #include <dyad/utils/utils.h>
 #include <fcntl.h>
 #include <flux/core.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 // clang-format on
 
@@ -128,7 +138,385 @@ kvs_commit_region_finish:;
     return rc;
 }
 
-DYAD_CORE_FUNC_MODS dyad_rc_t publish_via_flux (const dyad_ctx_t *restrict ctx,
+DYAD_CORE_FUNC_MODS double dyad_publish_now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/* Commits the batch of a producer once its oldest key has waited for
+ * publish_max_delay seconds, even if no more files are produced. It has a
+ * Flux handle of its own, since a handle cannot be shared between threads,
+ * and leaves the logging to the producer for the same reason. A batch it
+ * failed to commit goes back to the context, for the next dyad_produce or
+ * dyad_flush_publish to retry. */
+struct dyad_publish_flusher {
+    pthread_t thread;
+    pthread_mutex_t lock;      // Guards the batch in the context
+    pthread_cond_t cond;       // Signaled on a new batch and on shutdown
+    pthread_cond_t done_cond;  // Signaled whenever the flusher is done with a batch
+    bool committing;           // A batch taken from the context is being committed
+    bool failed;               // The batch in the context failed to commit here
+    bool shutdown;
+    dyad_ctx_t *ctx;
+};
+
+static void dyad_publish_lock (dyad_ctx_t *restrict ctx)
+{
+    struct dyad_publish_flusher *fl = (struct dyad_publish_flusher *)ctx->publish_flusher;
+    if (fl != NULL) {
+        pthread_mutex_lock (&fl->lock);
+        // Keys handed to the flusher reach the KVS before the ones after them
+        while (fl->committing)
+            pthread_cond_wait (&fl->done_cond, &fl->lock);
+    }
+}
+
+/* Whether the batch in the context is one the flusher failed to commit.
+ * Called with the batch locked. */
+static bool dyad_publish_flusher_failed (const dyad_ctx_t *restrict ctx)
+{
+    const struct dyad_publish_flusher *fl =
+        (const struct dyad_publish_flusher *)ctx->publish_flusher;
+    return fl != NULL && fl->failed;
+}
+
+static void dyad_publish_unlock (dyad_ctx_t *restrict ctx)
+{
+    struct dyad_publish_flusher *fl = (struct dyad_publish_flusher *)ctx->publish_flusher;
+    if (fl != NULL) {
+        pthread_mutex_unlock (&fl->lock);
+    }
+}
+
+static void *dyad_publish_flusher_run (void *arg)
+{
+    struct dyad_publish_flusher *fl = (struct dyad_publish_flusher *)arg;
+    dyad_ctx_t *ctx = fl->ctx;
+    flux_t *h = flux_open (NULL, 0);
+    flux_kvs_txn_t *txn = NULL;
+    flux_future_t *f = NULL;
+    unsigned int pending = 0u;
+    bool failed = false;
+    struct timespec deadline;
+    double due = 0.0;
+
+    if (h == NULL) {
+        DYAD_LOG_STDERR ("DYAD CLIENT: Cannot open a Flux handle to flush batches. "
+                         "They are flushed when files are produced.\n");
+        return NULL;
+    }
+    pthread_mutex_lock (&fl->lock);
+    while (!fl->shutdown) {
+        if (ctx->publish_txn == NULL || fl->failed) {
+            pthread_cond_wait (&fl->cond, &fl->lock);
+            continue;
+        }
+        due = ctx->publish_txn_start + ctx->publish_max_delay;
+        if (dyad_publish_now () < due) {
+            deadline.tv_sec = (time_t)due;
+            deadline.tv_nsec = (long)((due - (double)deadline.tv_sec) * 1000000000.0);
+            pthread_cond_timedwait (&fl->cond, &fl->lock, &deadline);
+            continue;
+        }
+        txn = (flux_kvs_txn_t *)ctx->publish_txn;
+        pending = ctx->publish_pending;
+        ctx->publish_txn = NULL;
+        ctx->publish_pending = 0u;
+        fl->committing = true;
+        pthread_mutex_unlock (&fl->lock);
+
+        failed = false;
+        if (pending > 0u) {
+            f = flux_kvs_commit (h, ctx->kvs_namespace, 0, txn);
+            failed = (f == NULL || flux_future_get (f, NULL) < 0);
+            flux_future_destroy (f);
+            f = NULL;
+        }
+
+        pthread_mutex_lock (&fl->lock);
+        fl->failed = failed;
+        if (failed) {
+            // Nothing touched the batch of the context while committing
+            ctx->publish_txn = txn;
+            ctx->publish_pending = pending;
+        } else {
+            flux_kvs_txn_destroy (txn);
+        }
+        fl->committing = false;
+        pthread_cond_broadcast (&fl->done_cond);
+    }
+    pthread_mutex_unlock (&fl->lock);
+    flux_close (h);
+    return NULL;
+}
+
+/* Stop the flusher, leaving the current batch in the context for
+ * dyad_finalize to commit. Called by dyad_finalize. */
+static void dyad_publish_flusher_fini (void *arg)
+{
+    struct dyad_publish_flusher *fl = (struct dyad_publish_flusher *)arg;
+    if (fl == NULL)
+        return;
+    pthread_mutex_lock (&fl->lock);
+    fl->shutdown = true;
+    pthread_cond_broadcast (&fl->cond);
+    pthread_mutex_unlock (&fl->lock);
+    pthread_join (fl->thread, NULL);
+    pthread_cond_destroy (&fl->done_cond);
+    pthread_cond_destroy (&fl->cond);
+    pthread_mutex_destroy (&fl->lock);
+    free (fl);
+}
+
+/* Start the flusher of a producer that bounds the delay of its batches.
+ * Without it, the delay is only checked whenever a file is produced. */
+DYAD_CORE_FUNC_MODS void dyad_publish_flusher_start (dyad_ctx_t *restrict ctx)
+{
+    pthread_condattr_t attr;
+    struct dyad_publish_flusher *fl =
+        (struct dyad_publish_flusher *)calloc (1, sizeof (struct dyad_publish_flusher));
+    if (fl == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate the publish flusher");
+        return;
+    }
+    fl->ctx = ctx;
+    pthread_mutex_init (&fl->lock, NULL);
+    // Deadlines are on the clock of dyad_publish_now
+    pthread_condattr_init (&attr);
+    pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+    pthread_cond_init (&fl->cond, &attr);
+    pthread_condattr_destroy (&attr);
+    pthread_cond_init (&fl->done_cond, NULL);
+    if (pthread_create (&fl->thread, NULL, dyad_publish_flusher_run, fl) != 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot start the publish flusher thread");
+        pthread_cond_destroy (&fl->done_cond);
+        pthread_cond_destroy (&fl->cond);
+        pthread_mutex_destroy (&fl->lock);
+        free (fl);
+        return;
+    }
+    ctx->publish_flusher = fl;
+    ctx->publish_flusher_fini = dyad_publish_flusher_fini;
+}
+
+DYAD_DLL_EXPORTED dyad_rc_t dyad_flush_publish (dyad_ctx_t *restrict ctx)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    if (ctx == NULL) {
+        goto flush_done;
+    }
+    dyad_publish_lock (ctx);
+    if (ctx->publish_txn == NULL) {
+        goto flush_unlock;
+    }
+    DYAD_C_FUNCTION_UPDATE_INT ("publish_pending", ctx->publish_pending);
+    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Committing a batch of %u keys", ctx->publish_pending);
+    if (ctx->publish_pending > 0u) {
+        rc = dyad_kvs_commit (ctx, (flux_kvs_txn_t *)ctx->publish_txn);
+        if (DYAD_IS_ERROR (rc)) {
+            DYAD_LOG_ERROR (ctx,
+                            "dyad_kvs_commit failed for a batch of %u keys!",
+                            ctx->publish_pending);
+        }
+    }
+    // A failed batch is dropped like a failed single-key commit would be
+    flux_kvs_txn_destroy ((flux_kvs_txn_t *)ctx->publish_txn);
+    ctx->publish_txn = NULL;
+    ctx->publish_pending = 0u;
+    if (dyad_publish_flusher_failed (ctx)) {
+        ((struct dyad_publish_flusher *)ctx->publish_flusher)->failed = false;
+    }
+flush_unlock:;
+    dyad_publish_unlock (ctx);
+flush_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Keys are batched when either a batch size or a maximum delay is set */
+DYAD_CORE_FUNC_MODS bool dyad_publish_is_batched (const dyad_ctx_t *restrict ctx)
+{
+    return ctx->publish_batch > 1u || ctx->publish_max_delay > 0.0;
+}
+
+/* Read the file at upath, relative to the producer-managed directory, and
+ * encode it for its KVS entry if it is at most ctx->inline_max bytes.
+ * Returns NULL if the file is not inlined. */
+DYAD_CORE_FUNC_MODS char *dyad_inline_encode (const dyad_ctx_t *restrict ctx,
+                                              const char *restrict upath)
+{
+    char path[PATH_MAX + 1] = {'\0'};
+    struct stat st;
+    char *data = NULL;
+    char *enc = NULL;
+    size_t enc_len = 0ul;
+    int fd = -1;
+
+    // Consumers of a shared storage never fetch the data
+    if (ctx->inline_max == 0ul || ctx->shared_storage) {
+        return NULL;
+    }
+    strncpy (path, ctx->prod_managed_path, PATH_MAX - 1);
+    concat_str (path, upath, "/", PATH_MAX);
+    fd = open (path, O_RDONLY);
+    if (fd == -1 || fstat (fd, &st) != 0 || !S_ISREG (st.st_mode)
+        || (size_t)st.st_size > ctx->inline_max) {
+        goto inline_encode_done;
+    }
+    data = (char *)malloc ((size_t)st.st_size + 1ul);
+    enc_len = base64_encoded_length ((size_t)st.st_size) + 1ul;
+    enc = (char *)malloc (enc_len);
+    if (data == NULL || enc == NULL
+        || pread_all (fd, data, (size_t)st.st_size, 0) != (ssize_t)st.st_size
+        || base64_encode (enc, enc_len, data, (size_t)st.st_size) < 0) {
+        free (enc);
+        enc = NULL;
+        goto inline_encode_done;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Inlining the %zu bytes of %s", (size_t)st.st_size, upath);
+
+inline_encode_done:;
+    free (data);
+    if (fd != -1) {
+        close (fd);
+    }
+    return enc;
+}
+
+/* Pack the KVS entry of upath into txn. The entry is the rank of the
+ * producer, or an object with the rank and the contents of the file if it
+ * is small enough to be inlined. */
+DYAD_CORE_FUNC_MODS int dyad_kvs_txn_put (const dyad_ctx_t *restrict ctx,
+                                          flux_kvs_txn_t *restrict txn,
+                                          const char *restrict topic,
+                                          const char *restrict upath)
+{
+    int ret = 0;
+    char *enc = dyad_inline_encode (ctx, upath);
+    if (enc == NULL) {
+        return flux_kvs_txn_pack (txn, 0, topic, "i", ctx->rank);
+    }
+    ret = flux_kvs_txn_pack (txn, 0, topic, "{s:i s:s}", "rank", ctx->rank, "data", enc);
+    free (enc);
+    return ret;
+}
+
+/* Append the file at upath, relative to the producer-managed directory, to
+ * the segment of this producer if it is at most ctx->segment_max bytes, so
+ * that the module serves it without opening the file. Larger files get a
+ * record that drops any earlier copy of the file. Files inlined in their
+ * KVS entry are never fetched, so they are not packed. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_segment_pack (dyad_ctx_t *restrict ctx,
+                                                 const char *restrict upath)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
+    dyad_rc_t rc = DYAD_RC_OK;
+    char path[PATH_MAX + 1] = {'\0'};
+    struct stat st;
+    char *data = NULL;
+    int fd = -1;
+
+    if (ctx->segment_max == 0ul || ctx->shared_storage) {
+        goto segment_pack_done;
+    }
+    strncpy (path, ctx->prod_managed_path, PATH_MAX - 1);
+    concat_str (path, upath, "/", PATH_MAX);
+    fd = open (path, O_RDONLY);
+    if (fd == -1 || fstat (fd, &st) != 0 || !S_ISREG (st.st_mode)) {
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Cannot pack %s into a segment", upath);
+        goto segment_pack_done;
+    }
+    if ((size_t)st.st_size <= ctx->inline_max) {
+        goto segment_pack_done;
+    }
+    if (ctx->segment_fd < 0) {
+        ctx->segment_fd = dyad_segment_create (ctx->prod_managed_path, ctx->rank);
+        if (ctx->segment_fd < 0) {
+            DYAD_LOG_ERROR (ctx, "Could not create a segment: %s", strerror (errno));
+            rc = DYAD_RC_BADFIO;
+            goto segment_pack_done;
+        }
+    }
+    if ((size_t)st.st_size <= ctx->segment_max) {
+        data = (char *)malloc ((size_t)st.st_size + 1ul);
+        if (data == NULL
+            || pread_all (fd, data, (size_t)st.st_size, 0) != (ssize_t)st.st_size) {
+            DYAD_LOG_ERROR (ctx, "Could not read %s to pack it into a segment", upath);
+            rc = DYAD_RC_BADFIO;
+            goto segment_pack_done;
+        }
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Packing the %zu bytes of %s", (size_t)st.st_size, upath);
+    }
+    if (dyad_segment_append (ctx->segment_fd, upath, data, (size_t)st.st_size) < 0) {
+        DYAD_LOG_ERROR (ctx, "Could not append %s to its segment: %s", upath, strerror (errno));
+        rc = DYAD_RC_BADFIO;
+        goto segment_pack_done;
+    }
+
+segment_pack_done:;
+    free (data);
+    if (fd != -1) {
+        close (fd);
+    }
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Add the key to the current batch, and commit the batch once it is full
+ * or its oldest key has waited for publish_max_delay seconds. A batch
+ * that stops growing is committed at its delay by the flusher thread. */
+DYAD_CORE_FUNC_MODS dyad_rc_t publish_batched (dyad_ctx_t *restrict ctx,
+                                               const char *restrict topic,
+                                               const char *restrict upath)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    double now = dyad_publish_now ();
+    bool full = false;
+    if (ctx->publish_max_delay > 0.0 && ctx->publish_flusher == NULL) {
+        dyad_publish_flusher_start (ctx);
+    }
+    dyad_publish_lock (ctx);
+    if (ctx->publish_txn == NULL) {
+        ctx->publish_txn = flux_kvs_txn_create ();
+        if (ctx->publish_txn == NULL) {
+            DYAD_LOG_ERROR (ctx, "Could not create Flux KVS transaction");
+            rc = DYAD_RC_FLUXFAIL;
+            goto publish_batched_unlock;
+        }
+        ctx->publish_pending = 0u;
+        ctx->publish_txn_start = now;
+        if (ctx->publish_flusher != NULL) {
+            // Let the flusher wait for the delay of the new batch
+            pthread_cond_signal (&((struct dyad_publish_flusher *)ctx->publish_flusher)->cond);
+        }
+    }
+    if (dyad_kvs_txn_put (ctx, (flux_kvs_txn_t *)ctx->publish_txn, topic, upath) < 0) {
+        DYAD_LOG_ERROR (ctx, "Could not pack Flux KVS transaction");
+        rc = DYAD_RC_FLUXFAIL;
+        goto publish_batched_unlock;
+    }
+    ctx->publish_pending++;
+    // Retry a batch the flusher failed to commit right away, so that a
+    // second failure reaches the producer
+    full = (ctx->publish_batch > 0u && ctx->publish_pending >= ctx->publish_batch)
+           || (ctx->publish_max_delay > 0.0
+               && now - ctx->publish_txn_start >= ctx->publish_max_delay)
+           || dyad_publish_flusher_failed (ctx);
+publish_batched_unlock:;
+    dyad_publish_unlock (ctx);
+    if (full) {
+        rc = dyad_flush_publish (ctx);
+    }
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+DYAD_CORE_FUNC_MODS dyad_rc_t publish_via_flux (dyad_ctx_t *restrict ctx,
                                                 const char *restrict upath)
 {
     DYAD_C_FUNCTION_START ();
@@ -144,10 +532,15 @@ DYAD_CORE_FUNC_MODS dyad_rc_t publish_via_flux (const dyad_ctx_t *restrict ctx,
     // the producer-managed directory
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Generating KVS key from path (%s)", upath);
     gen_path_key (upath, topic, topic_len, ctx->key_depth, ctx->key_bins);
+    if (dyad_publish_is_batched (ctx)) {
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Adding the key %s to the current batch", topic);
+        rc = publish_batched (ctx, topic, upath);
+        goto publish_done;
+    }
     // Crete and pack a Flux KVS transaction.
     // The transaction will contain a single key-value pair
     // with the previously generated key as the key and the
-    // producer's rank as the value
+    // producer's rank, and possibly the file itself, as the value
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Creating FLUX KVS transaction under the key %s", topic);
     txn = flux_kvs_txn_create ();
     if (txn == NULL) {
@@ -155,7 +548,7 @@ DYAD_CORE_FUNC_MODS dyad_rc_t publish_via_flux (const dyad_ctx_t *restrict ctx,
         rc = DYAD_RC_FLUXFAIL;
         goto publish_done;
     }
-    if (flux_kvs_txn_pack (txn, 0, topic, "i", ctx->rank) < 0) {
+    if (dyad_kvs_txn_put (ctx, txn, topic, upath) < 0) {
         DYAD_LOG_ERROR (ctx, "Could not pack Flux KVS transaction");
         rc = DYAD_RC_FLUXFAIL;
         goto publish_done;
@@ -212,6 +605,10 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_commit (dyad_ctx_t *restrict ctx, const char *r
     // Fence this call with reassignments of reenter so that, if intercepting
     // file I/O API calls, we will not get stuck in infinite recursion
     ctx->reenter = false;
+    // The file is packed before it is published, so that the module
+    // already has it once consumers learn about it. Consumers that miss
+    // it in the segments get the file itself, so a failure is not fatal.
+    dyad_segment_pack (ctx, upath);
     rc = publish_via_flux (ctx, upath);
     ctx->reenter = true;
 
@@ -233,9 +630,58 @@ static void print_mdata (const dyad_ctx_t *restrict ctx, const dyad_metadata_t *
         DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Printing contents of DYAD Metadata object");
         DYAD_LOG_DEBUG (ctx, "               fpath = %s", mdata->fpath);
         DYAD_LOG_DEBUG (ctx, "               owner_rank = %u", mdata->owner_rank);
+        if (mdata->inline_data != NULL) {
+            DYAD_LOG_DEBUG (ctx, "               inline_len = %zu", mdata->inline_len);
+        }
     }
 }
 
+/* Get the owner rank out of a KVS entry, along with the file data if the
+ * producer inlined it (see dyad_kvs_txn_put). *data is a heap buffer, or
+ * NULL if the entry holds the rank only. Returns -1 with errno set. */
+DYAD_CORE_FUNC_MODS int dyad_kvs_get_entry (flux_future_t *restrict f,
+                                            uint32_t *restrict owner_rank,
+                                            char **restrict data,
+                                            size_t *restrict data_len)
+{
+    const char *enc = NULL;
+    size_t enc_len = 0ul;
+    size_t buf_len = 0ul;
+    ssize_t n = 0l;
+
+    *data = NULL;
+    *data_len = 0ul;
+    if (flux_kvs_lookup_get_unpack (f, "i", owner_rank) == 0) {
+        return 0;
+    }
+    if (errno != EPROTO
+        || flux_kvs_lookup_get_unpack (f, "{s:i s:s%}", "rank", owner_rank, "data", &enc, &enc_len)
+               < 0) {
+        return -1;
+    }
+    // One more byte, so that an empty file still gets a buffer
+    buf_len = base64_decoded_length (enc_len) + 1ul;
+    *data = (char *)malloc (buf_len);
+    if (*data == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    n = base64_decode (*data, buf_len, enc, enc_len);
+    if (n < 0l) {
+        free (*data);
+        *data = NULL;
+        errno = EPROTO;
+        return -1;
+    }
+    *data_len = (size_t)n;
+    return 0;
+}
+
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fill_metadata (const dyad_ctx_t *restrict ctx,
+                                                  const char *restrict fpath,
+                                                  uint32_t owner_rank,
+                                                  dyad_metadata_t **restrict mdata);
+
 DYAD_DLL_EXPORTED dyad_rc_t dyad_kvs_read (const dyad_ctx_t *restrict ctx,
                                            const char *restrict topic,
                                            const char *restrict upath,
@@ -247,6 +693,8 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_kvs_read (const dyad_ctx_t *restrict ctx,
     dyad_rc_t rc = DYAD_RC_OK;
     int kvs_lookup_flags = 0;
     flux_future_t *f = NULL;
+    bool cached_found = false;
+    uint32_t cached_rank = 0u;
     if (mdata == NULL) {
         DYAD_LOG_ERROR (ctx,
                         "Metadata double pointer is NULL. "
@@ -254,6 +702,20 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_kvs_read (const dyad_ctx_t *restrict ctx,
         rc = DYAD_RC_NOTFOUND;
         goto kvs_read_end;
     }
+    // A file known to be missing is only reported as such when the caller
+    // does not want to wait for it
+    if (dyad_mdata_cache_lookup (ctx->mdata_cache, upath, &cached_found, &cached_rank) == 1
+        && (cached_found || !should_wait)) {
+        DYAD_C_FUNCTION_UPDATE_INT ("cache_hit", 1);
+        if (!cached_found) {
+            DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: %s is cached as not produced yet", upath);
+            rc = DYAD_RC_NOTFOUND;
+            goto kvs_read_end;
+        }
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Owner of %s found in the metadata cache", upath);
+        rc = dyad_fill_metadata (ctx, upath, cached_rank, mdata);
+        goto kvs_read_end;
+    }
     // Lookup information about the desired file (represented by kvs_topic)
     // from the Flux KVS. If there is no information, wait for it to be
     // made available
@@ -277,6 +739,8 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_kvs_read (const dyad_ctx_t *restrict ctx,
             goto kvs_read_end;
         }
     }
+    (*mdata)->inline_data = NULL;
+    (*mdata)->inline_len = 0ul;
     size_t upath_len = strlen (upath);
     (*mdata)->fpath = (char *)malloc (upath_len + 1);
     if ((*mdata)->fpath == NULL) {
@@ -286,13 +750,20 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_kvs_read (const dyad_ctx_t *restrict ctx,
     }
     memset ((*mdata)->fpath, '\0', upath_len + 1);
     memcpy ((*mdata)->fpath, upath, upath_len);
-    rc = flux_kvs_lookup_get_unpack (f, "i", &((*mdata)->owner_rank));
+    rc = dyad_kvs_get_entry (f,
+                             &((*mdata)->owner_rank),
+                             &((*mdata)->inline_data),
+                             &((*mdata)->inline_len));
     // If the extraction did not work, log an error and return DYAD_BADFETCH
     if (rc < 0) {
+        if (errno == ENOENT && !should_wait) {
+            dyad_mdata_cache_insert (ctx->mdata_cache, upath, false, 0u);
+        }
         DYAD_LOG_ERROR (ctx, "Could not unpack owner's rank from KVS response\n");
         rc = DYAD_RC_BADMETADATA;
         goto kvs_read_end;
     }
+    dyad_mdata_cache_insert (ctx->mdata_cache, upath, true, (*mdata)->owner_rank);
     DYAD_LOG_INFO (ctx, "DYAD CLIENT: Successfully retrieved metadata for key %s", topic);
     print_mdata (ctx, *mdata);
     DYAD_C_FUNCTION_UPDATE_STR ("fpath", (*mdata)->fpath);
@@ -311,6 +782,37 @@ kvs_read_end:;
     return rc;
 }
 
+/* Whether the broker of owner_rank runs on the node of this consumer,
+ * according to the hostnames Flux knows the brokers by. Only then can the
+ * SHM DTL pass descriptors between its module and this consumer. */
+DYAD_CORE_FUNC_MODS bool dyad_owner_on_node (const dyad_ctx_t *restrict ctx, uint32_t owner_rank)
+{
+    char host[HOST_NAME_MAX + 1] = {'\0'};
+    const char *owner_host = NULL;
+
+    if (owner_rank == ctx->rank) {
+        return true;
+    }
+    // The name may live in a buffer that the next lookup reuses
+    strncpy (host, flux_get_hostbyrank ((flux_t *)ctx->h, ctx->rank), HOST_NAME_MAX);
+    owner_host = flux_get_hostbyrank ((flux_t *)ctx->h, owner_rank);
+    // "(null)" stands for a rank whose host is unknown
+    return strcmp (host, "(null)") != 0 && strcmp (host, owner_host) == 0;
+}
+
+/* Whether the files of owner_rank are in the storage of this consumer
+ * already, so that there is nothing to transfer. Groups of service_mux
+ * brokers share their node-local storage. With the SHM DTL, each broker
+ * has a directory of its own instead, and consumers fetch the files of the
+ * other brokers of their node through shared memory. */
+DYAD_CORE_FUNC_MODS bool dyad_owner_is_local (const dyad_ctx_t *restrict ctx, uint32_t owner_rank)
+{
+    if (ctx->dtl_handle->mode == DYAD_DTL_SHM) {
+        return owner_rank == ctx->rank;
+    }
+    return (owner_rank / ctx->service_mux) == ctx->node_idx;
+}
+
 DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_metadata (const dyad_ctx_t *restrict ctx,
                                                    const char *restrict fname,
                                                    const char *restrict upath,
@@ -351,7 +853,7 @@ DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_metadata (const dyad_ctx_t *restrict ct
     // skipped
     DYAD_C_FUNCTION_UPDATE_INT ("owner_rank", (*mdata)->owner_rank);
     DYAD_C_FUNCTION_UPDATE_INT ("node_idx", ctx->node_idx);
-    if (((*mdata)->owner_rank / ctx->service_mux) == ctx->node_idx) {
+    if (dyad_owner_is_local (ctx, (*mdata)->owner_rank)) {
         DYAD_LOG_INFO (ctx,
                        "Either shared-storage is indicated or the producer rank (%u) is the"
                        " same as the consumer rank (%u)",
@@ -372,14 +874,22 @@ fetch_done:;
     return rc;
 }
 
-DYAD_DLL_EXPORTED dyad_rc_t dyad_get_data (const dyad_ctx_t *restrict ctx,
-                                           const dyad_metadata_t *restrict mdata,
-                                           char **restrict file_data,
-                                           size_t *restrict file_len)
+/* Pack and send the dyad.fetch RPC for the file described by mdata. A
+ * non-zero chunk_size asks the module to stream the file in responses of
+ * at most chunk_size bytes. A non-zero offset or length asks for the range
+ * [offset, offset + length) of the file only, where a length of 0 extends
+ * to the end of the file. A non-zero probe asks for that many bytes of
+ * zeros instead of the file, to time the DTL. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_send_fetch_rpc (const dyad_ctx_t *restrict ctx,
+                                                   const dyad_metadata_t *restrict mdata,
+                                                   size_t chunk_size,
+                                                   off_t offset,
+                                                   size_t length,
+                                                   size_t probe,
+                                                   flux_future_t **restrict f)
 {
     DYAD_C_FUNCTION_START ();
     dyad_rc_t rc = DYAD_RC_OK;
-    flux_future_t *f = NULL;
     json_t *rpc_payload = NULL;
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Packing payload for RPC to DYAD module");
     DYAD_C_FUNCTION_UPDATE_INT ("owner_rank", mdata->owner_rank);
@@ -389,26 +899,124 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_get_data (const dyad_ctx_t *restrict ctx,
         DYAD_LOG_ERROR (ctx,
                         "Cannot create JSON payload for Flux RPC to "
                         "DYAD module\n");
-        goto get_done;
+        goto send_rpc_done;
+    }
+    if (chunk_size > 0ul
+        && json_object_set_new (rpc_payload, "chunk_size", json_integer ((json_int_t)chunk_size))
+               < 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot add the chunk size to the RPC payload");
+        json_decref (rpc_payload);
+        rc = DYAD_RC_BADPACK;
+        goto send_rpc_done;
+    }
+    if ((offset > 0
+         && json_object_set_new (rpc_payload, "offset", json_integer ((json_int_t)offset)) < 0)
+        || (length > 0ul
+            && json_object_set_new (rpc_payload, "length", json_integer ((json_int_t)length))
+                   < 0)) {
+        DYAD_LOG_ERROR (ctx, "Cannot add the requested range to the RPC payload");
+        json_decref (rpc_payload);
+        rc = DYAD_RC_BADPACK;
+        goto send_rpc_done;
+    }
+    if (probe > 0ul
+        && json_object_set_new (rpc_payload, "probe", json_integer ((json_int_t)probe)) < 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot add the probe size to the RPC payload");
+        json_decref (rpc_payload);
+        rc = DYAD_RC_BADPACK;
+        goto send_rpc_done;
     }
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Sending payload for RPC to DYAD module");
-    f = flux_rpc_pack ((flux_t *)ctx->h,
-                       DYAD_DTL_RPC_NAME,
-                       mdata->owner_rank,
-                       FLUX_RPC_STREAMING,
-                       "o",
-                       rpc_payload);
-    if (f == NULL) {
+    *f = flux_rpc_pack ((flux_t *)ctx->h,
+                        DYAD_DTL_RPC_NAME,
+                        mdata->owner_rank,
+                        FLUX_RPC_STREAMING,
+                        "o",
+                        rpc_payload);
+    if (*f == NULL) {
         DYAD_LOG_ERROR (ctx, "Cannot send RPC to producer module.");
         rc = DYAD_RC_BADRPC;
-        goto get_done;
+        goto send_rpc_done;
     }
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Receive RPC response from DYAD module");
-    rc = ctx->dtl_handle->rpc_recv_response (ctx, f);
+    rc = ctx->dtl_handle->rpc_recv_response (ctx, *f);
     if (DYAD_IS_ERROR (rc)) {
         DYAD_LOG_ERROR (ctx, "Cannot receive and/or parse the RPC response.");
-        goto get_done;
+        goto send_rpc_done;
+    }
+    rc = DYAD_RC_OK;
+
+send_rpc_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+DYAD_DLL_EXPORTED dyad_rc_t dyad_get_data (const dyad_ctx_t *restrict ctx,
+                                           const dyad_metadata_t *restrict mdata,
+                                           char **restrict file_data,
+                                           size_t *restrict file_len)
+{
+    return dyad_get_data_range (ctx, mdata, 0, 0ul, file_data, file_len);
+}
+
+/* File size reported by fetches over a DTL that does not tell it */
+#define DYAD_FILE_SIZE_UNKNOWN ((size_t)-1)
+
+/* Largest piece of a file fetched over the RPC stream when the DTL cannot
+ * reach its producer. The module reads each piece on its reactor. */
+#define DYAD_REMOTE_PIECE (4ul << 20)
+
+/* A fetch whose request is sent but whose data is not received yet */
+typedef struct dyad_fetch {
+    flux_future_t *f;
+    off_t offset;
+    size_t length;
+    char *slot;  // Buffer the producer writes into with UCX RMA
+} dyad_fetch_t;
+
+/* Send the request for the range [offset, offset + length) of a file, or
+ * for probe bytes of zeros if probe is non-zero */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_start (const dyad_ctx_t *restrict ctx,
+                                                const dyad_metadata_t *restrict mdata,
+                                                off_t offset,
+                                                size_t length,
+                                                size_t probe,
+                                                dyad_fetch_t *restrict fetch)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    fetch->f = NULL;
+    fetch->offset = offset;
+    fetch->length = length;
+    fetch->slot = NULL;
+    rc = dyad_send_fetch_rpc (ctx, mdata, 0ul, offset, length, probe, &fetch->f);
+    if (DYAD_IS_ERROR (rc)) {
+        flux_future_destroy (fetch->f);
+        fetch->f = NULL;
+        return rc;
     }
+#ifdef DYAD_ENABLE_UCX_RMA
+    // rpc_pack made the buffer slot of this request the current one
+    ctx->dtl_handle->get_buffer (ctx, 0, (void **)&fetch->slot);
+#endif
+    return rc;
+}
+
+/* Wait for the data of a fetch started with dyad_fetch_start. On success,
+ * *file_size is the size of the whole file if the DTL reports it and
+ * DYAD_FILE_SIZE_UNKNOWN otherwise. On failure, *file_data is NULL. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_finish (const dyad_ctx_t *restrict ctx,
+                                                 const dyad_metadata_t *restrict mdata,
+                                                 dyad_fetch_t *restrict fetch,
+                                                 char **restrict file_data,
+                                                 size_t *restrict file_len,
+                                                 size_t *restrict file_size)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    flux_future_t *f = fetch->f;
+    *file_data = fetch->slot;
+    *file_len = 0ul;
+    *file_size = DYAD_FILE_SIZE_UNKNOWN;
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Establish DTL connection with DYAD module");
     rc = ctx->dtl_handle->establish_connection (ctx);
     if (DYAD_IS_ERROR (rc)) {
@@ -419,6 +1027,8 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_get_data (const dyad_ctx_t *restrict ctx,
         goto get_done;
     }
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Receive file data via DTL");
+    // A payload lent out under zero-copy holds on to its response message,
+    // so it is handed to the caller as is until dyad_release_data
     rc = ctx->dtl_handle->recv (ctx, (void **)file_data, file_len);
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Close DTL connection with DYAD module");
     ctx->dtl_handle->close_connection (ctx);
@@ -431,11 +1041,13 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_get_data (const dyad_ctx_t *restrict ctx,
     rc = DYAD_RC_OK;
 
 get_done:;
-    // There are two return codes that have special meaning when coming from the
+    // There are three return codes that have special meaning when coming from the
     // DTL:
     //  * DYAD_RC_RPC_FINISHED: occurs when an ENODATA error occurs
     //  * DYAD_RC_BADRPC: occurs when a previous RPC operation fails
-    // In either of these cases, we do not need to wait for the end of stream
+    //  * DYAD_RC_NOCONN: occurs when the producer no longer holds a connection
+    //                    to this consumer
+    // In any of these cases, we do not need to wait for the end of stream
     // because the RPC is already completely messed up. If we do not have either
     // of these cases, we will wait for one more RPC message. If everything went
     // well in the module, this last message will set errno to ENODATA (i.e.,
@@ -443,7 +1055,7 @@ get_done:;
     // DYAD_RC_BADRPC.
     // DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Wait for end-of-stream message from module (current RC =
     // %d)", rc);
-    if (rc != DYAD_RC_RPC_FINISHED && rc != DYAD_RC_BADRPC) {
+    if (f != NULL && rc != DYAD_RC_RPC_FINISHED && rc != DYAD_RC_BADRPC && rc != DYAD_RC_NOCONN) {
         if (!(flux_rpc_get (f, NULL) < 0 && errno == ENODATA)) {
             DYAD_LOG_ERROR (ctx,
                             "An error occured at end of getting data! Either the "
@@ -454,116 +1066,944 @@ get_done:;
         }
     }
 #ifdef DYAD_ENABLE_UCX_RMA
-    ctx->dtl_handle->get_buffer (ctx, 0, (void **)file_data);
-    ssize_t read_len = 0l;
-    memcpy (&read_len, *file_data, sizeof (read_len));
-    if (read_len < 0l) {
+    if (!DYAD_IS_ERROR (rc)) {
+        dyad_dtl_rma_header_t header;
+        memcpy (&header, fetch->slot, sizeof (header));
+        if (header.len < 0l) {
+            DYAD_LOG_DEBUG (ctx, "Not able to read from %s file", mdata->fpath);
+            rc = DYAD_RC_BADFIO;
+        } else {
+            *file_len = (size_t)header.len;
+            *file_size = (size_t)header.file_size;
+            *file_data = fetch->slot + sizeof (header);
+            DYAD_LOG_DEBUG (ctx,
+                            "DYAD CLIENT: Read %zd bytes from %s file",
+                            *file_len,
+                            mdata->fpath);
+        }
+    }
+    if (DYAD_IS_ERROR (rc) && fetch->slot != NULL) {
+        // Nobody gets to see the data, so give the slot back right away
+        ctx->dtl_handle->return_buffer (ctx, (void **)&fetch->slot);
+        *file_data = NULL;
         *file_len = 0ul;
-        DYAD_LOG_DEBUG (ctx, "Not able to read from %s file", mdata->fpath);
-        rc = DYAD_RC_BADFIO;
-    } else {
-        *file_len = (size_t)read_len;
     }
-    *file_data = ((char *)*file_data) + sizeof (read_len);
-    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Read %zd bytes from %s file", *file_len, mdata->fpath);
 #endif
+    // A module without range support sends the whole file
+    if (!DYAD_IS_ERROR (rc) && fetch->length > 0ul && *file_len > fetch->length) {
+        DYAD_LOG_ERROR (ctx,
+                        "Received %zu bytes for a range of %zu bytes. The module on broker "
+                        "%u may not support range requests.",
+                        *file_len,
+                        fetch->length,
+                        mdata->owner_rank);
+        rc = DYAD_RC_BADRPC;
+    }
+    if (DYAD_IS_ERROR (rc) && fetch->slot == NULL && *file_data != NULL) {
+        // A lent out payload would otherwise keep its response alive
+        ctx->dtl_handle->return_buffer (ctx, (void **)file_data);
+        *file_data = NULL;
+        *file_len = 0ul;
+    }
     DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Destroy the Flux future for the RPC.");
     flux_future_destroy (f);
+    fetch->f = NULL;
     DYAD_C_FUNCTION_END ();
     return rc;
 }
 
-DYAD_CORE_FUNC_MODS dyad_rc_t dyad_cons_store (const dyad_ctx_t *restrict ctx,
-                                               const dyad_metadata_t *restrict mdata,
-                                               int fd,
-                                               const size_t data_len,
-                                               char *restrict file_data)
+/* Fetch a range of at most one transfer of the DTL. If the producer dropped
+ * the connection it kept for us (e.g., it was evicted), ask again once with
+ * the full connection info. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_range (const dyad_ctx_t *restrict ctx,
+                                                const dyad_metadata_t *restrict mdata,
+                                                off_t offset,
+                                                size_t length,
+                                                char **restrict file_data,
+                                                size_t *restrict file_len,
+                                                size_t *restrict file_size)
 {
-    DYAD_C_FUNCTION_START ();
-    DYAD_C_FUNCTION_UPDATE_INT ("fd", fd);
     dyad_rc_t rc = DYAD_RC_OK;
-    const char *odir = NULL;
-    char file_path[PATH_MAX + 1] = {'\0'};
-    char file_path_copy[PATH_MAX + 1] = {'\0'};
-    mode_t m = (S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH | S_ISGID);
-    size_t written_len = 0;
-    memset (file_path, 0, PATH_MAX + 1);
-    memset (file_path_copy, 0, PATH_MAX + 1);
+    dyad_fetch_t fetch;
+    bool resent = false;
+fetch_again:;
+    rc = dyad_fetch_start (ctx, mdata, offset, length, 0ul, &fetch);
+    if (!DYAD_IS_ERROR (rc)) {
+        rc = dyad_fetch_finish (ctx, mdata, &fetch, file_data, file_len, file_size);
+    }
+    if (rc == DYAD_RC_NOCONN && !resent) {
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Resend fetch RPC with connection info");
+        resent = true;
+        goto fetch_again;
+    }
+    return rc;
+}
 
-    // Build the full path to the file being consumed
-    strncpy (file_path, ctx->cons_managed_path, PATH_MAX - 1);
-    concat_str (file_path, mdata->fpath, "/", PATH_MAX);
-    memcpy (file_path_copy, file_path, PATH_MAX);  // dirname modifies the arg
-    DYAD_C_FUNCTION_UPDATE_STR ("cons_managed_path", ctx->cons_managed_path);
-    DYAD_C_FUNCTION_UPDATE_STR ("fpath", mdata->fpath);
-    DYAD_C_FUNCTION_UPDATE_STR ("file_path_copy", file_path_copy);
+/* Fetch [offset, offset + length) of a file that may not fit in a single
+ * transfer of the DTL. The first piece tells the size of the file. The
+ * others are fetched with up to max_inflight requests in flight and are
+ * assembled into a buffer on the heap, which return_buffer frees. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_pieces (const dyad_ctx_t *restrict ctx,
+                                                 const dyad_metadata_t *restrict mdata,
+                                                 off_t offset,
+                                                 size_t length,
+                                                 char **restrict file_data,
+                                                 size_t *restrict file_len)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    size_t piece = ctx->dtl_handle->max_transfer_size;
+    size_t window = ctx->dtl_handle->max_inflight > 0u ? ctx->dtl_handle->max_inflight : 1u;
+    dyad_fetch_t *pending = NULL;  // Ring of the fetches in flight, in file order
+    size_t head = 0ul;
+    size_t num_pending = 0ul;
+    char *data = NULL;
+    char *piece_data = NULL;
+    size_t piece_len = 0ul;
+    size_t file_size = 0ul;
+    size_t total = 0ul;
+    size_t received = 0ul;
+    off_t next = offset;
+    off_t end = 0;
 
-    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Saving retrieved data to %s", file_path);
-    // Create the directory as needed
-    // TODO: Need to be consistent with the mode at the source
-    odir = dirname (file_path_copy);
-    if ((strncmp (odir, ".", strlen (".")) != 0) && (mkdir_as_needed (odir, m) < 0)) {
-        DYAD_LOG_ERROR (ctx, "DYAD CLIENT: Cannot create needed directories for pulled file");
-        rc = DYAD_RC_BADFIO;
-        goto pull_done;
+    rc = dyad_fetch_range (ctx, mdata, offset, piece, &piece_data, &piece_len, &file_size);
+    if (DYAD_IS_ERROR (rc)) {
+        goto pieces_done;
+    }
+    if (file_size == DYAD_FILE_SIZE_UNKNOWN || (size_t)offset + piece_len > file_size) {
+        DYAD_LOG_ERROR (ctx, "DYAD CLIENT: The DTL did not report the size of %s", mdata->fpath);
+        rc = DYAD_RC_BADRPC;
+        goto pieces_done;
+    }
+    end = (off_t)file_size;
+    if (length > 0ul && (size_t)offset + length < file_size) {
+        end = offset + (off_t)length;
+    }
+    total = (size_t)(end - offset);
+    if (piece_len == total) {
+        // The whole range fit in the first piece
+        *file_data = piece_data;
+        *file_len = piece_len;
+        piece_data = NULL;
+        goto pieces_done;
+    }
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD CLIENT: Fetching %zu bytes of %s in pieces of %zu bytes",
+                    total,
+                    mdata->fpath,
+                    piece);
+    data = (char *)malloc (total);
+    pending = (dyad_fetch_t *)calloc (window, sizeof (dyad_fetch_t));
+    if (data == NULL || pending == NULL) {
+        DYAD_LOG_ERROR (ctx, "DYAD CLIENT: Cannot allocate a buffer of %zu bytes", total);
+        rc = DYAD_RC_SYSFAIL;
+        goto pieces_done;
     }
+    memcpy (data, piece_data, piece_len);
+    ctx->dtl_handle->return_buffer (ctx, (void **)&piece_data);
+    received = piece_len;
+    next = offset + (off_t)piece_len;
 
-    // Write the file contents to the location specified by the user
-    if (data_len < DYAD_POSIX_TRANSFER_GRANULARITY) {
-        written_len = write (fd, file_data, data_len);
-    } else {
-        ssize_t written_data = 0;
-        ssize_t granularity = DYAD_POSIX_TRANSFER_GRANULARITY;
-        DYAD_LOG_DEBUG (ctx,
-                        " writing file %s with bytes %zd is big. Writing in granularity %zd",
-                        file_path,
-                        data_len,
-                        granularity);
-        while (written_data < (ssize_t)data_len) {
-            ssize_t written_size = (ssize_t)(data_len - written_data) > granularity
-                                       ? granularity
-                                       : (ssize_t)(data_len - written_data);
-            written_len = write (fd, file_data + written_data, written_size);
-            DYAD_LOG_DEBUG (ctx,
-                            " writing file %s with bytes %zd of %zd",
-                            file_path,
-                            written_size,
-                            written_len);
-            if (written_len <= 0) {
-                DYAD_LOG_ERROR (ctx,
-                                "DYAD CLIENT: Failed to write file \"%s\" only read %zd of %zd of "
-                                "%zd. with "
-                                "code %d:%s.",
-                                file_path,
-                                written_len,
-                                written_size,
-                                data_len,
-                                errno,
-                                strerror (errno));
-                goto pull_done;
+    while (received < total) {
+        while (num_pending < window && next < end) {
+            dyad_fetch_t *fetch = &pending[(head + num_pending) % window];
+            size_t len = (size_t)(end - next) < piece ? (size_t)(end - next) : piece;
+            rc = dyad_fetch_start (ctx, mdata, next, len, 0ul, fetch);
+            if (DYAD_IS_ERROR (rc)) {
+                // Buffers can run out while the caller holds on to data.
+                // Wait for the fetches in flight before trying again.
+                if (num_pending > 0ul && rc == DYAD_RC_BADBUF) {
+                    rc = DYAD_RC_OK;
+                    break;
+                }
+                goto pieces_done;
             }
-            written_data += written_len;
+            next += (off_t)len;
+            num_pending++;
         }
-        written_len = written_data;
-    }
-    if (written_len != data_len) {
-        DYAD_LOG_ERROR (ctx, "DYAD CLIENT: cons store write of pulled file failed!\n");
-        rc = DYAD_RC_BADFIO;
-        goto pull_done;
+        dyad_fetch_t *fetch = &pending[head];
+        head = (head + 1ul) % window;
+        num_pending--;
+        rc = dyad_fetch_finish (ctx, mdata, fetch, &piece_data, &piece_len, &file_size);
+        if (rc == DYAD_RC_NOCONN) {
+            rc = dyad_fetch_range (ctx,
+                                   mdata,
+                                   fetch->offset,
+                                   fetch->length,
+                                   &piece_data,
+                                   &piece_len,
+                                   &file_size);
+        }
+        if (DYAD_IS_ERROR (rc)) {
+            goto pieces_done;
+        }
+        if (piece_len != fetch->length) {
+            DYAD_LOG_ERROR (ctx,
+                            "DYAD CLIENT: Got %zu instead of %zu bytes at offset %jd of %s",
+                            piece_len,
+                            fetch->length,
+                            (intmax_t)fetch->offset,
+                            mdata->fpath);
+            ctx->dtl_handle->return_buffer (ctx, (void **)&piece_data);
+            rc = DYAD_RC_BADRPC;
+            goto pieces_done;
+        }
+        memcpy (data + (fetch->offset - offset), piece_data, piece_len);
+        ctx->dtl_handle->return_buffer (ctx, (void **)&piece_data);
+        received += piece_len;
     }
-    DYAD_C_FUNCTION_UPDATE_INT ("data_len", data_len);
+    *file_data = data;
+    *file_len = total;
+    data = NULL;
     rc = DYAD_RC_OK;
 
-pull_done:;
-    // If "check" is set and the operation was successful, set the
-    // DYAD_CHECK_ENV environment variable to "ok"
-    if (rc == DYAD_RC_OK && (ctx && ctx->check))
-        setenv (DYAD_CHECK_ENV, "ok", 1);
+pieces_done:;
+    // Drain the fetches still in flight after a failure
+    for (; num_pending > 0ul; num_pending--) {
+        dyad_fetch_t *fetch = &pending[head];
+        head = (head + 1ul) % window;
+        if (!DYAD_IS_ERROR (
+                dyad_fetch_finish (ctx, mdata, fetch, &piece_data, &piece_len, &file_size))) {
+            ctx->dtl_handle->return_buffer (ctx, (void **)&piece_data);
+        }
+    }
+    if (piece_data != NULL) {
+        ctx->dtl_handle->return_buffer (ctx, (void **)&piece_data);
+    }
+    free (pending);
+    free (data);
     DYAD_C_FUNCTION_END ();
     return rc;
 }
 
-dyad_rc_t dyad_produce (dyad_ctx_t *restrict ctx, const char *restrict fname)
+/* Copy [offset, offset + length) of the data inlined in mdata into a
+ * buffer that dyad_release_data can give back. On the consumer side, the
+ * UCX DTL hands out the buffer of the current request, but frees other
+ * buffers on return like the DTLs whose buffers come from the heap. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_inline_range (const dyad_ctx_t *restrict ctx,
+                                                 const dyad_metadata_t *restrict mdata,
+                                                 off_t offset,
+                                                 size_t length,
+                                                 char **restrict file_data,
+                                                 size_t *restrict file_len)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    size_t len = 0ul;
+    if ((size_t)offset < mdata->inline_len) {
+        len = mdata->inline_len - (size_t)offset;
+    }
+    if (length > 0ul && length < len) {
+        len = length;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: %s is inlined in its metadata", mdata->fpath);
+    if (ctx->dtl_handle->mode == DYAD_DTL_UCX) {
+        *file_data = (char *)malloc (len + 1ul);
+        rc = (*file_data == NULL) ? DYAD_RC_SYSFAIL : DYAD_RC_OK;
+    } else {
+        rc = ctx->dtl_handle->get_buffer (ctx, len + 1ul, (void **)file_data);
+    }
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate a buffer for the inlined data");
+        *file_data = NULL;
+        return rc;
+    }
+    if (len > 0ul) {
+        memcpy (*file_data, mdata->inline_data + offset, len);
+    }
+    *file_len = len;
+    return DYAD_RC_OK;
+}
+
+/* Whether a transfer of length bytes, where 0 stands for a size only the
+ * module knows, may come back in the RPC stream rather than through UCX
+ * or Margo */
+DYAD_CORE_FUNC_MODS bool dyad_use_rpc_route (const dyad_ctx_t *restrict ctx, size_t length)
+{
+    return ctx->dtl_rpc_max > 0ul
+           && (ctx->dtl_handle->mode == DYAD_DTL_UCX || ctx->dtl_handle->mode == DYAD_DTL_MARGO)
+           && length <= ctx->dtl_rpc_max;
+}
+
+/* Whether to ask the module to compress the data it sends back in the
+ * RPC stream (see dyad/utils/compress.h) */
+DYAD_CORE_FUNC_MODS bool dyad_want_compress (const dyad_ctx_t *restrict ctx)
+{
+    return ctx->compress_level != 0 && dyad_compress_available ();
+}
+
+/* Decode a payload that the module sent as a compressed frame into
+ * *data_len bytes at *data. Raw data is pointed to in place. Anything
+ * else is decoded into a heap buffer with one spare byte, which is also
+ * returned in *decoded for the caller to free. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_decode_payload (const dyad_ctx_t *restrict ctx,
+                                                   const void *payload,
+                                                   size_t len,
+                                                   const char **data,
+                                                   size_t *data_len,
+                                                   char **decoded)
+{
+    uint32_t codec = DYAD_CODEC_NONE;
+    size_t raw_len = 0ul;
+
+    *decoded = NULL;
+    if (dyad_compress_frame_info (payload, len, &codec, &raw_len) < 0) {
+        DYAD_LOG_ERROR (ctx, "Invalid frame from the module (errno = %d)", errno);
+        return DYAD_RC_BADRPC;
+    }
+    if (codec == DYAD_CODEC_NONE) {
+        *data = (const char *)payload + sizeof (dyad_compress_frame_t);
+        *data_len = raw_len;
+        return DYAD_RC_OK;
+    }
+    *decoded = (char *)malloc (raw_len + 1ul);
+    if (*decoded == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate %zu bytes to decode into", raw_len);
+        return DYAD_RC_SYSFAIL;
+    }
+    if (dyad_decompress_frame (payload, len, *decoded) < 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot decode data from the module (errno = %d)", errno);
+        free (*decoded);
+        *decoded = NULL;
+        return DYAD_RC_BADRPC;
+    }
+    *data = *decoded;
+    *data_len = raw_len;
+    return DYAD_RC_OK;
+}
+
+/* Ask the module on owner_rank for [offset, offset + length) of upath, or
+ * for probe bytes of zeros, as the payload of a response on the RPC stream
+ * instead of through the DTL. The module refuses anything larger than
+ * rpc_max, which is reported as DYAD_RC_TOOBIG. On success, *file_data is
+ * a heap buffer, which the return_buffer of the UCX and Margo DTLs frees
+ * like any buffer they did not hand out. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_rpc_fetch (const dyad_ctx_t *restrict ctx,
+                                              uint32_t owner_rank,
+                                              const char *restrict upath,
+                                              off_t offset,
+                                              size_t length,
+                                              size_t rpc_max,
+                                              size_t probe,
+                                              char **restrict file_data,
+                                              size_t *restrict file_len)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
+    dyad_rc_t rc = DYAD_RC_OK;
+    flux_future_t *f = NULL;
+    const void *payload = NULL;
+    size_t payload_len = 0ul;
+    const char *data = NULL;
+    size_t data_len = 0ul;
+    char *decoded = NULL;
+    // Probes time the transfer of zeros, which compress far too well
+    bool compress = probe == 0ul && dyad_want_compress (ctx);
+
+    *file_data = NULL;
+    *file_len = 0ul;
+    f = flux_rpc_pack ((flux_t *)ctx->h,
+                       DYAD_DTL_RPC_NAME,
+                       owner_rank,
+                       FLUX_RPC_STREAMING,
+                       "{s:s s:I s:I s:I s:I s:i}",
+                       "upath",
+                       upath,
+                       "rpc_max",
+                       (json_int_t)rpc_max,
+                       "probe",
+                       (json_int_t)probe,
+                       "offset",
+                       (json_int_t)offset,
+                       "length",
+                       (json_int_t)length,
+                       "compress",
+                       (int)(compress ? DYAD_CODEC_ZSTD : DYAD_CODEC_NONE));
+    if (f == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot send RPC to producer module.");
+        rc = DYAD_RC_BADRPC;
+        goto rpc_fetch_done;
+    }
+    if (flux_rpc_get_raw (f, &payload, &payload_len) < 0) {
+        if (errno == EFBIG) {
+            rc = DYAD_RC_TOOBIG;
+        } else {
+            DYAD_LOG_ERROR (ctx,
+                            "Cannot receive %s from the module on broker %u (errno = %d)",
+                            upath,
+                            owner_rank,
+                            errno);
+            rc = DYAD_RC_BADRPC;
+        }
+        goto rpc_fetch_done;
+    }
+    data = (const char *)payload;
+    data_len = payload_len;
+    if (compress) {
+        rc = dyad_decode_payload (ctx, payload, payload_len, &data, &data_len, &decoded);
+        if (DYAD_IS_ERROR (rc)) {
+            goto rpc_fetch_done;
+        }
+    }
+    if (decoded != NULL) {
+        *file_data = decoded;
+    } else {
+        // One more byte, so that an empty range still gets a buffer
+        *file_data = (char *)malloc (data_len + 1ul);
+        if (*file_data == NULL) {
+            DYAD_LOG_ERROR (ctx, "Cannot allocate a buffer for the received data");
+            rc = DYAD_RC_SYSFAIL;
+            goto rpc_fetch_done;
+        }
+        memcpy (*file_data, data, data_len);
+    }
+    *file_len = data_len;
+    flux_future_reset (f);
+    if (!(flux_rpc_get (f, NULL) < 0 && errno == ENODATA)) {
+        DYAD_LOG_ERROR (ctx,
+                        "An error occured at end of getting data! Either the "
+                        "module sent too many responses, or the module "
+                        "failed with a bad error (errno = %d).",
+                        errno);
+        free (*file_data);
+        *file_data = NULL;
+        *file_len = 0ul;
+        rc = DYAD_RC_BADRPC;
+        goto rpc_fetch_done;
+    }
+    DYAD_C_FUNCTION_UPDATE_INT ("file_len", *file_len);
+    rc = DYAD_RC_OK;
+
+rpc_fetch_done:;
+    flux_future_destroy (f);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Fetch [offset, offset + length) of the file described by mdata over the
+ * RPC stream, in pieces of ctx->dtl_chunk_size bytes, up to
+ * DYAD_REMOTE_PIECE. This serves the producers that the DTL cannot reach, like
+ * those on other nodes for the SHM DTL. The pieces end up in a buffer of
+ * the DTL, so that dyad_release_data gives it back like any other. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_rpc_fetch_pieces (const dyad_ctx_t *restrict ctx,
+                                                     const dyad_metadata_t *restrict mdata,
+                                                     off_t offset,
+                                                     size_t length,
+                                                     char **restrict file_data,
+                                                     size_t *restrict file_len)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    size_t piece = DYAD_REMOTE_PIECE;
+    size_t want = 0ul;
+    size_t total = 0ul;
+    char *piece_data = NULL;
+    size_t piece_len = 0ul;
+    char *data = NULL;
+    char *grown = NULL;
+
+    *file_data = NULL;
+    *file_len = 0ul;
+    if (ctx->dtl_chunk_size > 0ul && ctx->dtl_chunk_size < piece) {
+        piece = ctx->dtl_chunk_size;
+    }
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD CLIENT: fetching %s from broker %u over the RPC stream",
+                    mdata->fpath,
+                    mdata->owner_rank);
+    do {
+        want = (length > 0ul && length - total < piece) ? length - total : piece;
+        rc = dyad_rpc_fetch (ctx,
+                             mdata->owner_rank,
+                             mdata->fpath,
+                             offset + (off_t)total,
+                             want,
+                             want,
+                             0ul,
+                             &piece_data,
+                             &piece_len);
+        if (DYAD_IS_ERROR (rc)) {
+            goto rpc_pieces_done;
+        }
+        if (piece_len > 0ul) {
+            grown = (char *)realloc (data, total + piece_len);
+            if (grown == NULL) {
+                DYAD_LOG_ERROR (ctx, "Cannot allocate a buffer for the received data");
+                rc = DYAD_RC_SYSFAIL;
+                goto rpc_pieces_done;
+            }
+            data = grown;
+            memcpy (data + total, piece_data, piece_len);
+            total += piece_len;
+        }
+        free (piece_data);
+        piece_data = NULL;
+        // A short piece means the end of the file
+    } while (piece_len == want && (length == 0ul || total < length));
+
+    rc = ctx->dtl_handle->get_buffer (ctx, total + 1ul, (void **)file_data);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "Cannot get a DTL buffer for the received data");
+        *file_data = NULL;
+        goto rpc_pieces_done;
+    }
+    if (total > 0ul) {
+        memcpy (*file_data, data, total);
+    }
+    *file_len = total;
+    DYAD_C_FUNCTION_UPDATE_INT ("file_len", *file_len);
+
+rpc_pieces_done:;
+    free (piece_data);
+    free (data);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+DYAD_DLL_EXPORTED dyad_rc_t dyad_get_data_range (const dyad_ctx_t *restrict ctx,
+                                                 const dyad_metadata_t *restrict mdata,
+                                                 off_t offset,
+                                                 size_t length,
+                                                 char **restrict file_data,
+                                                 size_t *restrict file_len)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_INT ("offset", offset);
+    DYAD_C_FUNCTION_UPDATE_INT ("length", length);
+    dyad_rc_t rc = DYAD_RC_OK;
+    size_t file_size = 0ul;
+    *file_data = NULL;
+    *file_len = 0ul;
+    // Small files may come with their metadata
+    if (mdata->inline_data != NULL) {
+        rc = dyad_inline_range (ctx, mdata, offset, length, file_data, file_len);
+        goto get_range_done;
+    }
+    // The SHM DTL only reaches producers on this node
+    if (ctx->dtl_handle->mode == DYAD_DTL_SHM && !dyad_owner_on_node (ctx, mdata->owner_rank)) {
+        rc = dyad_rpc_fetch_pieces (ctx, mdata, offset, length, file_data, file_len);
+        goto get_range_done;
+    }
+    // Small transfers cost less in the RPC stream than through UCX or
+    // Margo. Whether the size of the file fits is up to the module.
+    if (dyad_use_rpc_route (ctx, length)) {
+        rc = dyad_rpc_fetch (ctx,
+                             mdata->owner_rank,
+                             mdata->fpath,
+                             offset,
+                             length,
+                             ctx->dtl_rpc_max,
+                             0ul,
+                             file_data,
+                             file_len);
+        if (rc != DYAD_RC_TOOBIG) {
+            goto get_range_done;
+        }
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: %s is too large for the RPC stream", mdata->fpath);
+    }
+    // Ranges larger than a single transfer of the DTL are fetched in pieces
+    if (ctx->dtl_handle->max_transfer_size > 0ul
+        && (length == 0ul || length > ctx->dtl_handle->max_transfer_size)) {
+        rc = dyad_fetch_pieces (ctx, mdata, offset, length, file_data, file_len);
+    } else {
+        rc = dyad_fetch_range (ctx, mdata, offset, length, file_data, file_len, &file_size);
+    }
+
+get_range_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_release_data (const dyad_ctx_t *restrict ctx, char **restrict file_data)
+{
+    if (ctx == NULL || ctx->dtl_handle == NULL || file_data == NULL || *file_data == NULL) {
+        return DYAD_RC_OK;
+    }
+    dyad_rc_t rc = ctx->dtl_handle->return_buffer (ctx, (void **)file_data);
+    *file_data = NULL;
+    return rc;
+}
+
+/* Best time, in seconds, of a few transfers of probe bytes from the module
+ * of mdata's owner, over the RPC stream if rpc is set and through the DTL
+ * otherwise. The first transfer also sets up the connection, so it does
+ * not count. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_time_probe (const dyad_ctx_t *restrict ctx,
+                                               const dyad_metadata_t *restrict mdata,
+                                               size_t probe,
+                                               bool rpc,
+                                               double *restrict best)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_fetch_t fetch;
+    char *data = NULL;
+    size_t len = 0ul;
+    size_t file_size = 0ul;
+    double start = 0.0;
+    double elapsed = 0.0;
+    bool resent = false;
+    const int runs = 3;
+    int i = 0;
+
+    *best = 0.0;
+    for (i = 0; i <= runs; i++) {
+        start = dyad_publish_now ();
+        if (rpc) {
+            rc = dyad_rpc_fetch (ctx,
+                                 mdata->owner_rank,
+                                 mdata->fpath,
+                                 0,
+                                 0ul,
+                                 probe,
+                                 probe,
+                                 &data,
+                                 &len);
+        } else {
+            rc = dyad_fetch_start (ctx, mdata, 0, 0ul, probe, &fetch);
+            if (!DYAD_IS_ERROR (rc)) {
+                rc = dyad_fetch_finish (ctx, mdata, &fetch, &data, &len, &file_size);
+            }
+            if (rc == DYAD_RC_NOCONN && !resent) {
+                resent = true;
+                i--;
+                continue;
+            }
+        }
+        if (DYAD_IS_ERROR (rc)) {
+            return rc;
+        }
+        elapsed = dyad_publish_now () - start;
+        if (i == 1 || (i > 1 && elapsed < *best)) {
+            *best = elapsed;
+        }
+        ctx->dtl_handle->return_buffer (ctx, (void **)&data);
+        if (len != probe) {
+            return DYAD_RC_BADRPC;
+        }
+    }
+    return DYAD_RC_OK;
+}
+
+/* Set ctx->dtl_rpc_max to the largest probe size for which the RPC stream
+ * is at least as fast as the DTL, measured against the producer of the
+ * first remote fetch. Probes stop at the first size where the DTL wins.
+ * Measured once: if a probe fails, the current limit stays. */
+DYAD_CORE_FUNC_MODS void dyad_dtl_rpc_calibrate (dyad_ctx_t *restrict ctx,
+                                                 const dyad_metadata_t *restrict mdata)
+{
+    static const size_t probe_sizes[] = {4ul << 10, 16ul << 10, 64ul << 10, 256ul << 10, 1ul << 20};
+    size_t crossover = 0ul;
+    double rpc_time = 0.0;
+    double dtl_time = 0.0;
+    size_t i = 0ul;
+
+    ctx->dtl_rpc_calibrate = false;
+    if (!dyad_use_rpc_route (ctx, 0ul)) {
+        return;
+    }
+    for (i = 0ul; i < sizeof (probe_sizes) / sizeof (probe_sizes[0]); i++) {
+        size_t probe = probe_sizes[i];
+        if (ctx->dtl_handle->max_transfer_size > 0ul
+            && probe > ctx->dtl_handle->max_transfer_size) {
+            break;
+        }
+        if (DYAD_IS_ERROR (dyad_time_probe (ctx, mdata, probe, true, &rpc_time))
+            || DYAD_IS_ERROR (dyad_time_probe (ctx, mdata, probe, false, &dtl_time))) {
+            DYAD_LOG_ERROR (ctx,
+                            "DYAD CLIENT: Cannot time transfers from broker %u. Sending up to "
+                            "%zu bytes in the RPC stream",
+                            mdata->owner_rank,
+                            ctx->dtl_rpc_max);
+            return;
+        }
+        DYAD_LOG_DEBUG (ctx,
+                        "DYAD CLIENT: %zu bytes take %.6f s in the RPC stream, %.6f s with %s",
+                        probe,
+                        rpc_time,
+                        dtl_time,
+                        dyad_dtl_mode_name[ctx->dtl_handle->mode]);
+        if (rpc_time > dtl_time) {
+            break;
+        }
+        crossover = probe;
+    }
+    ctx->dtl_rpc_max = crossover;
+    DYAD_LOG_INFO (ctx, "DYAD CLIENT: Sending up to %zu bytes in the RPC stream", crossover);
+}
+
+/* Create the directories of the file described by mdata in the
+ * consumer-managed directory, as needed */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_cons_make_dir (const dyad_ctx_t *restrict ctx,
+                                                  const dyad_metadata_t *restrict mdata)
+{
+    const char *odir = NULL;
+    char file_path_copy[PATH_MAX + 1] = {'\0'};
+    mode_t m = (S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH | S_ISGID);
+
+    // Build the full path to the file being consumed
+    strncpy (file_path_copy, ctx->cons_managed_path, PATH_MAX - 1);
+    concat_str (file_path_copy, mdata->fpath, "/", PATH_MAX);
+
+    // Create the directory as needed
+    // TODO: Need to be consistent with the mode at the source
+    odir = dirname (file_path_copy);  // dirname modifies the arg
+    if ((strncmp (odir, ".", strlen (".")) != 0) && (mkdir_as_needed (odir, m) < 0)) {
+        DYAD_LOG_ERROR (ctx, "DYAD CLIENT: Cannot create needed directories for pulled file");
+        return DYAD_RC_BADFIO;
+    }
+    return DYAD_RC_OK;
+}
+
+/* Write data_len bytes of file_data at the current offset of fd, the file
+ * described by mdata in the consumer-managed directory */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_cons_write (const dyad_ctx_t *restrict ctx,
+                                               const dyad_metadata_t *restrict mdata,
+                                               int fd,
+                                               const size_t data_len,
+                                               char *restrict file_data)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_INT ("fd", fd);
+    DYAD_C_FUNCTION_UPDATE_STR ("fpath", mdata->fpath);
+    dyad_rc_t rc = DYAD_RC_OK;
+    size_t written_len = 0;
+    ssize_t copied = 0l;
+    int buf_fd = -1;
+    off_t buf_off = 0;
+
+    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Saving retrieved data to %s", mdata->fpath);
+    // Write the file contents to the location specified by the user. If the
+    // DTL buffer is backed by a file, let the kernel copy it.
+    if (!ctx->posix_io && ctx->dtl_handle->get_buffer_fd != NULL
+        && !DYAD_IS_ERROR (ctx->dtl_handle->get_buffer_fd (ctx, file_data, &buf_fd, &buf_off))) {
+        copied = copy_range (buf_fd, buf_off, fd, NULL, data_len);
+        written_len = (copied < 0l) ? 0ul : (size_t)copied;
+    }
+    if (written_len < data_len && ctx->uring != NULL) {
+        // Queue the data in segments that are all written at once
+        off_t pos = lseek (fd, 0, SEEK_CUR);
+        if (pos >= 0) {
+            copied = dyad_uring_pwrite_all (ctx->uring,
+                                            fd,
+                                            file_data + written_len,
+                                            data_len - written_len,
+                                            pos,
+                                            ctx->uring_direct_min > 0ul
+                                                && data_len >= ctx->uring_direct_min);
+            if (copied > 0l && lseek (fd, pos + copied, SEEK_SET) >= 0) {
+                written_len += (size_t)copied;
+            }
+        }
+    }
+    if (written_len < data_len) {
+        copied = write_all (fd, file_data + written_len, data_len - written_len);
+        if (copied < 0l) {
+            DYAD_LOG_ERROR (ctx,
+                            "DYAD CLIENT: Failed to write file \"%s\" after %zu of %zu bytes "
+                            "with code %d:%s.",
+                            mdata->fpath,
+                            written_len,
+                            data_len,
+                            errno,
+                            strerror (errno));
+        } else {
+            written_len += (size_t)copied;
+        }
+    }
+    if (written_len != data_len) {
+        DYAD_LOG_ERROR (ctx, "DYAD CLIENT: cons store write of pulled file failed!\n");
+        rc = DYAD_RC_BADFIO;
+        goto pull_done;
+    }
+    DYAD_C_FUNCTION_UPDATE_INT ("data_len", data_len);
+    rc = DYAD_RC_OK;
+
+pull_done:;
+    // If "check" is set and the operation was successful, set the
+    // DYAD_CHECK_ENV environment variable to "ok"
+    if (rc == DYAD_RC_OK && (ctx && ctx->check))
+        setenv (DYAD_CHECK_ENV, "ok", 1);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_cons_store (const dyad_ctx_t *restrict ctx,
+                                               const dyad_metadata_t *restrict mdata,
+                                               int fd,
+                                               const size_t data_len,
+                                               char *restrict file_data)
+{
+    dyad_rc_t rc = dyad_cons_make_dir (ctx, mdata);
+    if (DYAD_IS_ERROR (rc)) {
+        return rc;
+    }
+    return dyad_cons_write (ctx, mdata, fd, data_len, file_data);
+}
+
+/* Chunked streaming is only implemented by the Flux RPC DTL, whose
+ * responses can be received one at a time. Zero-copy receives also take
+ * this path, so that each response is released as soon as its data has
+ * reached the file. */
+DYAD_CORE_FUNC_MODS bool dyad_use_chunked_fetch (const dyad_ctx_t *restrict ctx)
+{
+    return (ctx->dtl_chunk_size > 0ul || ctx->dtl_zero_copy)
+           && ctx->dtl_handle->mode == DYAD_DTL_FLUX_RPC;
+}
+
+/* Fetch the file described by mdata in chunks of ctx->dtl_chunk_size bytes.
+ * Each chunk is written to fd as soon as it arrives, so that at most one
+ * chunk is held in memory and the write overlaps the remaining transfer.
+ * With a chunk size of 0, the module sends the file in a single response. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_get_data_chunked (const dyad_ctx_t *restrict ctx,
+                                                     const dyad_metadata_t *restrict mdata,
+                                                     int fd,
+                                                     size_t *restrict file_len)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_INT ("chunk_size", ctx->dtl_chunk_size);
+    dyad_rc_t rc = DYAD_RC_OK;
+    flux_future_t *f = NULL;
+    char *chunk = NULL;
+    size_t chunk_len = 0ul;
+    size_t num_chunks = 0ul;
+
+    *file_len = 0ul;
+    // Once for all the chunks
+    rc = dyad_cons_make_dir (ctx, mdata);
+    if (DYAD_IS_ERROR (rc)) {
+        goto get_chunked_done;
+    }
+    rc = dyad_send_fetch_rpc (ctx, mdata, ctx->dtl_chunk_size, 0, 0ul, 0ul, &f);
+    if (DYAD_IS_ERROR (rc)) {
+        goto get_chunked_done;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Establish DTL connection with DYAD module");
+    rc = ctx->dtl_handle->establish_connection (ctx);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx,
+                        "Cannot establish connection with DYAD module on broker "
+                        "%u.",
+                        mdata->owner_rank);
+        goto get_chunked_done;
+    }
+    // The module closes the stream with ENODATA after the last chunk,
+    // which the DTL reports as DYAD_RC_RPC_FINISHED
+    for (;;) {
+        chunk = NULL;
+        chunk_len = 0ul;
+        rc = ctx->dtl_handle->recv (ctx, (void **)&chunk, &chunk_len);
+        if (rc == DYAD_RC_RPC_FINISHED) {
+            break;
+        }
+        if (DYAD_IS_ERROR (rc)) {
+            DYAD_LOG_ERROR (ctx,
+                            "Cannot receive chunk %zu of %s from producer module.",
+                            num_chunks,
+                            mdata->fpath);
+            break;
+        }
+        rc = dyad_cons_write (ctx, mdata, fd, chunk_len, chunk);
+        ctx->dtl_handle->return_buffer (ctx, (void **)&chunk);
+        if (DYAD_IS_ERROR (rc)) {
+            break;
+        }
+        *file_len += chunk_len;
+        num_chunks++;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Close DTL connection with DYAD module");
+    ctx->dtl_handle->close_connection (ctx);
+    if (rc == DYAD_RC_RPC_FINISHED) {
+        rc = (num_chunks > 0ul) ? DYAD_RC_OK : DYAD_RC_BADRPC;
+    }
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD CLIENT: Received %zu bytes of %s in %zu chunks",
+                    *file_len,
+                    mdata->fpath,
+                    num_chunks);
+    DYAD_C_FUNCTION_UPDATE_INT ("file_len", *file_len);
+
+get_chunked_done:;
+    flux_future_destroy (f);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Open fname for writing and stream its contents into it. A partially
+ * received file is truncated so that it is not mistaken for a fetched one. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_chunked_to_file (const dyad_ctx_t *restrict ctx,
+                                                          const dyad_metadata_t *restrict mdata,
+                                                          const char *restrict fname,
+                                                          size_t *restrict data_len)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    int io_fd = open (fname, O_WRONLY);
+    DYAD_C_FUNCTION_UPDATE_INT ("io_fd", io_fd);
+    if (io_fd == -1) {
+        DYAD_LOG_ERROR (ctx, "Cannot open file (%s) in write mode for dyad_consume!\n", fname);
+        rc = DYAD_RC_BADFIO;
+        goto fetch_chunked_done;
+    }
+    rc = dyad_get_data_chunked (ctx, mdata, io_fd, data_len);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "dyad_get_data_chunked failed!\n");
+        if (ftruncate (io_fd, 0) != 0) {
+            DYAD_LOG_ERROR (ctx, "Cannot truncate partially fetched file (%s)!\n", fname);
+        }
+    }
+    if (close (io_fd) != 0) {
+        rc = DYAD_RC_BADFIO;
+    }
+
+fetch_chunked_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Write the data inlined in mdata to fname, without contacting the
+ * producer */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_inline_to_file (const dyad_ctx_t *restrict ctx,
+                                                   const dyad_metadata_t *restrict mdata,
+                                                   const char *restrict fname,
+                                                   size_t *restrict data_len)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    int io_fd = open (fname, O_WRONLY);
+    *data_len = 0ul;
+    if (io_fd == -1) {
+        DYAD_LOG_ERROR (ctx, "Cannot open file (%s) in write mode for dyad_consume!\n", fname);
+        rc = DYAD_RC_BADFIO;
+        goto inline_to_file_done;
+    }
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD CLIENT: Storing the %zu inlined bytes of %s",
+                    mdata->inline_len,
+                    fname);
+    if (write_all (io_fd, mdata->inline_data, mdata->inline_len) != (ssize_t)mdata->inline_len) {
+        DYAD_LOG_ERROR (ctx,
+                        "DYAD CLIENT: Failed to write file \"%s\": %s",
+                        fname,
+                        strerror (errno));
+        rc = DYAD_RC_BADFIO;
+        if (ftruncate (io_fd, 0) != 0) {
+            DYAD_LOG_ERROR (ctx, "Cannot truncate partially written file (%s)!\n", fname);
+        }
+    } else {
+        *data_len = mdata->inline_len;
+    }
+    if (close (io_fd) != 0) {
+        rc = DYAD_RC_BADFIO;
+    }
+    if (rc == DYAD_RC_OK && ctx->check) {
+        setenv (DYAD_CHECK_ENV, "ok", 1);
+    }
+
+inline_to_file_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_produce (dyad_ctx_t *restrict ctx, const char *restrict fname)
 {
     DYAD_C_FUNCTION_START ();
     ctx->fname = fname;
@@ -594,6 +2034,70 @@ produce_done:;
     return rc;
 }
 
+/* Compute the path of fname relative to the consumer-managed directory */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_cons_upath (const dyad_ctx_t *restrict ctx,
+                                               const char *restrict fname,
+                                               char *restrict upath)
+{
+    const size_t fname_len = strlen (fname);
+
+    if (fname_len == 0ul) {
+        DYAD_LOG_ERROR (ctx, "Filename length is zero");
+        return DYAD_RC_BADFIO;
+    }
+    if (ctx->relative_to_managed_path
+        && (strncmp (fname, DYAD_PATH_DELIM, ctx->delim_len)
+            != 0)) {  // fname is a relative path that is relative to the
+                      // cons_managed_path
+        memcpy (upath, fname, fname_len);
+    } else if (!cmp_canonical_path_prefix (ctx, false, fname, upath, PATH_MAX)) {
+        // Extract the path to the file specified by fname relative to the
+        // producer-managed path
+        // This relative path will be stored in upath
+        // DYAD_LOG_TRACE (ctx, "%s is not in the Consumer's managed path\n",
+        // fname);
+        // NOTE: This is different from what dyad_fetch/commit returns,
+        // which is DYAD_RC_OK such that dyad does not interfere accesses on
+        // non-managed directories.
+        return DYAD_RC_UNTRACKED;
+    }
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD CLIENT: Obtaining file path relative to consumer directory: %s",
+                    upath);
+    return DYAD_RC_OK;
+}
+
+/* Fill in *mdata, allocating it if needed */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fill_metadata (const dyad_ctx_t *restrict ctx,
+                                                  const char *restrict fpath,
+                                                  uint32_t owner_rank,
+                                                  dyad_metadata_t **restrict mdata)
+{
+    const size_t fpath_len = strlen (fpath);
+    if (*mdata != NULL) {
+        DYAD_LOG_DEBUG (ctx,
+                        "DYAD CLIENT: Metadata object is already allocated. Skipping "
+                        "allocation");
+    } else {
+        *mdata = (dyad_metadata_t *)malloc (sizeof (struct dyad_metadata));
+        if (*mdata == NULL) {
+            DYAD_LOG_ERROR (ctx, "Cannot allocate memory for metadata object");
+            return DYAD_RC_SYSFAIL;
+        }
+    }
+    (*mdata)->inline_data = NULL;
+    (*mdata)->inline_len = 0ul;
+    (*mdata)->fpath = (char *)malloc (fpath_len + 1);
+    if ((*mdata)->fpath == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate memory for fpath in metadata object");
+        return DYAD_RC_SYSFAIL;
+    }
+    memset ((*mdata)->fpath, '\0', fpath_len + 1);
+    memcpy ((*mdata)->fpath, fpath, fpath_len);
+    (*mdata)->owner_rank = owner_rank;
+    return DYAD_RC_OK;
+}
+
 /** This function is coupled with Python API. This populates `mdata' which
  * is used by `dyad_consume_w_metadata ()'
  */
@@ -613,106 +2117,410 @@ dyad_rc_t dyad_get_metadata (dyad_ctx_t *restrict ctx,
         goto get_metadata_done;
     }
 #endif
-    const size_t fname_len = strlen (fname);
     char upath[PATH_MAX + 1] = {'\0'};
 
-    if (fname_len == 0ul) {
-        rc = DYAD_RC_BADFIO;
-        DYAD_LOG_ERROR (ctx, "Filename length is zero");
+    rc = dyad_cons_upath (ctx, fname, upath);
+    if (rc != DYAD_RC_OK) {
         goto get_metadata_done;
     }
-    if (ctx->relative_to_managed_path
-        && (strncmp (fname, DYAD_PATH_DELIM, ctx->delim_len)
-            != 0)) {  // fname is a relative path that is relative to the
-                      // cons_managed_path
-        memcpy (upath, fname, fname_len);
-    } else if (!cmp_canonical_path_prefix (ctx, false, fname, upath, PATH_MAX)) {
-        // Extract the path to the file specified by fname relative to the
-        // producer-managed path
-        // This relative path will be stored in upath
-        // DYAD_LOG_TRACE (ctx, "%s is not in the Consumer's managed path\n",
-        // fname);
-        // NOTE: This is different from what dyad_fetch/commit returns,
-        // which is DYAD_RC_OK such that dyad does not interfere accesses on
-        // non-managed directories.
-        rc = DYAD_RC_UNTRACKED;
+    ctx->reenter = false;
+    DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
+
+    // check if file exist locally, if so skip kvs
+    int fd = open (fname, O_RDONLY);
+    if (fd != -1) {
+        close (fd);
+        if (mdata == NULL) {
+            DYAD_LOG_ERROR (ctx,
+                            "Metadata double pointer is NULL. "
+                            "Cannot correctly create metadata object");
+            rc = DYAD_RC_NOTFOUND;
+            goto get_metadata_done;
+        }
+        rc = dyad_fill_metadata (ctx, fname, ctx->rank, mdata);
         goto get_metadata_done;
     }
-    DYAD_LOG_DEBUG (ctx,
-                    "DYAD CLIENT: Obtaining file path relative to consumer directory: %s",
-                    upath);
+
+    const size_t topic_len = PATH_MAX;
+    char topic[PATH_MAX + 1] = {'\0'};
+    DYAD_LOG_INFO (ctx, "Generating KVS key: %s", topic);
+    gen_path_key (upath, topic, topic_len, ctx->key_depth, ctx->key_bins);
+    rc = dyad_kvs_read (ctx, topic, upath, should_wait, mdata);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "Could not read data from the KVS");
+        goto get_metadata_done;
+    }
+    rc = DYAD_RC_OK;
+
+get_metadata_done:;
+    if (DYAD_IS_ERROR (rc) && mdata != NULL && *mdata != NULL) {
+        dyad_free_metadata (mdata);
+    }
+    ctx->reenter = true;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_get_metadata_batch (dyad_ctx_t *restrict ctx,
+                                   const char *const *restrict fnames,
+                                   size_t n,
+                                   bool should_wait,
+                                   dyad_metadata_t **restrict mdata)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_INT ("n", n);
+    DYAD_C_FUNCTION_UPDATE_INT ("should_wait", should_wait);
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_rc_t file_rc = DYAD_RC_OK;
+    flux_future_t **futures = NULL;
+    char (*upaths)[PATH_MAX + 1] = NULL;
+    char topic[PATH_MAX + 1] = {'\0'};
+    int kvs_lookup_flags = should_wait ? FLUX_KVS_WAITCREATE : 0;
+    size_t i = 0ul;
+
+    if (n == 0ul) {
+        goto get_metadata_batch_done;
+    }
+    if (fnames == NULL || mdata == NULL) {
+        DYAD_LOG_ERROR (ctx, "File name or metadata array is NULL");
+        rc = DYAD_RC_NOTFOUND;
+        goto get_metadata_batch_done;
+    }
+    futures = (flux_future_t **)calloc (n, sizeof (flux_future_t *));
+    upaths = (char (*)[PATH_MAX + 1]) calloc (n, sizeof (*upaths));
+    if (futures == NULL || upaths == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate memory for a batch of %zu lookups", n);
+        rc = DYAD_RC_SYSFAIL;
+        goto get_metadata_batch_done;
+    }
     ctx->reenter = false;
+
+    // Issue all the lookups first, so that the KVS works on them
+    // concurrently and the batch costs about one round trip
+    for (i = 0ul; i < n; i++) {
+        mdata[i] = NULL;
+        file_rc = dyad_cons_upath (ctx, fnames[i], upaths[i]);
+        if (file_rc != DYAD_RC_OK) {
+            rc = file_rc;
+            continue;
+        }
+        // check if file exist locally, if so skip kvs
+        int fd = open (fnames[i], O_RDONLY);
+        if (fd != -1) {
+            close (fd);
+            file_rc = dyad_fill_metadata (ctx, fnames[i], ctx->rank, &mdata[i]);
+            if (DYAD_IS_ERROR (file_rc)) {
+                dyad_free_metadata (&mdata[i]);
+                rc = file_rc;
+            }
+            continue;
+        }
+        bool cached_found = false;
+        uint32_t cached_rank = 0u;
+        if (dyad_mdata_cache_lookup (ctx->mdata_cache, upaths[i], &cached_found, &cached_rank) == 1
+            && (cached_found || !should_wait)) {
+            file_rc = cached_found ? dyad_fill_metadata (ctx, upaths[i], cached_rank, &mdata[i])
+                                   : DYAD_RC_NOTFOUND;
+            if (DYAD_IS_ERROR (file_rc)) {
+                dyad_free_metadata (&mdata[i]);
+                rc = file_rc;
+            }
+            continue;
+        }
+        memset (topic, '\0', PATH_MAX + 1);
+        gen_path_key (upaths[i], topic, PATH_MAX, ctx->key_depth, ctx->key_bins);
+        futures[i] =
+            flux_kvs_lookup ((flux_t *)ctx->h, ctx->kvs_namespace, kvs_lookup_flags, topic);
+        if (futures[i] == NULL) {
+            DYAD_LOG_ERROR (ctx, "KVS lookup failed for %s!", upaths[i]);
+            rc = DYAD_RC_NOTFOUND;
+        }
+    }
+
+    // Then collect the responses in order
+    for (i = 0ul; i < n; i++) {
+        uint32_t owner_rank = 0u;
+        char *inline_data = NULL;
+        size_t inline_len = 0ul;
+        if (futures[i] == NULL) {
+            continue;
+        }
+        if (dyad_kvs_get_entry (futures[i], &owner_rank, &inline_data, &inline_len) < 0) {
+            if (errno == ENOENT && !should_wait) {
+                dyad_mdata_cache_insert (ctx->mdata_cache, upaths[i], false, 0u);
+            }
+            DYAD_LOG_ERROR (ctx,
+                            "Could not unpack owner's rank of %s from KVS response",
+                            upaths[i]);
+            rc = DYAD_RC_BADMETADATA;
+        } else {
+            dyad_mdata_cache_insert (ctx->mdata_cache, upaths[i], true, owner_rank);
+            file_rc = dyad_fill_metadata (ctx, upaths[i], owner_rank, &mdata[i]);
+            if (DYAD_IS_ERROR (file_rc)) {
+                free (inline_data);
+                dyad_free_metadata (&mdata[i]);
+                rc = file_rc;
+            } else {
+                mdata[i]->inline_data = inline_data;
+                mdata[i]->inline_len = inline_len;
+                print_mdata (ctx, mdata[i]);
+            }
+        }
+        flux_future_destroy (futures[i]);
+        futures[i] = NULL;
+    }
+    ctx->reenter = true;
+
+get_metadata_batch_done:;
+    free (futures);
+    free (upaths);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_free_metadata (dyad_metadata_t **mdata)
+{
+    DYAD_C_FUNCTION_START ();
+    if (mdata == NULL || *mdata == NULL) {
+        return DYAD_RC_OK;
+    }
+    if ((*mdata)->fpath != NULL)
+        free ((*mdata)->fpath);
+    free ((*mdata)->inline_data);
+    free (*mdata);
+    *mdata = NULL;
+    DYAD_C_FUNCTION_END ();
+    return DYAD_RC_OK;
+}
+
+/* Remove a fetched file to make room in the consumer-managed directory,
+ * unless a consumer holds a lock on it, i.e., is still fetching it.
+ * Processes that have the file open keep reading its data, since the
+ * space is only released on the last close. */
+static int dyad_cons_evict_file (const char *path, void *arg)
+{
+    const dyad_ctx_t *ctx = (const dyad_ctx_t *)arg;
+    struct flock lock;
+    int evicted = 1;
+    int fd = open (path, O_RDWR);
+    if (fd == -1) {
+        // Already removed by someone else
+        return (errno == ENOENT) ? 0 : 1;
+    }
+    memset (&lock, 0, sizeof (lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 0;
+    if (fcntl (fd, F_SETLK, &lock) == 0 && unlink (path) == 0) {
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Evicted %s from the consumer cache", path);
+        evicted = 0;
+    }
+    close (fd);  // Also releases the lock
+    return evicted;
+}
+
+/* Account for a use of fname in the consumer cache. A file that was just
+ * fetched counts against the byte budget, which may evict older files. */
+DYAD_CORE_FUNC_MODS void dyad_cons_cache_record (const dyad_ctx_t *restrict ctx,
+                                                 const char *restrict fname,
+                                                 bool fetched)
+{
+    char path[PATH_MAX + 1] = {'\0'};
+    struct stat st;
+    if (ctx->cons_cache == NULL || ctx->shared_storage || realpath (fname, path) == NULL) {
+        return;
+    }
+    if (!fetched) {
+        dyad_cons_cache_touch (ctx->cons_cache, path);
+        return;
+    }
+    if (stat (path, &st) != 0) {
+        return;
+    }
+    if (dyad_cons_cache_insert (ctx->cons_cache,
+                                path,
+                                (size_t)st.st_size,
+                                dyad_cons_evict_file,
+                                (void *)ctx)
+        < 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot add %s to the consumer cache", path);
+    }
+}
+
+/* Node-level fetch coordination. The DYAD module of the local broker picks
+ * one consumer of the node to fetch a file. The others wait for it and copy
+ * the file it stored instead of transferring it again. */
+DYAD_CORE_FUNC_MODS bool dyad_node_dedup_enabled (const dyad_ctx_t *restrict ctx)
+{
+    return ctx->node_dedup && !ctx->shared_storage;
+}
+
+/* Claim the fetch of upath for this consumer. On return, *leader tells
+ * whether this consumer has to fetch the file. Otherwise, path holds where
+ * another consumer of the node stored it. */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_node_claim (dyad_ctx_t *restrict ctx,
+                                               const char *restrict upath,
+                                               bool *restrict leader,
+                                               char *restrict path)
+{
+    DYAD_C_FUNCTION_START ();
     DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
+    dyad_rc_t rc = DYAD_RC_OK;
+    flux_future_t *f = NULL;
+    int is_leader = 0;
+    const char *leader_path = NULL;
+
+    *leader = false;
+    path[0] = '\0';
+    f = flux_rpc_pack ((flux_t *)ctx->h,
+                       DYAD_CLAIM_RPC_NAME,
+                       ctx->rank,
+                       0,
+                       "{s:s}",
+                       "upath",
+                       upath);
+    if (f == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot send %s request for %s", DYAD_CLAIM_RPC_NAME, upath);
+        rc = DYAD_RC_BADRPC;
+        goto node_claim_done;
+    }
+    // The module answers once the current leader of the fetch, if any,
+    // is done
+    if (flux_rpc_get_unpack (f, "{s:b s:s}", "leader", &is_leader, "path", &leader_path) < 0) {
+        if (errno == ENOSYS) {
+            DYAD_LOG_INFO (ctx,
+                           "No DYAD module on broker %u. Disabling node-level fetch "
+                           "coordination",
+                           ctx->rank);
+            ctx->node_dedup = false;
+        } else {
+            DYAD_LOG_DEBUG (ctx,
+                            "%s failed for %s: %s",
+                            DYAD_CLAIM_RPC_NAME,
+                            upath,
+                            strerror (errno));
+        }
+        rc = DYAD_RC_BADRPC;
+        goto node_claim_done;
+    }
+    *leader = (is_leader != 0);
+    if (!*leader) {
+        strncpy (path, leader_path, PATH_MAX);
+        path[PATH_MAX] = '\0';
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: %s was fetched to %s on this node", upath, path);
+    }
+
+node_claim_done:;
+    flux_future_destroy (f);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Report the outcome of a fetch this consumer led, so that the consumers
+ * waiting for it can proceed. On failure, one of them takes over. */
+DYAD_CORE_FUNC_MODS void dyad_node_complete (dyad_ctx_t *restrict ctx,
+                                             const char *restrict upath,
+                                             const char *restrict fname,
+                                             dyad_rc_t fetch_rc)
+{
+    char path[PATH_MAX + 1] = {'\0'};
+    int errnum = 0;
+    flux_future_t *f = NULL;
+
+    if (DYAD_IS_ERROR (fetch_rc)) {
+        errnum = EIO;
+    } else if (realpath (fname, path) == NULL) {
+        errnum = errno;
+    }
+    f = flux_rpc_pack ((flux_t *)ctx->h,
+                       DYAD_COMPLETE_RPC_NAME,
+                       ctx->rank,
+                       FLUX_RPC_NORESPONSE,
+                       "{s:s s:s s:i}",
+                       "upath",
+                       upath,
+                       "path",
+                       path,
+                       "errnum",
+                       errnum);
+    if (f == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot send %s request for %s", DYAD_COMPLETE_RPC_NAME, upath);
+        return;
+    }
+    flux_future_destroy (f);
+}
 
-    // check if file exist locally, if so skip kvs
-    int fd = open (fname, O_RDONLY);
-    if (fd != -1) {
-        close (fd);
-        if (mdata == NULL) {
-            DYAD_LOG_ERROR (ctx,
-                            "Metadata double pointer is NULL. "
-                            "Cannot correctly create metadata object");
-            rc = DYAD_RC_NOTFOUND;
-            goto get_metadata_done;
+/* Copy the file at src, stored by another consumer of the node, into the
+ * empty file open at dst_fd */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_node_copy (const dyad_ctx_t *restrict ctx,
+                                              const char *restrict src,
+                                              int dst_fd,
+                                              size_t *restrict data_len)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("src", src);
+    dyad_rc_t rc = DYAD_RC_OK;
+    struct stat src_st, dst_st;
+    const size_t buf_size = 1ul << 20;
+    char *buf = NULL;
+    ssize_t nread = 0l;
+    int src_fd = open (src, O_RDONLY);
+
+    *data_len = 0ul;
+    if (src_fd == -1 || fstat (src_fd, &src_st) != 0 || fstat (dst_fd, &dst_st) != 0) {
+        rc = DYAD_RC_BADFIO;
+        goto node_copy_done;
+    }
+    // The other consumer wrote into this very file, which is still empty
+    if (src_st.st_dev == dst_st.st_dev && src_st.st_ino == dst_st.st_ino) {
+        rc = DYAD_RC_BADFIO;
+        goto node_copy_done;
+    }
+    // Let the kernel copy what it can. Plain reads and writes finish the
+    // rest if it cannot copy between these files.
+    if (!ctx->posix_io) {
+        nread = copy_range (src_fd, 0, dst_fd, NULL, (size_t)src_st.st_size);
+        if (nread > 0l) {
+            *data_len = (size_t)nread;
         }
-        if (*mdata != NULL) {
-            DYAD_LOG_DEBUG (ctx,
-                            "DYAD CLIENT: Metadata object is already allocated. Skipping "
-                            "allocation");
-        } else {
-            *mdata = (dyad_metadata_t *)malloc (sizeof (struct dyad_metadata));
-            if (*mdata == NULL) {
-                DYAD_LOG_ERROR (ctx, "Cannot allocate memory for metadata object");
-                rc = DYAD_RC_SYSFAIL;
-                goto get_metadata_done;
-            }
+        if (nread < 0l || (off_t)*data_len == src_st.st_size
+            || lseek (src_fd, (off_t)*data_len, SEEK_SET) < 0) {
+            goto node_copy_check;
         }
-        (*mdata)->fpath = (char *)malloc (fname_len + 1);
-        if ((*mdata)->fpath == NULL) {
-            DYAD_LOG_ERROR (ctx, "Cannot allocate memory for fpath in metadata object");
-            rc = DYAD_RC_SYSFAIL;
-            goto get_metadata_done;
+    }
+    buf = (char *)malloc (buf_size);
+    if (buf == NULL) {
+        rc = DYAD_RC_SYSFAIL;
+        goto node_copy_done;
+    }
+    while ((nread = read (src_fd, buf, buf_size)) > 0) {
+        if (write_all (dst_fd, buf, (size_t)nread) != nread) {
+            nread = -1l;
+            break;
         }
-        memset ((*mdata)->fpath, '\0', fname_len + 1);
-        memcpy ((*mdata)->fpath, fname, fname_len);
-        (*mdata)->owner_rank = ctx->rank;
-        rc = DYAD_RC_OK;
-        goto get_metadata_done;
+        *data_len += (size_t)nread;
     }
 
-    const size_t topic_len = PATH_MAX;
-    char topic[PATH_MAX + 1] = {'\0'};
-    DYAD_LOG_INFO (ctx, "Generating KVS key: %s", topic);
-    gen_path_key (upath, topic, topic_len, ctx->key_depth, ctx->key_bins);
-    rc = dyad_kvs_read (ctx, topic, upath, should_wait, mdata);
-    if (DYAD_IS_ERROR (rc)) {
-        DYAD_LOG_ERROR (ctx, "Could not read data from the KVS");
-        goto get_metadata_done;
+node_copy_check:;
+    if (nread < 0l || (off_t)*data_len != src_st.st_size) {
+        DYAD_LOG_ERROR (ctx, "Cannot copy %s: %s", src, strerror (errno));
+        rc = DYAD_RC_BADFIO;
     }
-    rc = DYAD_RC_OK;
 
-get_metadata_done:;
-    if (DYAD_IS_ERROR (rc) && mdata != NULL && *mdata != NULL) {
-        dyad_free_metadata (mdata);
+node_copy_done:;
+    if (DYAD_IS_ERROR (rc) && *data_len > 0ul && ftruncate (dst_fd, 0) != 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot discard a partial copy of %s", src);
+    }
+    free (buf);
+    if (src_fd != -1) {
+        close (src_fd);
     }
-    ctx->reenter = true;
     DYAD_C_FUNCTION_END ();
     return rc;
 }
 
-dyad_rc_t dyad_free_metadata (dyad_metadata_t **mdata)
-{
-    DYAD_C_FUNCTION_START ();
-    if (mdata == NULL || *mdata == NULL) {
-        return DYAD_RC_OK;
-    }
-    if ((*mdata)->fpath != NULL)
-        free ((*mdata)->fpath);
-    free (*mdata);
-    *mdata = NULL;
-    DYAD_C_FUNCTION_END ();
-    return DYAD_RC_OK;
-}
+DYAD_CORE_FUNC_MODS void dyad_prefetch_claim (dyad_ctx_t *restrict ctx, const char *restrict upath);
 
 dyad_rc_t dyad_consume (dyad_ctx_t *restrict ctx, const char *restrict fname)
 {
@@ -726,6 +2534,8 @@ dyad_rc_t dyad_consume (dyad_ctx_t *restrict ctx, const char *restrict fname)
     dyad_metadata_t *mdata = NULL;
     struct flock exclusive_lock;
     char upath[PATH_MAX + 1] = {'\0'};
+    bool node_leader = false;
+    char node_path[PATH_MAX + 1] = {'\0'};
 
     // If the context is not defined, then it is not valid.
     // So, return DYAD_NOCTX
@@ -755,6 +2565,7 @@ dyad_rc_t dyad_consume (dyad_ctx_t *restrict ctx, const char *restrict fname)
         goto consume_close;
     }
     ctx->reenter = false;
+    dyad_prefetch_claim (ctx, upath);
 
     lock_fd = open (fname, O_RDWR | O_CREAT, 0666);
     if (lock_fd == -1) {
@@ -791,6 +2602,26 @@ dyad_rc_t dyad_consume (dyad_ctx_t *restrict ctx, const char *restrict fname)
                            ctx->pid,
                            fname,
                            lock_fd);
+            // Only a file this consumer really has to fetch is claimed
+            if (dyad_node_dedup_enabled (ctx)
+                && DYAD_IS_ERROR (dyad_node_claim (ctx, upath, &node_leader, node_path))) {
+                // Fetch the file independently of the other consumers of the node
+                node_leader = false;
+                node_path[0] = '\0';
+            }
+            if (node_path[0] != '\0') {
+                // Another consumer of this node already fetched the file
+                rc = dyad_node_copy (ctx, node_path, lock_fd, &data_len);
+                if (!DYAD_IS_ERROR (rc)) {
+                    dyad_release_flock (ctx, lock_fd, &exclusive_lock);
+                    DYAD_C_FUNCTION_UPDATE_INT ("data_len", data_len);
+                    goto consume_done;
+                }
+                DYAD_LOG_INFO (ctx,
+                               "Cannot copy %s from %s. Fetching it instead",
+                               fname,
+                               node_path);
+            }
             // Call dyad_fetch to get (and possibly wait on)
             // data from the Flux KVS
             rc = dyad_fetch_metadata (ctx, fname, upath, &mdata);
@@ -812,11 +2643,36 @@ dyad_rc_t dyad_consume (dyad_ctx_t *restrict ctx, const char *restrict fname)
                 goto consume_done;
             }
 
+            if (mdata->inline_data != NULL) {
+                // The producer published the file along with its metadata
+                rc = dyad_inline_to_file (ctx, mdata, fname, &data_len);
+                dyad_free_metadata (&mdata);
+                dyad_release_flock (ctx, lock_fd, &exclusive_lock);
+                DYAD_C_FUNCTION_UPDATE_INT ("data_len", data_len);
+                goto consume_done;
+            }
+            if (dyad_use_chunked_fetch (ctx)) {
+                // Stream the file straight into place chunk by chunk
+                rc = dyad_fetch_chunked_to_file (ctx, mdata, fname, &data_len);
+                if (DYAD_IS_ERROR (rc)) {
+                    // The cached owner may be stale
+                    dyad_mdata_cache_remove (ctx->mdata_cache, upath);
+                }
+                dyad_free_metadata (&mdata);
+                dyad_release_flock (ctx, lock_fd, &exclusive_lock);
+                DYAD_C_FUNCTION_UPDATE_INT ("data_len", data_len);
+                goto consume_done;
+            }
+            if (ctx->dtl_rpc_calibrate) {
+                dyad_dtl_rpc_calibrate (ctx, mdata);
+            }
             // Call dyad_get_data to dispatch a RPC to the producer's Flux broker
             // and retrieve the data associated with the file
             rc = dyad_get_data (ctx, mdata, &file_data, &data_len);
             if (DYAD_IS_ERROR (rc)) {
                 DYAD_LOG_ERROR (ctx, "dyad_get_data failed!\n");
+                // The cached owner may be stale
+                dyad_mdata_cache_remove (ctx->mdata_cache, upath);
                 dyad_release_flock (ctx, lock_fd, &exclusive_lock);
                 goto consume_done;
             }
@@ -828,6 +2684,7 @@ dyad_rc_t dyad_consume (dyad_ctx_t *restrict ctx, const char *restrict fname)
                                 "Cannot open file (%s) in write mode for dyad_consume!\n",
                                 fname);
                 rc = DYAD_RC_BADFIO;
+                ctx->dtl_handle->return_buffer (ctx, (void **)&file_data);
                 goto consume_close;
             }
             // Call dyad_pull to fetch the data from the producer's
@@ -858,11 +2715,17 @@ consume_done:;
     if (close (lock_fd) != 0) {
         rc = DYAD_RC_BADFIO;
     }
+    if (!DYAD_IS_ERROR (rc) && (data_len > 0ul || file_size > 0)) {
+        dyad_cons_cache_record (ctx, fname, data_len > 0ul);
+    }
     if (file_data != NULL) {
         ctx->dtl_handle->return_buffer (ctx, (void **)&file_data);
     }
     // Set reenter to true to allow additional intercepting
 consume_close:;
+    if (node_leader) {
+        dyad_node_complete (ctx, upath, fname, rc);
+    }
     ctx->reenter = true;
     DYAD_C_FUNCTION_END ();
     return rc;
@@ -923,11 +2786,34 @@ dyad_rc_t dyad_consume_w_metadata (dyad_ctx_t *restrict ctx,
                        fname,
                        lock_fd);
 
+        if (mdata->inline_data != NULL) {
+            // The producer published the file along with its metadata
+            rc = dyad_inline_to_file (ctx, mdata, fname, &data_len);
+            dyad_release_flock (ctx, lock_fd, &exclusive_lock);
+            close (lock_fd);
+            DYAD_C_FUNCTION_UPDATE_INT ("data_len", data_len);
+            goto consume_done;
+        }
+        if (dyad_use_chunked_fetch (ctx)) {
+            // Stream the file straight into place chunk by chunk
+            rc = dyad_fetch_chunked_to_file (ctx, mdata, fname, &data_len);
+            if (DYAD_IS_ERROR (rc)) {
+                dyad_mdata_cache_remove (ctx->mdata_cache, mdata->fpath);
+            }
+            dyad_release_flock (ctx, lock_fd, &exclusive_lock);
+            close (lock_fd);
+            DYAD_C_FUNCTION_UPDATE_INT ("data_len", data_len);
+            goto consume_done;
+        }
+        if (ctx->dtl_rpc_calibrate) {
+            dyad_dtl_rpc_calibrate (ctx, mdata);
+        }
         // Call dyad_get_data to dispatch a RPC to the producer's Flux broker
         // and retrieve the data associated with the file
         rc = dyad_get_data (ctx, mdata, &file_data, &data_len);
         if (DYAD_IS_ERROR (rc)) {
             DYAD_LOG_ERROR (ctx, "dyad_get_data failed!\n");
+            dyad_mdata_cache_remove (ctx->mdata_cache, mdata->fpath);
             dyad_release_flock (ctx, lock_fd, &exclusive_lock);
             goto consume_done;
         }
@@ -937,6 +2823,7 @@ dyad_rc_t dyad_consume_w_metadata (dyad_ctx_t *restrict ctx,
         if (io_fd == -1) {
             DYAD_LOG_ERROR (ctx, "Cannot open file (%s) in write mode for dyad_consume!\n", fname);
             rc = DYAD_RC_BADFIO;
+            ctx->dtl_handle->return_buffer (ctx, (void **)&file_data);
             goto consume_close;
         }
         // Call dyad_pull to fetch the data from the producer's
@@ -965,6 +2852,9 @@ dyad_rc_t dyad_consume_w_metadata (dyad_ctx_t *restrict ctx,
     }
     rc = DYAD_RC_OK;
 consume_done:;
+    if (!DYAD_IS_ERROR (rc) && (data_len > 0ul || file_size > 0)) {
+        dyad_cons_cache_record (ctx, fname, data_len > 0ul);
+    }
     if (file_data != NULL) {
         ctx->dtl_handle->return_buffer (ctx, (void **)&file_data);
     }
@@ -975,6 +2865,626 @@ consume_close:;
     return rc;
 }
 
+/* dyad.fetch_many frames are stored straight from the response payload,
+ * which only works with DTLs whose buffers are not backed by a file of
+ * their own (see dyad_cons_store) */
+DYAD_CORE_FUNC_MODS bool dyad_use_fetch_many (const dyad_ctx_t *restrict ctx)
+{
+    return ctx->dtl_handle->get_buffer_fd == NULL;
+}
+
+/* Store the data of a dyad.fetch_many frame into fname, unless another
+ * consumer got the file first */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_store_frame (dyad_ctx_t *restrict ctx,
+                                                const char *restrict fname,
+                                                const dyad_metadata_t *restrict mdata,
+                                                const char *restrict data,
+                                                size_t data_len)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("fname", fname);
+    dyad_rc_t rc = DYAD_RC_OK;
+    struct flock exclusive_lock;
+    bool stored = false;
+    int fd = open (fname, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        DYAD_LOG_ERROR (ctx, "Cannot create file (%s) for dyad_consume_many!\n", fname);
+        rc = DYAD_RC_BADFIO;
+        goto store_frame_done;
+    }
+    rc = dyad_excl_flock (ctx, fd, &exclusive_lock);
+    if (DYAD_IS_ERROR (rc)) {
+        dyad_release_flock (ctx, fd, &exclusive_lock);
+        close (fd);
+        goto store_frame_done;
+    }
+    if (get_file_size (fd) <= 0) {
+        rc = dyad_cons_store (ctx, mdata, fd, data_len, (char *)data);
+        if (DYAD_IS_ERROR (rc) && ftruncate (fd, 0) != 0) {
+            DYAD_LOG_ERROR (ctx, "Cannot truncate partially written file (%s)!\n", fname);
+        }
+        stored = !DYAD_IS_ERROR (rc);
+    }
+    dyad_release_flock (ctx, fd, &exclusive_lock);
+    if (close (fd) != 0) {
+        rc = DYAD_RC_BADFIO;
+    }
+    if (!DYAD_IS_ERROR (rc)) {
+        dyad_cons_cache_record (ctx, fname, stored);
+    }
+
+store_frame_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/**
+ * Fetch the files of mdata[first] and of every later file with the same
+ * owner that is not tried yet with a single dyad.fetch_many RPC, storing
+ * each file as soon as its frame arrives. Files whose frame carries no
+ * data (e.g., they are larger than max) are left for the caller. Every
+ * file in the request is marked in tried, and the stored ones in done.
+ */
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_fetch_many (dyad_ctx_t *restrict ctx,
+                                               const char *const *restrict fnames,
+                                               dyad_metadata_t **restrict mdata,
+                                               size_t first,
+                                               size_t n,
+                                               size_t max,
+                                               bool *restrict tried,
+                                               bool *restrict done)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    uint32_t owner_rank = mdata[first]->owner_rank;
+    json_t *upaths = json_array ();
+    size_t *members = (size_t *)malloc (n * sizeof (size_t));
+    size_t num_members = 0ul;
+    size_t num_stored = 0ul;
+    flux_future_t *f = NULL;
+    const void *payload = NULL;
+    size_t payload_len = 0ul;
+    dyad_fetch_frame_t frame;
+    const char *data = NULL;
+    size_t data_len = 0ul;
+    char *decoded = NULL;
+    bool compress = dyad_want_compress (ctx);
+    struct stat st;
+    size_t i = 0ul;
+
+    if (upaths == NULL || members == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate a request for %zu files", n);
+        json_decref (upaths);
+        rc = DYAD_RC_SYSFAIL;
+        goto fetch_many_done;
+    }
+    for (i = first; i < n; i++) {
+        if (tried[i] || mdata[i] == NULL || mdata[i]->owner_rank != owner_rank
+            || mdata[i]->inline_data != NULL) {
+            continue;
+        }
+        tried[i] = true;
+        // Files already in place are left for dyad_consume to check
+        if (stat (fnames[i], &st) == 0 && st.st_size > 0) {
+            continue;
+        }
+        dyad_prefetch_claim (ctx, mdata[i]->fpath);
+        if (json_array_append_new (upaths, json_string (mdata[i]->fpath)) < 0) {
+            json_decref (upaths);
+            rc = DYAD_RC_BADPACK;
+            goto fetch_many_done;
+        }
+        members[num_members++] = i;
+    }
+    if (num_members == 0ul) {
+        json_decref (upaths);
+        goto fetch_many_done;
+    }
+    DYAD_C_FUNCTION_UPDATE_INT ("num_files", num_members);
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD CLIENT: Fetching %zu files from broker %u in one request",
+                    num_members,
+                    owner_rank);
+    f = flux_rpc_pack ((flux_t *)ctx->h,
+                       DYAD_FETCH_MANY_RPC_NAME,
+                       owner_rank,
+                       FLUX_RPC_STREAMING,
+                       "{s:o s:I s:i}",
+                       "upaths",
+                       upaths,
+                       "max",
+                       (json_int_t)max,
+                       "compress",
+                       (int)(compress ? DYAD_CODEC_ZSTD : DYAD_CODEC_NONE));
+    if (f == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot send RPC to producer module.");
+        rc = DYAD_RC_BADRPC;
+        goto fetch_many_done;
+    }
+    // The module closes the stream with ENODATA after the last frame
+    for (;;) {
+        if (flux_rpc_get_raw (f, &payload, &payload_len) < 0) {
+            if (errno != ENODATA) {
+                DYAD_LOG_ERROR (ctx,
+                                "Cannot receive files from the module on broker %u "
+                                "(errno = %d)",
+                                owner_rank,
+                                errno);
+                rc = DYAD_RC_BADRPC;
+            }
+            break;
+        }
+        if (payload_len < sizeof (frame)) {
+            rc = DYAD_RC_BADRPC;
+            break;
+        }
+        memcpy (&frame, payload, sizeof (frame));
+        if (frame.index >= num_members || payload_len - sizeof (frame) != frame.len) {
+            DYAD_LOG_ERROR (ctx, "Malformed frame from the module on broker %u", owner_rank);
+            rc = DYAD_RC_BADRPC;
+            break;
+        }
+        i = members[frame.index];
+        data = (const char *)payload + sizeof (frame);
+        data_len = (size_t)frame.len;
+        if (frame.errnum == 0 && compress
+            && DYAD_IS_ERROR (
+                dyad_decode_payload (ctx, data, data_len, &data, &data_len, &decoded))) {
+            // Left for the caller, like any file that is not stored
+            DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Cannot decode the frame of %s", mdata[i]->fpath);
+        } else if (frame.errnum == 0
+                   && !DYAD_IS_ERROR (
+                       dyad_store_frame (ctx, fnames[i], mdata[i], data, data_len))) {
+            done[i] = true;
+            num_stored++;
+        } else if (frame.errnum != 0) {
+            DYAD_LOG_DEBUG (ctx,
+                            "DYAD CLIENT: %s is not in its frame (errno = %d)",
+                            mdata[i]->fpath,
+                            frame.errnum);
+        }
+        free (decoded);
+        decoded = NULL;
+        flux_future_reset (f);
+    }
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD CLIENT: Stored %zu of %zu files from broker %u",
+                    num_stored,
+                    num_members,
+                    owner_rank);
+
+fetch_many_done:;
+    flux_future_destroy (f);
+    free (members);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_consume_many (dyad_ctx_t *restrict ctx, const char *const *restrict fnames, size_t n)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_INT ("n", n);
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_rc_t file_rc = DYAD_RC_OK;
+    dyad_metadata_t **mdata = NULL;
+    bool *tried = NULL;
+    bool *done = NULL;
+    size_t max = 0ul;
+    size_t i = 0ul;
+
+    if (!ctx || !ctx->h) {
+        rc = DYAD_RC_NOCTX;
+        goto consume_many_done;
+    }
+    if (ctx->cons_managed_path == NULL) {
+        rc = DYAD_RC_BADMANAGEDPATH;
+        goto consume_many_done;
+    }
+    if (n == 0ul) {
+        goto consume_many_done;
+    }
+    mdata = (dyad_metadata_t **)calloc (n, sizeof (dyad_metadata_t *));
+    tried = (bool *)calloc (n, sizeof (bool));
+    done = (bool *)calloc (n, sizeof (bool));
+    if (mdata == NULL || tried == NULL || done == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate the state of %zu files", n);
+        rc = DYAD_RC_SYSFAIL;
+        goto consume_many_done;
+    }
+    // The owners of all the files in about one KVS round trip. Files left
+    // without metadata are handed over to dyad_consume below.
+    dyad_get_metadata_batch (ctx, fnames, n, true, mdata);
+    for (i = 0ul; i < n; i++) {
+        if (mdata[i] != NULL
+            && (ctx->shared_storage
+                || dyad_owner_is_local (ctx, mdata[i]->owner_rank))) {
+            // Nothing to transfer, as in dyad_fetch_metadata
+            dyad_free_metadata (&mdata[i]);
+        }
+    }
+
+    if (dyad_use_fetch_many (ctx) && !ctx->shared_storage) {
+        ctx->reenter = false;
+        for (i = 0ul; i < n; i++) {
+            if (tried[i] || mdata[i] == NULL || mdata[i]->inline_data != NULL) {
+                continue;
+            }
+            if (ctx->dtl_rpc_calibrate) {
+                dyad_dtl_rpc_calibrate (ctx, mdata[i]);
+            }
+            // The module reads the files of a request on its reactor, so
+            // large files are better off sent by the DTL, which can stream
+            // them or hand them to I/O workers
+            max = (ctx->dtl_rpc_max > 0ul) ? ctx->dtl_rpc_max : DYAD_DTL_RPC_MAX_DEFAULT;
+            file_rc = dyad_fetch_many (ctx, fnames, mdata, i, n, max, tried, done);
+            if (DYAD_IS_ERROR (file_rc)) {
+                DYAD_LOG_INFO (ctx,
+                               "Cannot fetch the files of broker %u at once (rc = %d). Fetching "
+                               "them one by one",
+                               mdata[i]->owner_rank,
+                               file_rc);
+            }
+        }
+        ctx->reenter = true;
+    }
+
+    // Everything that did not come in a frame: local, inlined, too large
+    // files and failures
+    for (i = 0ul; i < n; i++) {
+        if (done[i]) {
+            continue;
+        }
+        file_rc = (mdata[i] != NULL) ? dyad_consume_w_metadata (ctx, fnames[i], mdata[i])
+                                     : dyad_consume (ctx, fnames[i]);
+        if (DYAD_IS_ERROR (file_rc)) {
+            rc = file_rc;
+        }
+    }
+
+consume_many_done:;
+    if (mdata != NULL) {
+        for (i = 0ul; i < n; i++) {
+            dyad_free_metadata (&mdata[i]);
+        }
+    }
+    free (mdata);
+    free (tried);
+    free (done);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Background prefetching. A worker thread consumes the queued files with a
+ * DYAD context of its own, since contexts are per thread and a Flux handle
+ * must not be shared between threads. fcntl locks do not exclude threads
+ * of the same process, so dyad_consume coordinates with the worker through
+ * dyad_prefetch_claim instead. */
+struct dyad_prefetch_item {
+    char *fname;
+    char upath[PATH_MAX + 1];
+    struct dyad_prefetch_item *next;
+};
+
+struct dyad_prefetcher {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;       // Signaled on new work and on shutdown
+    pthread_cond_t done_cond;  // Signaled whenever the worker is done with a file
+    struct dyad_prefetch_item *head;
+    struct dyad_prefetch_item *tail;
+    struct dyad_prefetch_item *current;  // File being consumed by the worker
+    bool shutdown;
+    // Snapshot of the consumer's configuration for the worker's context
+    bool debug;
+    bool check;
+    bool shared_storage;
+    bool fsync_write;
+    unsigned int key_depth;
+    unsigned int key_bins;
+    unsigned int service_mux;
+    char *kvs_namespace;
+    char *cons_managed_path;
+    bool relative_to_managed_path;
+    dyad_dtl_mode_t dtl_mode;
+    size_t dtl_chunk_size;
+    bool dtl_zero_copy;
+    bool node_dedup;
+    void *cons_cache;
+    bool posix_io;
+    unsigned int uring_depth;
+    size_t uring_direct_min;
+    size_t dtl_rpc_max;
+    bool dtl_rpc_calibrate;
+    int compress_level;
+};
+
+static void *dyad_prefetch_worker (void *arg)
+{
+    struct dyad_prefetcher *p = (struct dyad_prefetcher *)arg;
+    struct dyad_prefetch_item *item = NULL;
+    dyad_ctx_t *wctx = NULL;
+    dyad_rc_t rc = dyad_init (p->debug,
+                              p->check,
+                              p->shared_storage,
+                              false,  // reinit
+                              false,  // async_publish
+                              p->fsync_write,
+                              p->key_depth,
+                              p->key_bins,
+                              p->service_mux,
+                              p->kvs_namespace,
+                              NULL,  // prod_managed_path
+                              p->cons_managed_path,
+                              p->relative_to_managed_path,
+                              dyad_dtl_mode_name[p->dtl_mode],
+                              DYAD_COMM_RECV,
+                              NULL);
+    wctx = dyad_ctx_get ();
+    if (DYAD_IS_ERROR (rc) || wctx == NULL || wctx->h == NULL) {
+        DYAD_LOG_STDERR ("DYAD CLIENT: Cannot initialize the prefetch context. "
+                         "Queued files will be fetched on open.\n");
+        wctx = NULL;
+    } else {
+        wctx->dtl_chunk_size = p->dtl_chunk_size;
+        wctx->dtl_zero_copy = p->dtl_zero_copy;
+        wctx->node_dedup = p->node_dedup;
+        wctx->posix_io = p->posix_io;
+        // io_uring instances cannot be shared between threads
+        wctx->uring_depth = p->uring_depth;
+        wctx->uring_direct_min = p->uring_direct_min;
+        if (p->uring_depth > 0u && dyad_uring_init (p->uring_depth, &wctx->uring) < 0)
+            wctx->uring = NULL;
+        wctx->dtl_rpc_max = p->dtl_rpc_max;
+        wctx->dtl_rpc_calibrate = p->dtl_rpc_calibrate;
+        wctx->compress_level = p->compress_level;
+        // Prefetched files count against the consumer's budget
+        wctx->cons_cache = p->cons_cache;
+    }
+
+    pthread_mutex_lock (&p->lock);
+    for (;;) {
+        while (p->head == NULL && !p->shutdown)
+            pthread_cond_wait (&p->cond, &p->lock);
+        if (p->shutdown)
+            break;
+        item = p->head;
+        p->head = item->next;
+        if (p->head == NULL)
+            p->tail = NULL;
+        p->current = item;
+        pthread_mutex_unlock (&p->lock);
+
+        if (wctx != NULL) {
+            rc = dyad_consume (wctx, item->fname);
+            if (DYAD_IS_ERROR (rc)) {
+                DYAD_LOG_ERROR (wctx, "DYAD CLIENT: Cannot prefetch %s (rc = %d)", item->fname, rc);
+            }
+        }
+
+        pthread_mutex_lock (&p->lock);
+        p->current = NULL;
+        pthread_cond_broadcast (&p->done_cond);
+        free (item->fname);
+        free (item);
+    }
+    pthread_mutex_unlock (&p->lock);
+    if (wctx != NULL) {
+        // The cache belongs to the consumer's context
+        wctx->cons_cache = NULL;
+        dyad_finalize ();
+    }
+    return NULL;
+}
+
+/* Stop the worker once it is done with its current file and drop the
+ * files that are still queued. Called by dyad_finalize. */
+static void dyad_prefetch_fini (void *arg)
+{
+    struct dyad_prefetcher *p = (struct dyad_prefetcher *)arg;
+    struct dyad_prefetch_item *item = NULL;
+    struct dyad_prefetch_item *next = NULL;
+    if (p == NULL)
+        return;
+    pthread_mutex_lock (&p->lock);
+    p->shutdown = true;
+    pthread_cond_broadcast (&p->cond);
+    pthread_mutex_unlock (&p->lock);
+    pthread_join (p->thread, NULL);
+    for (item = p->head; item != NULL; item = next) {
+        next = item->next;
+        free (item->fname);
+        free (item);
+    }
+    pthread_cond_destroy (&p->done_cond);
+    pthread_cond_destroy (&p->cond);
+    pthread_mutex_destroy (&p->lock);
+    free (p->kvs_namespace);
+    free (p->cons_managed_path);
+    free (p);
+}
+
+DYAD_CORE_FUNC_MODS dyad_rc_t dyad_prefetch_start (dyad_ctx_t *restrict ctx)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    struct dyad_prefetcher *p = (struct dyad_prefetcher *)calloc (1, sizeof (*p));
+    if (p == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate the prefetch state");
+        return DYAD_RC_SYSFAIL;
+    }
+    p->debug = ctx->debug;
+    p->check = ctx->check;
+    p->shared_storage = ctx->shared_storage;
+    p->fsync_write = ctx->fsync_write;
+    p->key_depth = ctx->key_depth;
+    p->key_bins = ctx->key_bins;
+    p->service_mux = ctx->service_mux;
+    p->kvs_namespace = (ctx->kvs_namespace != NULL) ? strdup (ctx->kvs_namespace) : NULL;
+    p->cons_managed_path = strdup (ctx->cons_managed_path);
+    p->relative_to_managed_path = ctx->relative_to_managed_path;
+    p->dtl_mode = ctx->dtl_handle->mode;
+    p->dtl_chunk_size = ctx->dtl_chunk_size;
+    p->dtl_zero_copy = ctx->dtl_zero_copy;
+    p->node_dedup = ctx->node_dedup;
+    p->cons_cache = ctx->cons_cache;
+    p->posix_io = ctx->posix_io;
+    p->uring_depth = ctx->uring_depth;
+    p->uring_direct_min = ctx->uring_direct_min;
+    p->dtl_rpc_max = ctx->dtl_rpc_max;
+    p->dtl_rpc_calibrate = ctx->dtl_rpc_calibrate;
+    p->compress_level = ctx->compress_level;
+    if (p->cons_managed_path == NULL
+        || (ctx->kvs_namespace != NULL && p->kvs_namespace == NULL)) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate the prefetch state");
+        rc = DYAD_RC_SYSFAIL;
+        goto prefetch_start_failed;
+    }
+    pthread_mutex_init (&p->lock, NULL);
+    pthread_cond_init (&p->cond, NULL);
+    pthread_cond_init (&p->done_cond, NULL);
+    if (pthread_create (&p->thread, NULL, dyad_prefetch_worker, p) != 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot start the prefetch thread");
+        pthread_cond_destroy (&p->done_cond);
+        pthread_cond_destroy (&p->cond);
+        pthread_mutex_destroy (&p->lock);
+        rc = DYAD_RC_SYSFAIL;
+        goto prefetch_start_failed;
+    }
+    ctx->prefetcher = p;
+    ctx->prefetcher_fini = dyad_prefetch_fini;
+    return DYAD_RC_OK;
+
+prefetch_start_failed:;
+    free (p->kvs_namespace);
+    free (p->cons_managed_path);
+    free (p);
+    return rc;
+}
+
+/* Make sure the prefetch worker is not and will not be working on upath.
+ * A queued file is taken off the queue, and a file being fetched is waited
+ * for, so that the caller finds it complete. */
+DYAD_CORE_FUNC_MODS void dyad_prefetch_claim (dyad_ctx_t *restrict ctx, const char *restrict upath)
+{
+    struct dyad_prefetcher *p = (struct dyad_prefetcher *)ctx->prefetcher;
+    struct dyad_prefetch_item *item = NULL;
+    struct dyad_prefetch_item *prev = NULL;
+    if (p == NULL)
+        return;
+    pthread_mutex_lock (&p->lock);
+    for (item = p->head; item != NULL; prev = item, item = item->next) {
+        if (strcmp (item->upath, upath) == 0) {
+            if (prev == NULL)
+                p->head = item->next;
+            else
+                prev->next = item->next;
+            if (p->tail == item)
+                p->tail = prev;
+            free (item->fname);
+            free (item);
+            break;
+        }
+    }
+    while (p->current != NULL && strcmp (p->current->upath, upath) == 0) {
+        DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Waiting for the prefetch of %s", upath);
+        pthread_cond_wait (&p->done_cond, &p->lock);
+    }
+    pthread_mutex_unlock (&p->lock);
+}
+
+dyad_rc_t dyad_prefetch (dyad_ctx_t *restrict ctx, const char *restrict fname)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("fname", fname);
+    dyad_rc_t rc = DYAD_RC_OK;
+    struct dyad_prefetch_item *item = NULL;
+    struct dyad_prefetcher *p = NULL;
+
+    if (!ctx || !ctx->h) {
+        rc = DYAD_RC_NOCTX;
+        goto prefetch_done;
+    }
+    if (ctx->cons_managed_path == NULL) {
+        rc = DYAD_RC_BADMANAGEDPATH;
+        goto prefetch_done;
+    }
+    item = (struct dyad_prefetch_item *)calloc (1, sizeof (*item));
+    if (item == NULL) {
+        rc = DYAD_RC_SYSFAIL;
+        goto prefetch_done;
+    }
+    rc = dyad_cons_upath (ctx, fname, item->upath);
+    if (rc != DYAD_RC_OK) {
+        // Files outside of the managed directory are left alone, like
+        // dyad_consume does
+        free (item);
+        rc = (rc == DYAD_RC_UNTRACKED) ? DYAD_RC_OK : rc;
+        goto prefetch_done;
+    }
+    item->fname = strdup (fname);
+    if (item->fname == NULL) {
+        free (item);
+        rc = DYAD_RC_SYSFAIL;
+        goto prefetch_done;
+    }
+    if (ctx->prefetcher == NULL) {
+        rc = dyad_prefetch_start (ctx);
+        if (DYAD_IS_ERROR (rc)) {
+            free (item->fname);
+            free (item);
+            goto prefetch_done;
+        }
+    }
+    p = (struct dyad_prefetcher *)ctx->prefetcher;
+    pthread_mutex_lock (&p->lock);
+    if (p->tail == NULL)
+        p->head = item;
+    else
+        p->tail->next = item;
+    p->tail = item;
+    pthread_cond_signal (&p->cond);
+    pthread_mutex_unlock (&p->lock);
+    DYAD_LOG_DEBUG (ctx, "DYAD CLIENT: Queued %s for prefetching", item->upath);
+    rc = DYAD_RC_OK;
+
+prefetch_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_prefetch_list (dyad_ctx_t *restrict ctx,
+                              const char *const *restrict fnames,
+                              size_t n)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_INT ("n", n);
+    dyad_rc_t rc = DYAD_RC_OK;
+    for (size_t i = 0ul; i < n; i++) {
+        dyad_rc_t file_rc = dyad_prefetch (ctx, fnames[i]);
+        if (DYAD_IS_ERROR (file_rc)) {
+            rc = file_rc;
+        }
+    }
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_prefetch_wait (dyad_ctx_t *restrict ctx)
+{
+    DYAD_C_FUNCTION_START ();
+    struct dyad_prefetcher *p = NULL;
+    if (ctx == NULL || ctx->prefetcher == NULL) {
+        DYAD_C_FUNCTION_END ();
+        return DYAD_RC_OK;
+    }
+    p = (struct dyad_prefetcher *)ctx->prefetcher;
+    pthread_mutex_lock (&p->lock);
+    while (p->head != NULL || p->current != NULL)
+        pthread_cond_wait (&p->done_cond, &p->lock);
+    pthread_mutex_unlock (&p->lock);
+    DYAD_C_FUNCTION_END ();
+    return DYAD_RC_OK;
+}
+
 #if DYAD_SYNC_DIR
 int dyad_sync_directory (dyad_ctx_t *restrict ctx, const char *restrict path)
 {
@@ -10,9 +10,11 @@
 #include <dyad/common/dyad_structures.h>
 
 #ifdef __cplusplus
+#include <cstddef>
 #include <cstdint>
 #else
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #endif
 
@@ -58,11 +60,34 @@ struct dyad_ctx {
     char *prod_managed_path;        // producer path managed by DYAD
     char *cons_managed_path;        // consumer path managed by DYAD
     bool relative_to_managed_path;  // relative path is relative to the managed path
+    size_t dtl_chunk_size;          // chunk size for streamed transfers (0: whole file)
+    bool dtl_zero_copy;             // store received data straight from the DTL's buffer
+    unsigned int publish_batch;     // Number of keys per KVS commit (0 or 1: no batching)
+    double publish_max_delay;       // Max seconds a key waits in a batch (0: no limit)
+    void *publish_txn;              // KVS transaction accumulating the current batch
+    unsigned int publish_pending;   // Number of keys in publish_txn
+    double publish_txn_start;       // Time the first key was added to publish_txn
+    void *publish_flusher;          // Commits batches past their delay (NULL: not started)
+    void (*publish_flusher_fini) (void *publish_flusher);  // Stops the flusher at finalization
+    void *mdata_cache;              // LRU cache of resolved owner ranks (NULL: disabled)
+    void *prefetcher;               // Background prefetch state (NULL: not started)
+    void (*prefetcher_fini) (void *prefetcher);  // Stops the prefetcher at finalization
+    bool node_dedup;                // Coordinate fetches with the other consumers on the node
+    void *cons_cache;               // Byte budget of fetched files (NULL: unlimited)
+    bool posix_io;                  // Copy file data with read/write only, never in the kernel
+    unsigned int uring_depth;       // Transfers in flight on the io_uring (0: POSIX I/O)
+    size_t uring_direct_min;        // Smallest file moved with O_DIRECT (0: never)
+    void *uring;                    // io_uring for file I/O (NULL: POSIX I/O)
+    size_t inline_max;              // Largest file published with its data in the KVS (0: none)
+    size_t dtl_rpc_max;             // Largest transfer sent over the RPC stream instead of UCX
+                                    // or Margo (0: none)
+    bool dtl_rpc_calibrate;         // Measure dtl_rpc_max on the first remote fetch
+    size_t segment_max;             // Largest file packed into a segment (0: none)
+    int segment_fd;                 // Segment this producer appends to (-1: not created yet)
+    int compress_level;             // Level at which transfers are compressed (0: not at all)
 };
 typedef void *ucx_ep_cache_h;
 
-#define DYAD_POSIX_TRANSFER_GRANULARITY 1024L * 1024L * 1024L
-
 #ifdef __cplusplus
 }
 #endif
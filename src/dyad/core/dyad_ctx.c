@@ -10,8 +10,12 @@
 // #include <dyad/core/dyad_core_int.h>
 #include <dyad/core/dyad_ctx.h>
 #include <dyad/dtl/dyad_dtl_api.h>
+#include <dyad/utils/cons_cache.h>
+#include <dyad/utils/mdata_cache.h>
+#include <dyad/utils/uring_io.h>
 #include <dyad/utils/utils.h>
 #include <flux/core.h>
+#include <unistd.h>
 
 #ifdef __cplusplus
 #include <climits>
@@ -66,7 +70,31 @@ const struct dyad_ctx dyad_ctx_default = {
     NULL,   // kvs_namespace
     NULL,   // prod_managed_path
     NULL,   // cons_managed_path
-    false   // relative_to_managed_path
+    false,  // relative_to_managed_path
+    0ul,    // dtl_chunk_size
+    false,  // dtl_zero_copy
+    0u,     // publish_batch
+    0.0,    // publish_max_delay
+    NULL,   // publish_txn
+    0u,     // publish_pending
+    0.0,    // publish_txn_start
+    NULL,   // publish_flusher
+    NULL,   // publish_flusher_fini
+    NULL,   // mdata_cache
+    NULL,   // prefetcher
+    NULL,   // prefetcher_fini
+    false,  // node_dedup
+    NULL,   // cons_cache
+    false,  // posix_io
+    0u,     // uring_depth
+    0ul,    // uring_direct_min
+    NULL,   // uring
+    0ul,    // inline_max
+    0ul,    // dtl_rpc_max
+    false,  // dtl_rpc_calibrate
+    0ul,    // segment_max
+    -1,     // segment_fd
+    0       // compress_level
 };
 
 DYAD_DLL_EXPORTED dyad_ctx_t *dyad_ctx_get ()
@@ -345,6 +373,22 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_init_env (const dyad_dtl_comm_mode_t dtl_comm_m
     const char *prod_managed_path = NULL;
     const char *cons_managed_path = NULL;
     const char *dtl_mode = NULL;
+    size_t dtl_chunk_size = 0ul;
+    bool dtl_zero_copy = false;
+    unsigned int publish_batch = 0u;
+    double publish_max_delay = 0.0;
+    size_t mdata_cache_size = 0ul;
+    double mdata_cache_ttl = 0.0;
+    bool node_dedup = false;
+    size_t cons_cache_bytes = 0ul;
+    bool posix_io = false;
+    unsigned int uring_depth = 0u;
+    size_t uring_direct_min = 0ul;
+    size_t inline_max = 0ul;
+    size_t dtl_rpc_max = 0ul;
+    bool dtl_rpc_calibrate = false;
+    size_t segment_max = 0ul;
+    int compress_level = 0;
 
     if ((e = getenv (DYAD_SYNC_DEBUG_ENV))) {
         debug = true;
@@ -431,6 +475,100 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_init_env (const dyad_dtl_comm_mode_t dtl_comm_m
         DYAD_LOG_STDERR ("%s is not set. Defaulting to %s\n", DYAD_DTL_MODE_ENV, dtl_mode);
     }
 
+    if ((e = getenv (DYAD_DTL_CHUNK_SIZE_ENV))) {
+        dtl_chunk_size = (size_t)strtoull (e, NULL, 10);
+    } else {
+        dtl_chunk_size = 0ul;
+    }
+
+    if ((e = getenv (DYAD_DTL_ZERO_COPY_ENV))) {
+        dtl_zero_copy = true;
+    } else {
+        dtl_zero_copy = false;
+    }
+
+    if ((e = getenv (DYAD_PUBLISH_BATCH_ENV))) {
+        publish_batch = (unsigned int)strtoul (e, NULL, 10);
+    } else {
+        publish_batch = 0u;
+    }
+
+    if ((e = getenv (DYAD_PUBLISH_MAX_DELAY_ENV))) {
+        publish_max_delay = strtod (e, NULL);
+    } else {
+        publish_max_delay = 0.0;
+    }
+
+    if ((e = getenv (DYAD_MDATA_CACHE_SIZE_ENV))) {
+        mdata_cache_size = (size_t)strtoull (e, NULL, 10);
+    } else {
+        mdata_cache_size = 0ul;
+    }
+
+    if ((e = getenv (DYAD_MDATA_CACHE_TTL_ENV))) {
+        mdata_cache_ttl = strtod (e, NULL);
+    } else {
+        mdata_cache_ttl = 0.0;
+    }
+
+    if ((e = getenv (DYAD_NODE_DEDUP_ENV))) {
+        node_dedup = true;
+    } else {
+        node_dedup = false;
+    }
+
+    if ((e = getenv (DYAD_CONS_CACHE_BYTES_ENV))) {
+        cons_cache_bytes = (size_t)strtoull (e, NULL, 10);
+    } else {
+        cons_cache_bytes = 0ul;
+    }
+
+    if ((e = getenv (DYAD_POSIX_IO_ENV))) {
+        posix_io = true;
+    } else {
+        posix_io = false;
+    }
+
+    if ((e = getenv (DYAD_URING_DEPTH_ENV))) {
+        uring_depth = (unsigned int)strtoul (e, NULL, 10);
+    } else {
+        uring_depth = 0u;
+    }
+
+    if ((e = getenv (DYAD_URING_DIRECT_MIN_ENV))) {
+        uring_direct_min = (size_t)strtoull (e, NULL, 10);
+    } else {
+        uring_direct_min = 0ul;
+    }
+
+    if ((e = getenv (DYAD_INLINE_MAX_ENV))) {
+        inline_max = (size_t)strtoull (e, NULL, 10);
+    } else {
+        inline_max = 0ul;
+    }
+
+    if ((e = getenv (DYAD_DTL_RPC_MAX_ENV))) {
+        // "auto" starts from the default and measures the crossover
+        // between the two routes against the first producer contacted
+        dtl_rpc_calibrate = (strcmp (e, "auto") == 0);
+        dtl_rpc_max = dtl_rpc_calibrate ? DYAD_DTL_RPC_MAX_DEFAULT : (size_t)strtoull (e, NULL, 10);
+    } else {
+        dtl_rpc_max = 0ul;
+        dtl_rpc_calibrate = false;
+    }
+
+    if ((e = getenv (DYAD_SEGMENT_MAX_ENV))) {
+        segment_max = (size_t)strtoull (e, NULL, 10);
+    } else {
+        segment_max = 0ul;
+    }
+
+    if ((e = getenv (DYAD_COMPRESS_LEVEL_ENV))) {
+        compress_level = (int)strtol (e, NULL, 10);
+    } else {
+        compress_level = 0;
+    }
+
     dyad_rc_t rc = dyad_init (debug,
                               check,
                               shared_storage,
@@ -447,6 +585,40 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_init_env (const dyad_dtl_comm_mode_t dtl_comm_m
                               dtl_mode,
                               dtl_comm_mode,
                               flux_handle);
+    // Transfer tuning knobs are not part of dyad_init's signature.
+    // They can be changed on an initialized context at any time.
+    if (!DYAD_IS_ERROR (rc) && ctx != NULL) {
+        ctx->dtl_chunk_size = dtl_chunk_size;
+        ctx->dtl_zero_copy = dtl_zero_copy;
+        ctx->publish_batch = publish_batch;
+        ctx->publish_max_delay = publish_max_delay;
+        ctx->node_dedup = node_dedup;
+        ctx->posix_io = posix_io;
+        ctx->uring_depth = uring_depth;
+        ctx->uring_direct_min = uring_direct_min;
+        ctx->inline_max = inline_max;
+        ctx->dtl_rpc_max = dtl_rpc_max;
+        ctx->dtl_rpc_calibrate = dtl_rpc_calibrate;
+        ctx->segment_max = segment_max;
+        ctx->compress_level = compress_level;
+        if (mdata_cache_size > 0ul && ctx->mdata_cache == NULL
+            && dyad_mdata_cache_init (mdata_cache_size, mdata_cache_ttl, &ctx->mdata_cache) < 0) {
+            DYAD_LOG_ERROR (ctx, "Could not create the metadata cache. Continuing without it");
+            ctx->mdata_cache = NULL;
+        }
+        if (cons_cache_bytes > 0ul && ctx->cons_cache == NULL
+            && dyad_cons_cache_init (cons_cache_bytes, &ctx->cons_cache) < 0) {
+            DYAD_LOG_ERROR (ctx, "Could not create the consumer cache. Continuing without it");
+            ctx->cons_cache = NULL;
+        }
+        if (uring_depth > 0u && ctx->uring == NULL
+            && dyad_uring_init (uring_depth, &ctx->uring) < 0) {
+            DYAD_LOG_INFO (ctx,
+                           "io_uring is not available (%s). Using POSIX I/O",
+                           strerror (errno));
+            ctx->uring = NULL;
+        }
+    }
     DYAD_C_FUNCTION_END ();
     return rc;
 }
@@ -473,6 +645,8 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_set_and_init_dtl_mode (const char *dtl_name,
         dtl_mode = DYAD_DTL_MARGO;
     } else if (strncmp (dtl_name, dyad_dtl_mode_name[DYAD_DTL_FLUX_RPC], dtl_name_len) == 0) {
         dtl_mode = DYAD_DTL_FLUX_RPC;
+    } else if (strncmp (dtl_name, dyad_dtl_mode_name[DYAD_DTL_SHM], dtl_name_len) == 0) {
+        dtl_mode = DYAD_DTL_SHM;
     } else {
         DYAD_LOG_STDERR ("Invalid env %s = %s.\n", DYAD_DTL_MODE_ENV, dtl_name);
         return DYAD_RC_BADDTLMODE;
@@ -755,7 +929,44 @@ DYAD_DLL_EXPORTED dyad_rc_t dyad_clear ()
         rc = DYAD_RC_OK;
         goto clear_region_finish;
     }
+    // Stop prefetching before the consumer's context goes away
+    if (ctx->prefetcher != NULL && ctx->prefetcher_fini != NULL) {
+        ctx->prefetcher_fini (ctx->prefetcher);
+    }
+    ctx->prefetcher = NULL;
+    ctx->prefetcher_fini = NULL;
+    // Transfers in flight may still use DTL buffers
+    dyad_uring_finalize (&ctx->uring);
     dyad_dtl_finalize (ctx);
+    // The flusher leaves its last batch to be committed below
+    if (ctx->publish_flusher != NULL && ctx->publish_flusher_fini != NULL) {
+        ctx->publish_flusher_fini (ctx->publish_flusher);
+    }
+    ctx->publish_flusher = NULL;
+    ctx->publish_flusher_fini = NULL;
+    if (ctx->publish_txn != NULL) {
+        // Commit the keys a producer batched since its last flush before
+        // the Flux handle goes away
+        if (ctx->h != NULL && ctx->publish_pending > 0u) {
+            flux_future_t *f = flux_kvs_commit ((flux_t *)ctx->h,
+                                                ctx->kvs_namespace,
+                                                0,
+                                                (flux_kvs_txn_t *)ctx->publish_txn);
+            if (f == NULL || flux_future_get (f, NULL) < 0) {
+                DYAD_LOG_ERROR (ctx, "Could not commit %u batched keys", ctx->publish_pending);
+            }
+            flux_future_destroy (f);
+        }
+        flux_kvs_txn_destroy ((flux_kvs_txn_t *)ctx->publish_txn);
+        ctx->publish_txn = NULL;
+        ctx->publish_pending = 0u;
+    }
+    dyad_mdata_cache_finalize (&ctx->mdata_cache);
+    dyad_cons_cache_finalize (&ctx->cons_cache);
+    if (ctx->segment_fd >= 0) {
+        close (ctx->segment_fd);
+        ctx->segment_fd = -1;
+    }
     if (ctx->h != NULL) {
         flux_close (ctx->h);
         ctx->h = NULL;
@@ -8,6 +8,7 @@
 #include <dyad/common/dyad_profiler.h>
 #include <dyad/dtl/dyad_dtl_api.h>
 #include <dyad/dtl/flux_dtl.h>
+#include <dyad/dtl/shm_dtl.h>
 
 #if defined(DYAD_ENABLE_MARGO_DTL)
 #include "margo_dtl.h"
@@ -32,6 +33,11 @@ dyad_rc_t dyad_dtl_init (dyad_ctx_t* ctx,
     }
 
     ctx->dtl_handle->mode = mode;
+    ctx->dtl_handle->max_transfer_size = 0ul;
+    ctx->dtl_handle->max_inflight = 1u;
+    ctx->dtl_handle->get_event_fd = NULL;
+    ctx->dtl_handle->progress = NULL;
+    ctx->dtl_handle->get_buffer_fd = NULL;
     // clang-format off
 #if defined (DYAD_ENABLE_UCX_DTL) || defined(DYAD_ENABLE_UCX_DATA_RMA)
     if (mode == DYAD_DTL_UCX) {
@@ -45,6 +51,8 @@ dyad_rc_t dyad_dtl_init (dyad_ctx_t* ctx,
 #endif // defined (DYAD_ENABLE_MARGO_DTL)
     if (mode == DYAD_DTL_FLUX_RPC) {
         rc = dyad_dtl_flux_init (ctx, mode, comm_mode, debug);
+    } else if (mode == DYAD_DTL_SHM) {
+        rc = dyad_dtl_shm_init (ctx, mode, comm_mode, debug);
     } else {
         rc = DYAD_RC_BADDTLMODE;
     }
@@ -84,6 +92,8 @@ dyad_rc_t dyad_dtl_finalize (dyad_ctx_t* ctx)
         if ((ctx->dtl_handle)->private_dtl.flux_dtl_handle != NULL) {
             rc = dyad_dtl_flux_finalize (ctx);
         }
+    } else if ((ctx->dtl_handle)->mode == DYAD_DTL_SHM) {
+        rc = dyad_dtl_shm_finalize (ctx);
     } else {
         rc = DYAD_RC_BADDTLMODE;
     }
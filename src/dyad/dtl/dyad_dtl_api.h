@@ -39,12 +39,32 @@ union dyad_dtl_private {
     struct dyad_dtl_ucx *ucx_dtl_handle;
     struct dyad_dtl_flux *flux_dtl_handle;
     struct dyad_dtl_margo *margo_dtl_handle;
+    struct dyad_dtl_shm *shm_dtl_handle;
 } __attribute__ ((aligned (16)));
 typedef union dyad_dtl_private dyad_dtl_private_t;
 
+// Written by the producer in front of the data it puts into the buffer of
+// a consumer with UCX RMA. The consumer waits for len to become non-zero.
+struct dyad_dtl_rma_header {
+    ssize_t len;        // Bytes of data following the header (< 0: read error)
+    ssize_t file_size;  // Size of the whole file the data is part of
+};
+typedef struct dyad_dtl_rma_header dyad_dtl_rma_header_t;
+
+// Start of each response of a dyad.fetch_many stream. A response carries
+// one of the requested files, in any order.
+struct dyad_fetch_frame {
+    uint32_t index;   // Position of the file in the request
+    int32_t errnum;   // 0, or why the data is not in the frame (EFBIG: too large)
+    uint64_t len;     // Bytes of data following the frame (a compressed frame if asked for)
+};
+typedef struct dyad_fetch_frame dyad_fetch_frame_t;
+
 struct dyad_dtl {
     dyad_dtl_private_t private_dtl;
     dyad_dtl_mode_t mode;
+    size_t max_transfer_size;   // Largest payload of a single fetch (0: unlimited)
+    unsigned int max_inflight;  // Transfers in flight: fetches of a consumer, reads of a producer
     dyad_rc_t (*rpc_pack) (const dyad_ctx_t *ctx,
                            const char *upath,
                            uint32_t producer_rank,
@@ -58,6 +78,14 @@ struct dyad_dtl {
     dyad_rc_t (*send) (const dyad_ctx_t *ctx, void *buf, size_t buflen);
     dyad_rc_t (*recv) (const dyad_ctx_t *ctx, void **buf, size_t *buflen);
     dyad_rc_t (*close_connection) (const dyad_ctx_t *ctx);
+    // Optional (NULL if unsupported): an fd that becomes readable when the
+    // DTL has events, and the function that handles them and rearms the fd
+    dyad_rc_t (*get_event_fd) (const dyad_ctx_t *ctx, int *fd);
+    dyad_rc_t (*progress) (const dyad_ctx_t *ctx);
+    // Optional (NULL if unsupported): the file backing a buffer returned by
+    // get_buffer or recv, and the offset of the buffer in that file, so the
+    // kernel can move data in and out of it
+    dyad_rc_t (*get_buffer_fd) (const dyad_ctx_t *ctx, void *buf, int *fd, off_t *offset);
 } __attribute__ ((aligned (256)));
 typedef struct dyad_dtl dyad_dtl_t;
 
@@ -9,6 +9,7 @@
 #include <dyad/common/dyad_logging.h>
 #include <dyad/common/dyad_profiler.h>
 #include <dyad/dtl/flux_dtl.h>
+#include <dyad/utils/compress.h>
 
 dyad_rc_t dyad_dtl_flux_init (const dyad_ctx_t* ctx,
                               dyad_dtl_mode_t mode,
@@ -28,6 +29,8 @@ dyad_rc_t dyad_dtl_flux_init (const dyad_ctx_t* ctx,
     ctx->dtl_handle->private_dtl.flux_dtl_handle->debug = debug;
     ctx->dtl_handle->private_dtl.flux_dtl_handle->f = NULL;
     ctx->dtl_handle->private_dtl.flux_dtl_handle->msg = NULL;
+    ctx->dtl_handle->private_dtl.flux_dtl_handle->lent = NULL;
+    ctx->dtl_handle->private_dtl.flux_dtl_handle->compress = false;
 
     ctx->dtl_handle->rpc_pack = dyad_dtl_flux_rpc_pack;
     ctx->dtl_handle->rpc_unpack = dyad_dtl_flux_rpc_unpack;
@@ -54,12 +57,18 @@ dyad_rc_t dyad_dtl_flux_rpc_pack (const dyad_ctx_t* ctx,
     DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
     DYAD_C_FUNCTION_UPDATE_INT ("producer_rank", producer_rank);
     dyad_rc_t rc = DYAD_RC_OK;
-    *packed_obj = json_pack ("{s:s}", "upath", upath);
+    bool compress = ctx->compress_level != 0 && dyad_compress_available ();
+    if (compress) {
+        *packed_obj = json_pack ("{s:s s:i}", "upath", upath, "compress", (int)DYAD_CODEC_ZSTD);
+    } else {
+        *packed_obj = json_pack ("{s:s}", "upath", upath);
+    }
     if (*packed_obj == NULL) {
         DYAD_LOG_ERROR (ctx, "Could not pack upath for Flux DTL");
         rc = DYAD_RC_BADPACK;
         goto dtl_flux_rpc_pack;
     }
+    ctx->dtl_handle->private_dtl.flux_dtl_handle->compress = compress;
 dtl_flux_rpc_pack:
     DYAD_C_FUNCTION_END ();
     return rc;
@@ -70,7 +79,8 @@ dyad_rc_t dyad_dtl_flux_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg
     DYAD_C_FUNCTION_START ();
     int rc = 0;
     dyad_rc_t dyad_rc = DYAD_RC_OK;
-    rc = flux_request_unpack (msg, NULL, "{s:s}", "upath", upath);
+    int codec = (int)DYAD_CODEC_NONE;
+    rc = flux_request_unpack (msg, NULL, "{s:s s?i}", "upath", upath, "compress", &codec);
     if (FLUX_IS_ERROR (rc)) {
         DYAD_LOG_ERROR (ctx, "Could not unpack Flux message from consumer");
         // TODO create new RC for this
@@ -78,6 +88,9 @@ dyad_rc_t dyad_dtl_flux_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg
         goto dtl_flux_rpc_unpack_region_finish;
     }
     ctx->dtl_handle->private_dtl.flux_dtl_handle->msg = (flux_msg_t*)msg;
+    // Consumers only ask for codecs they can decode, and get frames of
+    // raw data if this build cannot compress
+    ctx->dtl_handle->private_dtl.flux_dtl_handle->compress = codec != (int)DYAD_CODEC_NONE;
     dyad_rc = DYAD_RC_OK;
     DYAD_C_FUNCTION_UPDATE_STR ("upath", *upath);
 dtl_flux_rpc_unpack_region_finish:
@@ -133,10 +146,24 @@ dyad_rc_t dyad_dtl_flux_return_buffer (const dyad_ctx_t* ctx, void** data_buf)
 {
     DYAD_C_FUNCTION_START ();
     dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_flux_t* dtl_handle = ctx->dtl_handle->private_dtl.flux_dtl_handle;
     if (data_buf == NULL || *data_buf == NULL) {
         rc = DYAD_RC_BADBUF;
         goto flux_ret_buf_done;
     }
+    for (struct dyad_dtl_flux_lent** l = &dtl_handle->lent; *l != NULL; l = &(*l)->next) {
+        if ((*l)->buf == *data_buf) {
+            // The buffer belongs to a response message, which goes away
+            // with its last reference
+            struct dyad_dtl_flux_lent* found = *l;
+            *l = found->next;
+            flux_msg_decref (found->msg);
+            free (found);
+            *data_buf = NULL;
+            rc = DYAD_RC_OK;
+            goto flux_ret_buf_done;
+        }
+    }
     free (*data_buf);
     rc = DYAD_RC_OK;
 
@@ -157,11 +184,27 @@ dyad_rc_t dyad_dtl_flux_send (const dyad_ctx_t* ctx, void* buf, size_t buflen)
     DYAD_C_FUNCTION_START ();
     dyad_rc_t dyad_rc = DYAD_RC_OK;
     int rc = 0;
+    void* frame = NULL;
+    size_t frame_len = 0ul;
     DYAD_LOG_INFO (ctx, "Send data to consumer using a Flux RPC response");
+    if (ctx->dtl_handle->private_dtl.flux_dtl_handle->compress) {
+        frame = malloc (dyad_compress_bound (buflen));
+        if (frame == NULL) {
+            DYAD_LOG_ERROR (ctx, "Cannot allocate a frame for %zu bytes", buflen);
+            dyad_rc = DYAD_RC_SYSFAIL;
+            goto dtl_flux_send_region_finish;
+        }
+        frame_len = dyad_compress_frame ((ctx->compress_level != 0) ? ctx->compress_level
+                                                                     : DYAD_COMPRESS_LEVEL_DEFAULT,
+                                         buf,
+                                         buflen,
+                                         frame);
+        DYAD_C_FUNCTION_UPDATE_INT ("frame_len", frame_len);
+    }
     rc = flux_respond_raw (ctx->dtl_handle->private_dtl.flux_dtl_handle->h,
                            ctx->dtl_handle->private_dtl.flux_dtl_handle->msg,
-                           buf,
-                           buflen);
+                           (frame != NULL) ? frame : buf,
+                           (frame != NULL) ? frame_len : buflen);
     if (FLUX_IS_ERROR (rc)) {
         DYAD_LOG_ERROR (ctx,
                         "Could not send Flux RPC response containing file "
@@ -174,11 +217,75 @@ dyad_rc_t dyad_dtl_flux_send (const dyad_ctx_t* ctx, void* buf, size_t buflen)
     }
     dyad_rc = DYAD_RC_OK;
 dtl_flux_send_region_finish:
+    free (frame);
     DYAD_C_FUNCTION_UPDATE_INT ("buflen", buflen);
     DYAD_C_FUNCTION_END ();
     return dyad_rc;
 }
 
+/* Lend out buf, which lies in the payload of the response the future
+ * holds, by taking a reference on that response */
+static dyad_rc_t dyad_dtl_flux_lend (const dyad_ctx_t* ctx, const void* buf)
+{
+    dyad_dtl_flux_t* dtl_handle = ctx->dtl_handle->private_dtl.flux_dtl_handle;
+    const flux_msg_t* msg = NULL;
+    struct dyad_dtl_flux_lent* lent = NULL;
+
+    if (flux_future_get (dtl_handle->f, (const void**)&msg) < 0 || msg == NULL) {
+        return DYAD_RC_FLUXFAIL;
+    }
+    lent = malloc (sizeof (struct dyad_dtl_flux_lent));
+    if (lent == NULL) {
+        return DYAD_RC_SYSFAIL;
+    }
+    lent->buf = buf;
+    lent->msg = flux_msg_incref (msg);
+    lent->next = dtl_handle->lent;
+    dtl_handle->lent = lent;
+    return DYAD_RC_OK;
+}
+
+/* Decode the compressed frame of a response payload into *buf. Frames
+ * of raw data are lent out as is under zero-copy. */
+static dyad_rc_t dyad_dtl_flux_recv_frame (const dyad_ctx_t* ctx,
+                                           const void* payload,
+                                           size_t payload_len,
+                                           void** buf,
+                                           size_t* buflen)
+{
+    uint32_t codec = DYAD_CODEC_NONE;
+    size_t raw_len = 0ul;
+    dyad_rc_t dyad_rc = DYAD_RC_OK;
+
+    *buf = NULL;
+    *buflen = 0ul;
+    if (dyad_compress_frame_info (payload, payload_len, &codec, &raw_len) < 0) {
+        DYAD_LOG_ERROR (ctx, "Invalid frame in Flux RPC response (errno = %d)", errno);
+        return DYAD_RC_BADRPC;
+    }
+    if (codec == DYAD_CODEC_NONE && ctx->dtl_zero_copy
+        && !DYAD_IS_ERROR (
+            dyad_dtl_flux_lend (ctx, (const char*)payload + sizeof (dyad_compress_frame_t)))) {
+        *buf = (char*)payload + sizeof (dyad_compress_frame_t);
+        *buflen = raw_len;
+        return DYAD_RC_OK;
+    }
+    // posix_memalign may return NULL for a size of 0
+    dyad_rc = ctx->dtl_handle->get_buffer (ctx, (raw_len > 0ul) ? raw_len : 1ul, buf);
+    if (DYAD_IS_ERROR (dyad_rc)) {
+        *buf = NULL;
+        return dyad_rc;
+    }
+    if (dyad_decompress_frame (payload, payload_len, *buf) < 0) {
+        DYAD_LOG_ERROR (ctx, "Could not decode Flux RPC response (errno = %d)", errno);
+        free (*buf);
+        *buf = NULL;
+        return DYAD_RC_BADRPC;
+    }
+    *buflen = raw_len;
+    return DYAD_RC_OK;
+}
+
 dyad_rc_t dyad_dtl_flux_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen)
 {
     DYAD_C_FUNCTION_START ();
@@ -197,14 +304,27 @@ dyad_rc_t dyad_dtl_flux_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen)
     size_t tmp_buflen = 0;
     rc = flux_rpc_get_raw (dtl_handle->f, (const void**)&tmp_buf, &tmp_buflen);
     if (FLUX_IS_ERROR (rc)) {
-        DYAD_LOG_ERROR (ctx, "Could not get file data from Flux RPC");
-        if (errno == ENODATA)
+        if (errno == ENODATA) {
+            // End of a (possibly chunked) stream, not a failure
+            DYAD_LOG_DEBUG (ctx, "Flux RPC stream is finished");
             dyad_rc = DYAD_RC_RPC_FINISHED;
-        else
+        } else {
+            DYAD_LOG_ERROR (ctx, "Could not get file data from Flux RPC");
             dyad_rc = DYAD_RC_BADRPC;
+        }
+        goto finish_recv;
+    }
+    if (dtl_handle->compress) {
+        dyad_rc = dyad_dtl_flux_recv_frame (ctx, tmp_buf, tmp_buflen, buf, buflen);
         goto finish_recv;
     }
     *buflen = tmp_buflen;
+    if (ctx->dtl_zero_copy && !DYAD_IS_ERROR (dyad_dtl_flux_lend (ctx, tmp_buf))) {
+        // Lend out the payload of the response instead of copying it
+        *buf = tmp_buf;
+        dyad_rc = DYAD_RC_OK;
+        goto finish_recv;
+    }
     dyad_rc = ctx->dtl_handle->get_buffer (ctx, *buflen, buf);
     if (DYAD_IS_ERROR (dyad_rc)) {
         *buf = NULL;
@@ -224,6 +344,8 @@ finish_recv:
 dyad_rc_t dyad_dtl_flux_close_connection (const dyad_ctx_t* ctx)
 {
     DYAD_C_FUNCTION_START ();
+    // Buffers still lent out outlive the connection until return_buffer
+    ctx->dtl_handle->private_dtl.flux_dtl_handle->compress = false;
     if (ctx->dtl_handle->private_dtl.flux_dtl_handle->f != NULL)
         ctx->dtl_handle->private_dtl.flux_dtl_handle->f = NULL;
     if (ctx->dtl_handle->private_dtl.flux_dtl_handle->msg != NULL)
@@ -242,6 +364,12 @@ dyad_rc_t dyad_dtl_flux_finalize (const dyad_ctx_t* ctx)
     ctx->dtl_handle->private_dtl.flux_dtl_handle->h = NULL;
     ctx->dtl_handle->private_dtl.flux_dtl_handle->f = NULL;
     ctx->dtl_handle->private_dtl.flux_dtl_handle->msg = NULL;
+    while (ctx->dtl_handle->private_dtl.flux_dtl_handle->lent != NULL) {
+        struct dyad_dtl_flux_lent* lent = ctx->dtl_handle->private_dtl.flux_dtl_handle->lent;
+        ctx->dtl_handle->private_dtl.flux_dtl_handle->lent = lent->next;
+        flux_msg_decref (lent->msg);
+        free (lent);
+    }
     free (ctx->dtl_handle->private_dtl.flux_dtl_handle);
     ctx->dtl_handle->private_dtl.flux_dtl_handle = NULL;
 dtl_flux_finalize_done:;
@@ -11,12 +11,25 @@
 
 #include <dyad/dtl/dyad_dtl_api.h>
 
+// A response payload lent out by a zero-copy recv. The reference on its
+// message keeps it valid past the future until return_buffer.
+struct dyad_dtl_flux_lent {
+    const void* buf;
+    const flux_msg_t* msg;
+    struct dyad_dtl_flux_lent* next;
+};
+
 struct dyad_dtl_flux {
     flux_t* h;
     dyad_dtl_comm_mode_t comm_mode;
     bool debug;
     flux_future_t* f;
     flux_msg_t* msg;
+    // Payloads lent out and not given back yet
+    struct dyad_dtl_flux_lent* lent;
+    // Whether the payloads of the current transfer are compressed frames
+    // (see dyad/utils/compress.h). The consumer asks for it in the request.
+    bool compress;
 };
 
 typedef struct dyad_dtl_flux dyad_dtl_flux_t;
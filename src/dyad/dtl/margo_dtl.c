@@ -13,6 +13,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <dyad/common/dyad_envs.h>
 #include <dyad/common/dyad_logging.h>
 #include <dyad/common/dyad_profiler.h>
 #include <dyad/dtl/margo_dtl.h>
@@ -29,12 +30,184 @@
 MERCURY_GEN_PROC (margo_rpc_in_t, ((int64_t)(n)) ((hg_bulk_t)(bulk)))
 MERCURY_GEN_PROC (margo_rpc_out_t, ((int32_t)(ret)))
 
+#define MARGO_NO_REGION SIZE_MAX
+#define MARGO_NA_PROTOCOL "ofi+tcp"
+// Defaults for the registered regions and the pipelining of bulk pulls
+#define MARGO_BULK_REGIONS 2ul
+#define MARGO_PULL_SEGMENT (4ul * 1024ul * 1024ul)
+#define MARGO_PULL_DEPTH 4ul
+#define MARGO_MAX_PULL_DEPTH 16ul
+// Regions grow in multiples of this, so similar sizes share a registration
+#define MARGO_REGION_ALIGN (1024ul * 1024ul)
+// Default size past which a region is not grown, so that one large file
+// does not keep a registration of its size for good
+#define MARGO_REGION_MAX (256ul * 1024ul * 1024ul)
+
+// Index of the region holding buf, or MARGO_NO_REGION
+static size_t margo_region_of (dyad_dtl_margo_t* margo_handle, const void* buf)
+{
+    size_t i;
+    for (i = 0ul; i < margo_handle->num_regions; i++) {
+        if (buf != NULL && margo_handle->regions[i].buf == buf) {
+            return i;
+        }
+    }
+    return MARGO_NO_REGION;
+}
+
+/* Take a free region of at least size bytes, growing one if none is large
+ * enough. Returns MARGO_NO_REGION if all of them are busy, if size is
+ * past region_max, or if the region cannot be registered; callers then
+ * fall back to a one-off buffer. */
+static size_t margo_region_acquire (dyad_dtl_margo_t* margo_handle, size_t size)
+{
+    size_t i;
+    size_t idx = MARGO_NO_REGION;
+    size_t region_size = 0ul;
+    dyad_margo_region_t* region = NULL;
+    hg_size_t seg_size = 0;
+    hg_return_t ret = HG_SUCCESS;
+
+    if (size > margo_handle->region_max) {
+        return MARGO_NO_REGION;
+    }
+    region_size = (size + MARGO_REGION_ALIGN - 1ul) / MARGO_REGION_ALIGN * MARGO_REGION_ALIGN;
+    pthread_mutex_lock (&margo_handle->region_lock);
+    for (i = 0ul; i < margo_handle->num_regions; i++) {
+        if (margo_handle->regions[i].busy) {
+            continue;
+        }
+        if (margo_handle->regions[i].size >= size) {
+            idx = i;
+            break;
+        }
+        if (idx == MARGO_NO_REGION) {
+            idx = i;
+        }
+    }
+    if (idx != MARGO_NO_REGION) {
+        margo_handle->regions[idx].busy = true;
+    }
+    pthread_mutex_unlock (&margo_handle->region_lock);
+    if (idx == MARGO_NO_REGION) {
+        return MARGO_NO_REGION;
+    }
+
+    region = &margo_handle->regions[idx];
+    if (region->size >= size) {
+        return idx;
+    }
+    if (region->bulk != HG_BULK_NULL) {
+        margo_bulk_free (region->bulk);
+        region->bulk = HG_BULK_NULL;
+    }
+    free (region->buf);
+    region->size = 0ul;
+    region->buf = malloc (region_size);
+    if (region->buf == NULL) {
+        goto region_acquire_error;
+    }
+    region->size = region_size;
+    seg_size = (hg_size_t)region->size;
+    ret = margo_bulk_create (margo_handle->mid,
+                             1,
+                             &region->buf,
+                             &seg_size,
+                             (margo_handle->comm_mode == DYAD_COMM_SEND) ? HG_BULK_READ_ONLY
+                                                                         : HG_BULK_WRITE_ONLY,
+                             &region->bulk);
+    if (ret != HG_SUCCESS) {
+        region->bulk = HG_BULK_NULL;
+        goto region_acquire_error;
+    }
+    return idx;
+
+region_acquire_error:;
+    free (region->buf);
+    region->buf = NULL;
+    region->size = 0ul;
+    pthread_mutex_lock (&margo_handle->region_lock);
+    region->busy = false;
+    pthread_mutex_unlock (&margo_handle->region_lock);
+    return MARGO_NO_REGION;
+}
+
+static void margo_region_release (dyad_dtl_margo_t* margo_handle, size_t idx)
+{
+    pthread_mutex_lock (&margo_handle->region_lock);
+    margo_handle->regions[idx].busy = false;
+    pthread_mutex_unlock (&margo_handle->region_lock);
+}
+
+/* Pull len bytes from the producer's bulk handle in segments, keeping up
+ * to pull_depth of them in flight */
+static hg_return_t margo_pull (dyad_dtl_margo_t* margo_handle,
+                               hg_addr_t producer_addr,
+                               hg_bulk_t remote_bulk,
+                               hg_bulk_t local_bulk,
+                               size_t len)
+{
+    margo_request reqs[MARGO_MAX_PULL_DEPTH];
+    size_t depth = margo_handle->pull_depth;
+    size_t seg = margo_handle->pull_segment;
+    size_t num_segs = (len + seg - 1ul) / seg;
+    size_t i;
+    hg_return_t ret = HG_SUCCESS;
+    hg_return_t wret = HG_SUCCESS;
+
+    // A request is reset once waited for, so that only the pulls still in
+    // flight are waited for after a failure
+    for (i = 0ul; i < depth; i++) {
+        reqs[i] = MARGO_REQUEST_NULL;
+    }
+    for (i = 0ul; i < num_segs; i++) {
+        size_t off = i * seg;
+        size_t seg_len = (len - off < seg) ? (len - off) : seg;
+        margo_request* req = &reqs[i % depth];
+        // Reuse the request slot of the oldest pull once it is done
+        if (*req != MARGO_REQUEST_NULL) {
+            ret = margo_wait (*req);
+            *req = MARGO_REQUEST_NULL;
+            if (ret != HG_SUCCESS) {
+                break;
+            }
+        }
+        ret = margo_bulk_itransfer (margo_handle->mid,
+                                    HG_BULK_PULL,
+                                    producer_addr,
+                                    remote_bulk,
+                                    off,
+                                    local_bulk,
+                                    off,
+                                    seg_len,
+                                    req);
+        if (ret != HG_SUCCESS) {
+            *req = MARGO_REQUEST_NULL;
+            break;
+        }
+    }
+    for (i = 0ul; i < depth; i++) {
+        if (reqs[i] == MARGO_REQUEST_NULL) {
+            continue;
+        }
+        wret = margo_wait (reqs[i]);
+        reqs[i] = MARGO_REQUEST_NULL;
+        if (wret != HG_SUCCESS && ret == HG_SUCCESS) {
+            ret = wret;
+        }
+    }
+    return ret;
+}
+
 static void data_ready_rpc (hg_handle_t h)
 {
     hg_return_t ret;
     margo_rpc_in_t in;
     margo_rpc_out_t out;
-    hg_bulk_t local_bulk;
+    hg_bulk_t local_bulk = HG_BULK_NULL;
+    hg_size_t recv_len = 0;
+    size_t idx = MARGO_NO_REGION;
+    void* recv_buffer = NULL;
     // clang-format off
     (void) ret;
     // clang-format on
@@ -50,31 +223,49 @@ static void data_ready_rpc (hg_handle_t h)
     ret = margo_get_input (h, &in);
     assert (ret == HG_SUCCESS);
 
-    margo_handle->recv_len = (size_t)in.n;
-    margo_handle->recv_buffer = malloc (margo_handle->recv_len);
-
-    ret = margo_bulk_create (mid,
-                             1,
-                             (void**)&margo_handle->recv_buffer,
-                             &margo_handle->recv_len,
-                             HG_BULK_WRITE_ONLY,
-                             &local_bulk);
-    assert (ret == HG_SUCCESS);
+    recv_len = (hg_size_t)in.n;
+    // Pull into a registered region. If they are all in use, e.g., by data
+    // the client has not returned yet, register a buffer for this pull only.
+    idx = margo_region_acquire (margo_handle, (size_t)recv_len);
+    if (idx != MARGO_NO_REGION) {
+        recv_buffer = margo_handle->regions[idx].buf;
+        local_bulk = margo_handle->regions[idx].bulk;
+        ret = HG_SUCCESS;
+    } else {
+        recv_buffer = malloc (recv_len);
+        ret = (recv_buffer == NULL) ? HG_NOMEM
+                                    : margo_bulk_create (mid,
+                                                         1,
+                                                         &recv_buffer,
+                                                         &recv_len,
+                                                         HG_BULK_WRITE_ONLY,
+                                                         &local_bulk);
+    }
 
     // RDMA pull from the producer (which for now is the flux borker)
-    ret = margo_bulk_transfer (mid,
-                               HG_BULK_PULL,
-                               producer_addr,
-                               in.bulk,
-                               0,
-                               local_bulk,
-                               0,
-                               margo_handle->recv_len);
-    assert (ret == HG_SUCCESS);
+    if (ret == HG_SUCCESS) {
+        ret = margo_pull (margo_handle, producer_addr, in.bulk, local_bulk, (size_t)recv_len);
+    }
+    if (idx == MARGO_NO_REGION && local_bulk != HG_BULK_NULL) {
+        margo_bulk_free (local_bulk);
+    }
 
     // DYAD_LOG_DEBUG(ctx, "[MARGO DTL] RDMA pulled from the producer.");
 
-    out.ret = 0;
+    out.ret = (ret == HG_SUCCESS) ? 0 : -1;
+    if (ret != HG_SUCCESS) {
+        if (idx != MARGO_NO_REGION) {
+            margo_region_release (margo_handle, idx);
+        } else {
+            free (recv_buffer);
+        }
+        recv_buffer = NULL;
+        recv_len = 0;
+    }
+    margo_handle->recv_buffer = recv_buffer;
+    margo_handle->recv_len = (size_t)recv_len;
+    margo_handle->recv_failed = (out.ret != 0);
+
     ret = margo_respond (h, &out);
     assert (ret == HG_SUCCESS);
     ret = margo_free_input (h, &in);
@@ -93,10 +284,20 @@ dyad_rc_t dyad_dtl_margo_get_buffer (const dyad_ctx_t* ctx, size_t data_size, vo
     DYAD_C_FUNCTION_START ();
     dyad_rc_t rc = DYAD_RC_OK;
 
+    dyad_dtl_margo_t* margo_handle = ctx->dtl_handle->private_dtl.margo_dtl_handle;
+    size_t idx = MARGO_NO_REGION;
+
     if (data_buf == NULL || *data_buf != NULL) {
         rc = DYAD_RC_BADBUF;
         goto margo_get_buf_done;
     }
+    // Producers read files straight into a registered region, so sending
+    // it needs no registration
+    if (margo_handle->comm_mode == DYAD_COMM_SEND
+        && (idx = margo_region_acquire (margo_handle, data_size)) != MARGO_NO_REGION) {
+        *data_buf = margo_handle->regions[idx].buf;
+        goto margo_get_buf_done;
+    }
 #if 1
     *data_buf = malloc (data_size);
     if (*data_buf == NULL) {
@@ -118,11 +319,19 @@ dyad_rc_t dyad_dtl_margo_return_buffer (const dyad_ctx_t* ctx, void** data_buf)
 {
     DYAD_C_FUNCTION_START ();
     dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_margo_t* margo_handle = ctx->dtl_handle->private_dtl.margo_dtl_handle;
+    size_t idx = MARGO_NO_REGION;
     if (data_buf == NULL || *data_buf == NULL) {
         rc = DYAD_RC_BADBUF;
         goto margo_ret_buf_done;
     }
-    free (*data_buf);
+    idx = margo_region_of (margo_handle, *data_buf);
+    if (idx != MARGO_NO_REGION) {
+        margo_region_release (margo_handle, idx);
+    } else {
+        free (*data_buf);
+    }
+    *data_buf = NULL;
     rc = DYAD_RC_OK;
 
 margo_ret_buf_done:
@@ -139,6 +348,7 @@ dyad_rc_t dyad_dtl_margo_init (const dyad_ctx_t* ctx,
 
     // dyad_rc_t rc = DYAD_RC_OK;
     dyad_dtl_margo_t* margo_handle = NULL;
+    char* e = NULL;
 
     ctx->dtl_handle->private_dtl.margo_dtl_handle = malloc (sizeof (struct dyad_dtl_margo));
     if (ctx->dtl_handle->private_dtl.margo_dtl_handle == NULL) {
@@ -150,18 +360,79 @@ dyad_rc_t dyad_dtl_margo_init (const dyad_ctx_t* ctx,
     margo_handle = ctx->dtl_handle->private_dtl.margo_dtl_handle;
     margo_handle->h = (flux_t*)ctx->h;  // flux handle
     margo_handle->debug = debug;
+    margo_handle->comm_mode = comm_mode;
+    margo_handle->mid = MARGO_INSTANCE_NULL;
+    margo_handle->local_addr = HG_ADDR_NULL;
+    margo_handle->remote_addr = HG_ADDR_NULL;
     margo_handle->recv_ready = 0;
+    margo_handle->recv_failed = false;
+    margo_handle->recv_len = 0ul;
+    margo_handle->recv_buffer = NULL;
+    margo_handle->xfer_xstream = ABT_XSTREAM_NULL;
+    margo_handle->xfer_pool = ABT_POOL_NULL;
+    pthread_mutex_init (&margo_handle->region_lock, NULL);
+    margo_handle->num_regions = MARGO_BULK_REGIONS;
+    if ((e = getenv (DYAD_MARGO_BULK_REGIONS_ENV))) {
+        margo_handle->num_regions = (size_t)strtoull (e, NULL, 10);
+    }
+    margo_handle->region_max = MARGO_REGION_MAX;
+    if ((e = getenv (DYAD_MARGO_REGION_MAX_ENV)) && strtoull (e, NULL, 10) > 0ull) {
+        margo_handle->region_max = (size_t)strtoull (e, NULL, 10);
+    }
+    margo_handle->pull_segment = MARGO_PULL_SEGMENT;
+    if ((e = getenv (DYAD_MARGO_PULL_SEGMENT_ENV)) && strtoull (e, NULL, 10) > 0ull) {
+        margo_handle->pull_segment = (size_t)strtoull (e, NULL, 10);
+    }
+    margo_handle->pull_depth = MARGO_PULL_DEPTH;
+    if ((e = getenv (DYAD_MARGO_PULL_DEPTH_ENV)) && strtoull (e, NULL, 10) > 0ull) {
+        margo_handle->pull_depth = (size_t)strtoull (e, NULL, 10);
+    }
+    if (margo_handle->pull_depth > MARGO_MAX_PULL_DEPTH) {
+        margo_handle->pull_depth = MARGO_MAX_PULL_DEPTH;
+    }
+    // Regions are allocated and registered on first use
+    margo_handle->regions = calloc (margo_handle->num_regions, sizeof (dyad_margo_region_t));
+    if (margo_handle->num_regions > 0ul && margo_handle->regions == NULL) {
+        DYAD_LOG_ERROR (ctx, "Could not allocate the Margo bulk regions\n");
+        margo_handle->num_regions = 0ul;
+    }
 
     // the underlying network protocol
-    // to use for the margo dtl.
-    // TODO: currently hardcoded.
-    char margo_na_protocol[] = "ofi+tcp";  // works everywhere
-    // char margo_na_protocol[] = "ofi+verbs";  // best for infiniband
-    // char margo_na_protocol[] = "ofi+cxi";    // bset for HPC slingshot
+    // to use for the margo dtl, e.g.,
+    //   "ofi+tcp"    works everywhere (default)
+    //   "ofi+verbs"  best for infiniband
+    //   "ofi+cxi"    best for HPC slingshot
+    //   "na+sm"      shared memory, for producers and consumers on one node
+    const char* margo_na_protocol = MARGO_NA_PROTOCOL;
+    if ((e = getenv (DYAD_MARGO_PROTOCOL_ENV)) && strlen (e) > 0ul) {
+        margo_na_protocol = e;
+    }
+    // Whether Mercury progress runs in an execution stream of its own, and
+    // the number of execution streams running RPC handlers (see below)
+    int use_progress_thread = (comm_mode == DYAD_COMM_RECV) ? 1 : 0;
+    if ((e = getenv (DYAD_MARGO_PROGRESS_THREAD_ENV))) {
+        use_progress_thread = (atoi (e) > 0) ? 1 : 0;
+    }
+    int rpc_thread_count = -1;
+    if ((e = getenv (DYAD_MARGO_RPC_THREADS_ENV))) {
+        rpc_thread_count = atoi (e);
+    }
+    DYAD_LOG_INFO (ctx,
+                   "[MARGO DTL] protocol \"%s\", progress thread %d, RPC threads %d",
+                   margo_na_protocol,
+                   use_progress_thread,
+                   rpc_thread_count);
     // producer (FLUX broker)
     // essentially the margo client
     if (comm_mode == DYAD_COMM_SEND) {
-        margo_handle->mid = margo_init (margo_na_protocol, MARGO_CLIENT_MODE, 0, -1);
+        margo_handle->mid = margo_init (margo_na_protocol,
+                                        MARGO_CLIENT_MODE,
+                                        use_progress_thread,
+                                        rpc_thread_count);
+        if (margo_handle->mid == MARGO_INSTANCE_NULL) {
+            DYAD_LOG_ERROR (ctx, "[MARGO DTL] margo_init failed for \"%s\"", margo_na_protocol);
+            goto error;
+        }
         margo_handle->sendrecv_rpc_id = MARGO_REGISTER (margo_handle->mid,
                                                         "data_ready_rpc",
                                                         margo_rpc_in_t,
@@ -182,12 +453,39 @@ dyad_rc_t dyad_dtl_margo_init (const dyad_ctx_t* ctx,
         // make Margo execute RPCs in the ES that called margo_init. A value of -1
         // will make Margo execute the RPCs in the ES running the progress loop.
         // A positive value will make Margo create new ESs to run the RPCs.
-        margo_handle->mid = margo_init (margo_na_protocol, MARGO_SERVER_MODE, 1, -1);
-        margo_handle->sendrecv_rpc_id = MARGO_REGISTER (margo_handle->mid,
-                                                        "data_ready_rpc",
-                                                        margo_rpc_in_t,
-                                                        margo_rpc_out_t,
-                                                        data_ready_rpc);
+        margo_handle->mid = margo_init (margo_na_protocol,
+                                        MARGO_SERVER_MODE,
+                                        use_progress_thread,
+                                        rpc_thread_count);
+        if (margo_handle->mid == MARGO_INSTANCE_NULL) {
+            DYAD_LOG_ERROR (ctx, "[MARGO DTL] margo_init failed for \"%s\"", margo_na_protocol);
+            goto error;
+        }
+        // Optionally run the transfers in an execution stream of their own,
+        // away from the one running the Mercury progress loop
+        if ((e = getenv (DYAD_MARGO_XFER_XSTREAM_ENV)) && atoi (e) > 0
+            && (ABT_pool_create_basic (ABT_POOL_FIFO,
+                                       ABT_POOL_ACCESS_MPMC,
+                                       ABT_TRUE,
+                                       &margo_handle->xfer_pool)
+                    != ABT_SUCCESS
+                || ABT_xstream_create_basic (ABT_SCHED_DEFAULT,
+                                             1,
+                                             &margo_handle->xfer_pool,
+                                             ABT_SCHED_CONFIG_NULL,
+                                             &margo_handle->xfer_xstream)
+                       != ABT_SUCCESS)) {
+            DYAD_LOG_WARN (ctx, "[MARGO DTL] could not create the transfer execution stream");
+            margo_handle->xfer_xstream = ABT_XSTREAM_NULL;
+            margo_handle->xfer_pool = ABT_POOL_NULL;
+        }
+        margo_handle->sendrecv_rpc_id = MARGO_REGISTER_PROVIDER (margo_handle->mid,
+                                                                 "data_ready_rpc",
+                                                                 margo_rpc_in_t,
+                                                                 margo_rpc_out_t,
+                                                                 data_ready_rpc,
+                                                                 MARGO_DEFAULT_PROVIDER_ID,
+                                                                 margo_handle->xfer_pool);
         margo_register_data (margo_handle->mid, margo_handle->sendrecv_rpc_id, margo_handle, NULL);
     }
     // both margo client and server
@@ -344,16 +642,21 @@ dyad_rc_t dyad_dtl_margo_send (const dyad_ctx_t* ctx, void* buf, size_t buflen)
 
     hg_size_t segment_sizes[1] = {buflen};
     void* segment_ptrs[1] = {buf};
+    size_t idx = margo_region_of (margo_handle, buf);
 
     // Register my local data
-    // which will be pulled by the consumer
-    hg_bulk_t local_bulk;
-    margo_bulk_create (margo_handle->mid,
-                       1,
-                       segment_ptrs,
-                       segment_sizes,
-                       HG_BULK_READ_ONLY,
-                       &local_bulk);
+    // which will be pulled by the consumer, unless it already is
+    hg_bulk_t local_bulk = HG_BULK_NULL;
+    if (idx != MARGO_NO_REGION) {
+        local_bulk = margo_handle->regions[idx].bulk;
+    } else {
+        margo_bulk_create (margo_handle->mid,
+                           1,
+                           segment_ptrs,
+                           segment_sizes,
+                           HG_BULK_READ_ONLY,
+                           &local_bulk);
+    }
 
     margo_rpc_in_t args;
     args.n = buflen;
@@ -367,8 +670,15 @@ dyad_rc_t dyad_dtl_margo_send (const dyad_ctx_t* ctx, void* buf, size_t buflen)
 
     margo_rpc_out_t resp;
     margo_get_output (h, &resp);
+    if (resp.ret != 0) {
+        DYAD_LOG_ERROR (ctx, "[MARGO DTL] consumer failed to pull the data");
+        rc = DYAD_RC_BADRPC;
+    }
     margo_free_output (h, &resp);
     margo_destroy (h);
+    if (idx == MARGO_NO_REGION && local_bulk != HG_BULK_NULL) {
+        margo_bulk_free (local_bulk);
+    }
 
     DYAD_LOG_DEBUG (ctx, "[MARGO DTL] margo_send completed.", buflen);
 
@@ -392,14 +702,20 @@ dyad_rc_t dyad_dtl_margo_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen
     DYAD_LOG_DEBUG (ctx, "[MARGO DTL] margo_recv received %ld bytes.", margo_handle->recv_len);
 
     // recv message handled, reset it to 0
-    *buflen = margo_handle->recv_len;
-    *buf = malloc (*buflen);
-    memcpy (*buf, margo_handle->recv_buffer, margo_handle->recv_len);
-
-    // margo_handle->recv_buffer is allocated in data_ready_rpc()
-    free (margo_handle->recv_buffer);
+    if (margo_handle->recv_failed) {
+        DYAD_LOG_ERROR (ctx, "[MARGO DTL] could not pull the data from the producer");
+        rc = DYAD_RC_BADRPC;
+        *buf = NULL;
+        *buflen = 0ul;
+    } else {
+        // Hand out the pulled buffer itself. It goes back to the region pool
+        // (or is freed) in return_buffer.
+        *buflen = margo_handle->recv_len;
+        *buf = margo_handle->recv_buffer;
+    }
     margo_handle->recv_buffer = NULL;
     margo_handle->recv_len = 0;
+    margo_handle->recv_failed = false;
     margo_handle->recv_ready = 0;
 
     DYAD_C_FUNCTION_END ();
@@ -430,10 +746,30 @@ dyad_rc_t dyad_dtl_margo_finalize (const dyad_ctx_t* ctx)
 
     margo_handle = ctx->dtl_handle->private_dtl.margo_dtl_handle;
 
+    if (margo_handle->mid == MARGO_INSTANCE_NULL) {
+        // margo_init failed, so nothing was registered or created
+        goto dtl_margo_finalize_free;
+    }
+    if (margo_handle->comm_mode == DYAD_COMM_RECV) {
+        margo_deregister (margo_handle->mid, margo_handle->sendrecv_rpc_id);
+    }
+    if (margo_handle->xfer_xstream != ABT_XSTREAM_NULL) {
+        ABT_xstream_join (margo_handle->xfer_xstream);
+        ABT_xstream_free (&margo_handle->xfer_xstream);
+    }
+    for (size_t i = 0ul; i < margo_handle->num_regions; i++) {
+        if (margo_handle->regions[i].bulk != HG_BULK_NULL)
+            margo_bulk_free (margo_handle->regions[i].bulk);
+        free (margo_handle->regions[i].buf);
+    }
     margo_addr_free (margo_handle->mid, margo_handle->local_addr);
     if (margo_handle->remote_addr != NULL)
         margo_addr_free (margo_handle->mid, margo_handle->remote_addr);
     margo_finalize (margo_handle->mid);
+
+dtl_margo_finalize_free:;
+    free (margo_handle->regions);
+    pthread_mutex_destroy (&margo_handle->region_lock);
     free (margo_handle);
     ctx->dtl_handle->private_dtl.margo_dtl_handle = NULL;
 
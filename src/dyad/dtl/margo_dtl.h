@@ -9,18 +9,42 @@
 
 #include <dyad/dtl/dyad_dtl_api.h>
 #include <margo.h>
+#include <pthread.h>
 #include <stdlib.h>
 
+// A buffer registered for bulk transfers once and reused across them. It
+// only gets registered again when it has to grow.
+struct dyad_margo_region {
+    void* buf;
+    size_t size;
+    hg_bulk_t bulk;
+    bool busy;
+};
+typedef struct dyad_margo_region dyad_margo_region_t;
+
 struct dyad_dtl_margo {
     flux_t* h;
     bool debug;
+    dyad_dtl_comm_mode_t comm_mode;
     margo_instance_id mid;    // margo id
     hg_addr_t local_addr;     // margo local server address
     hg_addr_t remote_addr;    // margo remote server address
     hg_id_t sendrecv_rpc_id;  // margo rpc id for send/recv
     bool recv_ready;
+    bool recv_failed;
     size_t recv_len;
     void* recv_buffer;
+    // Registered regions holding file data on the producer and pulled data
+    // on the consumer. Taken by I/O threads and RPC handlers concurrently.
+    dyad_margo_region_t* regions;
+    size_t num_regions;
+    size_t region_max;  // Largest region; larger transfers get one-off buffers
+    pthread_mutex_t region_lock;
+    size_t pull_segment;  // Bytes per bulk pull
+    size_t pull_depth;    // Bulk pulls in flight
+    // Execution stream running the transfers on the consumer, if any
+    ABT_xstream xfer_xstream;
+    ABT_pool xfer_pool;
 };
 
 typedef struct dyad_dtl_margo dyad_dtl_margo_t;
@@ -0,0 +1,558 @@
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif  // _GNU_SOURCE
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <dyad/common/dyad_logging.h>
+#include <dyad/common/dyad_profiler.h>
+#include <dyad/dtl/shm_dtl.h>
+
+// Longest wait for data before checking whether the producer failed
+#define SHM_WAIT_TIMEOUT_MS 100
+
+// Kept in the first page of every buffer handed out by this DTL. On the
+// producer, the buffer is a memfd that is passed to the consumer, which
+// maps the same pages instead of receiving a copy of them.
+struct shm_buf_header {
+    size_t map_len;  // Bytes mapped, including this page
+    int fd;          // memfd backing the buffer (-1: none)
+};
+
+// Datagram sent along with the descriptor of a buffer
+struct shm_msg {
+    uint64_t tag;  // Request the data is for
+    uint64_t len;  // Bytes of data following the header page
+};
+
+static inline size_t shm_header_len (void)
+{
+    return (size_t)sysconf (_SC_PAGESIZE);
+}
+
+static inline struct shm_buf_header* shm_header_of (void* buf)
+{
+    return (struct shm_buf_header*)((char*)buf - shm_header_len ());
+}
+
+/* Random bits for the socket names and tags, so that other processes on
+ * the node cannot guess where to send a buffer to a consumer */
+static int shm_random (uint64_t* value)
+{
+    ssize_t got = 0l;
+    do {
+        got = getrandom (value, sizeof (*value), 0);
+    } while (got < 0 && errno == EINTR);
+    return (got == (ssize_t)sizeof (*value)) ? 0 : -1;
+}
+
+/* Address of a socket in the abstract namespace, which needs no file and
+ * goes away with the socket */
+static void shm_sockaddr (const char* name, struct sockaddr_un* addr, socklen_t* addr_len)
+{
+    size_t len = strnlen (name, DYAD_SHM_SOCK_NAME_MAX);
+    memset (addr, 0, sizeof (*addr));
+    addr->sun_family = AF_UNIX;
+    memcpy (addr->sun_path + 1, name, len);
+    *addr_len = (socklen_t)(offsetof (struct sockaddr_un, sun_path) + 1ul + len);
+}
+
+/* Whether the request being received failed on the producer without
+ * sending any data */
+static bool shm_rpc_failed (const dyad_ctx_t* ctx, dyad_dtl_shm_t* dtl_handle)
+{
+    struct pollfd pfd;
+    if (dtl_handle->f == NULL || flux_future_wait_for (dtl_handle->f, 0.0) < 0) {
+        return false;
+    }
+    // The data is sent before the end of the stream, so it would be queued
+    pfd.fd = dtl_handle->sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll (&pfd, 1, 0) > 0) {
+        return false;
+    }
+    if (flux_rpc_get (dtl_handle->f, NULL) < 0 && errno != ENODATA) {
+        DYAD_LOG_ERROR (ctx, "Producer failed the request (errno = %d)", errno);
+    } else {
+        DYAD_LOG_ERROR (ctx, "Producer finished the request without sending data");
+    }
+    return true;
+}
+
+dyad_rc_t dyad_dtl_shm_init (const dyad_ctx_t* ctx,
+                             dyad_dtl_mode_t mode,
+                             dyad_dtl_comm_mode_t comm_mode,
+                             bool debug)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_shm_t* dtl_handle = NULL;
+    struct sockaddr_un addr;
+    socklen_t addr_len = 0;
+    uint64_t suffix = 0ul;
+    int on = 1;
+
+    ctx->dtl_handle->private_dtl.shm_dtl_handle = malloc (sizeof (struct dyad_dtl_shm));
+    if (ctx->dtl_handle->private_dtl.shm_dtl_handle == NULL) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate the SHM DTL handle");
+        rc = DYAD_RC_SYSFAIL;
+        goto dtl_shm_init_region_finish;
+    }
+    dtl_handle = ctx->dtl_handle->private_dtl.shm_dtl_handle;
+    dtl_handle->h = (flux_t*)ctx->h;
+    dtl_handle->comm_mode = comm_mode;
+    dtl_handle->debug = debug;
+    dtl_handle->sock_name[0] = '\0';
+    dtl_handle->tag = 0ul;
+    dtl_handle->f = NULL;
+    dtl_handle->cons_sock_name[0] = '\0';
+    dtl_handle->cons_tag = 0ul;
+
+    dtl_handle->sock = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (dtl_handle->sock < 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot create the SHM DTL socket: %s", strerror (errno));
+        rc = DYAD_RC_SHMINIT_FAIL;
+        goto dtl_shm_init_region_error;
+    }
+    // Consumers receive the buffers on a socket of their own. There is one
+    // per context, and a process can have one context per thread. Abstract
+    // sockets have no permissions, so the name is random and the sender of
+    // every message is checked by recv.
+    if (comm_mode == DYAD_COMM_RECV) {
+        if (shm_random (&suffix) < 0
+            || setsockopt (dtl_handle->sock, SOL_SOCKET, SO_PASSCRED, &on, sizeof (on)) < 0) {
+            DYAD_LOG_ERROR (ctx, "Cannot set up the SHM DTL socket: %s", strerror (errno));
+            rc = DYAD_RC_SHMINIT_FAIL;
+            goto dtl_shm_init_region_error;
+        }
+        snprintf (dtl_handle->sock_name,
+                  DYAD_SHM_SOCK_NAME_MAX,
+                  "dyad-shm-%d-%016" PRIx64,
+                  (int)getpid (),
+                  suffix);
+        shm_sockaddr (dtl_handle->sock_name, &addr, &addr_len);
+        if (bind (dtl_handle->sock, (struct sockaddr*)&addr, addr_len) < 0) {
+            DYAD_LOG_ERROR (ctx,
+                            "Cannot bind the SHM DTL socket %s: %s",
+                            dtl_handle->sock_name,
+                            strerror (errno));
+            rc = DYAD_RC_SHMINIT_FAIL;
+            goto dtl_shm_init_region_error;
+        }
+    }
+
+    ctx->dtl_handle->rpc_pack = dyad_dtl_shm_rpc_pack;
+    ctx->dtl_handle->rpc_unpack = dyad_dtl_shm_rpc_unpack;
+    ctx->dtl_handle->rpc_respond = dyad_dtl_shm_rpc_respond;
+    ctx->dtl_handle->rpc_recv_response = dyad_dtl_shm_rpc_recv_response;
+    ctx->dtl_handle->get_buffer = dyad_dtl_shm_get_buffer;
+    ctx->dtl_handle->return_buffer = dyad_dtl_shm_return_buffer;
+    ctx->dtl_handle->establish_connection = dyad_dtl_shm_establish_connection;
+    ctx->dtl_handle->send = dyad_dtl_shm_send;
+    ctx->dtl_handle->recv = dyad_dtl_shm_recv;
+    ctx->dtl_handle->close_connection = dyad_dtl_shm_close_connection;
+    ctx->dtl_handle->get_buffer_fd = dyad_dtl_shm_get_buffer_fd;
+    rc = DYAD_RC_OK;
+    goto dtl_shm_init_region_finish;
+
+dtl_shm_init_region_error:;
+    dyad_dtl_shm_finalize (ctx);
+
+dtl_shm_init_region_finish:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_dtl_shm_rpc_pack (const dyad_ctx_t* ctx,
+                                 const char* restrict upath,
+                                 uint32_t producer_rank,
+                                 json_t** restrict packed_obj)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
+    DYAD_C_FUNCTION_UPDATE_INT ("producer_rank", producer_rank);
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_shm_t* dtl_handle = ctx->dtl_handle->private_dtl.shm_dtl_handle;
+    // A new tag per request lets recv drop data of an earlier request that
+    // arrives late, and data that does not come from the producer
+    if (shm_random (&dtl_handle->tag) < 0) {
+        DYAD_LOG_ERROR (ctx, "Cannot draw a tag for the SHM DTL: %s", strerror (errno));
+        rc = DYAD_RC_SYSFAIL;
+        goto dtl_shm_rpc_pack_done;
+    }
+    *packed_obj = json_pack ("{s:s, s:s, s:I}",
+                             "upath",
+                             upath,
+                             "shm_sock",
+                             dtl_handle->sock_name,
+                             "shm_tag",
+                             (json_int_t)dtl_handle->tag);
+    if (*packed_obj == NULL) {
+        DYAD_LOG_ERROR (ctx, "Could not pack upath and socket name for SHM DTL");
+        rc = DYAD_RC_BADPACK;
+    }
+
+dtl_shm_rpc_pack_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_dtl_shm_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg, char** upath)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_shm_t* dtl_handle = ctx->dtl_handle->private_dtl.shm_dtl_handle;
+    const char* sock_name = NULL;
+    json_int_t tag = 0;
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:s, s:s, s:I}",
+                             "upath",
+                             upath,
+                             "shm_sock",
+                             &sock_name,
+                             "shm_tag",
+                             &tag)
+        < 0) {
+        DYAD_LOG_ERROR (ctx, "Could not unpack Flux message from consumer for SHM DTL");
+        rc = DYAD_RC_BADUNPACK;
+        goto dtl_shm_rpc_unpack_region_finish;
+    }
+    if (strlen (sock_name) >= DYAD_SHM_SOCK_NAME_MAX) {
+        DYAD_LOG_ERROR (ctx, "Consumer socket name is too long");
+        rc = DYAD_RC_BADUNPACK;
+        goto dtl_shm_rpc_unpack_region_finish;
+    }
+    strcpy (dtl_handle->cons_sock_name, sock_name);
+    dtl_handle->cons_tag = (uint64_t)tag;
+    DYAD_C_FUNCTION_UPDATE_STR ("upath", *upath);
+
+dtl_shm_rpc_unpack_region_finish:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_dtl_shm_rpc_respond (const dyad_ctx_t* ctx, const flux_msg_t* orig_msg)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_END ();
+    return DYAD_RC_OK;
+}
+
+dyad_rc_t dyad_dtl_shm_rpc_recv_response (const dyad_ctx_t* ctx, flux_future_t* f)
+{
+    DYAD_C_FUNCTION_START ();
+    ctx->dtl_handle->private_dtl.shm_dtl_handle->f = f;
+    DYAD_C_FUNCTION_END ();
+    return DYAD_RC_OK;
+}
+
+dyad_rc_t dyad_dtl_shm_get_buffer (const dyad_ctx_t* ctx, size_t data_size, void** data_buf)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_shm_t* dtl_handle = ctx->dtl_handle->private_dtl.shm_dtl_handle;
+    size_t map_len = shm_header_len () + data_size;
+    struct shm_buf_header* header = NULL;
+    void* base = MAP_FAILED;
+    int fd = -1;
+
+    if (data_buf == NULL || *data_buf != NULL) {
+        rc = DYAD_RC_BADBUF;
+        goto shm_get_buf_done;
+    }
+    if (dtl_handle->comm_mode == DYAD_COMM_SEND) {
+        // The file is read straight into pages the consumer can map
+        fd = memfd_create ("dyad_shm", MFD_CLOEXEC);
+        if (fd < 0 || ftruncate (fd, (off_t)map_len) < 0) {
+            DYAD_LOG_ERROR (ctx, "Cannot create a shared buffer: %s", strerror (errno));
+            rc = DYAD_RC_SYSFAIL;
+            goto shm_get_buf_done;
+        }
+        base = mmap (NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    } else {
+        base = mmap (NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (base == MAP_FAILED) {
+        DYAD_LOG_ERROR (ctx, "Cannot map a buffer of %zu bytes: %s", map_len, strerror (errno));
+        rc = DYAD_RC_SYSFAIL;
+        goto shm_get_buf_done;
+    }
+    header = (struct shm_buf_header*)base;
+    header->map_len = map_len;
+    header->fd = fd;
+    fd = -1;
+    *data_buf = (char*)base + shm_header_len ();
+    rc = DYAD_RC_OK;
+
+shm_get_buf_done:;
+    if (fd >= 0) {
+        close (fd);
+    }
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_dtl_shm_return_buffer (const dyad_ctx_t* ctx, void** data_buf)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    struct shm_buf_header* header = NULL;
+    int fd = -1;
+    if (data_buf == NULL || *data_buf == NULL) {
+        rc = DYAD_RC_BADBUF;
+        goto shm_ret_buf_done;
+    }
+    header = shm_header_of (*data_buf);
+    fd = header->fd;
+    munmap (header, header->map_len);
+    if (fd >= 0) {
+        close (fd);
+    }
+    *data_buf = NULL;
+    rc = DYAD_RC_OK;
+
+shm_ret_buf_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_dtl_shm_get_buffer_fd (const dyad_ctx_t* ctx, void* buf, int* fd, off_t* offset)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    struct shm_buf_header* header = NULL;
+    if (buf == NULL) {
+        rc = DYAD_RC_BADBUF;
+        goto shm_buf_fd_done;
+    }
+    header = shm_header_of (buf);
+    if (header->fd < 0) {
+        rc = DYAD_RC_BADBUF;
+        goto shm_buf_fd_done;
+    }
+    // On the consumer, the memfd holds the data as received, which the
+    // private mapping shows as long as nobody writes to it
+    *fd = header->fd;
+    *offset = (off_t)shm_header_len ();
+    rc = DYAD_RC_OK;
+
+shm_buf_fd_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_dtl_shm_establish_connection (const dyad_ctx_t* ctx)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_END ();
+    return DYAD_RC_OK;
+}
+
+/* Pass the memfd behind buf to the consumer */
+dyad_rc_t dyad_dtl_shm_send (const dyad_ctx_t* ctx, void* buf, size_t buflen)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_shm_t* dtl_handle = ctx->dtl_handle->private_dtl.shm_dtl_handle;
+    struct shm_buf_header* header = shm_header_of (buf);
+    struct shm_msg msg = {dtl_handle->cons_tag, (uint64_t)buflen};
+    struct sockaddr_un addr;
+    socklen_t addr_len = 0;
+    struct iovec iov = {&msg, sizeof (msg)};
+    union {
+        char buf[CMSG_SPACE (sizeof (int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr mh;
+    struct cmsghdr* cmsg = NULL;
+    ssize_t sent = 0l;
+
+    if (dtl_handle->cons_sock_name[0] == '\0' || header->fd < 0) {
+        DYAD_LOG_ERROR (ctx, "No consumer socket or shared buffer to send");
+        rc = DYAD_RC_SHMCOMM_FAIL;
+        goto dtl_shm_send_region_finish;
+    }
+    shm_sockaddr (dtl_handle->cons_sock_name, &addr, &addr_len);
+    memset (&mh, 0, sizeof (mh));
+    memset (&control, 0, sizeof (control));
+    mh.msg_name = &addr;
+    mh.msg_namelen = addr_len;
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control.buf;
+    mh.msg_controllen = sizeof (control.buf);
+    cmsg = CMSG_FIRSTHDR (&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (cmsg), &header->fd, sizeof (int));
+    do {
+        sent = sendmsg (dtl_handle->sock, &mh, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) {
+        // Most likely the consumer is not on this node
+        DYAD_LOG_ERROR (ctx,
+                        "Could not pass the buffer to consumer socket %s: %s",
+                        dtl_handle->cons_sock_name,
+                        strerror (errno));
+        rc = DYAD_RC_SHMCOMM_FAIL;
+        goto dtl_shm_send_region_finish;
+    }
+    rc = DYAD_RC_OK;
+
+dtl_shm_send_region_finish:;
+    DYAD_C_FUNCTION_UPDATE_INT ("buflen", buflen);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Wait for the memfd of the current request and map it. The mapping is
+ * handed out as the data and unmapped by return_buffer, which also closes
+ * the memfd kept open for get_buffer_fd. */
+dyad_rc_t dyad_dtl_shm_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_shm_t* dtl_handle = ctx->dtl_handle->private_dtl.shm_dtl_handle;
+    struct shm_msg msg;
+    struct iovec iov = {&msg, sizeof (msg)};
+    union {
+        char buf[CMSG_SPACE (sizeof (int)) + CMSG_SPACE (sizeof (struct ucred))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr mh;
+    struct cmsghdr* cmsg = NULL;
+    struct ucred cred;
+    bool trusted = false;
+    struct pollfd pfd;
+    struct stat st;
+    struct shm_buf_header* header = NULL;
+    void* base = MAP_FAILED;
+    ssize_t got = 0l;
+    int fd = -1;
+
+    *buf = NULL;
+    *buflen = 0ul;
+    for (;;) {
+        pfd.fd = dtl_handle->sock;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll (&pfd, 1, SHM_WAIT_TIMEOUT_MS) <= 0) {
+            if (shm_rpc_failed (ctx, dtl_handle)) {
+                rc = DYAD_RC_BADRPC;
+                goto dtl_shm_recv_region_finish;
+            }
+            continue;
+        }
+        memset (&mh, 0, sizeof (mh));
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        mh.msg_control = control.buf;
+        mh.msg_controllen = sizeof (control.buf);
+        got = recvmsg (dtl_handle->sock, &mh, MSG_CMSG_CLOEXEC);
+        if (got < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            DYAD_LOG_ERROR (ctx, "Could not receive from the SHM DTL socket: %s", strerror (errno));
+            rc = DYAD_RC_SHMCOMM_FAIL;
+            goto dtl_shm_recv_region_finish;
+        }
+        fd = -1;
+        trusted = false;
+        for (cmsg = CMSG_FIRSTHDR (&mh); cmsg != NULL; cmsg = CMSG_NXTHDR (&mh, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET) {
+                continue;
+            }
+            if (cmsg->cmsg_type == SCM_RIGHTS && cmsg->cmsg_len == CMSG_LEN (sizeof (int))) {
+                memcpy (&fd, CMSG_DATA (cmsg), sizeof (int));
+            } else if (cmsg->cmsg_type == SCM_CREDENTIALS) {
+                // Filled in by the kernel, since the socket has SO_PASSCRED
+                memcpy (&cred, CMSG_DATA (cmsg), sizeof (cred));
+                trusted = cred.uid == geteuid ();
+            }
+        }
+        if (trusted && (size_t)got == sizeof (msg) && fd >= 0 && msg.tag == dtl_handle->tag) {
+            break;
+        }
+        // Data of an earlier request that was given up on, or of another user
+        DYAD_LOG_DEBUG (ctx, "Dropping a stale or foreign SHM DTL message");
+        if (fd >= 0) {
+            close (fd);
+        }
+    }
+
+    if (fstat (fd, &st) < 0 || (size_t)st.st_size < shm_header_len () + msg.len) {
+        DYAD_LOG_ERROR (ctx, "Shared buffer is smaller than the data it should hold");
+        rc = DYAD_RC_SHMCOMM_FAIL;
+        goto dtl_shm_recv_region_finish;
+    }
+    // A private mapping shares the pages of the producer until written to
+    base = mmap (NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        DYAD_LOG_ERROR (ctx, "Cannot map the shared buffer: %s", strerror (errno));
+        rc = DYAD_RC_SHMCOMM_FAIL;
+        goto dtl_shm_recv_region_finish;
+    }
+    header = (struct shm_buf_header*)base;
+    header->map_len = (size_t)st.st_size;
+    header->fd = fd;
+    fd = -1;
+    *buf = (char*)base + shm_header_len ();
+    *buflen = (size_t)msg.len;
+    rc = DYAD_RC_OK;
+
+dtl_shm_recv_region_finish:;
+    if (fd >= 0) {
+        close (fd);
+    }
+    DYAD_C_FUNCTION_UPDATE_INT ("buflen", *buflen);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_dtl_shm_close_connection (const dyad_ctx_t* ctx)
+{
+    DYAD_C_FUNCTION_START ();
+    ctx->dtl_handle->private_dtl.shm_dtl_handle->f = NULL;
+    ctx->dtl_handle->private_dtl.shm_dtl_handle->cons_sock_name[0] = '\0';
+    DYAD_C_FUNCTION_END ();
+    return DYAD_RC_OK;
+}
+
+dyad_rc_t dyad_dtl_shm_finalize (const dyad_ctx_t* ctx)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    if (ctx->dtl_handle == NULL || ctx->dtl_handle->private_dtl.shm_dtl_handle == NULL) {
+        goto dtl_shm_finalize_done;
+    }
+    if (ctx->dtl_handle->private_dtl.shm_dtl_handle->sock >= 0) {
+        close (ctx->dtl_handle->private_dtl.shm_dtl_handle->sock);
+    }
+    free (ctx->dtl_handle->private_dtl.shm_dtl_handle);
+    ctx->dtl_handle->private_dtl.shm_dtl_handle = NULL;
+
+dtl_shm_finalize_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
@@ -0,0 +1,69 @@
+#ifndef DYAD_DTL_SHM_H
+#define DYAD_DTL_SHM_H
+
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <dyad/dtl/dyad_dtl_api.h>
+
+// Longest name of a consumer socket in the abstract namespace, without
+// the leading NUL byte
+#define DYAD_SHM_SOCK_NAME_MAX 64
+
+struct dyad_dtl_shm {
+    flux_t* h;
+    dyad_dtl_comm_mode_t comm_mode;
+    bool debug;
+    // Unix datagram socket carrying the descriptors of the shared buffers.
+    // Consumers bind it to sock_name, producers only send from it.
+    int sock;
+    char sock_name[DYAD_SHM_SOCK_NAME_MAX];
+    // Internal for Receiver: tag of the request being received and its RPC
+    uint64_t tag;
+    flux_future_t* f;
+    // Internal for Sender: socket and request tag of the consumer
+    char cons_sock_name[DYAD_SHM_SOCK_NAME_MAX];
+    uint64_t cons_tag;
+};
+
+typedef struct dyad_dtl_shm dyad_dtl_shm_t;
+
+dyad_rc_t dyad_dtl_shm_init (const dyad_ctx_t* ctx,
+                             dyad_dtl_mode_t mode,
+                             dyad_dtl_comm_mode_t comm_mode,
+                             bool debug);
+
+dyad_rc_t dyad_dtl_shm_rpc_pack (const dyad_ctx_t* ctx,
+                                 const char* restrict upath,
+                                 uint32_t producer_rank,
+                                 json_t** restrict packed_obj);
+
+dyad_rc_t dyad_dtl_shm_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg, char** upath);
+
+dyad_rc_t dyad_dtl_shm_rpc_respond (const dyad_ctx_t* ctx, const flux_msg_t* orig_msg);
+
+dyad_rc_t dyad_dtl_shm_rpc_recv_response (const dyad_ctx_t* ctx, flux_future_t* f);
+
+dyad_rc_t dyad_dtl_shm_get_buffer (const dyad_ctx_t* ctx, size_t data_size, void** data_buf);
+
+dyad_rc_t dyad_dtl_shm_return_buffer (const dyad_ctx_t* ctx, void** data_buf);
+
+dyad_rc_t dyad_dtl_shm_get_buffer_fd (const dyad_ctx_t* ctx, void* buf, int* fd, off_t* offset);
+
+dyad_rc_t dyad_dtl_shm_establish_connection (const dyad_ctx_t* ctx);
+
+dyad_rc_t dyad_dtl_shm_send (const dyad_ctx_t* ctx, void* buf, size_t buflen);
+
+dyad_rc_t dyad_dtl_shm_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen);
+
+dyad_rc_t dyad_dtl_shm_close_connection (const dyad_ctx_t* ctx);
+
+dyad_rc_t dyad_dtl_shm_finalize (const dyad_ctx_t* ctx);
+
+#endif /* DYAD_DTL_SHM_H */
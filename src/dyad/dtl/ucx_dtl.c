@@ -5,7 +5,9 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,6 +15,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <dyad/common/dyad_envs.h>
 #include <dyad/common/dyad_logging.h>
 #include <dyad/common/dyad_profiler.h>
 #include <dyad/dtl/ucx_dtl.h>
@@ -21,6 +24,22 @@
 extern const base64_maps_t base64_maps_rfc4648;
 
 #define UCX_MAX_TRANSFER_SIZE (4 * 1024L * 1024L * 1024L)
+// Defaults for the slots of the registered buffer with RMA. Larger files
+// are fetched in pieces of one slot.
+#define UCX_RMA_SLOT_SIZE (256L * 1024L * 1024L)
+#define UCX_RMA_NUM_SLOTS 4ul
+#define UCX_NO_SLOT SIZE_MAX
+// Default payload bytes of a staging slot of the producer without RMA.
+// Larger transfers are staged on the heap.
+#define UCX_STAGING_SLOT_SIZE (256L * 1024L * 1024L)
+// Longest wait of a producer I/O thread for a free staging slot
+#define UCX_SLOT_WAIT_TIMEOUT_S 30
+// Idle progress rounds before waiting on the worker's event fd, and the
+// longest such wait so failed requests are still noticed
+#define UCX_SPIN_COUNT 1000ul
+#define UCX_WAIT_TIMEOUT_MS 100
+// Longest sleep between polls of the RMA buffer once done spinning
+#define UCX_RMA_MAX_BACKOFF_NS 1000000L
 
 // Tag mask for UCX Tag send/recv
 #define DYAD_UCX_TAG_MASK UINT64_MAX
@@ -76,6 +95,37 @@ static void dyad_send_callback (void* req, ucs_status_t status)
     DYAD_C_FUNCTION_END ();
 }
 
+/* Progress the worker. Once it has been idle for spin_count rounds, sleep
+ * on its event fd until UCX has new events instead of spinning. Returns
+ * true if it slept, so callers can check on the peer meanwhile. */
+static bool ucx_progress_or_wait (const dyad_ctx_t* ctx, unsigned long* idle_rounds)
+{
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    ucs_status_t status = UCS_OK;
+    struct pollfd pfd;
+    if (ucp_worker_progress (dtl_handle->ucx_worker) > 0u) {
+        *idle_rounds = 0ul;
+        return false;
+    }
+    if (dtl_handle->efd < 0 || ++(*idle_rounds) < dtl_handle->spin_count) {
+        return false;
+    }
+    status = ucp_worker_arm (dtl_handle->ucx_worker);
+    if (status == UCS_ERR_BUSY) {
+        // Events arrived since the last progress
+        return false;
+    }
+    if (UCX_STATUS_FAIL (status)) {
+        DYAD_LOG_ERROR (ctx, "Could not arm the UCP worker (status = %d)", status);
+        return false;
+    }
+    pfd.fd = dtl_handle->efd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    poll (&pfd, 1, UCX_WAIT_TIMEOUT_MS);
+    return true;
+}
+
 // Simple function used to wait on the async receive
 static ucs_status_t dyad_ucx_request_wait (const dyad_ctx_t* ctx, dyad_ucx_request_t* request)
 {
@@ -88,14 +138,11 @@ static ucs_status_t dyad_ucx_request_wait (const dyad_ctx_t* ctx, dyad_ucx_reque
         // If 'request' is actually a request handle, this means the communication
         // operation is scheduled, but not yet completed.
         if (UCS_PTR_IS_PTR (request)) {
-            // Spin lock until the request is completed
-            // The spin lock shouldn't be costly (performance-wise)
-            // because the wait should always come directly after other UCX calls
-            // that minimize the size of the worker's event queue.
-            // In other words, prior UCX calls should mean that this loop only runs
-            // a couple of times at most.
+            // Spin for a while since the request usually completes quickly,
+            // then sleep until the worker has events to progress
+            unsigned long idle_rounds = 0ul;
             do {
-                ucp_worker_progress (ctx->dtl_handle->private_dtl.ucx_dtl_handle->ucx_worker);
+                ucx_progress_or_wait (ctx, &idle_rounds);
 
                 // Get the final status of the communication operation
                 final_request_status = ucp_request_check_status (request);
@@ -122,6 +169,59 @@ dtl_ucx_request_wait_region_finish:;
     return final_request_status;
 }
 
+// Bytes between two slots of net_buf: a header and the payload
+static inline size_t ucx_slot_stride (const dyad_dtl_ucx_t* dtl_handle)
+{
+    return dtl_handle->max_transfer_size + sizeof (dyad_dtl_rma_header_t);
+}
+
+static inline char* ucx_slot_buf (const dyad_dtl_ucx_t* dtl_handle, size_t slot)
+{
+    return (char*)dtl_handle->net_buf + slot * ucx_slot_stride (dtl_handle);
+}
+
+// Index of the slot holding buf, or UCX_NO_SLOT if buf is not in net_buf
+static inline size_t ucx_slot_of (const dyad_dtl_ucx_t* dtl_handle, const void* buf)
+{
+    const char* base = (const char*)dtl_handle->net_buf;
+    if (base == NULL || (const char*)buf < base
+        || (const char*)buf >= base + dtl_handle->num_slots * ucx_slot_stride (dtl_handle)) {
+        return UCX_NO_SLOT;
+    }
+    return (size_t)((const char*)buf - base) / ucx_slot_stride (dtl_handle);
+}
+
+// Index of a free slot, or UCX_NO_SLOT if all of them are in use
+static inline size_t ucx_free_slot (const dyad_dtl_ucx_t* dtl_handle)
+{
+    size_t i;
+    for (i = 0ul; i < dtl_handle->num_slots; i++) {
+        if (dtl_handle->slots[i].state == DYAD_UCX_SLOT_FREE) {
+            return i;
+        }
+    }
+    return UCX_NO_SLOT;
+}
+
+/* Sends from a staging slot of the producer reuse the registration of
+ * net_buf instead of having UCX look it up or register it again */
+static inline void ucx_set_send_memh (const dyad_dtl_ucx_t* dtl_handle,
+                                      const void* buf,
+                                      ucp_request_param_t* params)
+{
+#if UCP_API_VERSION >= UCP_VERSION(1, 13)
+    if (dtl_handle->comm_mode == DYAD_COMM_SEND && dtl_handle->mem_handle != NULL
+        && ucx_slot_of (dtl_handle, buf) != UCX_NO_SLOT) {
+        params->op_attr_mask |= UCP_OP_ATTR_FIELD_MEMH;
+        params->memh = dtl_handle->mem_handle;
+    }
+#else   // UCP_API_VERSION
+    (void)dtl_handle;
+    (void)buf;
+    (void)params;
+#endif  // UCP_API_VERSION
+}
+
 static dyad_rc_t ucx_allocate_buffer (const dyad_ctx_t* ctx,
                                       dyad_dtl_ucx_t* dtl_handle,
                                       dyad_dtl_comm_mode_t comm_mode)
@@ -146,7 +246,7 @@ static dyad_rc_t ucx_allocate_buffer (const dyad_ctx_t* ctx,
                              | UCP_MEM_MAP_PARAM_FIELD_PROT;
     mmap_params.address = NULL;
     mmap_params.memory_type = UCS_MEMORY_TYPE_HOST;
-    mmap_params.length = dtl_handle->max_transfer_size + sizeof (size_t);
+    mmap_params.length = dtl_handle->num_slots * ucx_slot_stride (dtl_handle);
     mmap_params.flags = UCP_MEM_MAP_ALLOCATE;
     if (dtl_handle->comm_mode == DYAD_COMM_SEND) {
         mmap_params.prot = UCP_MEM_MAP_PROT_LOCAL_READ;
@@ -246,6 +346,7 @@ static inline ucs_status_ptr_t ucx_send_no_wait (const dyad_ctx_t* ctx,
     ucp_request_param_t params;
     params.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK;
     params.cb.send = dyad_send_callback;
+    ucx_set_send_memh (dtl_handle, buf, &params);
     DYAD_LOG_DEBUG (ctx, "Sending data to consumer with ucp_tag_send_nbx");
     stat_ptr = ucp_tag_send_nbx (dtl_handle->ep, buf, buflen, dtl_handle->comm_tag, &params);
 #else   // UCP_API_VERSION
@@ -258,16 +359,23 @@ static inline ucs_status_ptr_t ucx_send_no_wait (const dyad_ctx_t* ctx,
                                 dyad_send_callback);
 #endif  // UCP_API_VERSION
 #else   // DYAD_ENABLE_UCX_RMA
-    ucs_status_t status =
-        ucp_ep_rkey_unpack (dtl_handle->ep, dtl_handle->rkey_buf, &(dtl_handle->rkey));
-    if (UCX_STATUS_FAIL (status)) {
-        DYAD_LOG_ERROR (ctx, "ucp_ep_rkey_unpack failed");
+    if (dtl_handle->rkey == NULL) {
+        DYAD_LOG_ERROR (ctx, "No rkey for the consumer buffer");
         stat_ptr = (void*)UCS_ERR_NOT_CONNECTED;
         goto ucx_send_no_wait_done;
     }
+    if (!is_warmup && dtl_handle->cons_buf_len > 0ul && buflen > dtl_handle->cons_buf_len) {
+        DYAD_LOG_ERROR (ctx,
+                        "%zu bytes do not fit in the consumer buffer of %zu bytes",
+                        buflen,
+                        dtl_handle->cons_buf_len);
+        stat_ptr = (void*)UCS_ERR_BUFFER_TOO_SMALL;
+        goto ucx_send_no_wait_done;
+    }
     ucp_request_param_t params;
     params.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK;
     params.cb.send = dyad_send_callback;
+    ucx_set_send_memh (dtl_handle, buf, &params);
     stat_ptr = ucp_put_nbx (dtl_handle->ep,
                             buf,
                             buflen,
@@ -289,6 +397,27 @@ ucx_send_no_wait_done:;
     return stat_ptr;
 }
 
+/* Whether the RPC that asked the producer for the data of the current slot
+ * already failed, in which case the data will never arrive. An end of
+ * stream is not a failure because the data can still be in flight. */
+static bool ucx_rpc_failed (const dyad_ctx_t* ctx)
+{
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    dyad_ucx_slot_t* slot = &(dtl_handle->slots[dtl_handle->cur_slot]);
+    if (slot->rpc_f == NULL || flux_future_wait_for (slot->rpc_f, 0.0) < 0) {
+        return false;
+    }
+    if (flux_rpc_get (slot->rpc_f, NULL) < 0 && errno != ENODATA) {
+        slot->rpc_errnum = errno;
+        DYAD_LOG_ERROR (ctx,
+                        "Producer %u failed the request (errno = %d)",
+                        slot->producer_rank,
+                        slot->rpc_errnum);
+        return true;
+    }
+    return false;
+}
+
 static inline ucs_status_ptr_t ucx_recv_no_wait (const dyad_ctx_t* ctx,
                                                  bool is_warmup,
                                                  void** buf,
@@ -300,13 +429,17 @@ static inline ucs_status_ptr_t ucx_recv_no_wait (const dyad_ctx_t* ctx,
     dyad_rc_t rc = DYAD_RC_OK;
     ucp_tag_message_h msg = NULL;
     ucp_tag_recv_info_t msg_info;
+    unsigned long num_probes = 0ul;
+    unsigned long idle_rounds = 0ul;
+    bool slept = false;
     dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
     DYAD_LOG_INFO (ctx, "Poll UCP for incoming data");
-    // TODO: replace this loop with a resiliency response over RPC
     // TODO(Ian): explore whether removing probe makes the overall
     //            recv faster or not
     do {
-        ucp_worker_progress (dtl_handle->ucx_worker);
+        // Every message progressed so far has been probed for, so the
+        // worker can be armed and waited on when it goes idle
+        slept = ucx_progress_or_wait (ctx, &idle_rounds);
         msg = ucp_tag_probe_nb (dtl_handle->ucx_worker,
                                 dtl_handle->comm_tag,
                                 DYAD_UCX_TAG_MASK,
@@ -314,53 +447,13 @@ static inline ucs_status_ptr_t ucx_recv_no_wait (const dyad_ctx_t* ctx,
                                 // Requires calling ucp_tag_msg_recv_nb
                                 // with the ucp_tag_message_h to retrieve message
                                 &msg_info);
+        // Stop waiting if the producer reported a failure over RPC
+        if (msg == NULL && (slept || (++num_probes & 0xFFFul) == 0ul) && ucx_rpc_failed (ctx)) {
+            *buflen = 0;
+            stat_ptr = (ucs_status_ptr_t)UCS_ERR_CANCELED;
+            goto ucx_recv_no_wait_done;
+        }
     } while (msg == NULL);
-    // TODO: This version of the polling code is not supposed to spin-lock,
-    // unlike the code above. Currently, it does not work. Once it starts
-    // working, we can replace the code above with a version of this code.
-    //
-    // while (true)
-    // {
-    //     // Probe the tag recv event at the top
-    //     // of the worker's queue
-    //     DYAD_LOG_INFO (ctx, "Probe UCP worker with tag %lu",
-    //     dtl_handle->comm_tag); msg = ucp_tag_probe_nb(
-    //         dtl_handle->ucx_worker,
-    //         dtl_handle->comm_tag,
-    //         DYAD_UCX_TAG_MASK,
-    //         1, // Remove the message from UCP tracking
-    //         // Requires calling ucp_tag_msg_recv_nb
-    //         // with the ucp_tag_message_h to retrieve message
-    //         &msg_info
-    //     );
-    //     // If data has arrived from the producer plugin,
-    //     // break the loop
-    //     if (msg != NULL)
-    //     {
-    //         DYAD_LOG_INFO (ctx, "Data has arrived, so end
-    //         polling"); break;
-    //     }
-    //     // If data has not arrived, check if there are
-    //     // any other events in the worker's queue.
-    //     // If so, start the loop over to handle the next event
-    //     else if (ucp_worker_progress(dtl_handle->ucx_worker))
-    //     {
-    //         DYAD_LOG_INFO (ctx, "Progressed UCP worker to check if
-    //         any other UCP events are available"); continue;
-    //     }
-    //     // No other events are queued. So, we will wait on new
-    //     // events to come in. By using 'ucp_worker_wait' for this,
-    //     // we let the OS do other work in the meantime (no spin locking).
-    //     DYAD_LOG_INFO (ctx, "Launch pre-emptable wait until UCP
-    //     worker gets new events\n"); status =
-    //     ucp_worker_wait(dtl_handle->ucx_worker);
-    //     // If the wait fails, log an error
-    //     if (UCX_STATUS_FAIL(status))
-    //     {
-    //         DYAD_LOG_INFO (ctx, "Could not wait on the message from
-    //         the producer plugin\n"); return DYAD_RC_UCXWAIT_FAIL;
-    //     }
-    // }
     // The metadata retrived from the probed tag recv event contains
     // the size of the data to be sent.
     // So, use that size to allocate a buffer
@@ -414,21 +507,32 @@ static inline ucs_status_ptr_t ucx_recv_no_wait (const dyad_ctx_t* ctx,
     dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
     ssize_t temp = 0l;
     int is_first = 1;
+    unsigned long num_polls = 0ul;
+    long backoff_ns = 10000L;
     do {
-        memcpy (&temp, dtl_handle->net_buf, sizeof (temp));
+        memcpy (&temp, ucx_slot_buf (dtl_handle, dtl_handle->cur_slot), sizeof (temp));
         ucp_worker_progress (ctx->dtl_handle->private_dtl.ucx_dtl_handle->ucx_worker);
-        nanosleep ((const struct timespec[]){{0, 10000L}}, NULL);
+        // A put into our buffer raises no event on this side, so poll it.
+        // After spinning for a while, back off to longer and longer sleeps.
+        if (temp == 0l && num_polls >= dtl_handle->spin_count) {
+            nanosleep ((const struct timespec[]){{0, backoff_ns}}, NULL);
+            backoff_ns = (2L * backoff_ns < UCX_RMA_MAX_BACKOFF_NS) ? 2L * backoff_ns
+                                                                   : UCX_RMA_MAX_BACKOFF_NS;
+        }
         if (is_first == 1) {
             DYAD_LOG_DEBUG (ctx, "Consumer Waiting for worker to finsih all work");
         }
         is_first = 0;
+        // Stop waiting if the producer reported a failure over RPC
+        if (temp == 0l && (++num_polls % 1000ul) == 0ul && ucx_rpc_failed (ctx)) {
+            stat_ptr = (ucs_status_ptr_t)UCS_ERR_CANCELED;
+            goto ucx_recv_no_wait_done;
+        }
     } while (temp == 0l);
 #endif  // DYAD_ENABLE_UCX_RMA
     DYAD_LOG_DEBUG (ctx, "Consumer finsihed all work");
 
-#ifndef DYAD_ENABLE_UCX_RMA
 ucx_recv_no_wait_done:;
-#endif  // DYAD_ENABLE_UCX_RMA
     DYAD_C_FUNCTION_END ();
     return stat_ptr;
 }
@@ -471,10 +575,25 @@ static dyad_rc_t ucx_warmup (const dyad_ctx_t* ctx)
         DYAD_LOG_ERROR (ctx, "Failed to establish connection with self");
         goto warmup_region_done;
     }
+#ifdef DYAD_ENABLE_UCX_RMA
+    // Sends use the rkey unpacked at connection establishment
+    if (UCX_STATUS_FAIL (
+            ucp_ep_rkey_unpack (ctx->dtl_handle->private_dtl.ucx_dtl_handle->ep,
+                                ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey_buf,
+                                &(ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey)))) {
+        ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey = NULL;
+    }
+#endif  // DYAD_ENABLE_UCX_RMA
     DYAD_LOG_INFO (ctx, "Starting non-blocking send for warmup");
     send_stat_ptr = ucx_send_no_wait (ctx, true, send_buf, 1);
     if ((uintptr_t)send_stat_ptr == (uintptr_t)UCS_ERR_NOT_CONNECTED) {
         DYAD_LOG_ERROR (ctx, "Send failed because there's no endpoint");
+#ifdef DYAD_ENABLE_UCX_RMA
+        if (ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey != NULL) {
+            ucp_rkey_destroy (ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey);
+            ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey = NULL;
+        }
+#endif  // DYAD_ENABLE_UCX_RMA
         free (recv_buf);
         dyad_dtl_ucx_return_buffer (ctx, &send_buf);
         goto warmup_region_done;
@@ -487,6 +606,12 @@ static dyad_rc_t ucx_warmup (const dyad_ctx_t* ctx)
 #endif  // DYAD_ENABLE_UCX_RMA
     DYAD_LOG_INFO (ctx, "Waiting on warmup send to finish");
     send_status = dyad_ucx_request_wait (ctx, send_stat_ptr);
+#ifdef DYAD_ENABLE_UCX_RMA
+    if (ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey != NULL) {
+        ucp_rkey_destroy (ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey);
+        ctx->dtl_handle->private_dtl.ucx_dtl_handle->rkey = NULL;
+    }
+#endif  // DYAD_ENABLE_UCX_RMA
     DYAD_LOG_INFO (ctx, "Disconnecting from self");
     ucx_disconnect (ctx,
                     ctx->dtl_handle->private_dtl.ucx_dtl_handle->ucx_worker,
@@ -522,6 +647,9 @@ dyad_rc_t dyad_dtl_ucx_init (const dyad_ctx_t* ctx,
     ucs_status_t status;
     dyad_rc_t rc = DYAD_RC_OK;
     dyad_dtl_ucx_t* dtl_handle = NULL;
+    char* e = NULL;
+    size_t ep_cache_size = 0ul;
+    double ep_cache_ttl = 0.0;
 
     ctx->dtl_handle->private_dtl.ucx_dtl_handle = malloc (sizeof (struct dyad_dtl_ucx));
     if (ctx->dtl_handle->private_dtl.ucx_dtl_handle == NULL) {
@@ -540,6 +668,9 @@ dyad_rc_t dyad_dtl_ucx_init (const dyad_ctx_t* ctx,
     dtl_handle->mem_handle = NULL;
     dtl_handle->net_buf = NULL;
     dtl_handle->max_transfer_size = UCX_MAX_TRANSFER_SIZE;
+    dtl_handle->slots = NULL;
+    dtl_handle->num_slots = 1ul;
+    dtl_handle->cur_slot = 0ul;
     dtl_handle->ep = NULL;
     dtl_handle->ep_cache = NULL;
     dtl_handle->local_address = NULL;
@@ -547,6 +678,59 @@ dyad_rc_t dyad_dtl_ucx_init (const dyad_ctx_t* ctx,
     dtl_handle->remote_address = NULL;
     dtl_handle->remote_addr_len = 0;
     dtl_handle->comm_tag = 0;
+    dtl_handle->consumer_conn_key = 0;
+    dtl_handle->rkey_buf = NULL;
+    dtl_handle->rkey_size = 0;
+    dtl_handle->rkey = NULL;
+    dtl_handle->cons_buf_len = 0ul;
+    dtl_handle->known_producers = NULL;
+    dtl_handle->known_producers_len = 0ul;
+    dtl_handle->efd = -1;
+    dtl_handle->spin_count = UCX_SPIN_COUNT;
+    if ((e = getenv (DYAD_UCX_SPIN_COUNT_ENV))) {
+        dtl_handle->spin_count = (unsigned long)strtoul (e, NULL, 10);
+    }
+    pthread_mutex_init (&(dtl_handle->slot_lock), NULL);
+    pthread_cond_init (&(dtl_handle->slot_cond), NULL);
+#ifdef DYAD_ENABLE_UCX_RMA
+    // Consumers can have one fetch in flight per slot. Producers read at
+    // most one slot worth of data per request.
+    dtl_handle->max_transfer_size = UCX_RMA_SLOT_SIZE;
+    if ((e = getenv (DYAD_UCX_RMA_SLOT_SIZE_ENV)) && strtoull (e, NULL, 10) > 0ull) {
+        dtl_handle->max_transfer_size = (size_t)strtoull (e, NULL, 10);
+    }
+    if (comm_mode == DYAD_COMM_RECV) {
+        dtl_handle->num_slots = UCX_RMA_NUM_SLOTS;
+        if ((e = getenv (DYAD_UCX_RMA_SLOTS_ENV)) && strtoull (e, NULL, 10) > 0ull) {
+            dtl_handle->num_slots = (size_t)strtoull (e, NULL, 10);
+        }
+    }
+    // The RMA header tells the size of the file, which lets the client fetch
+    // larger files in pieces of one slot
+    ctx->dtl_handle->max_transfer_size = dtl_handle->max_transfer_size;
+    ctx->dtl_handle->max_inflight = (unsigned int)dtl_handle->num_slots;
+#endif  // DYAD_ENABLE_UCX_RMA
+    // Producers stage each read in its own slot, so as many files as there
+    // are slots can be read while another one is being sent
+    if (comm_mode == DYAD_COMM_SEND) {
+        if ((e = getenv (DYAD_UCX_STAGING_BUFS_ENV)) && strtoull (e, NULL, 10) > 0ull) {
+            dtl_handle->num_slots = (size_t)strtoull (e, NULL, 10);
+        }
+        ctx->dtl_handle->max_inflight = (unsigned int)dtl_handle->num_slots;
+#ifndef DYAD_ENABLE_UCX_RMA
+        // Without RMA, nothing bounds a transfer, so slots as large as the
+        // largest one would map num_slots times that much memory
+        dtl_handle->max_transfer_size = UCX_STAGING_SLOT_SIZE;
+        if ((e = getenv (DYAD_UCX_STAGING_SLOT_SIZE_ENV)) && strtoull (e, NULL, 10) > 0ull) {
+            dtl_handle->max_transfer_size = (size_t)strtoull (e, NULL, 10);
+        }
+#endif  // DYAD_ENABLE_UCX_RMA
+    }
+    dtl_handle->slots = calloc (dtl_handle->num_slots, sizeof (dyad_ucx_slot_t));
+    if (dtl_handle->slots == NULL) {
+        DYAD_LOG_ERROR (ctx, "Could not allocate the UCX buffer slots\n");
+        goto error;
+    }
 
     // Read the UCX configuration
     DYAD_LOG_INFO (ctx, "Reading UCP config\n");
@@ -566,7 +750,8 @@ dyad_rc_t dyad_dtl_ucx_init (const dyad_ctx_t* ctx,
     //   * Auto initialization of request objects
     //   * Worker sleep, wakeup, poll, etc. features
     ucx_params.field_mask = UCP_PARAM_FIELD_FEATURES | UCP_PARAM_FIELD_REQUEST_SIZE;
-    ucx_params.features = UCP_FEATURE_RMA | UCP_FEATURE_AMO32 | UCP_FEATURE_TAG;
+    ucx_params.features =
+        UCP_FEATURE_RMA | UCP_FEATURE_AMO32 | UCP_FEATURE_TAG | UCP_FEATURE_WAKEUP;
     ucx_params.request_size = sizeof (struct ucx_request);
     ucx_params.request_init = dyad_ucx_request_init;
 
@@ -595,21 +780,38 @@ dyad_rc_t dyad_dtl_ucx_init (const dyad_ctx_t* ctx,
         DYAD_LOG_ERROR (ctx, "ucp_worker_create failed (status = %d)!\n", status);
         goto error;
     }
+    // Lets waits sleep until the worker has events. Without it, they spin.
+    status = ucp_worker_get_efd (dtl_handle->ucx_worker, &(dtl_handle->efd));
+    if (UCX_STATUS_FAIL (status)) {
+        DYAD_LOG_WARN (ctx, "No event fd for the UCP worker, falling back to polling\n");
+        dtl_handle->efd = -1;
+    }
     // Query the worker for its address
     DYAD_LOG_INFO (ctx, "Get address of UCP worker\n");
     status = ucp_worker_get_address (dtl_handle->ucx_worker,
                                      &(dtl_handle->local_address),
                                      &(dtl_handle->local_addr_len));
 
-    // Initialize endpoint cache
-    rc = dyad_ucx_ep_cache_init (ctx, &(dtl_handle->ep_cache));
+    // Initialize endpoint cache. Its size is read from the environment
+    // because the DTL is created from within dyad_init.
+    if ((e = getenv (DYAD_UCX_EP_CACHE_SIZE_ENV))) {
+        ep_cache_size = (size_t)strtoull (e, NULL, 10);
+    }
+    if ((e = getenv (DYAD_UCX_EP_CACHE_TTL_ENV))) {
+        ep_cache_ttl = strtod (e, NULL);
+    }
+    rc = dyad_ucx_ep_cache_init (ctx, ep_cache_size, ep_cache_ttl, &(dtl_handle->ep_cache));
     if (DYAD_IS_ERROR (rc)) {
         DYAD_LOG_ERROR (ctx, "Cannot create endpoint cache (err code = %d)", (int)rc);
         goto error;
     }
 
-    // Allocate a buffer of max transfer size using UCX
-    ucx_allocate_buffer (ctx, dtl_handle, comm_mode);
+    // Allocate the slots of max transfer size using UCX
+    rc = ucx_allocate_buffer (ctx, dtl_handle, comm_mode);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "Cannot allocate the UCX buffer (err code = %d)", (int)rc);
+        goto error;
+    }
 
     ctx->dtl_handle->rpc_pack = dyad_dtl_ucx_rpc_pack;
     ctx->dtl_handle->rpc_unpack = dyad_dtl_ucx_rpc_unpack;
@@ -621,6 +823,10 @@ dyad_rc_t dyad_dtl_ucx_init (const dyad_ctx_t* ctx,
     ctx->dtl_handle->send = dyad_dtl_ucx_send;
     ctx->dtl_handle->recv = dyad_dtl_ucx_recv;
     ctx->dtl_handle->close_connection = dyad_dtl_ucx_close_connection;
+    if (dtl_handle->efd >= 0) {
+        ctx->dtl_handle->get_event_fd = dyad_dtl_ucx_get_event_fd;
+        ctx->dtl_handle->progress = dyad_dtl_ucx_progress;
+    }
 
     rc = ucx_warmup (ctx);
     if (DYAD_IS_ERROR (rc)) {
@@ -640,6 +846,72 @@ error:;
     DYAD_C_FUNCTION_END ();
     return DYAD_RC_UCXINIT_FAIL;
 }
+/* Whether producer_rank already knows this consumer's UCX address and
+ * rkey from an earlier request */
+static inline bool ucx_producer_is_known (const dyad_dtl_ucx_t* dtl_handle, uint32_t producer_rank)
+{
+    return producer_rank < dtl_handle->known_producers_len
+           && dtl_handle->known_producers[producer_rank] != 0;
+}
+
+static void ucx_set_producer_known (const dyad_ctx_t* ctx, uint32_t producer_rank, bool known)
+{
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    uint8_t* known_producers = NULL;
+    size_t len = 0ul;
+    if (producer_rank >= dtl_handle->known_producers_len) {
+        if (!known)
+            return;
+        len = (size_t)producer_rank + 1ul;
+        known_producers = realloc (dtl_handle->known_producers, len);
+        if (known_producers == NULL) {
+            // The producer will be sent the full connection info again
+            return;
+        }
+        memset (known_producers + dtl_handle->known_producers_len,
+                0,
+                len - dtl_handle->known_producers_len);
+        dtl_handle->known_producers = known_producers;
+        dtl_handle->known_producers_len = len;
+    }
+    dtl_handle->known_producers[producer_rank] = known ? 1 : 0;
+}
+
+/* Make a slot the current one for a new fetch from producer_rank. With RMA,
+ * the producer writes the data into that slot, so it has to be free. */
+static dyad_rc_t ucx_reserve_slot (const dyad_ctx_t* ctx, uint32_t producer_rank)
+{
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    dyad_ucx_slot_t* slot = NULL;
+    size_t i = 0ul;
+    ssize_t temp = 0l;
+#ifdef DYAD_ENABLE_UCX_RMA
+    for (i = 0ul; i < dtl_handle->num_slots; i++) {
+        // A packed slot belongs to a request that never got sent
+        if (dtl_handle->slots[i].state == DYAD_UCX_SLOT_FREE
+            || dtl_handle->slots[i].state == DYAD_UCX_SLOT_PACKED) {
+            break;
+        }
+    }
+    if (i == dtl_handle->num_slots) {
+        DYAD_LOG_ERROR (ctx,
+                        "All %zu UCX buffer slots hold data. Release fetched data before "
+                        "fetching more.",
+                        dtl_handle->num_slots);
+        return DYAD_RC_BADBUF;
+    }
+#endif  // DYAD_ENABLE_UCX_RMA
+    slot = &(dtl_handle->slots[i]);
+    slot->state = DYAD_UCX_SLOT_PACKED;
+    slot->producer_rank = producer_rank;
+    slot->rpc_f = NULL;
+    slot->rpc_errnum = 0;
+    dtl_handle->cur_slot = i;
+    // Reset the size header, which recv waits for with RMA
+    memcpy (ucx_slot_buf (dtl_handle, i), &temp, sizeof (temp));
+    return DYAD_RC_OK;
+}
+
 dyad_rc_t dyad_dtl_ucx_rpc_pack (const dyad_ctx_t* ctx,
                                  const char* restrict upath,
                                  uint32_t producer_rank,
@@ -650,17 +922,27 @@ dyad_rc_t dyad_dtl_ucx_rpc_pack (const dyad_ctx_t* ctx,
     DYAD_C_FUNCTION_UPDATE_INT ("producer_rank", producer_rank);
     DYAD_C_FUNCTION_UPDATE_INT ("pid", ctx->pid);
     dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
-    /**
-     * Reset the Buffer so that we can loop on it
-     * as we expect a size_t lets put int -1 as a check.
-     */
-    ssize_t temp = 0;
-    memcpy (dtl_handle->net_buf, &temp, sizeof (temp));
     dyad_rc_t rc = DYAD_RC_OK;
     size_t cons_enc_len = 0;
     char* cons_enc_buf = NULL;
     ssize_t cons_enc_size = 0;
+    size_t rkey_enc_len = 0;
+    char* rkey_enc_buf = NULL;
+    ssize_t rkey_enc_size = 0;
+    // Identifies this consumer process to the producer across requests
+    json_int_t conn = (json_int_t)(((uint64_t)ctx->pid << 32) | ctx->rank);
+    bool known = ucx_producer_is_known (dtl_handle, producer_rank);
 
+    rc = ucx_reserve_slot (ctx, producer_rank);
+    if (DYAD_IS_ERROR (rc)) {
+        goto dtl_ucx_rpc_pack_region_finish;
+    }
+    if (known) {
+        // The producer keeps an endpoint and the rkey for this consumer.
+        // So, only the connection id is needed.
+        DYAD_LOG_DEBUG (ctx, "Reusing the connection with producer %u", producer_rank);
+        goto dtl_ucx_rpc_pack_payload;
+    }
     if (dtl_handle->local_address == NULL) {
         DYAD_LOG_ERROR (dtl_handle, "Tried to pack an RPC payload without a local UCX address");
         rc = DYAD_RC_BADPACK;
@@ -686,16 +968,11 @@ dyad_rc_t dyad_dtl_ucx_rpc_pack (const dyad_ctx_t* ctx,
                                               dtl_handle->local_addr_len);
     if (cons_enc_size < 0) {
         DYAD_LOG_ERROR (ctx, "Unable to encode address\n");
-        // TODO log error
-        free (cons_enc_buf);
         rc = DYAD_RC_BADPACK;
         goto dtl_ucx_rpc_pack_region_finish;
     }
 
     DYAD_LOG_INFO (ctx, "Encode UCP rkey using base64\n");
-    size_t rkey_enc_len = 0;
-    char* rkey_enc_buf = NULL;
-    ssize_t rkey_enc_size = 0;
     rkey_enc_len = base64_encoded_length (dtl_handle->rkey_size);
     // Add 1 to encoded length because the encoded buffer will be
     // packed as if it is a string
@@ -715,11 +992,11 @@ dyad_rc_t dyad_dtl_ucx_rpc_pack (const dyad_ctx_t* ctx,
                                               dtl_handle->rkey_size);
     if (rkey_enc_size < 0) {
         DYAD_LOG_ERROR (ctx, "Unable to encode rkey\n");
-        // TODO log error
-        free (rkey_enc_buf);
         rc = DYAD_RC_BADPACK;
         goto dtl_ucx_rpc_pack_region_finish;
     }
+
+dtl_ucx_rpc_pack_payload:;
 #ifndef DYAD_ENABLE_UCX_RMA
     char* tag_name = "tag_cons";
     uint64_t tag_val;
@@ -744,37 +1021,66 @@ dyad_rc_t dyad_dtl_ucx_rpc_pack (const dyad_ctx_t* ctx,
     DYAD_LOG_INFO (ctx, "Packing RPC payload for UCX DTL\n");
 #else   // DYAD_ENABLE_UCX_RMA
     char* tag_name = "cons_buf";
-    uint64_t tag_val = dtl_handle->cons_buf_ptr;
+    uint64_t tag_val = (uint64_t)ucx_slot_buf (dtl_handle, dtl_handle->cur_slot);
 #endif  // DYAD_ENABLE_UCX_RMA
     char tag_val_buf[128];
     memset (tag_val_buf, 0x00, 128);
     sprintf (tag_val_buf, "%" PRIu64, tag_val);
     DYAD_LOG_INFO (ctx, "Creating Json object %lu with buf %s", tag_val, tag_val_buf);
-    *packed_obj = json_pack ("{s:s, s:i, s:s, s:i, s:s%, s:s%}",
-                             "upath",
-                             upath,
-                             "tag_prod",
-                             (int)producer_rank,
-                             tag_name,
-                             tag_val_buf,
-                             "pid_cons",
-                             ctx->pid,
-                             "addr",
-                             cons_enc_buf,
-                             cons_enc_len,
-                             "rkey",
-                             rkey_enc_buf,
-                             rkey_enc_len);
-    free (cons_enc_buf);
-    free (rkey_enc_buf);
+    if (known) {
+        *packed_obj = json_pack ("{s:s, s:i, s:s, s:i, s:I}",
+                                 "upath",
+                                 upath,
+                                 "tag_prod",
+                                 (int)producer_rank,
+                                 tag_name,
+                                 tag_val_buf,
+                                 "pid_cons",
+                                 ctx->pid,
+                                 "conn",
+                                 conn);
+    } else {
+        *packed_obj = json_pack ("{s:s, s:i, s:s, s:i, s:I, s:s%, s:s%}",
+                                 "upath",
+                                 upath,
+                                 "tag_prod",
+                                 (int)producer_rank,
+                                 tag_name,
+                                 tag_val_buf,
+                                 "pid_cons",
+                                 ctx->pid,
+                                 "conn",
+                                 conn,
+                                 "addr",
+                                 cons_enc_buf,
+                                 cons_enc_len,
+                                 "rkey",
+                                 rkey_enc_buf,
+                                 rkey_enc_len);
+    }
     // If the packing failed, log an error
     if (*packed_obj == NULL) {
         DYAD_LOG_ERROR (ctx, "Could not pack upath and UCX address for RPC\n");
         rc = DYAD_RC_BADPACK;
         goto dtl_ucx_rpc_pack_region_finish;
     }
+#ifdef DYAD_ENABLE_UCX_RMA
+    // Lets the producer refuse data that would overflow the slot
+    if (json_object_set_new (*packed_obj,
+                             "cons_buf_len",
+                             json_integer ((json_int_t)ucx_slot_stride (dtl_handle)))
+        < 0) {
+        DYAD_LOG_ERROR (ctx, "Could not pack the size of the UCX buffer slot for RPC\n");
+        json_decref (*packed_obj);
+        *packed_obj = NULL;
+        rc = DYAD_RC_BADPACK;
+        goto dtl_ucx_rpc_pack_region_finish;
+    }
+#endif  // DYAD_ENABLE_UCX_RMA
     rc = DYAD_RC_OK;
 dtl_ucx_rpc_pack_region_finish:;
+    free (cons_enc_buf);
+    free (rkey_enc_buf);
     DYAD_C_FUNCTION_END ();
     return rc;
 }
@@ -791,6 +1097,8 @@ dyad_rc_t dyad_dtl_ucx_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg,
     uint64_t tag_prod = 0;
     uint64_t tag_cons = 0;
     uint64_t pid = 0;
+    json_int_t conn = -1;
+    json_int_t cons_buf_len = 0;
     ssize_t decoded_len = 0;
     dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
     DYAD_LOG_INFO (ctx, "Unpacking RPC payload\n");
@@ -803,7 +1111,7 @@ dyad_rc_t dyad_dtl_ucx_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg,
     char* tag_value_str = NULL;
     errcode = flux_request_unpack (msg,
                                    NULL,
-                                   "{s:s, s:i, s:s, s:i, s:s%, s:s%}",
+                                   "{s:s, s:i, s:s, s:i, s?I, s?I, s?s%, s?s%}",
                                    "upath",
                                    upath,
                                    "tag_prod",
@@ -812,19 +1120,24 @@ dyad_rc_t dyad_dtl_ucx_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg,
                                    &tag_value_str,
                                    "pid_cons",
                                    &pid,
+                                   "conn",
+                                   &conn,
+                                   "cons_buf_len",
+                                   &cons_buf_len,
                                    "addr",
                                    &enc_addr,
                                    &enc_addr_len,
                                    "rkey",
                                    &enc_rkey,
                                    &enc_rkey_len);
-    tag_val = atoll (tag_value_str);
-    DYAD_LOG_INFO (ctx, "Reading Json object %lu", tag_val);
     if (errcode < 0) {
         DYAD_LOG_ERROR (ctx, "Could not unpack Flux message from consumer!\n");
         rc = DYAD_RC_BADUNPACK;
         goto dtl_ucx_rpc_unpack_region_finish;
     }
+    tag_val = atoll (tag_value_str);
+    DYAD_LOG_INFO (ctx, "Reading Json object %lu", tag_val);
+    dtl_handle->cons_buf_len = cons_buf_len > 0 ? (size_t)cons_buf_len : 0ul;
 #ifndef DYAD_ENABLE_UCX_RMA
     tag_cons = tag_val;
 #else   // DYAD_ENABLE_UCX_RMA
@@ -833,10 +1146,44 @@ dyad_rc_t dyad_dtl_ucx_rpc_unpack (const dyad_ctx_t* ctx, const flux_msg_t* msg,
     DYAD_C_FUNCTION_UPDATE_INT ("pid", pid);
     DYAD_C_FUNCTION_UPDATE_INT ("tag_cons", tag_cons);
     dtl_handle->comm_tag = tag_prod << 32 | tag_cons;
-    dtl_handle->consumer_conn_key = pid << 32 | tag_cons;
+    if (conn >= 0) {
+        dtl_handle->consumer_conn_key = (uint64_t)conn;
+    } else {
+        dtl_handle->consumer_conn_key = pid << 32 | tag_cons;
+    }
     DYAD_C_FUNCTION_UPDATE_INT ("cons_key", dtl_handle->consumer_conn_key);
     DYAD_LOG_INFO (ctx, "Obtained upath from RPC payload: %s\n", *upath);
     DYAD_LOG_INFO (ctx, "Obtained UCP tag from RPC payload: %lu\n", dtl_handle->comm_tag);
+    if (enc_addr == NULL || enc_rkey == NULL) {
+        // The consumer believes we already hold an endpoint and rkey for it
+        if (conn < 0) {
+            DYAD_LOG_ERROR (ctx, "Consumer sent neither its address nor a connection id");
+            rc = DYAD_RC_BADUNPACK;
+            goto dtl_ucx_rpc_unpack_region_finish;
+        }
+        dtl_handle->ep = NULL;
+        rc = dyad_ucx_ep_cache_find (ctx, dtl_handle->ep_cache, NULL, 0ul, &(dtl_handle->ep));
+        if (DYAD_IS_ERROR (rc)) {
+            DYAD_LOG_INFO (ctx,
+                           "No cached connection for consumer %lu. It must resend its address",
+                           dtl_handle->consumer_conn_key);
+            dtl_handle->ep = NULL;
+            rc = DYAD_RC_NOCONN;
+            goto dtl_ucx_rpc_unpack_region_finish;
+        }
+#ifdef DYAD_ENABLE_UCX_RMA
+        rc = dyad_ucx_ep_cache_get_rkey (ctx, dtl_handle->ep_cache, &(dtl_handle->rkey));
+        if (DYAD_IS_ERROR (rc) || dtl_handle->rkey == NULL) {
+            DYAD_LOG_INFO (ctx, "No cached rkey for consumer %lu", dtl_handle->consumer_conn_key);
+            dtl_handle->ep = NULL;
+            dtl_handle->rkey = NULL;
+            rc = DYAD_RC_NOCONN;
+            goto dtl_ucx_rpc_unpack_region_finish;
+        }
+#endif  // DYAD_ENABLE_UCX_RMA
+        rc = DYAD_RC_OK;
+        goto dtl_ucx_rpc_unpack_region_finish;
+    }
     DYAD_LOG_INFO (ctx, "Decoding consumer UCP address using base64\n");
     dtl_handle->remote_addr_len = base64_decoded_length (enc_addr_len);
     dtl_handle->remote_address = (ucp_address_t*)malloc (dtl_handle->remote_addr_len);
@@ -896,6 +1243,12 @@ dyad_rc_t dyad_dtl_ucx_rpc_respond (const dyad_ctx_t* ctx, const flux_msg_t* ori
 dyad_rc_t dyad_dtl_ucx_rpc_recv_response (const dyad_ctx_t* ctx, flux_future_t* f)
 {
     DYAD_C_FUNCTION_START ();
+    // The data arrives over UCX. The future is only watched for a failure
+    // of the producer while waiting for it.
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    dtl_handle->slots[dtl_handle->cur_slot].state = DYAD_UCX_SLOT_POSTED;
+    dtl_handle->slots[dtl_handle->cur_slot].rpc_f = f;
+    dtl_handle->slots[dtl_handle->cur_slot].rpc_errnum = 0;
     DYAD_C_FUNCTION_END ();
     return DYAD_RC_OK;
 }
@@ -905,6 +1258,7 @@ dyad_rc_t dyad_dtl_ucx_get_buffer (const dyad_ctx_t* ctx, size_t data_size, void
     DYAD_C_FUNCTION_START ();
     dyad_rc_t rc = DYAD_RC_OK;
     dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    size_t slot = UCX_NO_SLOT;
     DYAD_LOG_INFO (dtl_handle, "Validating data_buf in get_buffer");
     // TODO(Ian): the second part of this check is (for some reason) evaluating
     //            to true despite `data_buf` being a pointer to a NULL pointer.
@@ -918,6 +1272,15 @@ dyad_rc_t dyad_dtl_ucx_get_buffer (const dyad_ctx_t* ctx, size_t data_size, void
     //     goto ucx_get_buffer_done;
     // }
     DYAD_LOG_INFO (dtl_handle, "Validating data_size in get_buffer");
+#ifndef DYAD_ENABLE_UCX_RMA
+    if (dtl_handle->comm_mode == DYAD_COMM_SEND && data_size > dtl_handle->max_transfer_size) {
+        // Transfers larger than a staging slot are sent from the heap,
+        // which return_buffer frees since the buffer is not in a slot
+        *data_buf = malloc (data_size);
+        rc = (*data_buf == NULL) ? DYAD_RC_SYSFAIL : DYAD_RC_OK;
+        goto ucx_get_buffer_done;
+    }
+#endif  // DYAD_ENABLE_UCX_RMA
     if (data_size > ctx->dtl_handle->private_dtl.ucx_dtl_handle->max_transfer_size) {
         DYAD_LOG_ERROR (dtl_handle,
                         "Requested a data size that's larger than the pre-allocated UCX buffer");
@@ -925,7 +1288,36 @@ dyad_rc_t dyad_dtl_ucx_get_buffer (const dyad_ctx_t* ctx, size_t data_size, void
         goto ucx_get_buffer_done;
     }
     DYAD_LOG_INFO (dtl_handle, "Setting the data buffer pointer to the UCX-allocated buffer");
-    *data_buf = dtl_handle->net_buf;
+    if (dtl_handle->comm_mode == DYAD_COMM_SEND) {
+        // Wait for a staging slot that no other I/O thread holds, but not
+        // forever: a send that never completes would hold its slot for good
+        struct timespec deadline;
+        clock_gettime (CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += UCX_SLOT_WAIT_TIMEOUT_S;
+        pthread_mutex_lock (&(dtl_handle->slot_lock));
+        while ((slot = ucx_free_slot (dtl_handle)) == UCX_NO_SLOT) {
+            if (pthread_cond_timedwait (&(dtl_handle->slot_cond),
+                                        &(dtl_handle->slot_lock),
+                                        &deadline)
+                == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (slot == UCX_NO_SLOT) {
+            pthread_mutex_unlock (&(dtl_handle->slot_lock));
+            DYAD_LOG_ERROR (dtl_handle,
+                            "No staging slot was freed within %d seconds",
+                            UCX_SLOT_WAIT_TIMEOUT_S);
+            errno = EAGAIN;
+            rc = DYAD_RC_BADBUF;
+            goto ucx_get_buffer_done;
+        }
+        dtl_handle->slots[slot].state = DYAD_UCX_SLOT_HELD;
+        pthread_mutex_unlock (&(dtl_handle->slot_lock));
+        *data_buf = ucx_slot_buf (dtl_handle, slot);
+    } else {
+        *data_buf = ucx_slot_buf (dtl_handle, dtl_handle->cur_slot);
+    }
     rc = DYAD_RC_OK;
 
 ucx_get_buffer_done:;
@@ -937,10 +1329,23 @@ dyad_rc_t dyad_dtl_ucx_return_buffer (const dyad_ctx_t* ctx, void** data_buf)
 {
     DYAD_C_FUNCTION_START ();
     dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    size_t slot = UCX_NO_SLOT;
     if (data_buf == NULL || *data_buf == NULL) {
         rc = DYAD_RC_BADBUF;
         goto dtl_ucx_return_buffer_done;
     }
+    slot = ucx_slot_of (dtl_handle, *data_buf);
+    if (slot == UCX_NO_SLOT) {
+        // Data fetched in several pieces is assembled on the heap
+        free (*data_buf);
+    } else {
+        pthread_mutex_lock (&(dtl_handle->slot_lock));
+        dtl_handle->slots[slot].state = DYAD_UCX_SLOT_FREE;
+        dtl_handle->slots[slot].rpc_f = NULL;
+        pthread_cond_signal (&(dtl_handle->slot_cond));
+        pthread_mutex_unlock (&(dtl_handle->slot_lock));
+    }
     *data_buf = NULL;
 dtl_ucx_return_buffer_done:;
     DYAD_C_FUNCTION_END ();
@@ -953,7 +1358,13 @@ dyad_rc_t dyad_dtl_ucx_establish_connection (const dyad_ctx_t* ctx)
     dyad_rc_t rc = DYAD_RC_OK;
     dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
     dyad_dtl_comm_mode_t comm_mode = dtl_handle->comm_mode;
-    if (comm_mode == DYAD_COMM_SEND) {
+    if (comm_mode == DYAD_COMM_SEND && dtl_handle->ep != NULL) {
+        // rpc_unpack already found the endpoint of a known consumer
+        DYAD_LOG_INFO (ctx,
+                       "Reuse the UCP endpoint of consumer %lu\n",
+                       dtl_handle->consumer_conn_key);
+        rc = DYAD_RC_OK;
+    } else if (comm_mode == DYAD_COMM_SEND) {
         DYAD_LOG_INFO (ctx, "Create UCP endpoint for communication with consumer\n");
         rc = dyad_ucx_ep_cache_find (ctx,
                                      dtl_handle->ep_cache,
@@ -975,6 +1386,27 @@ dyad_rc_t dyad_dtl_ucx_establish_connection (const dyad_ctx_t* ctx)
         if (dtl_handle->debug) {
             ucp_ep_print_info (dtl_handle->ep, stderr);
         }
+#ifdef DYAD_ENABLE_UCX_RMA
+        // Unpack the rkey of the consumer once. The endpoint cache keeps it
+        // for later requests of the same consumer.
+        ucs_status_t status =
+            ucp_ep_rkey_unpack (dtl_handle->ep, dtl_handle->rkey_buf, &(dtl_handle->rkey));
+        free (dtl_handle->rkey_buf);
+        dtl_handle->rkey_buf = NULL;
+        dtl_handle->rkey_size = 0;
+        if (UCX_STATUS_FAIL (status)) {
+            DYAD_LOG_ERROR (ctx, "ucp_ep_rkey_unpack failed");
+            dtl_handle->rkey = NULL;
+            rc = DYAD_RC_UCXCOMM_FAIL;
+            goto dtl_ucx_establish_connection_region_finish;
+        }
+        rc = dyad_ucx_ep_cache_set_rkey (ctx, dtl_handle->ep_cache, dtl_handle->rkey);
+        if (DYAD_IS_ERROR (rc)) {
+            ucp_rkey_destroy (dtl_handle->rkey);
+            dtl_handle->rkey = NULL;
+            goto dtl_ucx_establish_connection_region_finish;
+        }
+#endif  // DYAD_ENABLE_UCX_RMA
         rc = DYAD_RC_OK;
     } else if (comm_mode == DYAD_COMM_RECV) {
         DYAD_LOG_INFO (ctx, "No explicit connection establishment needed for UCX receiver\n");
@@ -1016,6 +1448,15 @@ dyad_rc_t dyad_dtl_ucx_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen)
     dyad_rc_t rc = DYAD_RC_OK;
 
     ucs_status_ptr_t stat_ptr = NULL;
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    dyad_ucx_slot_t* slot = NULL;
+#ifdef DYAD_ENABLE_UCX_RMA
+    // A slot passed in *buf selects which of the fetches in flight to wait for
+    if (buf != NULL && *buf != NULL && ucx_slot_of (dtl_handle, *buf) != UCX_NO_SLOT) {
+        dtl_handle->cur_slot = ucx_slot_of (dtl_handle, *buf);
+    }
+#endif  // DYAD_ENABLE_UCX_RMA
+    slot = &(dtl_handle->slots[dtl_handle->cur_slot]);
     // Wait on the recv operation to complete
     stat_ptr = ucx_recv_no_wait (ctx, false, buf, buflen);
 #ifndef DYAD_ENABLE_UCX_RMA
@@ -1024,22 +1465,30 @@ dyad_rc_t dyad_dtl_ucx_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen)
     status = dyad_ucx_request_wait (ctx, stat_ptr);
     // If the recv operation failed, log an error, free the data buffer,
     // and set the buffer pointer to NULL
-    if (UCX_STATUS_FAIL (status)) {
+    if (UCX_STATUS_FAIL (status) && status != UCS_ERR_CANCELED) {
         DYAD_LOG_ERROR (ctx, "UCX recv failed!\n");
         rc = DYAD_RC_UCXCOMM_FAIL;
         goto dtl_ucx_recv_region_finish;
     }
-#else   // DYAD_ENABLE_UCX_RMA
-    (void)stat_ptr;
 #endif  // DYAD_ENABLE_UCX_RMA
+    if (stat_ptr == (ucs_status_ptr_t)UCS_ERR_CANCELED) {
+        if (slot->rpc_errnum == ENOTCONN) {
+            // The producer dropped our endpoint. It needs our address again.
+            ucx_set_producer_known (ctx, slot->producer_rank, false);
+            rc = DYAD_RC_NOCONN;
+        } else {
+            rc = DYAD_RC_BADRPC;
+        }
+        goto dtl_ucx_recv_region_finish;
+    }
 
     DYAD_LOG_INFO (ctx, "Data receive using UCX is successful\n");
     DYAD_LOG_INFO (ctx, "Received %lu bytes from producer\n", *buflen);
+    ucx_set_producer_known (ctx, slot->producer_rank, true);
+    slot->state = DYAD_UCX_SLOT_HELD;
 
     rc = DYAD_RC_OK;
-#ifndef DYAD_ENABLE_UCX_RMA
 dtl_ucx_recv_region_finish:;
-#endif  // DYAD_ENABLE_UCX_RMA
     DYAD_C_FUNCTION_END ();
     return rc;
 }
@@ -1052,26 +1501,19 @@ dyad_rc_t dyad_dtl_ucx_close_connection (const dyad_ctx_t* ctx)
     dyad_dtl_comm_mode_t comm_mode = dtl_handle->comm_mode;
     if (comm_mode == DYAD_COMM_SEND) {
         if (dtl_handle != NULL) {
-            // TODO replace this code (either here or elsewhere) with LRU eviction
-            // rc = ucx_disconnect (ctx, dtl_handle->ucx_worker, dtl_handle->ep);
-            // if (DYAD_IS_ERROR (rc)) {
-            //     DYAD_LOG_ERROR (ctx,
-            //                   "Could not successfully close Endpoint! However, endpoint was "
-            //                   "released.");
-            // }
-#ifdef DYAD_ENABLE_UCX_RMA
-            ucp_rkey_destroy (dtl_handle->rkey);
-#endif  // DYAD_ENABLE_UCX_RMA
+            // The endpoint and the rkey stay in the endpoint cache, which
+            // releases them once they get evicted
+            dtl_handle->rkey = NULL;
             dtl_handle->ep = NULL;
             // Sender doesn't have a consumer address at this time
-            // So, free the consumer address when closing the connection
-            // NOTE: currently removing the deallocation of the remote address
-            //       because it is still in use by the endpoint cache
-            // if (dtl_handle->remote_address != NULL) {
-            //     free (dtl_handle->remote_address);
-            dtl_handle->remote_address = NULL;
-            dtl_handle->remote_addr_len = 0;
-            // }
+            // So, free the consumer address when closing the connection.
+            // ucp_ep_create copies the address, so cached endpoints do not
+            // need it.
+            if (dtl_handle->remote_address != NULL) {
+                free (dtl_handle->remote_address);
+                dtl_handle->remote_address = NULL;
+                dtl_handle->remote_addr_len = 0;
+            }
             dtl_handle->comm_tag = 0;
         }
         DYAD_LOG_INFO (ctx, "UCP endpoint close successful\n");
@@ -1083,6 +1525,7 @@ dyad_rc_t dyad_dtl_ucx_close_connection (const dyad_ctx_t* ctx)
         // be valid for DYAD because DYAD won't send a file from
         // one node to the same node).
         dtl_handle->comm_tag = 0;
+        dtl_handle->slots[dtl_handle->cur_slot].rpc_f = NULL;
         rc = DYAD_RC_OK;
     } else {
         DYAD_LOG_ERROR (ctx, "Somehow, an invalid comm mode reached 'close_connection'\n");
@@ -1093,6 +1536,36 @@ dyad_rc_t dyad_dtl_ucx_close_connection (const dyad_ctx_t* ctx)
     return rc;
 }
 
+dyad_rc_t dyad_dtl_ucx_get_event_fd (const dyad_ctx_t* ctx, int* fd)
+{
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    if (fd == NULL || dtl_handle->efd < 0) {
+        return DYAD_RC_BADBUF;
+    }
+    *fd = dtl_handle->efd;
+    return DYAD_RC_OK;
+}
+
+dyad_rc_t dyad_dtl_ucx_progress (const dyad_ctx_t* ctx)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_dtl_ucx_t* dtl_handle = ctx->dtl_handle->private_dtl.ucx_dtl_handle;
+    ucs_status_t status = UCS_OK;
+    // Drain the events, then rearm the event fd for the next ones
+    do {
+        while (ucp_worker_progress (dtl_handle->ucx_worker) > 0u)
+            ;
+        status = ucp_worker_arm (dtl_handle->ucx_worker);
+    } while (status == UCS_ERR_BUSY);
+    if (UCX_STATUS_FAIL (status)) {
+        DYAD_LOG_ERROR (ctx, "Could not arm the UCP worker (status = %d)", status);
+        rc = DYAD_RC_UCXWAIT_FAIL;
+    }
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
 dyad_rc_t dyad_dtl_ucx_finalize (const dyad_ctx_t* ctx)
 {
     DYAD_C_FUNCTION_START ();
@@ -1131,6 +1604,13 @@ dyad_rc_t dyad_dtl_ucx_finalize (const dyad_ctx_t* ctx)
         ucp_cleanup (dtl_handle->ucx_ctx);
         dtl_handle->ucx_ctx = NULL;
     }
+    free (dtl_handle->slots);
+    dtl_handle->slots = NULL;
+    free (dtl_handle->known_producers);
+    dtl_handle->known_producers = NULL;
+    dtl_handle->known_producers_len = 0ul;
+    pthread_cond_destroy (&(dtl_handle->slot_cond));
+    pthread_mutex_destroy (&(dtl_handle->slot_lock));
     // Flux handle should be released by the
     // DYAD context, so it is not released here
     dtl_handle->h = NULL;
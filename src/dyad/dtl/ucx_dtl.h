@@ -7,21 +7,50 @@
 #error "no config"
 #endif
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <ucp/api/ucp.h>
 
 #include <dyad/dtl/dyad_dtl_api.h>
 #include <dyad/dtl/ucx_ep_cache.h>
 
+// State of a slot of the registered buffer. With RMA, each fetch of a
+// consumer owns one slot from rpc_pack until its data is returned. On the
+// producer, slots are staging buffers held from get_buffer to return_buffer.
+enum dyad_ucx_slot_state {
+    DYAD_UCX_SLOT_FREE,
+    DYAD_UCX_SLOT_PACKED,  // Reserved by rpc_pack, request not sent yet
+    DYAD_UCX_SLOT_POSTED,  // Request sent, waiting for the data
+    DYAD_UCX_SLOT_HELD     // Data received, not returned yet
+};
+
+struct dyad_ucx_slot {
+    enum dyad_ucx_slot_state state;
+    uint32_t producer_rank;
+    // RPC of the fetch, watched for failures of the producer
+    flux_future_t* rpc_f;
+    int rpc_errnum;
+};
+typedef struct dyad_ucx_slot dyad_ucx_slot_t;
+
 struct dyad_dtl_ucx {
     flux_t* h;
     dyad_dtl_comm_mode_t comm_mode;
     bool debug;
     ucp_context_h ucx_ctx;
     ucp_worker_h ucx_worker;
+    int efd;                    // Event fd of ucx_worker (-1: poll only)
+    unsigned long spin_count;   // Idle progress rounds before waiting on efd
     ucp_mem_h mem_handle;
     void* net_buf;
-    size_t max_transfer_size;
+    size_t max_transfer_size;  // Payload bytes of a slot
+    // Slots of net_buf, each holding a size header and max_transfer_size bytes
+    dyad_ucx_slot_t* slots;
+    size_t num_slots;
+    size_t cur_slot;  // Slot of the fetch being packed or received
+    // Producer I/O threads take and return staging slots concurrently
+    pthread_mutex_t slot_lock;
+    pthread_cond_t slot_cond;
     ucp_address_t* local_address;
     size_t local_addr_len;
     ucp_address_t* remote_address;
@@ -36,6 +65,10 @@ struct dyad_dtl_ucx {
     uint64_t cons_buf_ptr;
     // Internal for Sender
     ucp_rkey_h rkey;
+    size_t cons_buf_len;  // Capacity of the consumer's slot (0: unknown)
+    // Internal for Receiver: producer ranks holding our endpoint and rkey
+    uint8_t* known_producers;
+    size_t known_producers_len;
 };
 
 typedef struct dyad_dtl_ucx dyad_dtl_ucx_t;
@@ -68,6 +101,10 @@ dyad_rc_t dyad_dtl_ucx_recv (const dyad_ctx_t* ctx, void** buf, size_t* buflen);
 
 dyad_rc_t dyad_dtl_ucx_close_connection (const dyad_ctx_t* ctx);
 
+dyad_rc_t dyad_dtl_ucx_get_event_fd (const dyad_ctx_t* ctx, int* fd);
+
+dyad_rc_t dyad_dtl_ucx_progress (const dyad_ctx_t* ctx);
+
 dyad_rc_t dyad_dtl_ucx_finalize (const dyad_ctx_t* ctx);
 
 #endif /* DYAD_DTL_UCX_H */
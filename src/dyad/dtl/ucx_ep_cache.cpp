@@ -11,7 +11,10 @@
 #include <dyad/common/dyad_structures_int.h>
 // clang-format on
 
+#include <chrono>
 #include <functional>
+#include <iterator>
+#include <list>
 #include <new>
 #include <unordered_map>
 #include <utility>
@@ -22,7 +25,23 @@
 #include <dyad/dtl/ucx_ep_cache.h>
 
 using key_type = uint64_t;
-using cache_type = std::unordered_map<key_type, ucp_ep_h>;
+using clock_type = std::chrono::steady_clock;
+
+struct entry_type {
+    key_type key;
+    ucp_ep_h ep;
+    ucp_rkey_h rkey;  // Consumer's buffer for RMA, unpacked once per connection
+    clock_type::time_point last_used;
+};
+
+// Most recently used endpoints are at the front of the list
+struct cache_type {
+    size_t capacity;
+    std::chrono::duration<double> ttl;
+    std::list<entry_type> lru;
+    std::unordered_map<key_type, std::list<entry_type>::iterator> index;
+    dyad_ucx_ep_cache_stats_t stats;
+};
 
 static void __attribute__ ((unused)) dyad_ucx_ep_err_handler (void *arg,
                                                               ucp_ep_h ep,
@@ -112,24 +131,48 @@ ucx_disconnect_region_finish:
     return rc;
 }
 
-dyad_rc_t dyad_ucx_ep_cache_init (const dyad_ctx_t *ctx, ucx_ep_cache_h *cache)
+dyad_rc_t dyad_ucx_ep_cache_init (const dyad_ctx_t *ctx,
+                                  size_t capacity,
+                                  double ttl,
+                                  ucx_ep_cache_h *cache)
 {
     DYAD_C_FUNCTION_START ();
     dyad_rc_t rc = DYAD_RC_OK;
+    cache_type *cpp_cache = nullptr;
     if (cache == nullptr || *cache != nullptr) {
         rc = DYAD_RC_BADBUF;
         goto ucx_ep_cache_init_done;
     }
-    *cache = reinterpret_cast<ucx_ep_cache_h> (new (std::nothrow) cache_type ());
-    if (*cache == nullptr) {
+    cpp_cache = new (std::nothrow) cache_type ();
+    if (cpp_cache == nullptr) {
         rc = DYAD_RC_SYSFAIL;
         goto ucx_ep_cache_init_done;
     }
+    cpp_cache->capacity = capacity;
+    cpp_cache->ttl = std::chrono::duration<double> (ttl);
+    cpp_cache->stats = dyad_ucx_ep_cache_stats_t{0ul, 0ul, 0ul};
+    *cache = reinterpret_cast<ucx_ep_cache_h> (cpp_cache);
 ucx_ep_cache_init_done:;
     DYAD_C_FUNCTION_END ();
     return rc;
 }
 
+static inline std::list<entry_type>::iterator cache_evict_impl (const dyad_ctx_t *ctx,
+                                                                cache_type *cache,
+                                                                std::list<entry_type>::iterator it,
+                                                                ucp_worker_h worker)
+{
+    DYAD_C_FUNCTION_START ();
+    if (it->rkey != nullptr) {
+        ucp_rkey_destroy (it->rkey);
+    }
+    ucx_disconnect (ctx, worker, it->ep);
+    cache->index.erase (it->key);
+    auto next_it = cache->lru.erase (it);
+    DYAD_C_FUNCTION_END ();
+    return next_it;
+}
+
 dyad_rc_t dyad_ucx_ep_cache_find (const dyad_ctx_t *ctx,
                                   const ucx_ep_cache_h cache,
                                   const ucp_address_t *addr,
@@ -143,14 +186,31 @@ dyad_rc_t dyad_ucx_ep_cache_find (const dyad_ctx_t *ctx,
         goto ucx_ep_cache_find_done;
     }
     try {
-        const auto *cpp_cache = reinterpret_cast<const cache_type *> (cache);
+        auto *cpp_cache = reinterpret_cast<cache_type *> (cache);
         auto key = ctx->dtl_handle->private_dtl.ucx_dtl_handle->consumer_conn_key;
-        auto cache_it = cpp_cache->find (key);
-        if (cache_it == cpp_cache->cend ()) {
+        auto cache_it = cpp_cache->index.find (key);
+        auto now = clock_type::now ();
+        if (cache_it != cpp_cache->index.end () && cpp_cache->ttl.count () > 0.0
+            && now - cache_it->second->last_used > cpp_cache->ttl) {
+            // The consumer has been idle for too long. Reconnect in case it
+            // went away.
+            DYAD_LOG_DEBUG (ctx, "Endpoint for consumer %lu expired", (unsigned long)key);
+            cache_evict_impl (ctx,
+                              cpp_cache,
+                              cache_it->second,
+                              ctx->dtl_handle->private_dtl.ucx_dtl_handle->ucx_worker);
+            cpp_cache->stats.evictions++;
+            cache_it = cpp_cache->index.end ();
+        }
+        if (cache_it == cpp_cache->index.end ()) {
+            cpp_cache->stats.misses++;
             *ep = nullptr;
             rc = DYAD_RC_NOTFOUND;
         } else {
-            *ep = cache_it->second;
+            cpp_cache->stats.hits++;
+            cache_it->second->last_used = now;
+            cpp_cache->lru.splice (cpp_cache->lru.begin (), cpp_cache->lru, cache_it->second);
+            *ep = cache_it->second->ep;
             rc = DYAD_RC_OK;
         }
     } catch (...) {
@@ -175,14 +235,27 @@ dyad_rc_t dyad_ucx_ep_cache_insert (const dyad_ctx_t *ctx,
         uint64_t key = ctx->dtl_handle->private_dtl.ucx_dtl_handle->consumer_conn_key;
         DYAD_C_FUNCTION_UPDATE_INT ("cons_key",
                                     ctx->dtl_handle->private_dtl.ucx_dtl_handle->consumer_conn_key)
-        auto cache_it = cpp_cache->find (key);
-        if (cache_it != cpp_cache->end ()) {
+        auto cache_it = cpp_cache->index.find (key);
+        if (cache_it != cpp_cache->index.end ()) {
             rc = DYAD_RC_OK;
         } else {
             DYAD_LOG_INFO (ctx, "No cache entry found. Creating new connection");
             rc = ucx_connect (ctx, worker, addr, &ctx->dtl_handle->private_dtl.ucx_dtl_handle->ep);
             if (!DYAD_IS_ERROR (rc)) {
-                cpp_cache->insert_or_assign (key, ctx->dtl_handle->private_dtl.ucx_dtl_handle->ep);
+                cpp_cache->lru.push_front (
+                    entry_type{key,
+                               ctx->dtl_handle->private_dtl.ucx_dtl_handle->ep,
+                               nullptr,
+                               clock_type::now ()});
+                cpp_cache->index.emplace (key, cpp_cache->lru.begin ());
+                // Make room by closing the least recently used endpoints
+                while (cpp_cache->capacity > 0ul && cpp_cache->lru.size () > cpp_cache->capacity) {
+                    DYAD_LOG_DEBUG (ctx,
+                                    "Evicting endpoint for consumer %lu",
+                                    (unsigned long)cpp_cache->lru.back ().key);
+                    cache_evict_impl (ctx, cpp_cache, std::prev (cpp_cache->lru.end ()), worker);
+                    cpp_cache->stats.evictions++;
+                }
                 rc = DYAD_RC_OK;
             }
         }
@@ -193,25 +266,6 @@ dyad_rc_t dyad_ucx_ep_cache_insert (const dyad_ctx_t *ctx,
     return rc;
 }
 
-static inline cache_type::iterator cache_remove_impl (const dyad_ctx_t *ctx,
-                                                      cache_type *cache,
-                                                      cache_type::iterator it,
-                                                      ucp_worker_h worker)
-{
-    DYAD_C_FUNCTION_START ();
-    if (it != cache->end ()) {
-        ucx_disconnect (ctx, worker, it->second);
-        // The UCP address was allocated with 'malloc' while unpacking
-        // the RPC message. So, we extract it from the key and free
-        // it after erasing the iterator
-        auto next_it = cache->erase (it);
-        DYAD_C_FUNCTION_END ();
-        return next_it;
-    }
-    DYAD_C_FUNCTION_END ();
-    return cache->end ();
-}
-
 dyad_rc_t dyad_ucx_ep_cache_remove (const dyad_ctx_t *ctx,
                                     ucx_ep_cache_h cache,
                                     const ucp_address_t *addr,
@@ -223,8 +277,10 @@ dyad_rc_t dyad_ucx_ep_cache_remove (const dyad_ctx_t *ctx,
     try {
         cache_type *cpp_cache = reinterpret_cast<cache_type *> (cache);
         auto key = ctx->dtl_handle->private_dtl.ucx_dtl_handle->consumer_conn_key;
-        cache_type::iterator cache_it = cpp_cache->find (key);
-        cache_remove_impl (ctx, cpp_cache, cache_it, worker);
+        auto cache_it = cpp_cache->index.find (key);
+        if (cache_it != cpp_cache->index.end ()) {
+            cache_evict_impl (ctx, cpp_cache, cache_it->second, worker);
+        }
         rc = DYAD_RC_OK;
     } catch (...) {
         rc = DYAD_RC_SYSFAIL;
@@ -233,6 +289,58 @@ dyad_rc_t dyad_ucx_ep_cache_remove (const dyad_ctx_t *ctx,
     return rc;
 }
 
+dyad_rc_t dyad_ucx_ep_cache_set_rkey (const dyad_ctx_t *ctx, ucx_ep_cache_h cache, ucp_rkey_h rkey)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    cache_type *cpp_cache = reinterpret_cast<cache_type *> (cache);
+    auto key = ctx->dtl_handle->private_dtl.ucx_dtl_handle->consumer_conn_key;
+    auto cache_it = cpp_cache->index.find (key);
+    if (cache_it == cpp_cache->index.end ()) {
+        rc = DYAD_RC_NOTFOUND;
+        goto ucx_ep_cache_set_rkey_done;
+    }
+    if (cache_it->second->rkey != nullptr && cache_it->second->rkey != rkey) {
+        ucp_rkey_destroy (cache_it->second->rkey);
+    }
+    cache_it->second->rkey = rkey;
+ucx_ep_cache_set_rkey_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+dyad_rc_t dyad_ucx_ep_cache_get_rkey (const dyad_ctx_t *ctx,
+                                      const ucx_ep_cache_h cache,
+                                      ucp_rkey_h *rkey)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    const auto *cpp_cache = reinterpret_cast<const cache_type *> (cache);
+    auto key = ctx->dtl_handle->private_dtl.ucx_dtl_handle->consumer_conn_key;
+    auto cache_it = cpp_cache->index.find (key);
+    if (cache_it == cpp_cache->index.end () || cache_it->second->rkey == nullptr) {
+        *rkey = nullptr;
+        rc = DYAD_RC_NOTFOUND;
+    } else {
+        *rkey = cache_it->second->rkey;
+    }
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+void dyad_ucx_ep_cache_get_stats (const ucx_ep_cache_h cache, dyad_ucx_ep_cache_stats_t *stats)
+{
+    const auto *cpp_cache = reinterpret_cast<const cache_type *> (cache);
+    if (stats == nullptr) {
+        return;
+    }
+    if (cpp_cache == nullptr) {
+        *stats = dyad_ucx_ep_cache_stats_t{0ul, 0ul, 0ul};
+        return;
+    }
+    *stats = cpp_cache->stats;
+}
+
 dyad_rc_t dyad_ucx_ep_cache_finalize (const dyad_ctx_t *ctx,
                                       ucx_ep_cache_h *cache,
                                       ucp_worker_h worker)
@@ -242,8 +350,13 @@ dyad_rc_t dyad_ucx_ep_cache_finalize (const dyad_ctx_t *ctx,
         return DYAD_RC_OK;
     }
     cache_type *cpp_cache = reinterpret_cast<cache_type *> (*cache);
-    for (cache_type::iterator it = cpp_cache->begin (); it != cpp_cache->end ();) {
-        it = cache_remove_impl (ctx, cpp_cache, it, worker);
+    DYAD_LOG_INFO (ctx,
+                   "UCX endpoint cache: %lu hits, %lu misses, %lu evictions",
+                   (unsigned long)cpp_cache->stats.hits,
+                   (unsigned long)cpp_cache->stats.misses,
+                   (unsigned long)cpp_cache->stats.evictions);
+    for (auto it = cpp_cache->lru.begin (); it != cpp_cache->lru.end ();) {
+        it = cache_evict_impl (ctx, cpp_cache, it, worker);
     }
     delete cpp_cache;
     *cache = nullptr;
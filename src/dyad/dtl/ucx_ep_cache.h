@@ -32,8 +32,19 @@ dyad_rc_t ucx_connect (const dyad_ctx_t *ctx,
 
 dyad_rc_t ucx_disconnect (const dyad_ctx_t *ctx, ucp_worker_h worker, ucp_ep_h ep);
 
-// NOTE: in future, add option to configure replacement strategy
-dyad_rc_t dyad_ucx_ep_cache_init (const dyad_ctx_t *ctx, ucx_ep_cache_h *cache);
+typedef struct dyad_ucx_ep_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;  // Endpoints closed to make room or because they expired
+} dyad_ucx_ep_cache_stats_t;
+
+// Endpoints are replaced in least recently used order once the cache holds
+// capacity of them (0: unbounded). An endpoint unused for more than ttl
+// seconds is reconnected on its next use (ttl <= 0: never).
+dyad_rc_t dyad_ucx_ep_cache_init (const dyad_ctx_t *ctx,
+                                  size_t capacity,
+                                  double ttl,
+                                  ucx_ep_cache_h *cache);
 
 // NOTE: not positive if UCP addresses are 100% unique by worker
 dyad_rc_t dyad_ucx_ep_cache_find (const dyad_ctx_t *ctx,
@@ -54,6 +65,16 @@ dyad_rc_t dyad_ucx_ep_cache_remove (const dyad_ctx_t *ctx,
                                     const size_t addr_size,
                                     ucp_worker_h worker);
 
+// The cache owns the remote key of a connection once it is set, and
+// destroys it along with the endpoint
+dyad_rc_t dyad_ucx_ep_cache_set_rkey (const dyad_ctx_t *ctx, ucx_ep_cache_h cache, ucp_rkey_h rkey);
+
+dyad_rc_t dyad_ucx_ep_cache_get_rkey (const dyad_ctx_t *ctx,
+                                      const ucx_ep_cache_h cache,
+                                      ucp_rkey_h *rkey);
+
+void dyad_ucx_ep_cache_get_stats (const ucx_ep_cache_h cache, dyad_ucx_ep_cache_stats_t *stats);
+
 dyad_rc_t dyad_ucx_ep_cache_finalize (const dyad_ctx_t *ctx,
                                       ucx_ep_cache_h *cache,
                                       ucp_worker_h worker);
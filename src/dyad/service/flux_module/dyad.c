@@ -14,6 +14,10 @@
 #error "no config"
 #endif
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif  // _GNU_SOURCE
+
 // clang-format off
 // #include <dyad/core/dyad_core_int.h>
 #include <dyad/common/dyad_dtl.h>
@@ -24,12 +28,17 @@
 #include <dyad/common/dyad_structures_int.h>
 #include <dyad/core/dyad_ctx.h>
 #include <dyad/dtl/dyad_dtl_api.h>
+#include <dyad/utils/compress.h>
+#include <dyad/utils/murmur3.h>
 #include <dyad/utils/read_all.h>
+#include <dyad/utils/segment_store.h>
+#include <dyad/utils/uring_io.h>
 #include <dyad/utils/utils.h>
 // clang-format on
 
 #if defined(__cplusplus)
 #include <cerrno>
+#include <climits>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
@@ -37,6 +46,7 @@
 #include <ctime>
 #else
 #include <errno.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -45,9 +55,13 @@
 #include <time.h>
 #endif  // defined(__cplusplus)
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <linux/limits.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -68,12 +82,271 @@
  * using "flux module load".
  */
 
+// Largest probe a consumer may ask for to time the transfers
+#define DYAD_MOD_PROBE_MAX (4ul << 20)
+// Largest file read on the reactor to be sent in the RPC stream, whatever
+// the consumer asks for with "rpc_max" or "max". Larger files go through
+// the DTL, where I/O workers or chunked streaming take them.
+#define DYAD_MOD_RPC_FILE_MAX (16ul << 20)
+// Most bytes of files read on the reactor for a single dyad.fetch_many
+#define DYAD_MOD_FETCH_MANY_MAX (64ul << 20)
+
+/* Part of a file requested by a consumer. A length of 0 extends the range
+ * to the end of the file. */
+typedef struct dyad_mod_range {
+    off_t offset;
+    size_t length;
+} dyad_mod_range_t;
+
+struct dyad_mod_segment;
+
+/* Where a file packed by its producer is, within a segment the module
+ * keeps open (see dyad_mod_segments_t). The lookup that filled it in pins
+ * the segment, so that fd stays open until dyad_mod_segments_release. */
+typedef struct dyad_mod_packed {
+    int fd;
+    off_t offset;
+    size_t len;
+    struct dyad_mod_segment *seg;
+} dyad_mod_packed_t;
+
+/**
+ * A fetch request handed over to an I/O worker thread. The reactor keeps
+ * ownership of the RPC stream: it is closed by the reactor once the worker
+ * posted the job back.
+ */
+typedef struct dyad_mod_io_job {
+    const flux_msg_t *msg;
+    char fullpath[PATH_MAX + 1];
+    dyad_mod_range_t range;
+    size_t probe;              // Send this many bytes of zeros instead of the file
+    dyad_mod_packed_t packed;  // Segment holding the file (fd -1: read the file)
+    char *inbuf;
+    ssize_t inlen;
+    int errnum;
+    // Chunked streaming: the worker reads into one buffer while the
+    // reactor sends the other one
+    size_t chunk_size;
+    char *chunk_bufs[2];
+    ssize_t chunk_lens[2];
+    int chunk_idx;
+    bool chunk_pending;
+    bool finished;
+    struct dyad_mod_io_job *next;
+} dyad_mod_io_job_t;
+
+/**
+ * Pool of I/O worker threads enabled with the 'io_threads' module option.
+ * Workers take jobs off the pending queue, read the file (and, unless the
+ * DTL has to send from the reactor, send it), then push the job onto the
+ * done queue and wake up the reactor through the notification pipe.
+ */
+typedef struct dyad_mod_io_pool {
+    dyad_ctx_t *ctx;
+    // What the workers use instead of ctx: a copy without the flux handle,
+    // which is only safe to use from the reactor thread. Logging through it
+    // falls back to stderr.
+    dyad_ctx_t worker_ctx;
+    pthread_t *threads;
+    unsigned num_started;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    // Signaled whenever the reactor sent a chunk handed over by a worker
+    pthread_cond_t chunk_cond;
+    // Serializes the use of the DTL handle, which keeps per-transfer state
+    pthread_mutex_t dtl_lock;
+    dyad_mod_io_job_t *pending_head;
+    dyad_mod_io_job_t *pending_tail;
+    dyad_mod_io_job_t *done_head;
+    dyad_mod_io_job_t *done_tail;
+    int notify_fds[2];
+    flux_watcher_t *notify_w;
+    bool shutdown;
+} dyad_mod_io_pool_t;
+
+struct dyad_mod_uring;
+
+/* A fetch whose file is read through the io_uring of the DYAD context */
+typedef struct dyad_mod_uring_job {
+    struct dyad_mod_uring *mu;
+    const flux_msg_t *msg;
+    char fullpath[PATH_MAX + 1];
+    dyad_mod_range_t range;
+    int fd;
+    int direct_fd;  // Same file opened with O_DIRECT (-1: not used)
+    struct flock shared_lock;
+    char *inbuf;
+    ssize_t inlen;
+    unsigned int reads_pending;
+    int errnum;
+    struct dyad_mod_uring_job *next;
+} dyad_mod_uring_job_t;
+
+/* One segment of the file of a job */
+typedef struct dyad_mod_uring_read {
+    dyad_mod_uring_job_t *job;
+    char *buf;
+    size_t len;
+    off_t offset;
+    bool direct;
+} dyad_mod_uring_read_t;
+
+/**
+ * Fetches served by the reactor thread with their file reads queued on
+ * the io_uring of the DYAD context, so that many of them can be in
+ * flight without I/O worker threads. The eventfd of the ring wakes up
+ * the reactor when reads complete.
+ */
+typedef struct dyad_mod_uring {
+    dyad_ctx_t *ctx;
+    flux_watcher_t *w;
+    // Jobs holding a DTL buffer. Beyond max_jobs, jobs wait for one to
+    // finish, since some DTLs only have a few buffers to hand out.
+    unsigned int num_jobs;
+    unsigned int max_jobs;
+    dyad_mod_uring_job_t *wait_head;
+    dyad_mod_uring_job_t *wait_tail;
+    bool shutdown;
+} dyad_mod_uring_t;
+
+#define DYAD_MOD_FETCH_TABLE_BINS 1024u
+#define DYAD_MOD_FETCH_TABLE_MAX_DONE 4096u
+
+/* A consumer waiting for a file that another consumer of the node fetches */
+typedef struct dyad_mod_fetch_waiter {
+    const flux_msg_t *msg;
+    struct dyad_mod_fetch_waiter *next;
+} dyad_mod_fetch_waiter_t;
+
+/**
+ * Fetch of a file by the consumers of this node. The first consumer to
+ * claim a file becomes the leader and transfers it. The others wait until
+ * the leader reports completion. Completed entries remember where the
+ * leader stored the file, so that later consumers can copy it locally.
+ */
+typedef struct dyad_mod_fetch_entry {
+    char *upath;
+    char *path;    // File written by the leader (NULL until done)
+    char *leader;  // Route of the leader's connection (NULL once done)
+    dyad_mod_fetch_waiter_t *waiters_head;
+    dyad_mod_fetch_waiter_t *waiters_tail;
+    struct dyad_mod_fetch_entry *next;       // Next entry in the same bin
+    struct dyad_mod_fetch_entry *done_next;  // Next entry in completion order
+} dyad_mod_fetch_entry_t;
+
+/* In-flight and completed fetches of this node, hashed by upath. Only the
+ * reactor thread uses it. */
+typedef struct dyad_mod_fetch_table {
+    flux_t *h;
+    dyad_mod_fetch_entry_t *bins[DYAD_MOD_FETCH_TABLE_BINS];
+    dyad_mod_fetch_entry_t *done_head;
+    dyad_mod_fetch_entry_t *done_tail;
+    unsigned num_done;
+} dyad_mod_fetch_table_t;
+
+#define DYAD_MOD_SEGMENT_BINS 4096u
+// Most segments open at once. Beyond that, the least recently used one
+// that nobody reads from is closed, and opened again when needed.
+#define DYAD_MOD_SEGMENT_FDS 64u
+
+/* A segment written by a producer, indexed up to scanned */
+typedef struct dyad_mod_segment {
+    char *name;
+    int fd;  // -1 while closed (see DYAD_MOD_SEGMENT_FDS)
+    off_t scanned;
+    off_t size;  // Bytes as of the last scan
+    bool corrupt;
+    bool dirty;      // May have records past scanned
+    bool check;      // May be ready to be retired or compacted
+    bool compacted;  // Its live records were copied already
+    unsigned users;  // Pins of lookups still reading from fd
+    // Index entries pointing into this segment, and the bytes of their
+    // records
+    size_t live;
+    size_t live_bytes;
+    uint64_t last_used;
+    struct dyad_mod_segment *next;
+} dyad_mod_segment_t;
+
+/* Newest record of a packed file */
+typedef struct dyad_mod_segment_entry {
+    char *upath;
+    uint64_t stamp;
+    // Segment holding the data, or NULL if the newest record drops the file
+    dyad_mod_segment_t *seg;
+    off_t offset;
+    size_t len;
+    size_t rec_bytes;                     // Size of the whole record
+    struct dyad_mod_segment_entry *next;  // Next entry in the same bin
+} dyad_mod_segment_entry_t;
+
+/**
+ * Index of the small files that the producers of this broker packed into
+ * segments (see utils/segment_store.h), hashed by upath. Of the records of
+ * a file, the newest one counts, whatever segment it is in. Producers do
+ * not tell the module about new records: an inotify watch on the directory
+ * marks the segments created or appended to, which the next lookup scans
+ * (without inotify, every lookup checks every segment). Only the reactor
+ * thread uses it, and I/O workers read from segments a lookup pinned.
+ * Once the writer of a segment closed it, the segment is removed when
+ * none of its records count anymore, or compacted when those that do
+ * take less than half of it.
+ */
+typedef struct dyad_mod_segments {
+    char dir[PATH_MAX + 1];
+    struct timespec dir_mtime;
+    // The directory may change again within the same mtime tick, so it is
+    // listed again until its mtime is old enough
+    bool dir_settled;
+    int inotify_fd;    // -1: not watching the directory (yet)
+    bool no_inotify;   // inotify is not available
+    bool rescan;       // Events were lost, so check every segment
+    bool dir_changed;  // Segments may have been created
+    unsigned num_open;
+    uint64_t clock;  // Ticks at each lookup, to find the least recently used
+    dyad_mod_segment_t *segments;
+    dyad_mod_segment_entry_t *bins[DYAD_MOD_SEGMENT_BINS];
+} dyad_mod_segments_t;
+
+struct dyad_mod_ctx;
+
+/* A chunked transfer served by the reactor thread, without I/O workers */
+typedef struct dyad_mod_stream {
+    struct dyad_mod_ctx *mod_ctx;
+    const flux_msg_t *msg;
+    char fullpath[PATH_MAX + 1];
+    dyad_mod_range_t range;
+    int fd;
+    struct flock shared_lock;
+    ssize_t len;     // Bytes of the range
+    ssize_t offset;  // Bytes of the range sent so far
+    size_t chunk_size;
+    char *chunk;
+    flux_watcher_t *check_w;
+    flux_watcher_t *idle_w;
+    struct dyad_mod_stream *prev;
+    struct dyad_mod_stream *next;
+} dyad_mod_stream_t;
+
 typedef struct dyad_mod_ctx {
     flux_msg_handler_t **handlers;
     dyad_ctx_t *ctx;
+    dyad_mod_io_pool_t *io_pool;
+    dyad_mod_fetch_table_t *fetch_table;
+    // Progresses the DTL from the reactor when its event fd fires
+    flux_watcher_t *dtl_w;
+    dyad_mod_uring_t *uring;
+    dyad_mod_segments_t *segments;
+    dyad_mod_stream_t *streams;
 } dyad_mod_ctx_t;
 
-const struct dyad_mod_ctx dyad_mod_ctx_default = {NULL, NULL};
+const struct dyad_mod_ctx dyad_mod_ctx_default = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+
+static void dyad_mod_io_pool_destroy (dyad_mod_io_pool_t *pool);
+static void dyad_mod_uring_destroy (dyad_mod_uring_t *mu);
+static void dyad_mod_fetch_table_destroy (dyad_mod_fetch_table_t *table);
+static void dyad_mod_segments_destroy (dyad_mod_segments_t *segs);
+static void dyad_mod_stream_destroy (dyad_mod_stream_t *stream);
 
 static void dyad_mod_fini (void) __attribute__ ((destructor));
 
@@ -98,6 +371,22 @@ static void freectx (void *arg)
 {
     dyad_mod_ctx_t *mod_ctx = (dyad_mod_ctx_t *)arg;
     flux_msg_handler_delvec (mod_ctx->handlers);
+    flux_watcher_destroy (mod_ctx->dtl_w);
+    mod_ctx->dtl_w = NULL;
+    // Streams still sending are dropped along with the module
+    while (mod_ctx->streams != NULL)
+        dyad_mod_stream_destroy (mod_ctx->streams);
+    // Reads in flight use DTL buffers, so finish them before it goes away
+    dyad_mod_uring_destroy (mod_ctx->uring);
+    mod_ctx->uring = NULL;
+    // Workers use the DYAD context, so stop them before it goes away
+    dyad_mod_io_pool_destroy (mod_ctx->io_pool);
+    mod_ctx->io_pool = NULL;
+    // Workers may have been reading from the segments
+    dyad_mod_segments_destroy (mod_ctx->segments);
+    mod_ctx->segments = NULL;
+    dyad_mod_fetch_table_destroy (mod_ctx->fetch_table);
+    mod_ctx->fetch_table = NULL;
     if (mod_ctx->ctx) {
         dyad_ctx_fini ();
         mod_ctx->ctx = NULL;
@@ -117,6 +406,12 @@ static dyad_mod_ctx_t *get_mod_ctx (flux_t *h)
         }
         mod_ctx->handlers = NULL;
         mod_ctx->ctx = NULL;
+        mod_ctx->io_pool = NULL;
+        mod_ctx->fetch_table = NULL;
+        mod_ctx->dtl_w = NULL;
+        mod_ctx->uring = NULL;
+        mod_ctx->segments = NULL;
+        mod_ctx->streams = NULL;
 
         if (flux_aux_set (h, "dyad", mod_ctx, freectx) < 0) {
             DYAD_LOG_STDERR ("DYAD_MOD: flux_aux_set() failed!");
@@ -124,13 +419,1879 @@ static dyad_mod_ctx_t *get_mod_ctx (flux_t *h)
         }
     }
 
-    goto getctx_done;
+    goto getctx_done;
+
+getctx_error:;
+    return NULL;
+
+getctx_done:
+    return mod_ctx;
+}
+
+/* Number of bytes of the range to transfer from a file of file_size bytes,
+ * or -1 if the range starts past the end of the file. Like read(2), a
+ * range starting right at the end of the file is empty. */
+static ssize_t dyad_mod_range_len (const dyad_mod_range_t *range, ssize_t file_size)
+{
+    ssize_t len = 0l;
+    if (range->offset < 0 || range->offset > file_size) {
+        return -1l;
+    }
+    len = file_size - (ssize_t)range->offset;
+    if (range->length > 0ul && range->length < (size_t)len) {
+        len = (ssize_t)range->length;
+    }
+    return len;
+}
+
+/* Unlock and close a file opened by dyad_mod_open_file, keeping errno */
+static void dyad_mod_close_file (dyad_ctx_t *ctx, int fd, struct flock *shared_lock)
+{
+    int saved_errno = errno;
+    dyad_release_flock (ctx, fd, shared_lock);
+    close (fd);
+    errno = saved_errno;
+}
+
+/* Open and lock the file at fullpath, then get a buffer from the DTL for
+ * the requested range. On success, the range goes to *data, within
+ * *inbuf, and is *len bytes long. The file stays open and locked until
+ * dyad_mod_close_file. On failure, errno is set to the value the consumer
+ * should see. */
+static dyad_rc_t dyad_mod_open_file (dyad_ctx_t *ctx,
+                                     const char *fullpath,
+                                     const dyad_mod_range_t *range,
+                                     int *fd,
+                                     struct flock *shared_lock,
+                                     char **inbuf,
+                                     char **data,
+                                     ssize_t *len)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("fullpath", fullpath);
+    dyad_rc_t rc = DYAD_RC_OK;
+    ssize_t file_size = 0l;
+#ifdef DYAD_ENABLE_UCX_RMA
+    dyad_dtl_rma_header_t header;
+#endif
+
+#if DYAD_SPIN_WAIT
+    if (!get_stat (fullpath, 1000U, 1000L)) {
+        DYAD_LOG_ERR (ctx, "DYAD_MOD: Failed to access info on \"%s\".", fullpath);
+        // goto error;
+    }
+#endif  // DYAD_SPIN_WAIT
+
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Reading file %s for transfer", fullpath);
+    *fd = open (fullpath, O_RDONLY);
+
+    if (*fd < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Failed to open file \"%s\".", fullpath);
+        rc = DYAD_RC_BADFIO;
+        goto open_done;
+    }
+    rc = dyad_shared_flock (ctx, *fd, shared_lock);
+    if (DYAD_IS_ERROR (rc)) {
+        goto open_error;
+    }
+    file_size = get_file_size (*fd);
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: file %s has size %zd", fullpath, file_size);
+    if (file_size < 0l) {
+        rc = DYAD_RC_BADFIO;
+        goto open_error;
+    }
+#ifdef DYAD_ENABLE_UCX_RMA
+    header.file_size = file_size;
+#endif
+    // From here on, file_size is the size of the requested range
+    file_size = dyad_mod_range_len (range, file_size);
+    if (file_size < 0l) {
+        DYAD_LOG_ERROR (ctx,
+                        "DYAD_MOD: Range at offset %jd is past the end of \"%s\".",
+                        (intmax_t)range->offset,
+                        fullpath);
+        errno = EINVAL;
+        rc = DYAD_RC_BADFIO;
+        goto open_error;
+    }
+    // posix_memalign may return NULL for a size of 0
+    rc = ctx->dtl_handle->get_buffer (ctx, (file_size > 0l) ? file_size : 1l, (void **)inbuf);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not get a DTL buffer for \"%s\".", fullpath);
+        // A DTL out of buffers for now tells the consumer to try again
+        errno = (errno == EAGAIN) ? EAGAIN : ENOMEM;
+        goto open_error;
+    }
+    *data = *inbuf;
+#ifdef DYAD_ENABLE_UCX_RMA
+    // To reduce the number of RMA calls, we are encoding the size of the
+    // range and of the whole file at the start of the buffer
+    header.len = file_size;
+    memcpy (*inbuf, &header, sizeof (header));
+    *data += sizeof (header);
+#endif
+    *len = file_size;
+    DYAD_C_FUNCTION_UPDATE_INT ("file_size", file_size);
+    rc = DYAD_RC_OK;
+    goto open_done;
+
+open_error:;
+    if (errno == 0)
+        errno = EIO;
+    dyad_mod_close_file (ctx, *fd, shared_lock);
+    *fd = -1;
+
+open_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Open, lock and read the requested range of the file at fullpath into a
+ * buffer obtained from the DTL. On success, *inbuf and *inlen describe the
+ * data to send. On failure, errno is set to the value the consumer should
+ * see. */
+static dyad_rc_t dyad_mod_read_file (dyad_ctx_t *ctx,
+                                     const char *fullpath,
+                                     const dyad_mod_range_t *range,
+                                     char **inbuf,
+                                     ssize_t *inlen)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("fullpath", fullpath);
+    dyad_rc_t rc = DYAD_RC_OK;
+    int fd = -1;
+    ssize_t file_size = 0l;
+    ssize_t read_len = 0l;
+    char *data = NULL;
+    int buf_fd = -1;
+    off_t buf_off = 0;
+    struct flock shared_lock;
+
+    rc = dyad_mod_open_file (ctx, fullpath, range, &fd, &shared_lock, inbuf, &data, &file_size);
+    if (DYAD_IS_ERROR (rc)) {
+        goto read_done;
+    }
+    if (!ctx->posix_io && ctx->dtl_handle->get_buffer_fd != NULL
+        && !DYAD_IS_ERROR (ctx->dtl_handle->get_buffer_fd (ctx, *inbuf, &buf_fd, &buf_off))) {
+        // The buffer is backed by a file, so the kernel can fill it
+        // without copying the data through user space
+        buf_off += (off_t)(data - *inbuf);
+        read_len = copy_range (fd, range->offset, buf_fd, &buf_off, (size_t)file_size);
+        if (read_len < 0l) {
+            read_len = 0l;
+        }
+    }
+    if (read_len < file_size) {
+        ssize_t n = pread_all (fd,
+                               data + read_len,
+                               (size_t)(file_size - read_len),
+                               range->offset + (off_t)read_len);
+        read_len = (n < 0l) ? n : read_len + n;
+    }
+    if (read_len != file_size) {
+        DYAD_LOG_ERROR (ctx,
+                        "DYAD_MOD: Failed to load file \"%s\" only read %zd of %zd. with code "
+                        "%d:%s.",
+                        fullpath,
+                        read_len,
+                        file_size,
+                        errno,
+                        strerror (errno));
+        if (read_len >= 0l || errno == 0)
+            errno = EIO;
+        rc = DYAD_RC_BADFIO;
+        ctx->dtl_handle->return_buffer (ctx, (void **)inbuf);
+        *inbuf = NULL;
+        goto read_close;
+    }
+    // The buffer may start with a header ahead of the data
+    *inlen = (ssize_t)(data - *inbuf) + read_len;
+    rc = DYAD_RC_OK;
+
+read_close:;
+    dyad_mod_close_file (ctx, fd, &shared_lock);
+
+read_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Read the requested range of a packed file into a buffer obtained from
+ * the DTL, as dyad_mod_read_file does, with a single read from its
+ * segment. On failure, errno is set to the value the consumer should see. */
+static dyad_rc_t dyad_mod_read_packed (dyad_ctx_t *ctx,
+                                       const dyad_mod_packed_t *packed,
+                                       const dyad_mod_range_t *range,
+                                       char **inbuf,
+                                       ssize_t *inlen)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+    ssize_t len = dyad_mod_range_len (range, (ssize_t)packed->len);
+    char *data = NULL;
+#ifdef DYAD_ENABLE_UCX_RMA
+    dyad_dtl_rma_header_t header;
+#endif
+
+    if (len < 0l) {
+        errno = EINVAL;
+        rc = DYAD_RC_BADFIO;
+        goto read_packed_done;
+    }
+    // posix_memalign may return NULL for a size of 0
+    rc = ctx->dtl_handle->get_buffer (ctx, (len > 0l) ? len : 1l, (void **)inbuf);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not get a DTL buffer for a packed file");
+        errno = ENOMEM;
+        goto read_packed_done;
+    }
+    data = *inbuf;
+#ifdef DYAD_ENABLE_UCX_RMA
+    header.len = len;
+    header.file_size = (ssize_t)packed->len;
+    memcpy (*inbuf, &header, sizeof (header));
+    data += sizeof (header);
+#endif
+    if (pread_all (packed->fd, data, (size_t)len, packed->offset + range->offset) != len) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Failed to read %zd bytes from a segment", len);
+        ctx->dtl_handle->return_buffer (ctx, (void **)inbuf);
+        *inbuf = NULL;
+        errno = EIO;
+        rc = DYAD_RC_BADFIO;
+        goto read_packed_done;
+    }
+    *inlen = (ssize_t)(data - *inbuf) + len;
+    DYAD_C_FUNCTION_UPDATE_INT ("file_size", len);
+    rc = DYAD_RC_OK;
+
+read_packed_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Fill a buffer from the DTL with len bytes of zeros, laid out like the
+ * range of a file read by dyad_mod_read_file. Consumers time such probes
+ * to choose between the DTL and the RPC stream (see dyad_mod_rpc_send). */
+static dyad_rc_t dyad_mod_probe_buffer (dyad_ctx_t *ctx, size_t len, char **inbuf, ssize_t *inlen)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    char *data = NULL;
+#ifdef DYAD_ENABLE_UCX_RMA
+    dyad_dtl_rma_header_t header;
+#endif
+
+    if (len == 0ul || len > DYAD_MOD_PROBE_MAX) {
+        errno = EINVAL;
+        return DYAD_RC_BADBUF;
+    }
+    rc = ctx->dtl_handle->get_buffer (ctx, len, (void **)inbuf);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not get a DTL buffer for a probe");
+        errno = ENOMEM;
+        return rc;
+    }
+    data = *inbuf;
+#ifdef DYAD_ENABLE_UCX_RMA
+    header.len = (ssize_t)len;
+    header.file_size = (ssize_t)len;
+    memcpy (*inbuf, &header, sizeof (header));
+    data += sizeof (header);
+#endif
+    memset (data, 0, len);
+    *inlen = (ssize_t)(data - *inbuf) + (ssize_t)len;
+    return DYAD_RC_OK;
+}
+
+/**
+ * Read the requested range of the file at fullpath into a heap buffer,
+ * after prefix bytes left for the caller, unless the range is larger than
+ * max. For data sent in the RPC stream rather than through the DTL. A
+ * packed file is read from its segment instead (packed is NULL if not).
+ * On success, *buf holds prefix + *len bytes. On failure, errno is set to
+ * the value the consumer should see, EFBIG if the range is too large.
+ */
+static dyad_rc_t dyad_mod_load_range (dyad_ctx_t *ctx,
+                                      const char *fullpath,
+                                      const dyad_mod_packed_t *packed,
+                                      const dyad_mod_range_t *range,
+                                      size_t max,
+                                      size_t prefix,
+                                      char **buf,
+                                      ssize_t *len)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    struct flock shared_lock;
+    ssize_t file_size = 0l;
+    off_t base = 0;
+    int fd = -1;
+
+    *buf = NULL;
+    *len = 0l;
+    if (packed != NULL) {
+        fd = packed->fd;
+        base = packed->offset;
+        file_size = (ssize_t)packed->len;
+    } else {
+        fd = open (fullpath, O_RDONLY);
+        if (fd < 0) {
+            DYAD_LOG_ERROR (ctx, "DYAD_MOD: Failed to open file \"%s\".", fullpath);
+            return DYAD_RC_BADFIO;
+        }
+        rc = dyad_shared_flock (ctx, fd, &shared_lock);
+        if (DYAD_IS_ERROR (rc)) {
+            close (fd);
+            errno = EIO;
+            return rc;
+        }
+        file_size = get_file_size (fd);
+    }
+    *len = (file_size >= 0l) ? dyad_mod_range_len (range, file_size) : -1l;
+    if (*len < 0l) {
+        errno = (file_size >= 0l) ? EINVAL : EIO;
+        rc = DYAD_RC_BADFIO;
+        goto load_close;
+    }
+    if ((size_t)*len > max) {
+        DYAD_LOG_DEBUG (ctx,
+                        "DYAD_MOD: %zd bytes of %s are too many for the RPC stream",
+                        *len,
+                        fullpath);
+        errno = EFBIG;
+        rc = DYAD_RC_TOOBIG;
+        goto load_close;
+    }
+    *buf = (char *)malloc (prefix + (size_t)*len);
+    if (*buf == NULL) {
+        errno = ENOMEM;
+        rc = DYAD_RC_SYSFAIL;
+        goto load_close;
+    }
+    if (pread_all (fd, *buf + prefix, (size_t)*len, base + range->offset) != *len) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Failed to read %zd bytes of \"%s\".", *len, fullpath);
+        free (*buf);
+        *buf = NULL;
+        errno = EIO;
+        rc = DYAD_RC_BADFIO;
+        goto load_close;
+    }
+    rc = DYAD_RC_OK;
+
+load_close:;
+    if (DYAD_IS_ERROR (rc)) {
+        *len = 0l;
+    }
+    if (packed == NULL) {
+        dyad_mod_close_file (ctx, fd, &shared_lock);
+    }
+    return rc;
+}
+
+/* Replace the len bytes of data that follow prefix bytes in *buf with
+ * their compressed frame (see dyad/utils/compress.h), for consumers that
+ * add "compress" to their request. The prefix is kept in front. */
+static dyad_rc_t dyad_mod_compress (dyad_ctx_t *ctx, size_t prefix, char **buf, ssize_t *len)
+{
+    int level = (ctx->compress_level != 0) ? ctx->compress_level : DYAD_COMPRESS_LEVEL_DEFAULT;
+    char *framed = (char *)malloc (prefix + dyad_compress_bound ((size_t)*len));
+
+    if (framed == NULL) {
+        errno = ENOMEM;
+        return DYAD_RC_SYSFAIL;
+    }
+    memcpy (framed, *buf, prefix);
+    *len = (ssize_t)dyad_compress_frame (level, *buf + prefix, (size_t)*len, framed + prefix);
+    free (*buf);
+    *buf = framed;
+    return DYAD_RC_OK;
+}
+
+/**
+ * Send the requested range of the file at fullpath (or of its packed
+ * copy, if packed is not NULL), or probe bytes of zeros, as the payload
+ * of a single response on the RPC stream of msg.
+ * UCX and Margo consumers ask for this with "rpc_max" in the request,
+ * since setting up a transfer through those DTLs costs more than the
+ * transfer itself for small files. A range larger than rpc_max is refused
+ * with EFBIG, and the consumer asks again through the DTL. The DTL is not
+ * used at all, so this is safe while I/O workers are sending. The data
+ * of a file is sent as a compressed frame if compress is set. On failure,
+ * errno is set to the value the consumer should see.
+ */
+static dyad_rc_t dyad_mod_rpc_send (flux_t *h,
+                                    dyad_ctx_t *ctx,
+                                    const flux_msg_t *msg,
+                                    const char *fullpath,
+                                    const dyad_mod_packed_t *packed,
+                                    const dyad_mod_range_t *range,
+                                    size_t rpc_max,
+                                    size_t probe,
+                                    bool compress)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("fullpath", fullpath);
+    dyad_rc_t rc = DYAD_RC_OK;
+    ssize_t len = (ssize_t)probe;
+    char *buf = NULL;
+
+    if (probe == 0ul) {
+        rc = dyad_mod_load_range (ctx, fullpath, packed, range, rpc_max, 0ul, &buf, &len);
+        if (DYAD_IS_ERROR (rc)) {
+            goto rpc_send_done;
+        }
+        if (compress) {
+            rc = dyad_mod_compress (ctx, 0ul, &buf, &len);
+            if (DYAD_IS_ERROR (rc)) {
+                goto rpc_send_done;
+            }
+        }
+    } else if (probe > DYAD_MOD_PROBE_MAX || probe > rpc_max) {
+        errno = (probe > rpc_max) ? EFBIG : EINVAL;
+        rc = DYAD_RC_BADBUF;
+        goto rpc_send_done;
+    } else if ((buf = (char *)calloc (1ul, probe)) == NULL) {
+        errno = ENOMEM;
+        rc = DYAD_RC_SYSFAIL;
+        goto rpc_send_done;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Sending %zd bytes of %s in the RPC stream", len, fullpath);
+    if (flux_respond_raw (h, msg, buf, (int)len) < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not respond with the data of %s", fullpath);
+        rc = DYAD_RC_FLUXFAIL;
+        goto rpc_send_done;
+    }
+    DYAD_C_FUNCTION_UPDATE_INT ("file_size", len);
+    rc = DYAD_RC_OK;
+
+rpc_send_done:;
+    free (buf);
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Push the buffer to the consumer the DTL is currently bound to (i.e.,
+ * the one of the last rpc_unpack). The buffer is always handed back to
+ * the DTL. On failure, errno is set to the value the consumer should see. */
+static dyad_rc_t dyad_mod_send_file (dyad_ctx_t *ctx, char **inbuf, ssize_t inlen)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_rc_t rc = DYAD_RC_OK;
+
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Establish DTL connection with consumer");
+    rc = ctx->dtl_handle->establish_connection (ctx);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not establish DTL connection with client");
+        errno = (rc == DYAD_RC_NOCONN) ? ENOTCONN : ECONNREFUSED;
+        goto send_done;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Send file to consumer with DTL");
+    rc = ctx->dtl_handle->send (ctx, *inbuf, inlen);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not send data to client via DTL\n");
+        errno = ECOMM;
+        goto send_done;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Close DTL connection with consumer");
+    ctx->dtl_handle->close_connection (ctx);
+
+send_done:;
+    ctx->dtl_handle->return_buffer (ctx, (void **)inbuf);
+    *inbuf = NULL;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* Unpack msg again so that the per-transfer state of the DTL refers to
+ * its consumer. Used by the I/O workers, which send long after the
+ * request callback returned. */
+static dyad_rc_t dyad_mod_bind_consumer (dyad_ctx_t *ctx, const flux_msg_t *msg)
+{
+    char *upath = NULL;
+    dyad_rc_t rc = ctx->dtl_handle->rpc_unpack (ctx, msg, &upath);
+    if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not unpack message from client");
+        // ENOTCONN asks the consumer to resend its connection info
+        errno = (rc == DYAD_RC_NOCONN) ? ENOTCONN : EPROTO;
+    }
+    return rc;
+}
+
+/* Close the RPC stream of msg, either with ENODATA on success or with
+ * the error number of the failed transfer. */
+static void dyad_mod_finish_request (flux_t *h, dyad_ctx_t *ctx, const flux_msg_t *msg, int errnum)
+{
+    if (errnum == 0) {
+        DYAD_LOG_DEBUG (ctx,
+                        "DYAD_MOD: Close RPC message stream with an ENODATA (%d) message",
+                        ENODATA);
+        if (flux_respond_error (h, msg, ENODATA, NULL) < 0) {
+            DYAD_LOG_DEBUG (ctx,
+                            "DYAD_MOD: %s: flux_respond_error with ENODATA failed\n",
+                            __func__);
+        }
+        DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Finished %s module invocation\n", DYAD_DTL_RPC_NAME);
+    } else {
+        DYAD_LOG_ERROR (ctx,
+                        "DYAD_MOD: Close RPC message stream with an error (errno = %d)\n",
+                        errnum);
+        if (flux_respond_error (h, msg, errnum, NULL) < 0) {
+            DYAD_LOG_ERROR (ctx, "DYAD_MOD: %s: flux_respond_error", __func__);
+        }
+    }
+}
+
+/* Open and lock the file at fullpath for a chunked transfer of range.
+ * On success, *len is the size of the range. On failure, errno is set to
+ * the value the consumer should see. */
+static dyad_rc_t dyad_mod_stream_open (dyad_ctx_t *ctx,
+                                       const char *fullpath,
+                                       const dyad_mod_range_t *range,
+                                       int *fd,
+                                       struct flock *shared_lock,
+                                       ssize_t *len)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    ssize_t file_size = 0l;
+
+    *fd = open (fullpath, O_RDONLY);
+    if (*fd < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Failed to open file \"%s\".", fullpath);
+        return DYAD_RC_BADFIO;
+    }
+    rc = dyad_shared_flock (ctx, *fd, shared_lock);
+    if (DYAD_IS_ERROR (rc)) {
+        close (*fd);
+        *fd = -1;
+        errno = EIO;
+        return rc;
+    }
+    file_size = get_file_size (*fd);
+    if (file_size < 0l || (file_size = dyad_mod_range_len (range, file_size)) < 0l) {
+        dyad_mod_close_file (ctx, *fd, shared_lock);
+        *fd = -1;
+        errno = EINVAL;
+        return DYAD_RC_BADFIO;
+    }
+    *len = file_size;
+    return DYAD_RC_OK;
+}
+
+static void dyad_mod_stream_destroy (dyad_mod_stream_t *stream)
+{
+    dyad_ctx_t *ctx = stream->mod_ctx->ctx;
+
+    if (stream->prev != NULL)
+        stream->prev->next = stream->next;
+    else
+        stream->mod_ctx->streams = stream->next;
+    if (stream->next != NULL)
+        stream->next->prev = stream->prev;
+    flux_watcher_destroy (stream->check_w);
+    flux_watcher_destroy (stream->idle_w);
+    if (stream->chunk != NULL)
+        ctx->dtl_handle->return_buffer (ctx, (void **)&stream->chunk);
+    dyad_mod_close_file (ctx, stream->fd, &stream->shared_lock);
+    flux_msg_decref (stream->msg);
+    free (stream);
+}
+
+/* Send the next chunk of a stream. Runs once per reactor iteration, after
+ * the events of that iteration were handled, so the other requests are
+ * served between the chunks of a large file. */
+static void dyad_mod_stream_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_mod_stream_t *stream = (dyad_mod_stream_t *)arg;
+    dyad_ctx_t *ctx = stream->mod_ctx->ctx;
+    ssize_t want = stream->len - stream->offset;
+    ssize_t got = 0l;
+    int errnum = 0;
+
+    if (want > (ssize_t)stream->chunk_size)
+        want = (ssize_t)stream->chunk_size;
+    got = pread_all (stream->fd, stream->chunk, want, stream->range.offset + stream->offset);
+    if (got != want) {
+        DYAD_LOG_ERROR (ctx,
+                        "DYAD_MOD: Failed to read chunk at %zd of \"%s\": %zd of %zd bytes.",
+                        stream->offset,
+                        stream->fullpath,
+                        got,
+                        want);
+        errnum = (got < 0 && errno != 0) ? errno : EIO;
+        goto stream_finish;
+    }
+    // Requests served since the previous chunk rebound the DTL
+    if (DYAD_IS_ERROR (dyad_mod_bind_consumer (ctx, stream->msg))) {
+        errnum = errno;
+        goto stream_finish;
+    }
+    if (DYAD_IS_ERROR (ctx->dtl_handle->send (ctx, stream->chunk, got))) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not send chunk to client via DTL\n");
+        errnum = ECOMM;
+        goto stream_finish;
+    }
+    stream->offset += got;
+    if (stream->offset < stream->len) {
+        DYAD_C_FUNCTION_END ();
+        return;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Streamed %zd bytes of %s", stream->offset, stream->fullpath);
+
+stream_finish:;
+    ctx->dtl_handle->close_connection (ctx);
+    dyad_mod_finish_request (ctx->h, ctx, stream->msg, errnum);
+    dyad_mod_stream_destroy (stream);
+    DYAD_C_FUNCTION_END ();
+}
+
+/**
+ * Stream the file at fullpath to the consumer of msg, in responses of at
+ * most chunk_size bytes. Without I/O workers, the chunks are read and
+ * sent from the reactor one at a time (see dyad_mod_stream_cb) rather
+ * than all at once. Only one chunk-sized buffer is needed since the DTL
+ * copies each chunk into the outgoing response. The stream is closed
+ * once the last chunk is sent. On failure, nothing was sent yet and errno
+ * is set to the value the consumer should see.
+ */
+static dyad_rc_t dyad_mod_stream_start (dyad_mod_ctx_t *mod_ctx,
+                                        const flux_msg_t *msg,
+                                        const char *fullpath,
+                                        const dyad_mod_range_t *range,
+                                        size_t chunk_size)
+{
+    DYAD_C_FUNCTION_START ();
+    DYAD_C_FUNCTION_UPDATE_STR ("fullpath", fullpath);
+    DYAD_C_FUNCTION_UPDATE_INT ("chunk_size", chunk_size);
+    dyad_ctx_t *ctx = mod_ctx->ctx;
+    flux_reactor_t *r = flux_get_reactor (ctx->h);
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_mod_stream_t *stream = (dyad_mod_stream_t *)calloc (1, sizeof (*stream));
+
+    if (stream == NULL) {
+        errno = ENOMEM;
+        rc = DYAD_RC_SYSFAIL;
+        goto stream_start_done;
+    }
+    rc = dyad_mod_stream_open (ctx,
+                               fullpath,
+                               range,
+                               &stream->fd,
+                               &stream->shared_lock,
+                               &stream->len);
+    if (DYAD_IS_ERROR (rc)) {
+        free (stream);
+        goto stream_start_done;
+    }
+    stream->mod_ctx = mod_ctx;
+    stream->msg = flux_msg_incref (msg);
+    strncpy (stream->fullpath, fullpath, PATH_MAX);
+    stream->range = *range;
+    // posix_memalign may return NULL for a size of 0
+    stream->chunk_size =
+        (stream->len > 0l && (size_t)stream->len < chunk_size) ? (size_t)stream->len : chunk_size;
+    stream->next = mod_ctx->streams;
+    if (stream->next != NULL)
+        stream->next->prev = stream;
+    mod_ctx->streams = stream;
+    rc = ctx->dtl_handle->get_buffer (ctx, stream->chunk_size, (void **)&stream->chunk);
+    if (DYAD_IS_ERROR (rc)) {
+        stream->chunk = NULL;
+        errno = ENOMEM;
+        goto stream_start_error;
+    }
+    rc = ctx->dtl_handle->establish_connection (ctx);
+    if (DYAD_IS_ERROR (rc)) {
+        errno = ECONNREFUSED;
+        goto stream_start_error;
+    }
+    // The idle watcher keeps the reactor from blocking while chunks are
+    // left to send
+    stream->check_w = flux_check_watcher_create (r, dyad_mod_stream_cb, stream);
+    stream->idle_w = flux_idle_watcher_create (r, NULL, NULL);
+    if (stream->check_w == NULL || stream->idle_w == NULL) {
+        errno = ENOMEM;
+        rc = DYAD_RC_FLUXFAIL;
+        goto stream_start_error;
+    }
+    flux_watcher_start (stream->check_w);
+    flux_watcher_start (stream->idle_w);
+    rc = DYAD_RC_OK;
+    goto stream_start_done;
+
+stream_start_error:;
+    {
+        int saved_errno = errno;
+        dyad_mod_stream_destroy (stream);
+        errno = saved_errno;
+    }
+
+stream_start_done:;
+    DYAD_C_FUNCTION_END ();
+    return rc;
+}
+
+/* The flux handle is only safe to use from the reactor thread, so the
+ * Flux RPC DTL sends file contents from there. The other DTLs send from
+ * the I/O worker that read the file. */
+static inline bool dyad_mod_dtl_sends_on_reactor (const dyad_ctx_t *ctx)
+{
+    return ctx->dtl_handle->mode == DYAD_DTL_FLUX_RPC;
+}
+
+/* Unless it has several staging buffers, the UCX DTL hands out a single
+ * pre-registered buffer from get_buffer, so the file read must be
+ * serialized together with the send. */
+static inline bool dyad_mod_dtl_shares_buffer (const dyad_ctx_t *ctx)
+{
+    return ctx->dtl_handle->mode == DYAD_DTL_UCX && ctx->dtl_handle->max_inflight <= 1u;
+}
+
+/* Hand the chunk in job->chunk_bufs[idx] over to the reactor, after the
+ * previous one has been sent. Returns false if the job must be aborted. */
+static bool dyad_mod_io_post_chunk (dyad_mod_io_pool_t *pool, dyad_mod_io_job_t *job, int idx)
+{
+    const char token = 1;
+    bool ok = true;
+    pthread_mutex_lock (&pool->lock);
+    while (job->chunk_pending && !pool->shutdown)
+        pthread_cond_wait (&pool->chunk_cond, &pool->lock);
+    if (pool->shutdown || job->errnum != 0) {
+        ok = false;
+    } else {
+        job->chunk_idx = idx;
+        job->chunk_pending = true;
+        job->next = NULL;
+        if (pool->done_tail == NULL)
+            pool->done_head = job;
+        else
+            pool->done_tail->next = job;
+        pool->done_tail = job;
+    }
+    pthread_mutex_unlock (&pool->lock);
+    if (ok && write (pool->notify_fds[1], &token, sizeof (token)) < 0 && errno != EAGAIN) {
+        DYAD_LOG_ERROR (&pool->worker_ctx, "DYAD_MOD: Could not notify reactor of a read chunk");
+    }
+    return ok;
+}
+
+/* Worker side of chunked streaming. Reading chunk N+1 overlaps the send
+ * of chunk N on the reactor thread. */
+static void dyad_mod_io_stream_job (dyad_mod_io_pool_t *pool, dyad_mod_io_job_t *job)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_ctx_t *ctx = &pool->worker_ctx;
+    int fd = -1;
+    int idx = 0;
+    ssize_t file_size = 0l;
+    ssize_t offset = 0l;
+    size_t chunk_size = job->chunk_size;
+    struct flock shared_lock;
+
+    fd = open (job->fullpath, O_RDONLY);
+    if (fd < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Failed to open file \"%s\".", job->fullpath);
+        job->errnum = errno;
+        goto stream_job_done;
+    }
+    if (DYAD_IS_ERROR (dyad_shared_flock (ctx, fd, &shared_lock))) {
+        job->errnum = (errno != 0) ? errno : EIO;
+        goto stream_job_close;
+    }
+    file_size = get_file_size (fd);
+    if (file_size < 0l || (file_size = dyad_mod_range_len (&job->range, file_size)) < 0l) {
+        job->errnum = EINVAL;
+        goto stream_job_close;
+    }
+    // posix_memalign may return NULL for a size of 0
+    if (file_size > 0l && (size_t)file_size < chunk_size)
+        chunk_size = (size_t)file_size;
+    for (int i = 0; i < 2; i++) {
+        if (DYAD_IS_ERROR (
+                ctx->dtl_handle->get_buffer (ctx, chunk_size, (void **)&job->chunk_bufs[i]))) {
+            job->chunk_bufs[i] = NULL;
+            job->errnum = ENOMEM;
+            goto stream_job_close;
+        }
+    }
+    while (offset < file_size) {
+        ssize_t want = (file_size - offset) > (ssize_t)chunk_size ? (ssize_t)chunk_size
+                                                                  : (file_size - offset);
+        ssize_t got =
+            pread_all (fd, job->chunk_bufs[idx], want, job->range.offset + offset);
+        if (got != want) {
+            DYAD_LOG_ERROR (ctx,
+                            "DYAD_MOD: Failed to read chunk at %zd of \"%s\": %zd of %zd bytes.",
+                            offset,
+                            job->fullpath,
+                            got,
+                            want);
+            pthread_mutex_lock (&pool->lock);
+            job->errnum = (got < 0 && errno != 0) ? errno : EIO;
+            pthread_mutex_unlock (&pool->lock);
+            break;
+        }
+        job->chunk_lens[idx] = got;
+        if (!dyad_mod_io_post_chunk (pool, job, idx))
+            break;
+        offset += got;
+        idx ^= 1;
+    }
+    // Wait until the reactor is done with the last chunk before the
+    // buffers go away
+    pthread_mutex_lock (&pool->lock);
+    while (job->chunk_pending && !pool->shutdown)
+        pthread_cond_wait (&pool->chunk_cond, &pool->lock);
+    if (pool->shutdown && job->errnum == 0)
+        job->errnum = ECANCELED;
+    pthread_mutex_unlock (&pool->lock);
+
+stream_job_close:;
+    // The reactor no longer touches the buffers: either it sent the last
+    // chunk, or the pool is shutting down from the reactor thread itself
+    for (int i = 0; i < 2; i++) {
+        if (job->chunk_bufs[i] != NULL)
+            ctx->dtl_handle->return_buffer (ctx, (void **)&job->chunk_bufs[i]);
+        job->chunk_bufs[i] = NULL;
+    }
+    dyad_release_flock (ctx, fd, &shared_lock);
+    close (fd);
+
+stream_job_done:;
+    DYAD_C_FUNCTION_END ();
+}
+
+static void *dyad_mod_io_worker (void *arg)
+{
+    dyad_mod_io_pool_t *pool = (dyad_mod_io_pool_t *)arg;
+    dyad_ctx_t *ctx = &pool->worker_ctx;
+    dyad_mod_io_job_t *job = NULL;
+    dyad_rc_t rc = DYAD_RC_OK;
+    const char token = 1;
+
+    for (;;) {
+        pthread_mutex_lock (&pool->lock);
+        while (!pool->shutdown && pool->pending_head == NULL)
+            pthread_cond_wait (&pool->cond, &pool->lock);
+        if (pool->shutdown) {
+            pthread_mutex_unlock (&pool->lock);
+            break;
+        }
+        job = pool->pending_head;
+        pool->pending_head = job->next;
+        if (pool->pending_head == NULL)
+            pool->pending_tail = NULL;
+        job->next = NULL;
+        pthread_mutex_unlock (&pool->lock);
+
+        if (job->chunk_size > 0ul) {
+            dyad_mod_io_stream_job (pool, job);
+            goto post_job;
+        }
+
+        bool serialize_read = dyad_mod_dtl_shares_buffer (ctx);
+        bool send_here = !dyad_mod_dtl_sends_on_reactor (ctx);
+        if (serialize_read)
+            pthread_mutex_lock (&pool->dtl_lock);
+        errno = 0;
+        if (job->probe > 0ul)
+            rc = dyad_mod_probe_buffer (ctx, job->probe, &job->inbuf, &job->inlen);
+        else if (job->packed.fd >= 0)
+            rc = dyad_mod_read_packed (ctx, &job->packed, &job->range, &job->inbuf, &job->inlen);
+        else
+            rc = dyad_mod_read_file (ctx, job->fullpath, &job->range, &job->inbuf, &job->inlen);
+        if (DYAD_IS_ERROR (rc)) {
+            job->errnum = (errno != 0) ? errno : EIO;
+        } else if (send_here) {
+            if (!serialize_read)
+                pthread_mutex_lock (&pool->dtl_lock);
+            rc = dyad_mod_bind_consumer (ctx, job->msg);
+            if (DYAD_IS_ERROR (rc)) {
+                ctx->dtl_handle->return_buffer (ctx, (void **)&job->inbuf);
+                job->inbuf = NULL;
+            } else {
+                rc = dyad_mod_send_file (ctx, &job->inbuf, job->inlen);
+            }
+            if (!serialize_read)
+                pthread_mutex_unlock (&pool->dtl_lock);
+            if (DYAD_IS_ERROR (rc))
+                job->errnum = errno;
+        }
+        if (serialize_read)
+            pthread_mutex_unlock (&pool->dtl_lock);
+
+    post_job:;
+        pthread_mutex_lock (&pool->lock);
+        job->finished = true;
+        // A chunk stranded by shutdown already has the job on the done list
+        if (!job->chunk_pending) {
+            job->next = NULL;
+            if (pool->done_tail == NULL)
+                pool->done_head = job;
+            else
+                pool->done_tail->next = job;
+            pool->done_tail = job;
+        }
+        pthread_mutex_unlock (&pool->lock);
+        if (write (pool->notify_fds[1], &token, sizeof (token)) < 0 && errno != EAGAIN) {
+            DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not notify reactor of a finished fetch");
+        }
+    }
+    return NULL;
+}
+
+static void dyad_mod_segments_release (dyad_mod_packed_t *loc);
+
+/* Runs on the reactor thread whenever an I/O worker finished a job */
+static void dyad_mod_io_done_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_mod_io_pool_t *pool = (dyad_mod_io_pool_t *)arg;
+    dyad_ctx_t *ctx = pool->ctx;
+    dyad_mod_io_job_t *job = NULL;
+    dyad_mod_io_job_t *next = NULL;
+    char drain[64];
+
+    while (read (pool->notify_fds[0], drain, sizeof (drain)) > 0)
+        ;
+
+    pthread_mutex_lock (&pool->lock);
+    job = pool->done_head;
+    pool->done_head = NULL;
+    pool->done_tail = NULL;
+    pthread_mutex_unlock (&pool->lock);
+
+    for (; job != NULL; job = next) {
+        next = job->next;
+        bool finished = false;
+        if (job->chunk_pending) {
+            char *chunk = job->chunk_bufs[job->chunk_idx];
+            int errnum = 0;
+            if (DYAD_IS_ERROR (dyad_mod_bind_consumer (ctx, job->msg))) {
+                errnum = errno;
+            } else if (DYAD_IS_ERROR (ctx->dtl_handle->send (ctx,
+                                                             chunk,
+                                                             job->chunk_lens[job->chunk_idx]))) {
+                DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not send chunk to client via DTL\n");
+                errnum = ECOMM;
+            }
+            // From here on, the worker may post this job again
+            pthread_mutex_lock (&pool->lock);
+            if (errnum != 0)
+                job->errnum = errnum;
+            job->chunk_pending = false;
+            finished = job->finished;
+            pthread_cond_broadcast (&pool->chunk_cond);
+            pthread_mutex_unlock (&pool->lock);
+        } else {
+            finished = job->finished;
+        }
+        if (!finished)
+            continue;
+        if (job->errnum == 0 && job->inbuf != NULL) {
+            if (DYAD_IS_ERROR (dyad_mod_bind_consumer (ctx, job->msg))) {
+                job->errnum = errno;
+                ctx->dtl_handle->return_buffer (ctx, (void **)&job->inbuf);
+                job->inbuf = NULL;
+            } else if (DYAD_IS_ERROR (dyad_mod_send_file (ctx, &job->inbuf, job->inlen))) {
+                job->errnum = errno;
+            }
+        }
+        if (job->errnum != 0) {
+            DYAD_LOG_ERROR (ctx,
+                            "DYAD_MOD: I/O worker failed to serve \"%s\": %s",
+                            job->fullpath,
+                            strerror (job->errnum));
+        }
+        dyad_mod_finish_request (ctx->h, ctx, job->msg, job->errnum);
+        flux_msg_decref (job->msg);
+        dyad_mod_segments_release (&job->packed);
+        free (job);
+    }
+    DYAD_C_FUNCTION_END ();
+}
+
+static void dyad_mod_io_pool_destroy (dyad_mod_io_pool_t *pool)
+{
+    dyad_mod_io_job_t *job = NULL;
+    dyad_mod_io_job_t *next = NULL;
+
+    if (pool == NULL)
+        return;
+    pthread_mutex_lock (&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast (&pool->cond);
+    pthread_cond_broadcast (&pool->chunk_cond);
+    pthread_mutex_unlock (&pool->lock);
+    for (unsigned i = 0u; i < pool->num_started; i++) {
+        pthread_join (pool->threads[i], NULL);
+    }
+    flux_watcher_destroy (pool->notify_w);
+    // Requests that never got to run are dropped along with the module.
+    // Finished ones still own a DTL buffer that has to be given back.
+    for (job = pool->pending_head; job != NULL; job = next) {
+        next = job->next;
+        flux_msg_decref (job->msg);
+        free (job);
+    }
+    for (job = pool->done_head; job != NULL; job = next) {
+        next = job->next;
+        if (job->inbuf != NULL)
+            pool->ctx->dtl_handle->return_buffer (pool->ctx, (void **)&job->inbuf);
+        flux_msg_decref (job->msg);
+        free (job);
+    }
+    if (pool->notify_fds[0] >= 0)
+        close (pool->notify_fds[0]);
+    if (pool->notify_fds[1] >= 0)
+        close (pool->notify_fds[1]);
+    pthread_cond_destroy (&pool->chunk_cond);
+    pthread_cond_destroy (&pool->cond);
+    pthread_mutex_destroy (&pool->dtl_lock);
+    pthread_mutex_destroy (&pool->lock);
+    free (pool->threads);
+    free (pool);
+}
+
+static dyad_rc_t dyad_mod_io_pool_create (flux_t *h,
+                                          dyad_ctx_t *ctx,
+                                          unsigned num_threads,
+                                          dyad_mod_io_pool_t **pool_out)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    dyad_mod_io_pool_t *pool = NULL;
+
+    pool = (dyad_mod_io_pool_t *)calloc (1, sizeof (*pool));
+    if (pool == NULL) {
+        rc = DYAD_RC_SYSFAIL;
+        goto pool_error;
+    }
+    pool->ctx = ctx;
+    pool->worker_ctx = *ctx;
+    pool->worker_ctx.h = NULL;
+    pool->notify_fds[0] = -1;
+    pool->notify_fds[1] = -1;
+    pthread_mutex_init (&pool->lock, NULL);
+    pthread_mutex_init (&pool->dtl_lock, NULL);
+    pthread_cond_init (&pool->cond, NULL);
+    pthread_cond_init (&pool->chunk_cond, NULL);
+
+    if (pipe (pool->notify_fds) < 0) {
+        DYAD_LOG_STDERR ("DYAD_MOD: could not create I/O completion pipe: %s\n",
+                         strerror (errno));
+        rc = DYAD_RC_SYSFAIL;
+        goto pool_error;
+    }
+    // Neither side may block: the reactor drains whatever is there, and a
+    // full pipe already guarantees the reactor will wake up
+    for (int i = 0; i < 2; i++) {
+        fcntl (pool->notify_fds[i], F_SETFL, fcntl (pool->notify_fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl (pool->notify_fds[i], F_SETFD, FD_CLOEXEC);
+    }
+    pool->notify_w = flux_fd_watcher_create (flux_get_reactor (h),
+                                             pool->notify_fds[0],
+                                             FLUX_POLLIN,
+                                             dyad_mod_io_done_cb,
+                                             pool);
+    if (pool->notify_w == NULL) {
+        DYAD_LOG_STDERR ("DYAD_MOD: could not create I/O completion watcher\n");
+        rc = DYAD_RC_FLUXFAIL;
+        goto pool_error;
+    }
+    flux_watcher_start (pool->notify_w);
+
+    pool->threads = (pthread_t *)calloc (num_threads, sizeof (pthread_t));
+    if (pool->threads == NULL) {
+        rc = DYAD_RC_SYSFAIL;
+        goto pool_error;
+    }
+    for (unsigned i = 0u; i < num_threads; i++) {
+        if (pthread_create (&pool->threads[i], NULL, dyad_mod_io_worker, pool) != 0) {
+            DYAD_LOG_STDERR ("DYAD_MOD: could not start I/O worker %u\n", i);
+            rc = DYAD_RC_SYSFAIL;
+            goto pool_error;
+        }
+        pool->num_started++;
+    }
+    *pool_out = pool;
+    return DYAD_RC_OK;
+
+pool_error:;
+    dyad_mod_io_pool_destroy (pool);
+    *pool_out = NULL;
+    return rc;
+}
+
+static dyad_rc_t dyad_mod_io_pool_submit (dyad_mod_io_pool_t *pool,
+                                          const flux_msg_t *msg,
+                                          const char *fullpath,
+                                          const dyad_mod_packed_t *packed,
+                                          const dyad_mod_range_t *range,
+                                          size_t chunk_size,
+                                          size_t probe)
+{
+    dyad_mod_io_job_t *job = (dyad_mod_io_job_t *)calloc (1, sizeof (*job));
+    if (job == NULL) {
+        errno = ENOMEM;
+        return DYAD_RC_SYSFAIL;
+    }
+    // The reactor releases its reference to msg as soon as this callback
+    // returns, so the job keeps its own until the stream is closed.
+    job->msg = flux_msg_incref (msg);
+    strncpy (job->fullpath, fullpath, PATH_MAX);
+    job->range = *range;
+    job->chunk_size = chunk_size;
+    job->probe = probe;
+    job->packed.fd = -1;
+    if (packed != NULL)
+        job->packed = *packed;
+
+    pthread_mutex_lock (&pool->lock);
+    if (pool->pending_tail == NULL)
+        pool->pending_head = job;
+    else
+        pool->pending_tail->next = job;
+    pool->pending_tail = job;
+    pthread_cond_signal (&pool->cond);
+    pthread_mutex_unlock (&pool->lock);
+    return DYAD_RC_OK;
+}
+
+/* Waits inside the DTL progress the worker without rearming its event fd,
+ * so rearm it once the reactor is about to go back to waiting */
+static inline void dyad_mod_dtl_rearm (dyad_mod_ctx_t *mod_ctx)
+{
+    if (mod_ctx->dtl_w != NULL) {
+        mod_ctx->ctx->dtl_handle->progress (mod_ctx->ctx);
+    }
+}
+
+static void dyad_mod_uring_start_waiting (dyad_mod_uring_t *mu);
+
+/* All reads of job are done: send the data, unless they failed, and close
+ * the request */
+static void dyad_mod_uring_finish (dyad_mod_uring_job_t *job)
+{
+    dyad_mod_uring_t *mu = job->mu;
+    dyad_ctx_t *ctx = mu->ctx;
+
+    if (job->direct_fd >= 0)
+        close (job->direct_fd);
+    dyad_mod_close_file (ctx, job->fd, &job->shared_lock);
+    if (job->errnum != 0) {
+        DYAD_LOG_ERROR (ctx,
+                        "DYAD_MOD: Failed to read \"%s\": %s.",
+                        job->fullpath,
+                        strerror (job->errnum));
+    } else if (!mu->shutdown) {
+        // Other requests were unpacked since this one
+        if (DYAD_IS_ERROR (dyad_mod_bind_consumer (ctx, job->msg))) {
+            job->errnum = errno;
+        } else if (DYAD_IS_ERROR (dyad_mod_send_file (ctx, &job->inbuf, job->inlen))) {
+            job->errnum = errno;
+        }
+    }
+    if (job->inbuf != NULL)
+        ctx->dtl_handle->return_buffer (ctx, (void **)&job->inbuf);
+    // The RPC stream goes away with the module
+    if (!mu->shutdown)
+        dyad_mod_finish_request (ctx->h, ctx, job->msg, job->errnum);
+    flux_msg_decref (job->msg);
+    free (job);
+    mu->num_jobs--;
+    dyad_mod_uring_start_waiting (mu);
+}
+
+static void dyad_mod_uring_read_cb (void *arg, ssize_t result)
+{
+    dyad_mod_uring_read_t *rd = (dyad_mod_uring_read_t *)arg;
+    dyad_mod_uring_job_t *job = rd->job;
+    dyad_ctx_t *ctx = job->mu->ctx;
+
+    if (result == -EINVAL && rd->direct) {
+        // The file system refuses O_DIRECT after all
+        rd->direct = false;
+        if (dyad_uring_read (ctx->uring,
+                             job->fd,
+                             rd->buf,
+                             rd->len,
+                             rd->offset,
+                             dyad_mod_uring_read_cb,
+                             rd)
+            == 0)
+            return;
+        result = -errno;
+    }
+    if (job->errnum == 0 && result < 0l)
+        job->errnum = (int)-result;
+    else if (job->errnum == 0 && (size_t)result != rd->len)
+        job->errnum = EIO;  // The file shrank
+    free (rd);
+    if (--job->reads_pending == 0u)
+        dyad_mod_uring_finish (job);
+}
+
+/* Open the file of job and queue its reads, in segments the kernel can
+ * work on at the same time. On failure, errno is set to the value the
+ * consumer should see and job is left to the caller. */
+static dyad_rc_t dyad_mod_uring_start (dyad_mod_uring_job_t *job)
+{
+    dyad_mod_uring_t *mu = job->mu;
+    dyad_ctx_t *ctx = mu->ctx;
+    dyad_mod_uring_read_t *rd = NULL;
+    dyad_rc_t rc = DYAD_RC_OK;
+    char *data = NULL;
+    ssize_t len = 0l;
+    size_t body = 0ul;
+    size_t off = 0ul;
+
+    errno = 0;
+    rc = dyad_mod_open_file (ctx,
+                             job->fullpath,
+                             &job->range,
+                             &job->fd,
+                             &job->shared_lock,
+                             &job->inbuf,
+                             &data,
+                             &len);
+    if (DYAD_IS_ERROR (rc))
+        return rc;
+    job->inlen = (ssize_t)(data - job->inbuf) + len;
+    mu->num_jobs++;
+    // Large files can bypass the page cache if the buffer allows it
+    if (ctx->uring_direct_min > 0ul && (size_t)len >= ctx->uring_direct_min
+        && dyad_uring_direct_aligned (data, (size_t)len, job->range.offset)) {
+        job->direct_fd = open (job->fullpath, O_RDONLY | O_DIRECT);
+        if (job->direct_fd >= 0)
+            body = (size_t)len & ~(DYAD_URING_DIRECT_ALIGN - 1ul);
+    }
+    while (off < (size_t)len) {
+        rd = (dyad_mod_uring_read_t *)calloc (1, sizeof (*rd));
+        if (rd == NULL) {
+            job->errnum = ENOMEM;
+            break;
+        }
+        rd->job = job;
+        rd->buf = data + off;
+        rd->len = (size_t)len - off;
+        if (rd->len > DYAD_URING_SEGMENT_SIZE)
+            rd->len = DYAD_URING_SEGMENT_SIZE;
+        // The unaligned tail always goes through the page cache
+        rd->direct = off < body;
+        if (rd->direct && rd->len > body - off)
+            rd->len = body - off;
+        rd->offset = job->range.offset + (off_t)off;
+        if (dyad_uring_read (ctx->uring,
+                             rd->direct ? job->direct_fd : job->fd,
+                             rd->buf,
+                             rd->len,
+                             rd->offset,
+                             dyad_mod_uring_read_cb,
+                             rd)
+            < 0) {
+            job->errnum = errno;
+            free (rd);
+            break;
+        }
+        job->reads_pending++;
+        off += rd->len;
+    }
+    // Until the submission, none of the reads can have finished. If it
+    // fails, their callbacks run at once with the error, which finishes
+    // job and answers the consumer, so job is gone either way.
+    if (job->reads_pending == 0u) {
+        dyad_mod_uring_finish (job);
+    } else if (dyad_uring_submit (ctx->uring) < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not submit reads: %s", strerror (errno));
+    }
+    return DYAD_RC_OK;
+}
+
+static void dyad_mod_uring_start_waiting (dyad_mod_uring_t *mu)
+{
+    dyad_mod_uring_job_t *job = NULL;
+    while (!mu->shutdown && mu->wait_head != NULL && mu->num_jobs < mu->max_jobs) {
+        job = mu->wait_head;
+        mu->wait_head = job->next;
+        if (mu->wait_head == NULL)
+            mu->wait_tail = NULL;
+        job->next = NULL;
+        if (DYAD_IS_ERROR (dyad_mod_uring_start (job))) {
+            dyad_mod_finish_request (mu->ctx->h, mu->ctx, job->msg, errno);
+            flux_msg_decref (job->msg);
+            free (job);
+        }
+    }
+}
+
+static dyad_rc_t dyad_mod_uring_submit (dyad_mod_uring_t *mu,
+                                        const flux_msg_t *msg,
+                                        const char *fullpath,
+                                        const dyad_mod_range_t *range)
+{
+    dyad_rc_t rc = DYAD_RC_OK;
+    int errnum = 0;
+    dyad_mod_uring_job_t *job = (dyad_mod_uring_job_t *)calloc (1, sizeof (*job));
+    if (job == NULL) {
+        errno = ENOMEM;
+        return DYAD_RC_SYSFAIL;
+    }
+    job->mu = mu;
+    // The reactor releases its reference to msg as soon as the request
+    // callback returns
+    job->msg = flux_msg_incref (msg);
+    strncpy (job->fullpath, fullpath, PATH_MAX);
+    job->range = *range;
+    job->fd = -1;
+    job->direct_fd = -1;
+    if (mu->num_jobs >= mu->max_jobs) {
+        if (mu->wait_tail == NULL)
+            mu->wait_head = job;
+        else
+            mu->wait_tail->next = job;
+        mu->wait_tail = job;
+        return DYAD_RC_OK;
+    }
+    rc = dyad_mod_uring_start (job);
+    if (DYAD_IS_ERROR (rc)) {
+        errnum = errno;
+        flux_msg_decref (job->msg);
+        free (job);
+        errno = errnum;
+    }
+    return rc;
+}
+
+/* Runs on the reactor thread whenever reads complete */
+static void dyad_mod_uring_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_mod_ctx_t *mod_ctx = (dyad_mod_ctx_t *)arg;
+    dyad_ctx_t *ctx = mod_ctx->ctx;
+    uint64_t count = 0ul;
+
+    while (read (dyad_uring_event_fd (ctx->uring), &count, sizeof (count)) > 0)
+        ;
+    if (dyad_uring_complete (ctx->uring, false) < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not complete reads: %s", strerror (errno));
+    }
+    dyad_mod_dtl_rearm (mod_ctx);
+    DYAD_C_FUNCTION_END ();
+}
+
+static dyad_rc_t dyad_mod_uring_create (flux_t *h,
+                                        dyad_mod_ctx_t *mod_ctx,
+                                        dyad_mod_uring_t **mu_out)
+{
+    dyad_ctx_t *ctx = mod_ctx->ctx;
+    dyad_mod_uring_t *mu = (dyad_mod_uring_t *)calloc (1, sizeof (*mu));
+    *mu_out = NULL;
+    if (mu == NULL)
+        return DYAD_RC_SYSFAIL;
+    mu->ctx = ctx;
+    // The UCX DTL blocks in get_buffer until one of its staging buffers is
+    // free, which would stall the reactor that frees them
+    mu->max_jobs = (ctx->dtl_handle->mode == DYAD_DTL_UCX) ? ctx->dtl_handle->max_inflight
+                                                          : ctx->uring_depth;
+    if (mu->max_jobs == 0u)
+        mu->max_jobs = 1u;
+    mu->w = flux_fd_watcher_create (flux_get_reactor (h),
+                                    dyad_uring_event_fd (ctx->uring),
+                                    FLUX_POLLIN,
+                                    dyad_mod_uring_cb,
+                                    mod_ctx);
+    if (mu->w == NULL) {
+        free (mu);
+        return DYAD_RC_FLUXFAIL;
+    }
+    flux_watcher_start (mu->w);
+    *mu_out = mu;
+    return DYAD_RC_OK;
+}
+
+static void dyad_mod_uring_destroy (dyad_mod_uring_t *mu)
+{
+    dyad_mod_uring_job_t *job = NULL;
+    if (mu == NULL)
+        return;
+    flux_watcher_destroy (mu->w);
+    // Let the reads in flight finish. Their jobs are dropped without
+    // sending anything.
+    mu->shutdown = true;
+    while (dyad_uring_pending (mu->ctx->uring) > 0u
+           && dyad_uring_complete (mu->ctx->uring, true) >= 0)
+        ;
+    while ((job = mu->wait_head) != NULL) {
+        mu->wait_head = job->next;
+        flux_msg_decref (job->msg);
+        free (job);
+    }
+    free (mu);
+}
+
+static unsigned dyad_mod_segment_bin (const char *upath)
+{
+    uint32_t hash = 0u;
+    MurmurHash3_x86_32 (upath, (int)strlen (upath), 0u, &hash);
+    return hash % DYAD_MOD_SEGMENT_BINS;
+}
+
+/* Make sure seg is open. Beyond DYAD_MOD_SEGMENT_FDS open segments, the
+ * least recently used one without pins is closed first. */
+static bool dyad_mod_segment_open (dyad_ctx_t *ctx,
+                                   dyad_mod_segments_t *segs,
+                                   dyad_mod_segment_t *seg)
+{
+    char path[PATH_MAX + 1] = {'\0'};
+    dyad_mod_segment_t *lru = NULL;
+    dyad_mod_segment_t *other = NULL;
+
+    seg->last_used = segs->clock;
+    if (seg->fd >= 0)
+        return true;
+    if (segs->num_open >= DYAD_MOD_SEGMENT_FDS) {
+        for (other = segs->segments; other != NULL; other = other->next) {
+            if (other->fd >= 0 && other->users == 0u
+                && (lru == NULL || other->last_used < lru->last_used))
+                lru = other;
+        }
+        if (lru != NULL) {
+            close (lru->fd);
+            lru->fd = -1;
+            segs->num_open--;
+        }
+    }
+    snprintf (path, sizeof (path), "%s/%s", segs->dir, seg->name);
+    seg->fd = open (path, O_RDONLY | O_CLOEXEC);
+    if (seg->fd < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not open segment %s", seg->name);
+        return false;
+    }
+    segs->num_open++;
+    return true;
+}
+
+/* Index a record of upath made at stamp, whose data is len bytes at offset
+ * of seg, or which drops upath if seg is NULL. Older records than the one
+ * indexed are ignored. A file that cannot be indexed is read from the file
+ * itself. */
+static void dyad_mod_segments_put (dyad_ctx_t *ctx,
+                                   dyad_mod_segments_t *segs,
+                                   const char *upath,
+                                   uint64_t stamp,
+                                   dyad_mod_segment_t *seg,
+                                   off_t offset,
+                                   size_t len,
+                                   size_t rec_bytes)
+{
+    dyad_mod_segment_entry_t **link = &segs->bins[dyad_mod_segment_bin (upath)];
+    dyad_mod_segment_entry_t *entry = NULL;
+
+    while (*link != NULL && strcmp ((*link)->upath, upath) != 0)
+        link = &(*link)->next;
+    entry = *link;
+    if (entry != NULL && entry->stamp > stamp)
+        return;
+    if (entry == NULL) {
+        entry = (dyad_mod_segment_entry_t *)calloc (1, sizeof (*entry));
+        if (entry == NULL || (entry->upath = strdup (upath)) == NULL) {
+            DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not index packed file %s", upath);
+            free (entry);
+            return;
+        }
+        *link = entry;
+    } else if (entry->seg != NULL) {
+        entry->seg->live--;
+        entry->seg->live_bytes -= entry->rec_bytes;
+        entry->seg->check = true;
+    }
+    // An entry dropping the file stays, so that older records of the file
+    // in segments scanned later do not bring it back
+    entry->stamp = stamp;
+    entry->seg = seg;
+    entry->offset = offset;
+    entry->len = len;
+    entry->rec_bytes = rec_bytes;
+    if (seg != NULL) {
+        seg->live++;
+        seg->live_bytes += rec_bytes;
+    }
+}
+
+/* Index the records appended to seg since it was last scanned */
+static void dyad_mod_segment_scan (dyad_ctx_t *ctx,
+                                   dyad_mod_segments_t *segs,
+                                   dyad_mod_segment_t *seg)
+{
+    char upath[PATH_MAX + 1] = {'\0'};
+    struct stat st;
+    off_t start = 0;
+    off_t data_offset = 0;
+    size_t data_len = 0ul;
+    uint64_t stamp = 0ull;
+    bool live = false;
+    int ret = 0;
+
+    seg->dirty = false;
+    if (seg->corrupt || !dyad_mod_segment_open (ctx, segs, seg) || fstat (seg->fd, &st) != 0
+        || st.st_size <= seg->scanned)
+        return;
+    seg->size = st.st_size;
+    start = seg->scanned;
+    while ((ret = dyad_segment_read (seg->fd,
+                                     st.st_size,
+                                     &seg->scanned,
+                                     upath,
+                                     sizeof (upath),
+                                     &data_offset,
+                                     &data_len,
+                                     &stamp,
+                                     &live))
+           > 0) {
+        dyad_mod_segments_put (ctx,
+                               segs,
+                               upath,
+                               stamp,
+                               live ? seg : NULL,
+                               data_offset,
+                               data_len,
+                               (size_t)(seg->scanned - start));
+        start = seg->scanned;
+    }
+    if (ret < 0) {
+        DYAD_LOG_ERROR (ctx,
+                        "DYAD_MOD: Segment %s is invalid at offset %jd. Ignoring the rest of it",
+                        seg->name,
+                        (intmax_t)seg->scanned);
+        seg->corrupt = true;
+    }
+}
+
+/* Add the segments created since the directory was last listed. They are
+ * opened and scanned when needed. */
+static void dyad_mod_segments_scan_dir (dyad_ctx_t *ctx, dyad_mod_segments_t *segs)
+{
+    const size_t suffix_len = strlen (DYAD_SEGMENT_SUFFIX);
+    dyad_mod_segment_t **tail = &segs->segments;
+    dyad_mod_segment_t *seg = NULL;
+    struct dirent *de = NULL;
+    struct timespec now;
+    struct stat st;
+    DIR *dir = NULL;
+    size_t name_len = 0ul;
+
+    // No producer packed a file yet
+    if (stat (segs->dir, &st) != 0)
+        return;
+    if (segs->dir_settled && st.st_mtim.tv_sec == segs->dir_mtime.tv_sec
+        && st.st_mtim.tv_nsec == segs->dir_mtime.tv_nsec)
+        return;
+    dir = opendir (segs->dir);
+    if (dir == NULL)
+        return;
+    clock_gettime (CLOCK_REALTIME, &now);
+    segs->dir_mtime = st.st_mtim;
+    segs->dir_settled = now.tv_sec > st.st_mtim.tv_sec + 1;
+    while (*tail != NULL)
+        tail = &(*tail)->next;
+    while ((de = readdir (dir)) != NULL) {
+        name_len = strlen (de->d_name);
+        if (name_len <= suffix_len
+            || strcmp (de->d_name + name_len - suffix_len, DYAD_SEGMENT_SUFFIX) != 0)
+            continue;
+        for (seg = segs->segments; seg != NULL && strcmp (seg->name, de->d_name) != 0;
+             seg = seg->next)
+            ;
+        if (seg != NULL)
+            continue;
+        seg = (dyad_mod_segment_t *)calloc (1, sizeof (*seg));
+        if (seg == NULL || (seg->name = strdup (de->d_name)) == NULL) {
+            DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not add segment %s", de->d_name);
+            free (seg);
+            // Try again on the next lookup
+            segs->dir_settled = false;
+            continue;
+        }
+        seg->fd = -1;
+        seg->dirty = true;
+        *tail = seg;
+        tail = &seg->next;
+    }
+    closedir (dir);
+}
+
+/* Mark the segments that the events of the inotify watch are about */
+static void dyad_mod_segments_read_events (dyad_ctx_t *ctx, dyad_mod_segments_t *segs)
+{
+    char buf[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+    const struct inotify_event *ev = NULL;
+    dyad_mod_segment_t *seg = NULL;
+    bool removed = false;
+    ssize_t n = 0l;
+    char *p = NULL;
+
+    while ((n = read (segs->inotify_fd, buf, sizeof (buf))) > 0) {
+        for (p = buf; p < buf + n; p += sizeof (struct inotify_event) + ev->len) {
+            ev = (const struct inotify_event *)p;
+            if (ev->mask & (IN_Q_OVERFLOW | IN_IGNORED)) {
+                // The directory is gone when the watch is
+                removed = removed || (ev->mask & IN_IGNORED);
+                segs->rescan = true;
+                continue;
+            }
+            if (ev->len == 0u)
+                continue;
+            for (seg = segs->segments; seg != NULL && strcmp (seg->name, ev->name) != 0;
+                 seg = seg->next)
+                ;
+            if (seg == NULL) {
+                segs->dir_changed = true;
+                continue;
+            }
+            seg->dirty = true;
+            // Its writer may be gone
+            if (ev->mask & IN_CLOSE_WRITE)
+                seg->check = true;
+        }
+    }
+    if (n < 0 && errno != EAGAIN && errno != EINTR) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Lost the watch on the segments: %s", strerror (errno));
+        removed = true;
+    }
+    if (removed) {
+        close (segs->inotify_fd);
+        segs->inotify_fd = -1;
+        segs->rescan = true;
+    }
+}
+
+/* Watch the directory of the segments once it exists, so that a lookup
+ * only scans the segments written to since the previous one */
+static void dyad_mod_segments_watch (dyad_ctx_t *ctx, dyad_mod_segments_t *segs)
+{
+    const uint32_t mask = IN_CREATE | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE;
+    int fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+
+    if (fd < 0) {
+        DYAD_LOG_INFO (ctx,
+                       "DYAD_MOD: Cannot watch the segments (%s). Checking them on every lookup",
+                       strerror (errno));
+        segs->no_inotify = true;
+        return;
+    }
+    if (inotify_add_watch (fd, segs->dir, mask) < 0) {
+        // Until a producer creates the directory
+        if (errno != ENOENT) {
+            DYAD_LOG_INFO (ctx,
+                           "DYAD_MOD: Cannot watch %s (%s). Checking the segments on every "
+                           "lookup",
+                           segs->dir,
+                           strerror (errno));
+            segs->no_inotify = true;
+        }
+        close (fd);
+        return;
+    }
+    segs->inotify_fd = fd;
+    // Whatever was written before the watch
+    segs->rescan = true;
+}
+
+/* Copy the records of seg that still count into a new segment. The copies
+ * keep their stamp, so the index moves over to them once the new segment
+ * is scanned, at which point seg has no records left that count. */
+static void dyad_mod_segment_compact (dyad_ctx_t *ctx,
+                                      dyad_mod_segments_t *segs,
+                                      dyad_mod_segment_t *seg)
+{
+    dyad_mod_segment_entry_t *entry = NULL;
+    char *data = NULL;
+    int out = -1;
+    unsigned i = 0u;
+
+    seg->compacted = true;
+    out = dyad_segment_create (ctx->prod_managed_path, ctx->rank);
+    if (out < 0) {
+        DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not create a segment: %s", strerror (errno));
+        return;
+    }
+    for (i = 0u; i < DYAD_MOD_SEGMENT_BINS; i++) {
+        for (entry = segs->bins[i]; entry != NULL; entry = entry->next) {
+            if (entry->seg != seg)
+                continue;
+            data = (char *)malloc (entry->len + 1ul);
+            if (data == NULL
+                || pread_all (seg->fd, data, entry->len, entry->offset) != (ssize_t)entry->len
+                || dyad_segment_append_stamped (out, entry->upath, data, entry->len, entry->stamp)
+                       < 0) {
+                // The records copied so far are as good as the originals
+                DYAD_LOG_ERROR (ctx, "DYAD_MOD: Could not compact segment %s", seg->name);
+                free (data);
+                goto compact_done;
+            }
+            free (data);
+        }
+    }
+    DYAD_LOG_DEBUG (ctx,
+                    "DYAD_MOD: Compacted the %zu live records of segment %s",
+                    seg->live,
+                    seg->name);
+
+compact_done:;
+    // Also lets the copies be compacted in turn
+    close (out);
+}
+
+/* Remove the segment at *link if its writer is gone and none of its
+ * records count anymore, or compact it if those that do take less than
+ * half of it */
+static void dyad_mod_segment_check (dyad_ctx_t *ctx,
+                                    dyad_mod_segments_t *segs,
+                                    dyad_mod_segment_t **link)
+{
+    dyad_mod_segment_t *seg = *link;
+    char path[PATH_MAX + 1] = {'\0'};
+
+    seg->check = false;
+    // Cheap checks first, since this runs after most lookups of the segment
+    if (seg->users > 0u || seg->dirty || seg->corrupt || seg->size == 0)
+        return;
+    if (seg->live > 0ul && (seg->compacted || seg->live_bytes * 2ul >= (size_t)seg->size))
+        return;
+    if (!dyad_mod_segment_open (ctx, segs, seg) || dyad_segment_is_sealed (seg->fd) != 1)
+        return;
+    if (seg->live > 0ul) {
+        dyad_mod_segment_compact (ctx, segs, seg);
+        return;
+    }
+    snprintf (path, sizeof (path), "%s/%s", segs->dir, seg->name);
+    if (unlink (path) != 0) {
+        // Left alone, but not opened again
+        DYAD_LOG_INFO (ctx, "DYAD_MOD: Could not remove segment %s", seg->name);
+        seg->corrupt = true;
+        close (seg->fd);
+        seg->fd = -1;
+        segs->num_open--;
+        return;
+    }
+    DYAD_LOG_DEBUG (ctx, "DYAD_MOD: Removed segment %s", seg->name);
+    *link = seg->next;
+    close (seg->fd);
+    segs->num_open--;
+    free (seg->name);
+    free (seg);
+}
+
+/* Bring the index up to date with the segments, then retire or compact
+ * the segments that may be ready for it */
+static void dyad_mod_segments_refresh (dyad_ctx_t *ctx, dyad_mod_segments_t *segs)
+{
+    dyad_mod_segment_t **link = NULL;
+    dyad_mod_segment_t *seg = NULL;
+    bool all = false;
+
+    segs->clock++;
+    if (segs->inotify_fd < 0 && !segs->no_inotify)
+        dyad_mod_segments_watch (ctx, segs);
+    if (segs->inotify_fd >= 0)
+        dyad_mod_segments_read_events (ctx, segs);
+    all = segs->inotify_fd < 0 || segs->rescan;
+    if (all || segs->dir_changed) {
+        segs->dir_settled = segs->dir_settled && !segs->dir_changed && !segs->rescan;
+        dyad_mod_segments_scan_dir (ctx, segs);
+    }
+    segs->rescan = false;
+    segs->dir_changed = false;
+    for (seg = segs->segments; seg != NULL; seg = seg->next) {
+        if (all || seg->dirty)
+            dyad_mod_segment_scan (ctx, segs, seg);
+    }
+    link = &segs->segments;
+    while ((seg = *link) != NULL) {
+        if (seg->check)
+            dyad_mod_segment_check (ctx, segs, link);
+        // Unless seg was removed
+        if (*link == seg)
+            link = &seg->next;
+    }
+}
+
+/* Bring the index up to date, then look up upath. Returns whether upath
+ * is packed, with its location in *loc, whose segment is pinned until
+ * dyad_mod_segments_release. */
+static bool dyad_mod_segments_lookup (dyad_ctx_t *ctx,
+                                      dyad_mod_segments_t *segs,
+                                      const char *upath,
+                                      dyad_mod_packed_t *loc)
+{
+    dyad_mod_segment_entry_t *entry = NULL;
+
+    dyad_mod_segments_refresh (ctx, segs);
+    entry = segs->bins[dyad_mod_segment_bin (upath)];
+    while (entry != NULL && strcmp (entry->upath, upath) != 0)
+        entry = entry->next;
+    if (entry == NULL || entry->seg == NULL || !dyad_mod_segment_open (ctx, segs, entry->seg))
+        return false;
+    loc->fd = entry->seg->fd;
+    loc->offset = entry->offset;
+    loc->len = entry->len;
+    loc->seg = entry->seg;
+    entry->seg->users++;
+    return true;
+}
 
-getctx_error:;
-    return NULL;
+/* Unpin the segment of a lookup, if any. Runs on the reactor thread. */
+static void dyad_mod_segments_release (dyad_mod_packed_t *loc)
+{
+    if (loc->seg == NULL)
+        return;
+    if (--loc->seg->users == 0u)
+        loc->seg->check = true;
+    loc->seg = NULL;
+}
 
-getctx_done:
-    return mod_ctx;
+static dyad_rc_t dyad_mod_segments_create (dyad_ctx_t *ctx, dyad_mod_segments_t **segs_out)
+{
+    dyad_mod_segments_t *segs = NULL;
+
+    *segs_out = NULL;
+    if (ctx->prod_managed_path == NULL)
+        return DYAD_RC_BADMANAGEDPATH;
+    segs = (dyad_mod_segments_t *)calloc (1, sizeof (*segs));
+    if (segs == NULL)
+        return DYAD_RC_SYSFAIL;
+    if (snprintf (segs->dir, sizeof (segs->dir), "%s/%s", ctx->prod_managed_path, DYAD_SEGMENT_DIR)
+        >= (int)sizeof (segs->dir)) {
+        free (segs);
+        return DYAD_RC_BADMANAGEDPATH;
+    }
+    segs->inotify_fd = -1;
+    *segs_out = segs;
+    return DYAD_RC_OK;
+}
+
+static void dyad_mod_segments_destroy (dyad_mod_segments_t *segs)
+{
+    dyad_mod_segment_entry_t *entry = NULL;
+    dyad_mod_segment_t *seg = NULL;
+    unsigned i = 0u;
+    if (segs == NULL)
+        return;
+    for (i = 0u; i < DYAD_MOD_SEGMENT_BINS; i++) {
+        while ((entry = segs->bins[i]) != NULL) {
+            segs->bins[i] = entry->next;
+            free (entry->upath);
+            free (entry);
+        }
+    }
+    while ((seg = segs->segments) != NULL) {
+        segs->segments = seg->next;
+        if (seg->fd >= 0)
+            close (seg->fd);
+        free (seg->name);
+        free (seg);
+    }
+    if (segs->inotify_fd >= 0)
+        close (segs->inotify_fd);
+    free (segs);
 }
 
 /* request callback called when dyad.fetch request is invoked */
@@ -145,203 +2306,646 @@ dyad_fetch_request_cb (flux_t *h, flux_msg_handler_t *w, const flux_msg_t *msg,
     DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Launched callback for %s", DYAD_DTL_RPC_NAME);
     ssize_t inlen = 0l;
     char *inbuf = NULL;
-    int fd = -1;
     uint32_t userid = 0u;
     char *upath = NULL;
     char fullpath[PATH_MAX + 1] = {'\0'};
+    json_int_t chunk_size = 0;
+    json_int_t offset = 0;
+    json_int_t length = 0;
+    json_int_t rpc_max = 0;
+    json_int_t probe = 0;
+    int compress = (int)DYAD_CODEC_NONE;
+    dyad_mod_range_t range = {0, 0ul};
+    dyad_mod_packed_t packed_loc = {-1, 0, 0ul, NULL};
+    const dyad_mod_packed_t *packed = NULL;
     int saved_errno = errno;
-    ssize_t file_size = 0l;
     dyad_rc_t rc = 0;
-    struct flock shared_lock;
     if (!flux_msg_is_streaming (msg)) {
         errno = EPROTO;
-        goto fetch_error_wo_flock;
+        goto fetch_error;
     }
 
     if (flux_msg_get_userid (msg, &userid) < 0)
-        goto fetch_error_wo_flock;
+        goto fetch_error;
 
     DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: unpacking RPC message");
 
-    rc = mod_ctx->ctx->dtl_handle->rpc_unpack (mod_ctx->ctx, msg, &upath);
+    // UCX and Margo consumers add "rpc_max" to have small files sent back
+    // in the RPC stream, and "probe" to time transfers of a given size.
+    // "compress" asks for the files sent that way to be compressed.
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s?I s?I s?i}",
+                             "rpc_max",
+                             &rpc_max,
+                             "probe",
+                             &probe,
+                             "compress",
+                             &compress)
+            < 0
+        || rpc_max < 0 || probe < 0) {
+        errno = EPROTO;
+        goto fetch_error;
+    }
+    if ((size_t)rpc_max > DYAD_MOD_RPC_FILE_MAX) {
+        rpc_max = (json_int_t)DYAD_MOD_RPC_FILE_MAX;
+    }
+
+    if (rpc_max > 0 || mod_ctx->io_pool != NULL) {
+        // Data sent in the RPC stream does not go through the DTL, and the
+        // I/O workers may be using the DTL for another transfer, so only
+        // look at the path here. The worker binds the DTL to this consumer
+        // right before sending.
+        if (flux_request_unpack (msg, NULL, "{s:s}", "upath", &upath) < 0) {
+            rc = DYAD_RC_BADUNPACK;
+        }
+    } else {
+        rc = mod_ctx->ctx->dtl_handle->rpc_unpack (mod_ctx->ctx, msg, &upath);
+    }
 
     if (DYAD_IS_ERROR (rc)) {
         DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Could not unpack message from client");
-        errno = EPROTO;
-        goto fetch_error_wo_flock;
+        errno = (rc == DYAD_RC_NOCONN) ? ENOTCONN : EPROTO;
+        goto fetch_error;
     }
     DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
     DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: requested user_path: %s", upath);
-    DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: sending initial response to consumer");
 
-    rc = mod_ctx->ctx->dtl_handle->rpc_respond (mod_ctx->ctx, msg);
-    if (DYAD_IS_ERROR (rc)) {
-        DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Could not send primary RPC response to client");
-        goto fetch_error_wo_flock;
+    // Consumers ask for a chunked transfer by adding "chunk_size" to the
+    // request. Only DTLs that send over the RPC stream can honor it; the
+    // others keep sending the file in one piece.
+    if (flux_request_unpack (msg, NULL, "{s?I}", "chunk_size", &chunk_size) < 0
+        || chunk_size < 0 || !dyad_mod_dtl_sends_on_reactor (mod_ctx->ctx)) {
+        chunk_size = 0;
     }
-
+    // Consumers that need part of a file only add "offset" and "length" to
+    // the request. This works the same for every DTL.
+    if (flux_request_unpack (msg, NULL, "{s?I s?I}", "offset", &offset, "length", &length) < 0
+        || offset < 0 || length < 0) {
+        DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Invalid range requested for %s", upath);
+        errno = EINVAL;
+        goto fetch_error;
+    }
+    range.offset = (off_t)offset;
+    range.length = (size_t)length;
     strncpy (fullpath, mod_ctx->ctx->prod_managed_path, PATH_MAX - 1);
     concat_str (fullpath, upath, "/", PATH_MAX);
     DYAD_C_FUNCTION_UPDATE_STR ("fullpath", fullpath);
-
-#if DYAD_SPIN_WAIT
-    if (!get_stat (fullpath, 1000U, 1000L)) {
-        DYAD_LOG_ERR (mod_ctx->ctx, "DYAD_MOD: Failed to access info on \"%s\".", fullpath);
-        // goto error;
+    // A file packed by its producer is read from a segment that is already
+    // open, without opening and locking the file itself. Packed files are
+    // small, so they are never sent in chunks.
+    if (mod_ctx->segments != NULL && probe == 0
+        && dyad_mod_segments_lookup (mod_ctx->ctx, mod_ctx->segments, upath, &packed_loc)) {
+        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: %s is packed into a segment", upath);
+        packed = &packed_loc;
+        chunk_size = 0;
     }
-#endif  // DYAD_SPIN_WAIT
 
-    DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Reading file %s for transfer", fullpath);
-    fd = open (fullpath, O_RDONLY);
-
-    if (fd < 0) {
-        DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Failed to open file \"%s\".", fullpath);
-        goto fetch_error_wo_flock;
+    if (rpc_max > 0) {
+        // Small enough to read on the reactor without holding up others
+        rc = dyad_mod_rpc_send (h,
+                                mod_ctx->ctx,
+                                msg,
+                                fullpath,
+                                packed,
+                                &range,
+                                (size_t)rpc_max,
+                                (size_t)probe,
+                                compress != (int)DYAD_CODEC_NONE);
+        if (DYAD_IS_ERROR (rc)) {
+            goto fetch_error;
+        }
+        dyad_mod_finish_request (h, mod_ctx->ctx, msg, 0);
+        goto end_fetch_cb;
     }
-    rc = dyad_shared_flock (mod_ctx->ctx, fd, &shared_lock);
+
+    DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: sending initial response to consumer");
+    rc = mod_ctx->ctx->dtl_handle->rpc_respond (mod_ctx->ctx, msg);
     if (DYAD_IS_ERROR (rc)) {
+        DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Could not send primary RPC response to client");
         goto fetch_error;
     }
-    file_size = get_file_size (fd);
-    DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: file %s has size %zd", fullpath, file_size);
-    rc = mod_ctx->ctx->dtl_handle->get_buffer (mod_ctx->ctx, file_size, (void **)&inbuf);
-#ifdef DYAD_ENABLE_UCX_RMA
-    // To reduce the number of RMA calls, we are encoding file size at the start
-    // of the buffer
-    memcpy (inbuf, &file_size, sizeof (file_size));
-#endif
-    if (file_size > 0l) {
-#ifdef DYAD_ENABLE_UCX_RMA
-        if (file_size < DYAD_POSIX_TRANSFER_GRANULARITY) {
-            inlen = read (fd, inbuf + sizeof (file_size), file_size);
-        } else {
-            ssize_t read_data = 0;
-            int granularity = DYAD_POSIX_TRANSFER_GRANULARITY;
-            while (read_data < file_size) {
-                ssize_t read_size =
-                    (file_size - read_data) > granularity ? granularity : (file_size - read_data);
-                inlen = read (fd, inbuf + sizeof (file_size) + read_data, read_size);
-                DYAD_LOG_DEBUG (mod_ctx->ctx,
-                                "DYAD_MOD: reading file %s with bytes %zd of %zd",
-                                fullpath,
-                                read_size,
-                                inlen);
-                if (inlen <= 0) {
-                    DYAD_LOG_ERROR (mod_ctx->ctx,
-                                    "DYAD_MOD: Failed to load file \"%s\" only read %zd of %zd of "
-                                    "%zd. with code %d:%s.",
-                                    fullpath,
-                                    inlen,
-                                    read_size,
-                                    file_size,
-                                    errno,
-                                    strerror (errno));
-                    goto fetch_error;
-                }
-                read_data += inlen;
-            }
-            inlen = read_data;
-        }
-#else
-        if (file_size < DYAD_POSIX_TRANSFER_GRANULARITY) {
-            inlen = read (fd, inbuf, file_size);
-        } else {
-            ssize_t read_data = 0;
-            ssize_t granularity = DYAD_POSIX_TRANSFER_GRANULARITY;
-            while (read_data < file_size) {
-                ssize_t read_size =
-                    (file_size - read_data) > granularity ? granularity : (file_size - read_data);
-                inlen = read (fd, inbuf + read_data, read_size);
-                if (inlen < 0) {
-                    DYAD_LOG_ERROR (mod_ctx->ctx,
-                                    "DYAD_MOD: Failed to load file \"%s\" only read %zd of %zd. "
-                                    "with code %d:%s.",
-                                    fullpath,
-                                    inlen,
-                                    file_size,
-                                    errno,
-                                    strerror (errno));
-                    goto fetch_error;
-                }
-                read_data += inlen;
-            }
-            inlen = read_data;
+
+    if (mod_ctx->io_pool != NULL) {
+        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Handing %s over to an I/O worker", fullpath);
+        rc = dyad_mod_io_pool_submit (mod_ctx->io_pool,
+                                      msg,
+                                      fullpath,
+                                      packed,
+                                      &range,
+                                      (size_t)chunk_size,
+                                      (size_t)probe);
+        if (DYAD_IS_ERROR (rc)) {
+            goto fetch_error;
         }
+        // The job unpins the segment once the worker is done with it
+        packed_loc.seg = NULL;
+        goto end_fetch_cb;
+    }
 
-#endif
-        if (inlen != file_size) {
-            DYAD_LOG_ERROR (mod_ctx->ctx,
-                            "DYAD_MOD: Failed to load file \"%s\" only read %zd of %zd. with code "
-                            "%d:%s.",
-                            fullpath,
-                            inlen,
-                            file_size,
-                            errno,
-                            strerror (errno));
+    if (probe > 0) {
+        rc = dyad_mod_probe_buffer (mod_ctx->ctx, (size_t)probe, &inbuf, &inlen);
+        if (DYAD_IS_ERROR (rc)) {
             goto fetch_error;
         }
-#ifdef DYAD_ENABLE_UCX_RMA
-        inlen = file_size + sizeof (file_size);
-#endif
-        DYAD_C_FUNCTION_UPDATE_INT ("file_size", file_size);
-        dyad_release_flock (mod_ctx->ctx, fd, &shared_lock);
-        close (fd);
-        // DYAD_LOG_DEBUG (mod_ctx->ctx, "Is inbuf NULL? -> %i", (int)(inbuf == NULL));
-        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Establish DTL connection with consumer");
-        rc = mod_ctx->ctx->dtl_handle->establish_connection (mod_ctx->ctx);
+        rc = dyad_mod_send_file (mod_ctx->ctx, &inbuf, inlen);
         if (DYAD_IS_ERROR (rc)) {
-            DYAD_LOG_ERROR (mod_ctx->ctx,
-                            "DYAD_MOD: Could not establish DTL connection with client");
-            errno = ECONNREFUSED;
-            goto fetch_error_wo_flock;
+            goto fetch_error;
+        }
+        dyad_mod_finish_request (h, mod_ctx->ctx, msg, 0);
+        goto end_fetch_cb;
+    }
+
+    if (mod_ctx->uring != NULL && chunk_size == 0 && packed == NULL) {
+        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Queuing the reads of %s", fullpath);
+        rc = dyad_mod_uring_submit (mod_ctx->uring, msg, fullpath, &range);
+        if (DYAD_IS_ERROR (rc)) {
+            goto fetch_error;
         }
-        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Send file to consumer with DTL");
-        rc = mod_ctx->ctx->dtl_handle->send (mod_ctx->ctx, inbuf, inlen);
+        goto end_fetch_cb;
+    }
+
+    if (chunk_size > 0) {
+        rc = dyad_mod_stream_start (mod_ctx, msg, fullpath, &range, (size_t)chunk_size);
         if (DYAD_IS_ERROR (rc)) {
-            DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Could not send data to client via DTL\n");
-            errno = ECOMM;
-            goto fetch_error_wo_flock;
+            goto fetch_error;
         }
-        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Close DTL connection with consumer");
-        mod_ctx->ctx->dtl_handle->close_connection (mod_ctx->ctx);
-        mod_ctx->ctx->dtl_handle->return_buffer (mod_ctx->ctx, (void **)&inbuf);
+        goto end_fetch_cb;
+    }
+
+    if (packed != NULL) {
+        rc = dyad_mod_read_packed (mod_ctx->ctx, packed, &range, &inbuf, &inlen);
     } else {
+        rc = dyad_mod_read_file (mod_ctx->ctx, fullpath, &range, &inbuf, &inlen);
+    }
+    if (DYAD_IS_ERROR (rc)) {
         goto fetch_error;
     }
-    DYAD_LOG_DEBUG (mod_ctx->ctx,
-                    "DYAD_MOD: Close RPC message stream with an ENODATA (%d) message",
-                    ENODATA);
-    if (flux_respond_error (h, msg, ENODATA, NULL) < 0) {
-        DYAD_LOG_DEBUG (mod_ctx->ctx,
-                        "DYAD_MOD: %s: flux_respond_error with ENODATA failed\n",
-                        __func__);
+    rc = dyad_mod_send_file (mod_ctx->ctx, &inbuf, inlen);
+    if (DYAD_IS_ERROR (rc)) {
+        goto fetch_error;
     }
-    DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Finished %s module invocation\n", DYAD_DTL_RPC_NAME);
+    dyad_mod_finish_request (h, mod_ctx->ctx, msg, 0);
     goto end_fetch_cb;
 
 fetch_error:;
-    dyad_release_flock (mod_ctx->ctx, fd, &shared_lock);
-    close (fd);
+    dyad_mod_finish_request (h, mod_ctx->ctx, msg, errno);
+    dyad_mod_segments_release (&packed_loc);
+    dyad_mod_dtl_rearm (mod_ctx);
+    errno = saved_errno;
+    DYAD_C_FUNCTION_END ();
+    return;
 
-fetch_error_wo_flock:;
-    DYAD_LOG_ERROR (mod_ctx->ctx,
-                    "DYAD_MOD: Close RPC message stream with an error (errno = %d)\n",
-                    errno);
-    if (flux_respond_error (h, msg, errno, NULL) < 0) {
-        DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: %s: flux_respond_error", __func__);
+end_fetch_cb:;
+    dyad_mod_segments_release (&packed_loc);
+    dyad_mod_dtl_rearm (mod_ctx);
+    errno = saved_errno;
+    DYAD_C_FUNCTION_END ();
+    return;
+}
+
+/* request callback called when dyad.fetch_many is invoked. Each file of
+ * "upaths" is sent back in a response of its own, made of a
+ * dyad_fetch_frame_t followed by the data, and the stream ends with
+ * ENODATA. The data is a compressed frame if the request has "compress".
+ * The files are read on the reactor, as for small files sent with
+ * "rpc_max", so each is limited to "max" bytes (DYAD_DTL_RPC_MAX_DEFAULT
+ * if 0, at most DYAD_MOD_RPC_FILE_MAX) and all of them together to
+ * DYAD_MOD_FETCH_MANY_MAX. Files beyond that only get a frame with EFBIG,
+ * and the consumer fetches them through the DTL instead. */
+static void
+dyad_fetch_many_request_cb (flux_t *h, flux_msg_handler_t *w, const flux_msg_t *msg, void *arg)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_mod_ctx_t *mod_ctx = get_mod_ctx (h);
+    json_t *upaths = NULL;
+    json_t *value = NULL;
+    json_int_t max = 0;
+    int compress = (int)DYAD_CODEC_NONE;
+    dyad_mod_range_t range = {0, 0ul};
+    dyad_rc_t rc = DYAD_RC_OK;
+    char fullpath[PATH_MAX + 1] = {'\0'};
+    dyad_mod_packed_t packed_loc = {-1, 0, 0ul, NULL};
+    dyad_fetch_frame_t frame;
+    char *buf = NULL;
+    ssize_t len = 0l;
+    size_t file_max = 0ul;
+    size_t loaded = 0ul;
+    size_t index = 0ul;
+    int saved_errno = errno;
+
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto fetch_many_error;
+    }
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:o s?I s?i}",
+                             "upaths",
+                             &upaths,
+                             "max",
+                             &max,
+                             "compress",
+                             &compress)
+            < 0
+        || !json_is_array (upaths) || max < 0) {
+        DYAD_LOG_ERROR (mod_ctx->ctx,
+                        "DYAD_MOD: Could not unpack %s request",
+                        DYAD_FETCH_MANY_RPC_NAME);
+        errno = EPROTO;
+        goto fetch_many_error;
+    }
+    DYAD_C_FUNCTION_UPDATE_INT ("num_files", json_array_size (upaths));
+    file_max = (max > 0) ? (size_t)max : DYAD_DTL_RPC_MAX_DEFAULT;
+    if (file_max > DYAD_MOD_RPC_FILE_MAX) {
+        file_max = DYAD_MOD_RPC_FILE_MAX;
+    }
+    json_array_foreach (upaths, index, value)
+    {
+        const char *upath = json_string_value (value);
+        memset (&frame, 0, sizeof (frame));
+        frame.index = (uint32_t)index;
+        buf = NULL;
+        len = 0l;
+        errno = 0;
+        if (upath == NULL) {
+            frame.errnum = EINVAL;
+        } else {
+            bool packed = mod_ctx->segments != NULL
+                          && dyad_mod_segments_lookup (mod_ctx->ctx,
+                                                       mod_ctx->segments,
+                                                       upath,
+                                                       &packed_loc);
+            // Up to what the earlier files left of the budget of the request
+            size_t limit = DYAD_MOD_FETCH_MANY_MAX - loaded;
+            if (limit > file_max) {
+                limit = file_max;
+            }
+            strncpy (fullpath, mod_ctx->ctx->prod_managed_path, PATH_MAX - 1);
+            concat_str (fullpath, upath, "/", PATH_MAX);
+            rc = dyad_mod_load_range (mod_ctx->ctx,
+                                      fullpath,
+                                      packed ? &packed_loc : NULL,
+                                      &range,
+                                      limit,
+                                      sizeof (frame),
+                                      &buf,
+                                      &len);
+            dyad_mod_segments_release (&packed_loc);
+            if (DYAD_IS_ERROR (rc)) {
+                frame.errnum = (errno != 0) ? errno : EIO;
+            } else {
+                loaded += (size_t)len;
+                if (compress != (int)DYAD_CODEC_NONE
+                    && DYAD_IS_ERROR (
+                        dyad_mod_compress (mod_ctx->ctx, sizeof (frame), &buf, &len))) {
+                    free (buf);
+                    goto fetch_many_error;
+                }
+            }
+        }
+        // flux_respond_raw takes the size of a response as an int
+        if ((size_t)len > (size_t)INT_MAX - sizeof (frame)) {
+            free (buf);
+            buf = NULL;
+            len = 0l;
+            frame.errnum = EFBIG;
+        }
+        frame.len = (uint64_t)len;
+        if (buf == NULL) {
+            // Only the frame, to tell the consumer what happened to the file
+            buf = (char *)malloc (sizeof (frame));
+            if (buf == NULL) {
+                errno = ENOMEM;
+                goto fetch_many_error;
+            }
+        }
+        memcpy (buf, &frame, sizeof (frame));
+        if (flux_respond_raw (h, msg, buf, (int)(sizeof (frame) + (size_t)len)) < 0) {
+            DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Could not respond with file %zu", index);
+            free (buf);
+            goto fetch_many_error;
+        }
+        free (buf);
     }
+    dyad_mod_finish_request (h, mod_ctx->ctx, msg, 0);
     errno = saved_errno;
     DYAD_C_FUNCTION_END ();
     return;
 
-end_fetch_cb:;
+fetch_many_error:;
+    dyad_mod_finish_request (h, mod_ctx->ctx, msg, (errno != 0) ? errno : EIO);
     errno = saved_errno;
     DYAD_C_FUNCTION_END ();
+}
+
+static unsigned dyad_mod_fetch_bin (const char *upath)
+{
+    uint32_t hash = 0u;
+    MurmurHash3_x86_32 (upath, (int)strlen (upath), 0u, &hash);
+    return hash % DYAD_MOD_FETCH_TABLE_BINS;
+}
+
+static dyad_mod_fetch_entry_t *dyad_mod_fetch_lookup (dyad_mod_fetch_table_t *table,
+                                                      const char *upath)
+{
+    dyad_mod_fetch_entry_t *entry = table->bins[dyad_mod_fetch_bin (upath)];
+    while (entry != NULL && strcmp (entry->upath, upath) != 0)
+        entry = entry->next;
+    return entry;
+}
+
+static void dyad_mod_fetch_entry_free (dyad_mod_fetch_entry_t *entry)
+{
+    dyad_mod_fetch_waiter_t *waiter = NULL;
+    while ((waiter = entry->waiters_head) != NULL) {
+        entry->waiters_head = waiter->next;
+        flux_msg_decref (waiter->msg);
+        free (waiter);
+    }
+    free (entry->upath);
+    free (entry->path);
+    free (entry->leader);
+    free (entry);
+}
+
+static void dyad_mod_fetch_unlink (dyad_mod_fetch_table_t *table, dyad_mod_fetch_entry_t *entry)
+{
+    dyad_mod_fetch_entry_t **pp = &table->bins[dyad_mod_fetch_bin (entry->upath)];
+    while (*pp != NULL && *pp != entry)
+        pp = &(*pp)->next;
+    if (*pp == entry)
+        *pp = entry->next;
+}
+
+static void dyad_mod_fetch_respond (dyad_mod_fetch_table_t *table,
+                                    const flux_msg_t *msg,
+                                    bool leader,
+                                    const char *path)
+{
+    if (flux_respond_pack (table->h, msg, "{s:b s:s}", "leader", leader, "path", path) < 0) {
+        DYAD_LOG_STDERR ("DYAD_MOD: Cannot respond to %s: %s\n",
+                         DYAD_CLAIM_RPC_NAME,
+                         strerror (errno));
+    }
+}
+
+/* The leader of an in-flight fetch failed or went away. The first waiter
+ * becomes the new leader, or the entry is dropped if nobody waits. */
+static void dyad_mod_fetch_handoff (dyad_mod_fetch_table_t *table, dyad_mod_fetch_entry_t *entry)
+{
+    dyad_mod_fetch_waiter_t *waiter = NULL;
+    const char *route = NULL;
+
+    free (entry->leader);
+    entry->leader = NULL;
+    while ((waiter = entry->waiters_head) != NULL) {
+        entry->waiters_head = waiter->next;
+        if (entry->waiters_head == NULL)
+            entry->waiters_tail = NULL;
+        route = flux_msg_route_first (waiter->msg);
+        entry->leader = (route != NULL) ? strdup (route) : NULL;
+        if (entry->leader != NULL) {
+            dyad_mod_fetch_respond (table, waiter->msg, true, entry->upath);
+        } else if (flux_respond_error (table->h, waiter->msg, ENOMEM, NULL) < 0) {
+            DYAD_LOG_STDERR ("DYAD_MOD: %s: flux_respond_error failed\n", __func__);
+        }
+        flux_msg_decref (waiter->msg);
+        free (waiter);
+        if (entry->leader != NULL)
+            return;
+    }
+    dyad_mod_fetch_unlink (table, entry);
+    dyad_mod_fetch_entry_free (entry);
+}
+
+/* The leader stored the file at path. Release the waiters and remember
+ * the location for the consumers that come later. */
+static void dyad_mod_fetch_done (dyad_mod_fetch_table_t *table,
+                                 dyad_mod_fetch_entry_t *entry,
+                                 char *path)
+{
+    dyad_mod_fetch_waiter_t *waiter = NULL;
+    dyad_mod_fetch_entry_t *oldest = NULL;
+
+    free (entry->leader);
+    entry->leader = NULL;
+    entry->path = path;
+    while ((waiter = entry->waiters_head) != NULL) {
+        entry->waiters_head = waiter->next;
+        dyad_mod_fetch_respond (table, waiter->msg, false, entry->path);
+        flux_msg_decref (waiter->msg);
+        free (waiter);
+    }
+    entry->waiters_tail = NULL;
+
+    if (table->done_tail != NULL)
+        table->done_tail->done_next = entry;
+    else
+        table->done_head = entry;
+    table->done_tail = entry;
+    table->num_done++;
+    while (table->num_done > DYAD_MOD_FETCH_TABLE_MAX_DONE) {
+        oldest = table->done_head;
+        table->done_head = oldest->done_next;
+        if (table->done_head == NULL)
+            table->done_tail = NULL;
+        table->num_done--;
+        dyad_mod_fetch_unlink (table, oldest);
+        dyad_mod_fetch_entry_free (oldest);
+    }
+}
+
+static void dyad_mod_fetch_table_destroy (dyad_mod_fetch_table_t *table)
+{
+    dyad_mod_fetch_entry_t *entry = NULL;
+    dyad_mod_fetch_waiter_t *waiter = NULL;
+    unsigned i = 0u;
+    if (table == NULL)
+        return;
+    for (i = 0u; i < DYAD_MOD_FETCH_TABLE_BINS; i++) {
+        while ((entry = table->bins[i]) != NULL) {
+            table->bins[i] = entry->next;
+            // Waiters fall back to fetching the file themselves
+            for (waiter = entry->waiters_head; waiter != NULL; waiter = waiter->next) {
+                flux_respond_error (table->h, waiter->msg, ENOSYS, NULL);
+            }
+            dyad_mod_fetch_entry_free (entry);
+        }
+    }
+    free (table);
+}
+
+/* request callback called when dyad.claim is invoked. The response tells
+ * the consumer whether it has to fetch the file itself ("leader") or where
+ * another consumer of the node stored it ("path"). */
+static void
+dyad_claim_request_cb (flux_t *h, flux_msg_handler_t *w, const flux_msg_t *msg, void *arg)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_mod_ctx_t *mod_ctx = get_mod_ctx (h);
+    dyad_mod_fetch_table_t *table = mod_ctx->fetch_table;
+    dyad_mod_fetch_entry_t *entry = NULL;
+    dyad_mod_fetch_waiter_t *waiter = NULL;
+    const char *upath = NULL;
+    const char *route = NULL;
+    unsigned bin = 0u;
+
+    if (flux_request_unpack (msg, NULL, "{s:s}", "upath", &upath) < 0) {
+        DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: Could not unpack %s request", DYAD_CLAIM_RPC_NAME);
+        goto claim_error;
+    }
+    DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
+    if (table == NULL) {
+        table = (dyad_mod_fetch_table_t *)calloc (1, sizeof (*table));
+        if (table == NULL)
+            goto claim_error;
+        table->h = h;
+        mod_ctx->fetch_table = table;
+    }
+
+    entry = dyad_mod_fetch_lookup (table, upath);
+    if (entry != NULL && entry->path != NULL) {
+        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: %s is already at %s", upath, entry->path);
+        dyad_mod_fetch_respond (table, msg, false, entry->path);
+        goto claim_done;
+    }
+    if (entry != NULL) {
+        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: %s is being fetched, queuing the consumer", upath);
+        waiter = (dyad_mod_fetch_waiter_t *)calloc (1, sizeof (*waiter));
+        if (waiter == NULL)
+            goto claim_error;
+        waiter->msg = flux_msg_incref (msg);
+        if (entry->waiters_tail != NULL)
+            entry->waiters_tail->next = waiter;
+        else
+            entry->waiters_head = waiter;
+        entry->waiters_tail = waiter;
+        goto claim_done;
+    }
+
+    route = flux_msg_route_first (msg);
+    entry = (dyad_mod_fetch_entry_t *)calloc (1, sizeof (*entry));
+    if (entry == NULL || route == NULL || (entry->upath = strdup (upath)) == NULL
+        || (entry->leader = strdup (route)) == NULL) {
+        if (entry != NULL)
+            dyad_mod_fetch_entry_free (entry);
+        errno = (route == NULL) ? EPROTO : ENOMEM;
+        goto claim_error;
+    }
+    bin = dyad_mod_fetch_bin (upath);
+    entry->next = table->bins[bin];
+    table->bins[bin] = entry;
+    dyad_mod_fetch_respond (table, msg, true, upath);
+    goto claim_done;
+
+claim_error:;
+    if (flux_respond_error (h, msg, errno, NULL) < 0) {
+        DYAD_LOG_ERROR (mod_ctx->ctx, "DYAD_MOD: %s: flux_respond_error", __func__);
+    }
+claim_done:;
+    DYAD_C_FUNCTION_END ();
+    return;
+}
+
+/* request callback called when dyad.complete is invoked by the leader of a
+ * fetch. It expects no response. */
+static void
+dyad_complete_request_cb (flux_t *h, flux_msg_handler_t *w, const flux_msg_t *msg, void *arg)
+{
+    DYAD_C_FUNCTION_START ();
+    dyad_mod_ctx_t *mod_ctx = get_mod_ctx (h);
+    dyad_mod_fetch_entry_t *entry = NULL;
+    const char *upath = NULL;
+    const char *path = NULL;
+    const char *route = NULL;
+    char *path_copy = NULL;
+    int errnum = 0;
+
+    if (flux_request_unpack (msg,
+                             NULL,
+                             "{s:s s:s s:i}",
+                             "upath",
+                             &upath,
+                             "path",
+                             &path,
+                             "errnum",
+                             &errnum)
+        < 0) {
+        DYAD_LOG_ERROR (mod_ctx->ctx,
+                        "DYAD_MOD: Could not unpack %s request",
+                        DYAD_COMPLETE_RPC_NAME);
+        goto complete_done;
+    }
+    DYAD_C_FUNCTION_UPDATE_STR ("upath", upath);
+    if (mod_ctx->fetch_table == NULL
+        || (entry = dyad_mod_fetch_lookup (mod_ctx->fetch_table, upath)) == NULL
+        || entry->leader == NULL) {
+        goto complete_done;
+    }
+    // Only the current leader may complete the fetch
+    route = flux_msg_route_first (msg);
+    if (route == NULL || strcmp (route, entry->leader) != 0) {
+        goto complete_done;
+    }
+    if (errnum == 0 && (path_copy = strdup (path)) != NULL) {
+        dyad_mod_fetch_done (mod_ctx->fetch_table, entry, path_copy);
+    } else {
+        DYAD_LOG_DEBUG (mod_ctx->ctx, "DYAD_MOD: Fetch of %s failed, handing it over", upath);
+        dyad_mod_fetch_handoff (mod_ctx->fetch_table, entry);
+    }
+
+complete_done:;
+    DYAD_C_FUNCTION_END ();
     return;
 }
 
+/* A client of the module disconnected. Forget its pending claims and hand
+ * the fetches it was leading over to the next waiter. */
+static void
+dyad_disconnect_cb (flux_t *h, flux_msg_handler_t *w, const flux_msg_t *msg, void *arg)
+{
+    dyad_mod_ctx_t *mod_ctx = get_mod_ctx (h);
+    dyad_mod_fetch_table_t *table = mod_ctx->fetch_table;
+    dyad_mod_fetch_entry_t *entry = NULL;
+    dyad_mod_fetch_entry_t *next = NULL;
+    dyad_mod_fetch_waiter_t **pw = NULL;
+    dyad_mod_fetch_waiter_t *waiter = NULL;
+    const char *route = flux_msg_route_first (msg);
+    unsigned i = 0u;
+
+    if (table == NULL || route == NULL)
+        return;
+    for (i = 0u; i < DYAD_MOD_FETCH_TABLE_BINS; i++) {
+        for (entry = table->bins[i]; entry != NULL; entry = next) {
+            next = entry->next;
+            if (entry->path != NULL)
+                continue;
+            entry->waiters_tail = NULL;
+            pw = &entry->waiters_head;
+            while ((waiter = *pw) != NULL) {
+                if (flux_msg_route_match_first (waiter->msg, msg)) {
+                    *pw = waiter->next;
+                    flux_msg_decref (waiter->msg);
+                    free (waiter);
+                } else {
+                    entry->waiters_tail = waiter;
+                    pw = &waiter->next;
+                }
+            }
+            if (strcmp (entry->leader, route) == 0) {
+                dyad_mod_fetch_handoff (table, entry);
+            }
+        }
+    }
+}
+
 static const struct flux_msg_handler_spec htab[] =
     {{FLUX_MSGTYPE_REQUEST, DYAD_DTL_RPC_NAME, dyad_fetch_request_cb, 0},
+     {FLUX_MSGTYPE_REQUEST, DYAD_FETCH_MANY_RPC_NAME, dyad_fetch_many_request_cb, 0},
+     {FLUX_MSGTYPE_REQUEST, DYAD_CLAIM_RPC_NAME, dyad_claim_request_cb, 0},
+     {FLUX_MSGTYPE_REQUEST, DYAD_COMPLETE_RPC_NAME, dyad_complete_request_cb, 0},
+     {FLUX_MSGTYPE_REQUEST, "dyad.disconnect", dyad_disconnect_cb, 0},
      FLUX_MSGHANDLER_TABLE_END};
 
 static void show_help (void)
@@ -351,7 +2955,7 @@ static void show_help (void)
     DYAD_LOG_STDOUT ("    -d, --debug: Enable debugging log message.\n");
     DYAD_LOG_STDOUT (
         "    -m, --mode:  DTL mode. Need an argument.\n"
-        "                 Either 'FLUX_RPC' (default) or 'UCX'.\n");
+        "                 One of 'FLUX_RPC' (default), 'UCX', 'MARGO' or 'SHM'.\n");
     DYAD_LOG_STDOUT (
         "    -i, --info_log: Specify the file into which to redirect\n"
         "                    info logging. Does nothing if DYAD was not\n"
@@ -362,6 +2966,42 @@ static void show_help (void)
         "                     error logging. Does nothing if DYAD was\n"
         "                     not configured with '-DDYAD_LOGGER=PRINTF'\n"
         "                     Need a filename as an argument.\n");
+    DYAD_LOG_STDOUT (
+        "    -t, --io_threads: Number of I/O worker threads that read and\n"
+        "                      send files off the reactor thread. Need an\n"
+        "                      argument. 0 (default) serves requests on the\n"
+        "                      reactor thread.\n");
+    DYAD_LOG_STDOUT (
+        "    -b, --staging_bufs: Number of registered buffers the UCX DTL\n"
+        "                        reads files into. Need an argument. With\n"
+        "                        more than one, I/O worker threads read\n"
+        "                        files while another one is being sent.\n");
+    DYAD_LOG_STDOUT (
+        "    -c, --ep_cache_size: Number of consumer endpoints the UCX DTL\n"
+        "                         keeps connected (see DYAD_UCX_EP_CACHE_SIZE).\n"
+        "                         Need an argument. 0 keeps all of them.\n");
+    DYAD_LOG_STDOUT (
+        "    -l, --ep_cache_ttl: Seconds after which an unused endpoint of\n"
+        "                        the UCX DTL is reconnected (see\n"
+        "                        DYAD_UCX_EP_CACHE_TTL). Need an argument.\n");
+    DYAD_LOG_STDOUT (
+        "    -n, --na_protocol: Mercury NA protocol of the Margo DTL, e.g.,\n"
+        "                       'ofi+tcp' (default), 'ofi+verbs' or 'na+sm'.\n"
+        "                       Need an argument.\n");
+    DYAD_LOG_STDOUT (
+        "    -u, --uring_depth: Number of file transfers kept in flight\n"
+        "                       through io_uring, if DYAD was built with it.\n"
+        "                       Need an argument. 0 uses POSIX I/O.\n");
+    DYAD_LOG_STDOUT (
+        "    -s, --segment_max: Largest file the producers pack into\n"
+        "                       segments (see DYAD_SEGMENT_MAX). Above 0,\n"
+        "                       packed files are served from their segment.\n"
+        "                       Need an argument. 0 (default) reads every\n"
+        "                       file itself.\n");
+    DYAD_LOG_STDOUT (
+        "    -z, --compress_level: zstd level at which files are compressed\n"
+        "                          for consumers that ask for it (see\n"
+        "                          DYAD_COMPRESS_LEVEL). Need an argument.\n");
 }
 
 struct opt_parse_out {
@@ -369,6 +3009,14 @@ struct opt_parse_out {
     const char *dtl_mode;
     bool debug;
     bool showed_help;
+    unsigned io_threads;
+    const char *staging_bufs;
+    const char *ep_cache_size;
+    const char *ep_cache_ttl;
+    const char *na_protocol;
+    const char *uring_depth;
+    const char *segment_max;
+    const char *compress_level;
 };
 
 typedef struct opt_parse_out opt_parse_out_t;
@@ -416,10 +3064,18 @@ int opt_parse (opt_parse_out_t *restrict opt,
                                            {"mode", required_argument, 0, 'm'},
                                            {"info_log", required_argument, 0, 'i'},
                                            {"error_log", required_argument, 0, 'e'},
+                                           {"io_threads", required_argument, 0, 't'},
+                                           {"staging_bufs", required_argument, 0, 'b'},
+                                           {"ep_cache_size", required_argument, 0, 'c'},
+                                           {"ep_cache_ttl", required_argument, 0, 'l'},
+                                           {"na_protocol", required_argument, 0, 'n'},
+                                           {"uring_depth", required_argument, 0, 'u'},
+                                           {"segment_max", required_argument, 0, 's'},
+                                           {"compress_level", required_argument, 0, 'z'},
                                            {0, 0, 0, 0}};
 
     int c;
-    while ((c = getopt_long (_argc, _argv, "hdm:i:e:", long_options, NULL)) != -1) {
+    while ((c = getopt_long (_argc, _argv, "hdm:i:e:t:b:c:l:n:u:s:z:", long_options, NULL)) != -1) {
         switch (c) {
             case 'h':
                 show_help ();
@@ -450,6 +3106,38 @@ int opt_parse (opt_parse_out_t *restrict opt,
                 sprintf (err_file_name, "%s_%d.err", optarg, broker_rank);
 #endif  // DYAD_LOGGER_NO_LOG
                 break;
+            case 't':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'io_threads' option -t with value `%s'\n", optarg);
+                opt->io_threads = (unsigned)strtoul (optarg, NULL, 10);
+                break;
+            case 'b':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'staging_bufs' option -b with value `%s'\n", optarg);
+                opt->staging_bufs = optarg;
+                break;
+            case 'c':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'ep_cache_size' option -c with value `%s'\n", optarg);
+                opt->ep_cache_size = optarg;
+                break;
+            case 'l':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'ep_cache_ttl' option -l with value `%s'\n", optarg);
+                opt->ep_cache_ttl = optarg;
+                break;
+            case 'n':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'na_protocol' option -n with value `%s'\n", optarg);
+                opt->na_protocol = optarg;
+                break;
+            case 'u':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'uring_depth' option -u with value `%s'\n", optarg);
+                opt->uring_depth = optarg;
+                break;
+            case 's':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'segment_max' option -s with value `%s'\n", optarg);
+                opt->segment_max = optarg;
+                break;
+            case 'z':
+                DYAD_LOG_STDERR ("DYAD_MOD: 'compress_level' option -z with value `%s'\n", optarg);
+                opt->compress_level = optarg;
+                break;
             case '?':
                 /* getopt_long already printed an error message. */
                 break;
@@ -476,6 +3164,16 @@ int opt_parse (opt_parse_out_t *restrict opt,
     return DYAD_RC_OK;
 }
 
+/* Runs on the reactor thread when the DTL has events, e.g., connection
+ * setup by a consumer, so they are handled without spinning */
+static void dyad_mod_dtl_event_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
+{
+    dyad_ctx_t *ctx = (dyad_ctx_t *)arg;
+    if (ctx->dtl_handle != NULL && ctx->dtl_handle->progress != NULL) {
+        ctx->dtl_handle->progress (ctx);
+    }
+}
+
 dyad_rc_t dyad_module_ctx_init (const opt_parse_out_t *opt, flux_t *h)
 {
     // get DYAD Flux module
@@ -502,6 +3200,55 @@ dyad_rc_t dyad_module_ctx_init (const opt_parse_out_t *opt, flux_t *h)
                          opt->dtl_mode);
     }
 
+    if (opt->staging_bufs) {
+        setenv (DYAD_UCX_STAGING_BUFS_ENV, opt->staging_bufs, 1);
+        DYAD_LOG_STDOUT ("DYAD_MOD: Staging buffers option set. Setting env %s=%s\n",
+                         DYAD_UCX_STAGING_BUFS_ENV,
+                         opt->staging_bufs);
+    }
+
+    if (opt->ep_cache_size) {
+        setenv (DYAD_UCX_EP_CACHE_SIZE_ENV, opt->ep_cache_size, 1);
+        DYAD_LOG_STDOUT ("DYAD_MOD: Endpoint cache size option set. Setting env %s=%s\n",
+                         DYAD_UCX_EP_CACHE_SIZE_ENV,
+                         opt->ep_cache_size);
+    }
+
+    if (opt->ep_cache_ttl) {
+        setenv (DYAD_UCX_EP_CACHE_TTL_ENV, opt->ep_cache_ttl, 1);
+        DYAD_LOG_STDOUT ("DYAD_MOD: Endpoint cache TTL option set. Setting env %s=%s\n",
+                         DYAD_UCX_EP_CACHE_TTL_ENV,
+                         opt->ep_cache_ttl);
+    }
+
+    if (opt->na_protocol) {
+        setenv (DYAD_MARGO_PROTOCOL_ENV, opt->na_protocol, 1);
+        DYAD_LOG_STDOUT ("DYAD_MOD: NA protocol option set. Setting env %s=%s\n",
+                         DYAD_MARGO_PROTOCOL_ENV,
+                         opt->na_protocol);
+    }
+
+    if (opt->uring_depth) {
+        setenv (DYAD_URING_DEPTH_ENV, opt->uring_depth, 1);
+        DYAD_LOG_STDOUT ("DYAD_MOD: io_uring depth option set. Setting env %s=%s\n",
+                         DYAD_URING_DEPTH_ENV,
+                         opt->uring_depth);
+    }
+
+    if (opt->segment_max) {
+        setenv (DYAD_SEGMENT_MAX_ENV, opt->segment_max, 1);
+        DYAD_LOG_STDOUT ("DYAD_MOD: Segment option set. Setting env %s=%s\n",
+                         DYAD_SEGMENT_MAX_ENV,
+                         opt->segment_max);
+    }
+
+    if (opt->compress_level) {
+        setenv (DYAD_COMPRESS_LEVEL_ENV, opt->compress_level, 1);
+        DYAD_LOG_STDOUT ("DYAD_MOD: Compression level option set. Setting env %s=%s\n",
+                         DYAD_COMPRESS_LEVEL_ENV,
+                         opt->compress_level);
+    }
+
     char *kvs_namespace = getenv ("DYAD_KVS_NAMESPACE");
     if (kvs_namespace != NULL) {
         DYAD_LOG_STDOUT ("DYAD_MOD: DYAD_KVS_NAMESPACE is set to `%s'\n", kvs_namespace);
@@ -528,6 +3275,56 @@ dyad_rc_t dyad_module_ctx_init (const opt_parse_out_t *opt, flux_t *h)
         return DYAD_RC_NOCTX;
     }
 
+    if (opt->io_threads > 0u) {
+        DYAD_LOG_STDOUT ("DYAD_MOD: Starting %u I/O worker threads\n", opt->io_threads);
+        dyad_rc_t rc = dyad_mod_io_pool_create (h, ctx, opt->io_threads, &mod_ctx->io_pool);
+        if (DYAD_IS_ERROR (rc)) {
+            DYAD_LOG_STDERR ("DYAD_MOD: failed to start I/O worker threads!\n");
+            return rc;
+        }
+    }
+
+    // Without I/O workers, the reactor queues file reads on the io_uring of
+    // the context, if it has one. Buffers backed by a file are filled by
+    // the kernel instead.
+    if (mod_ctx->io_pool == NULL && ctx->uring != NULL && ctx->dtl_handle->get_buffer_fd == NULL) {
+        DYAD_LOG_STDOUT ("DYAD_MOD: Reading files through io_uring\n");
+        dyad_rc_t rc = dyad_mod_uring_create (h, mod_ctx, &mod_ctx->uring);
+        if (DYAD_IS_ERROR (rc)) {
+            DYAD_LOG_STDERR ("DYAD_MOD: could not create io_uring watcher\n");
+            return rc;
+        }
+    }
+
+    if (ctx->segment_max > 0ul) {
+        DYAD_LOG_STDOUT ("DYAD_MOD: Serving files packed into segments\n");
+        dyad_rc_t rc = dyad_mod_segments_create (ctx, &mod_ctx->segments);
+        if (DYAD_IS_ERROR (rc)) {
+            DYAD_LOG_STDERR ("DYAD_MOD: could not set up the segment index\n");
+            return rc;
+        }
+    }
+
+    // I/O workers progress the DTL themselves while sending. Watching its
+    // event fd from the reactor as well would race with them, so only do
+    // it when the reactor is the one thread that uses the DTL.
+    int dtl_fd = -1;
+    if (mod_ctx->io_pool == NULL && ctx->dtl_handle->get_event_fd != NULL
+        && !DYAD_IS_ERROR (ctx->dtl_handle->get_event_fd (ctx, &dtl_fd))) {
+        mod_ctx->dtl_w = flux_fd_watcher_create (flux_get_reactor (h),
+                                                 dtl_fd,
+                                                 FLUX_POLLIN,
+                                                 dyad_mod_dtl_event_cb,
+                                                 ctx);
+        if (mod_ctx->dtl_w == NULL) {
+            DYAD_LOG_STDERR ("DYAD_MOD: could not create DTL event watcher\n");
+            return DYAD_RC_FLUXFAIL;
+        }
+        // Arm the event fd before the reactor starts waiting on it
+        ctx->dtl_handle->progress (ctx);
+        flux_watcher_start (mod_ctx->dtl_w);
+    }
+
     return DYAD_RC_OK;
 }
 
@@ -562,7 +3359,7 @@ DYAD_DLL_EXPORTED int mod_main (flux_t *h, int argc, char **argv)
 
     DYAD_C_FUNCTION_START ();
 
-    opt_parse_out_t opt = {NULL, NULL, false, false};
+    opt_parse_out_t opt = {NULL, NULL, false, false, 0u, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
 
     if (DYAD_IS_ERROR (opt_parse (&opt, broker_rank, argc, argv))) {
         DYAD_LOG_STDERR ("DYAD_MOD: Cannot parse command line arguments\n");
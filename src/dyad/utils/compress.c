@@ -0,0 +1,143 @@
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "compress.h"
+
+#if defined(DYAD_ENABLE_ZSTD_COMPRESSION)
+#include <zstd.h>
+#endif
+
+static size_t frame_raw (const void *src, size_t len, void *dst)
+{
+    dyad_compress_frame_t frame = {DYAD_CODEC_NONE, 0u, (uint64_t)len};
+    memcpy (dst, &frame, sizeof (frame));
+    if (len > 0ul) {
+        memcpy ((char *)dst + sizeof (frame), src, len);
+    }
+    return sizeof (frame) + len;
+}
+
+#if defined(DYAD_ENABLE_ZSTD_COMPRESSION)
+
+/* Whether a payload of len bytes that compresses to clen bytes is worth
+ * sending compressed */
+static bool compress_pays_off (size_t len, size_t clen)
+{
+    return clen <= len - len / 8ul;
+}
+
+bool dyad_compress_available (void)
+{
+    return true;
+}
+
+size_t dyad_compress_bound (size_t len)
+{
+    size_t bound = ZSTD_compressBound (len);
+    return sizeof (dyad_compress_frame_t) + ((bound > len) ? bound : len);
+}
+
+size_t dyad_compress_frame (int level, const void *src, size_t len, void *dst)
+{
+    dyad_compress_frame_t frame = {DYAD_CODEC_ZSTD, 0u, (uint64_t)len};
+    char *out = (char *)dst + sizeof (frame);
+    size_t clen = 0ul;
+
+    if (len < DYAD_COMPRESS_MIN_LEN) {
+        return frame_raw (src, len, dst);
+    }
+    // The sample goes where the data would, and is overwritten below
+    if (len > 2ul * DYAD_COMPRESS_SAMPLE_LEN) {
+        clen = ZSTD_compress (out,
+                              ZSTD_compressBound (DYAD_COMPRESS_SAMPLE_LEN),
+                              src,
+                              DYAD_COMPRESS_SAMPLE_LEN,
+                              level);
+        if (ZSTD_isError (clen) || !compress_pays_off (DYAD_COMPRESS_SAMPLE_LEN, clen)) {
+            return frame_raw (src, len, dst);
+        }
+    }
+    clen = ZSTD_compress (out, ZSTD_compressBound (len), src, len, level);
+    if (ZSTD_isError (clen) || !compress_pays_off (len, clen)) {
+        return frame_raw (src, len, dst);
+    }
+    memcpy (dst, &frame, sizeof (frame));
+    return sizeof (frame) + clen;
+}
+
+#else  // defined(DYAD_ENABLE_ZSTD_COMPRESSION)
+
+bool dyad_compress_available (void)
+{
+    return false;
+}
+
+size_t dyad_compress_bound (size_t len)
+{
+    return sizeof (dyad_compress_frame_t) + len;
+}
+
+size_t dyad_compress_frame (int level, const void *src, size_t len, void *dst)
+{
+    (void)level;
+    return frame_raw (src, len, dst);
+}
+
+#endif  // defined(DYAD_ENABLE_ZSTD_COMPRESSION)
+
+int dyad_compress_frame_info (const void *payload, size_t len, uint32_t *codec, size_t *raw_len)
+{
+    dyad_compress_frame_t frame;
+
+    if (payload == NULL || len < sizeof (frame)) {
+        errno = EPROTO;
+        return -1;
+    }
+    memcpy (&frame, payload, sizeof (frame));
+    if (frame.codec == DYAD_CODEC_NONE && frame.raw_len != (uint64_t)(len - sizeof (frame))) {
+        errno = EPROTO;
+        return -1;
+    }
+    if (frame.codec != DYAD_CODEC_NONE
+        && (frame.codec != DYAD_CODEC_ZSTD || !dyad_compress_available ())) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    *codec = frame.codec;
+    *raw_len = (size_t)frame.raw_len;
+    return 0;
+}
+
+int dyad_decompress_frame (const void *payload, size_t len, void *dst)
+{
+    const char *data = (const char *)payload + sizeof (dyad_compress_frame_t);
+    uint32_t codec = DYAD_CODEC_NONE;
+    size_t raw_len = 0ul;
+
+    if (dyad_compress_frame_info (payload, len, &codec, &raw_len) < 0) {
+        return -1;
+    }
+    if (codec == DYAD_CODEC_NONE) {
+        if (raw_len > 0ul) {
+            memcpy (dst, data, raw_len);
+        }
+        return 0;
+    }
+#if defined(DYAD_ENABLE_ZSTD_COMPRESSION)
+    size_t n = ZSTD_decompress (dst, raw_len, data, len - sizeof (dyad_compress_frame_t));
+    if (ZSTD_isError (n) || n != raw_len) {
+        errno = EPROTO;
+        return -1;
+    }
+    return 0;
+#else
+    errno = ENOTSUP;
+    return -1;
+#endif
+}
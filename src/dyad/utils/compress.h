@@ -0,0 +1,74 @@
+#ifndef DYAD_UTILS_COMPRESS_H
+#define DYAD_UTILS_COMPRESS_H
+
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#if defined(__cplusplus)
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+// Codecs of a dyad_compress_frame_t
+#define DYAD_CODEC_NONE 0u
+#define DYAD_CODEC_ZSTD 1u
+
+// Level used by a producer whose DYAD_COMPRESS_LEVEL is not set
+#define DYAD_COMPRESS_LEVEL_DEFAULT 1
+// Smaller payloads are not worth compressing
+#define DYAD_COMPRESS_MIN_LEN 4096ul
+// Larger payloads are only compressed if a sample of this many bytes
+// from their start compresses well, so that data that is already
+// compressed (e.g., npz or JPEG files) costs little to pass on
+#define DYAD_COMPRESS_SAMPLE_LEN (64ul << 10)
+
+/**
+ * Payloads that a consumer asked to be compressed start with this frame,
+ * followed by raw_len bytes of data as is (DYAD_CODEC_NONE), or by the
+ * compressed data. Each payload, e.g., each chunk of a streamed file,
+ * is framed on its own.
+ */
+typedef struct dyad_compress_frame {
+    uint32_t codec;
+    uint32_t reserved;
+    uint64_t raw_len;
+} dyad_compress_frame_t;
+
+/* Whether DYAD was built with a compression library */
+bool dyad_compress_available (void);
+
+/* Size of the largest frame of a payload of len bytes */
+size_t dyad_compress_bound (size_t len);
+
+/**
+ * Frame the len bytes of src into dst, which has room for
+ * dyad_compress_bound (len) bytes. The data is compressed at level if it
+ * saves at least an eighth of its size, and kept as is otherwise.
+ * Returns the size of the frame.
+ */
+size_t dyad_compress_frame (int level, const void *src, size_t len, void *dst);
+
+/* Read the frame at the start of a payload of len bytes. Returns 0, or -1
+ * with errno set if the payload is not a frame this build can decode. */
+int dyad_compress_frame_info (const void *payload, size_t len, uint32_t *codec, size_t *raw_len);
+
+/* Decode the frame of a payload of len bytes into dst, which has room
+ * for its raw_len bytes. Returns 0 or -1 with errno set. */
+int dyad_decompress_frame (const void *payload, size_t len, void *dst);
+
+#if defined(__cplusplus)
+};
+#endif  // defined(__cplusplus)
+
+#endif /* DYAD_UTILS_COMPRESS_H */
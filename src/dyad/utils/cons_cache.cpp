@@ -0,0 +1,138 @@
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#include <dyad/utils/cons_cache.h>
+
+#include <list>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+struct entry_type {
+    std::string path;
+    size_t size;
+};
+
+// Most recently used files are at the front of the list
+struct cons_cache {
+    size_t capacity;
+    size_t used;
+    std::mutex lock;
+    std::list<entry_type> lru;
+    std::unordered_map<std::string, std::list<entry_type>::iterator> index;
+};
+
+void evict_until_fits (cons_cache *c, dyad_cons_cache_evict_fn evict, void *arg)
+{
+    // Skip the most recently used file, which was just inserted
+    auto it = c->lru.end ();
+    while (c->used > c->capacity && it != c->lru.begin () && --it != c->lru.begin ()) {
+        if (evict != nullptr && evict (it->path.c_str (), arg) != 0) {
+            continue;
+        }
+        c->used -= it->size;
+        c->index.erase (it->path);
+        it = c->lru.erase (it);
+    }
+}
+}  // namespace
+
+int dyad_cons_cache_init (size_t capacity_bytes, dyad_cons_cache_h *cache)
+{
+    if (cache == nullptr || capacity_bytes == 0ul) {
+        return -1;
+    }
+    cons_cache *c = new (std::nothrow) cons_cache;
+    if (c == nullptr) {
+        return -1;
+    }
+    c->capacity = capacity_bytes;
+    c->used = 0ul;
+    *cache = reinterpret_cast<dyad_cons_cache_h> (c);
+    return 0;
+}
+
+int dyad_cons_cache_insert (dyad_cons_cache_h cache,
+                            const char *path,
+                            size_t size,
+                            dyad_cons_cache_evict_fn evict,
+                            void *arg)
+{
+    cons_cache *c = reinterpret_cast<cons_cache *> (cache);
+    if (c == nullptr || path == nullptr) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> guard (c->lock);
+    try {
+        auto it = c->index.find (path);
+        if (it != c->index.end ()) {
+            c->used -= it->second->size;
+            it->second->size = size;
+            c->lru.splice (c->lru.begin (), c->lru, it->second);
+        } else {
+            c->lru.push_front (entry_type{path, size});
+            c->index.emplace (c->lru.front ().path, c->lru.begin ());
+        }
+        c->used += size;
+    } catch (...) {
+        return -1;
+    }
+    evict_until_fits (c, evict, arg);
+    return 0;
+}
+
+int dyad_cons_cache_touch (dyad_cons_cache_h cache, const char *path)
+{
+    cons_cache *c = reinterpret_cast<cons_cache *> (cache);
+    if (c == nullptr || path == nullptr) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard (c->lock);
+    auto it = c->index.find (path);
+    if (it == c->index.end ()) {
+        return 0;
+    }
+    c->lru.splice (c->lru.begin (), c->lru, it->second);
+    return 1;
+}
+
+void dyad_cons_cache_remove (dyad_cons_cache_h cache, const char *path)
+{
+    cons_cache *c = reinterpret_cast<cons_cache *> (cache);
+    if (c == nullptr || path == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard (c->lock);
+    auto it = c->index.find (path);
+    if (it != c->index.end ()) {
+        c->used -= it->second->size;
+        c->lru.erase (it->second);
+        c->index.erase (it);
+    }
+}
+
+size_t dyad_cons_cache_used (dyad_cons_cache_h cache)
+{
+    cons_cache *c = reinterpret_cast<cons_cache *> (cache);
+    if (c == nullptr) {
+        return 0ul;
+    }
+    std::lock_guard<std::mutex> guard (c->lock);
+    return c->used;
+}
+
+void dyad_cons_cache_finalize (dyad_cons_cache_h *cache)
+{
+    if (cache == nullptr || *cache == nullptr) {
+        return;
+    }
+    delete reinterpret_cast<cons_cache *> (*cache);
+    *cache = nullptr;
+}
@@ -0,0 +1,62 @@
+#ifndef DYAD_UTILS_CONS_CACHE_H
+#define DYAD_UTILS_CONS_CACHE_H
+
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#if defined(__cplusplus)
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+typedef void *dyad_cons_cache_h;
+
+/**
+ * Callback asked to delete the file at path to make room in the cache.
+ * Returns 0 if the file is gone, or non-zero if it is in use and has to
+ * stay.
+ */
+typedef int (*dyad_cons_cache_evict_fn) (const char *path, void *arg);
+
+/**
+ * Byte budget for the files fetched into the consumer-managed directory.
+ * Files are evicted in least recently used order. The cache is safe to
+ * share between threads. Returns 0 on success, -1 on failure.
+ */
+int dyad_cons_cache_init (size_t capacity_bytes, dyad_cons_cache_h *cache);
+
+/**
+ * Record a fetched file of size bytes as the most recently used one, then
+ * evict files until the cache fits in its budget. The new file itself is
+ * never evicted. Files that evict rejects are kept, so the cache may stay
+ * over budget until they are released. Returns 0 on success.
+ */
+int dyad_cons_cache_insert (dyad_cons_cache_h cache,
+                            const char *path,
+                            size_t size,
+                            dyad_cons_cache_evict_fn evict,
+                            void *arg);
+
+/* Mark path as used. Returns 1 if the cache tracks path, 0 otherwise. */
+int dyad_cons_cache_touch (dyad_cons_cache_h cache, const char *path);
+
+void dyad_cons_cache_remove (dyad_cons_cache_h cache, const char *path);
+
+/* Number of bytes held by the files the cache tracks */
+size_t dyad_cons_cache_used (dyad_cons_cache_h cache);
+
+void dyad_cons_cache_finalize (dyad_cons_cache_h *cache);
+
+#if defined(__cplusplus)
+};
+#endif  // defined(__cplusplus)
+
+#endif /* DYAD_UTILS_CONS_CACHE_H */
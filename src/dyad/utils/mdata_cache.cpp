@@ -0,0 +1,129 @@
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#include <dyad/utils/mdata_cache.h>
+
+#include <chrono>
+#include <list>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct entry_type {
+    std::string upath;
+    bool found;
+    uint32_t owner_rank;
+    clock_type::time_point inserted;
+};
+
+// Most recently used entries are at the front of the list
+struct mdata_cache {
+    size_t capacity;
+    std::chrono::duration<double> ttl;
+    std::list<entry_type> lru;
+    std::unordered_map<std::string, std::list<entry_type>::iterator> index;
+};
+}  // namespace
+
+int dyad_mdata_cache_init (size_t capacity, double ttl, dyad_mdata_cache_h *cache)
+{
+    if (cache == nullptr || capacity == 0ul) {
+        return -1;
+    }
+    mdata_cache *c = new (std::nothrow) mdata_cache;
+    if (c == nullptr) {
+        return -1;
+    }
+    c->capacity = capacity;
+    c->ttl = std::chrono::duration<double> (ttl);
+    c->index.reserve (capacity);
+    *cache = reinterpret_cast<dyad_mdata_cache_h> (c);
+    return 0;
+}
+
+int dyad_mdata_cache_lookup (dyad_mdata_cache_h cache,
+                             const char *upath,
+                             bool *found,
+                             uint32_t *owner_rank)
+{
+    mdata_cache *c = reinterpret_cast<mdata_cache *> (cache);
+    if (c == nullptr || upath == nullptr) {
+        return 0;
+    }
+    auto it = c->index.find (upath);
+    if (it == c->index.end ()) {
+        return 0;
+    }
+    if (c->ttl.count () > 0.0 && clock_type::now () - it->second->inserted > c->ttl) {
+        c->lru.erase (it->second);
+        c->index.erase (it);
+        return 0;
+    }
+    c->lru.splice (c->lru.begin (), c->lru, it->second);
+    *found = it->second->found;
+    *owner_rank = it->second->owner_rank;
+    return 1;
+}
+
+int dyad_mdata_cache_insert (dyad_mdata_cache_h cache,
+                             const char *upath,
+                             bool found,
+                             uint32_t owner_rank)
+{
+    mdata_cache *c = reinterpret_cast<mdata_cache *> (cache);
+    if (c == nullptr || upath == nullptr) {
+        return -1;
+    }
+    if (!found && c->ttl.count () <= 0.0) {
+        return 0;
+    }
+    try {
+        auto it = c->index.find (upath);
+        if (it != c->index.end ()) {
+            it->second->found = found;
+            it->second->owner_rank = owner_rank;
+            it->second->inserted = clock_type::now ();
+            c->lru.splice (c->lru.begin (), c->lru, it->second);
+            return 0;
+        }
+        if (c->lru.size () >= c->capacity) {
+            c->index.erase (c->lru.back ().upath);
+            c->lru.pop_back ();
+        }
+        c->lru.push_front (entry_type{upath, found, owner_rank, clock_type::now ()});
+        c->index.emplace (c->lru.front ().upath, c->lru.begin ());
+    } catch (...) {
+        return -1;
+    }
+    return 0;
+}
+
+void dyad_mdata_cache_remove (dyad_mdata_cache_h cache, const char *upath)
+{
+    mdata_cache *c = reinterpret_cast<mdata_cache *> (cache);
+    if (c == nullptr || upath == nullptr) {
+        return;
+    }
+    auto it = c->index.find (upath);
+    if (it != c->index.end ()) {
+        c->lru.erase (it->second);
+        c->index.erase (it);
+    }
+}
+
+void dyad_mdata_cache_finalize (dyad_mdata_cache_h *cache)
+{
+    if (cache == nullptr || *cache == nullptr) {
+        return;
+    }
+    delete reinterpret_cast<mdata_cache *> (*cache);
+    *cache = nullptr;
+}
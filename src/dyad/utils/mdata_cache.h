@@ -0,0 +1,61 @@
+#ifndef DYAD_UTILS_MDATA_CACHE_H
+#define DYAD_UTILS_MDATA_CACHE_H
+
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#if defined(__cplusplus)
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+typedef void *dyad_mdata_cache_h;
+
+/**
+ * Bounded LRU cache mapping the path of a file relative to the managed
+ * directory to the rank owning it. An entry can also record that a file
+ * was not found. Entries older than ttl seconds are ignored (ttl <= 0: they
+ * never expire). Returns 0 on success, -1 on failure.
+ */
+int dyad_mdata_cache_init (size_t capacity, double ttl, dyad_mdata_cache_h *cache);
+
+/**
+ * Look up upath. Returns 1 on a hit, with *found telling whether the file
+ * exists and *owner_rank holding its owner if it does. Returns 0 on a miss.
+ */
+int dyad_mdata_cache_lookup (dyad_mdata_cache_h cache,
+                             const char *upath,
+                             bool *found,
+                             uint32_t *owner_rank);
+
+/**
+ * Record the owner of upath, or that upath was not found, evicting the
+ * least recently used entry if the cache is full. Only the TTL makes a
+ * file that was not found visible again, so that is not recorded by a
+ * cache without a TTL. Returns 0 on success.
+ */
+int dyad_mdata_cache_insert (dyad_mdata_cache_h cache,
+                             const char *upath,
+                             bool found,
+                             uint32_t owner_rank);
+
+void dyad_mdata_cache_remove (dyad_mdata_cache_h cache, const char *upath);
+
+void dyad_mdata_cache_finalize (dyad_mdata_cache_h *cache);
+
+#if defined(__cplusplus)
+};
+#endif  // defined(__cplusplus)
+
+#endif /* DYAD_UTILS_MDATA_CACHE_H */
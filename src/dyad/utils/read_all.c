@@ -14,8 +14,14 @@
 #error "no config"
 #endif
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif  // _GNU_SOURCE
+
 #include <errno.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
 
 #include "read_all.h"
@@ -40,6 +46,76 @@ ssize_t write_all (int fd, const void *buf, size_t len)
     return count;
 }
 
+ssize_t pread_all (int fd, void *buf, size_t len, off_t offset)
+{
+    size_t read_data = 0ul;
+    if (fd < 0 || (buf == NULL && len != 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (read_data < len) {
+        ssize_t n = pread (fd, (char *)buf + read_data, len - read_data, offset + (off_t)read_data);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0)
+            break;
+        read_data += (size_t)n;
+    }
+    return (ssize_t)read_data;
+}
+
+/* Errors meaning that the call cannot copy between these two files, as
+ * opposed to the copy itself failing */
+static bool copy_unsupported (int err)
+{
+    return (err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP || err == EBADF);
+}
+
+ssize_t copy_range (int in_fd, off_t in_off, int out_fd, off_t *out_off, size_t len)
+{
+    size_t copied = 0ul;
+    bool use_copy_file_range = true;
+    ssize_t n = 0l;
+
+    if (in_fd < 0 || out_fd < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (copied < len) {
+        if (use_copy_file_range) {
+            n = copy_file_range (in_fd, &in_off, out_fd, out_off, len - copied, 0u);
+            if (n < 0 && copy_unsupported (errno)) {
+                use_copy_file_range = false;
+                continue;
+            }
+        } else {
+            // sendfile always writes at the file offset of out_fd
+            if (out_off != NULL && lseek (out_fd, *out_off, SEEK_SET) < 0) {
+                break;
+            }
+            n = sendfile (out_fd, in_fd, &in_off, len - copied);
+            if (n < 0 && copy_unsupported (errno)) {
+                break;
+            }
+            if (n > 0 && out_off != NULL) {
+                *out_off += n;
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0)
+            break;
+        copied += (size_t)n;
+    }
+    return (ssize_t)copied;
+}
+
 ssize_t read_all (int fd, void **bufp)
 {
     const ssize_t file_size = get_file_size (fd);
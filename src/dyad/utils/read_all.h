@@ -25,6 +25,20 @@ extern "C" {
 
 ssize_t write_all (int fd, const void *buf, size_t len);
 
+/* Read up to len bytes at offset of fd, retrying short reads. Returns the
+ * number of bytes read, which is less than len only at the end of the
+ * file, or -1 on error. */
+ssize_t pread_all (int fd, void *buf, size_t len, off_t offset);
+
+/* Copy len bytes at in_off of in_fd to out_fd without going through user
+ * space, using copy_file_range and falling back to sendfile. The data is
+ * written at *out_off, which is advanced, or at the file offset of out_fd
+ * if out_off is NULL. Returns the number of bytes copied, which is less
+ * than len at the end of in_fd or when the kernel cannot copy between
+ * these files, so that the caller can finish with plain reads and writes.
+ * Returns -1 on any other error. */
+ssize_t copy_range (int in_fd, off_t in_off, int out_fd, off_t *out_off, size_t len);
+
 #if DYAD_PERFFLOW
 __attribute__ ((annotate ("@critical_path()")))
 #endif
@@ -0,0 +1,199 @@
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif  // _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "read_all.h"
+#include "segment_store.h"
+#include "utils.h"
+
+int dyad_segment_create (const char *managed_path, uint32_t rank)
+{
+    char path[PATH_MAX + 1] = {'\0'};
+    const mode_t m = (S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH | S_ISGID);
+    int fd = -1;
+
+    if (managed_path == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (snprintf (path, sizeof (path), "%s/%s", managed_path, DYAD_SEGMENT_DIR)
+        >= (int)sizeof (path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    if (mkdir_as_needed (path, m) < 0) {
+        errno = EACCES;
+        return -1;
+    }
+    // Every thread of every producer process writes a segment of its own
+    if (snprintf (path,
+                  sizeof (path),
+                  "%s/%s/%u.%d.XXXXXX%s",
+                  managed_path,
+                  DYAD_SEGMENT_DIR,
+                  rank,
+                  (int)getpid (),
+                  DYAD_SEGMENT_SUFFIX)
+        >= (int)sizeof (path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    fd = mkstemps (path, (int)strlen (DYAD_SEGMENT_SUFFIX));
+    if (fd < 0) {
+        return -1;
+    }
+    // Read by the module, which may run as another user of the group
+    fchmod (fd, S_IRUSR | S_IWUSR | S_IRGRP);
+    // Held before the first record, so a segment with records and no lock
+    // is one whose writer is gone
+    if (flock (fd, LOCK_SH) < 0) {
+        int saved_errno = errno;
+        unlink (path);
+        close (fd);
+        errno = saved_errno;
+        return -1;
+    }
+    return fd;
+}
+
+int dyad_segment_is_sealed (int fd)
+{
+    if (flock (fd, LOCK_EX | LOCK_NB) < 0) {
+        return (errno == EWOULDBLOCK) ? 0 : -1;
+    }
+    flock (fd, LOCK_UN);
+    return 1;
+}
+
+int dyad_segment_append (int fd, const char *path, const void *data, size_t data_len)
+{
+    struct timespec now;
+    uint64_t stamp = 0ull;
+    clock_gettime (CLOCK_REALTIME, &now);
+    stamp = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+    return dyad_segment_append_stamped (fd, path, data, data_len, stamp);
+}
+
+int dyad_segment_append_stamped (int fd,
+                                 const char *path,
+                                 const void *data,
+                                 size_t data_len,
+                                 uint64_t stamp)
+{
+    dyad_segment_record_t rec;
+    struct iovec iov[3];
+    struct stat st;
+    size_t total = 0ul;
+    size_t done = 0ul;
+    int i = 0;
+
+    if (fd < 0 || path == NULL || data_len > (size_t)INT64_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    rec.magic = DYAD_SEGMENT_MAGIC;
+    rec.path_len = (uint32_t)strlen (path);
+    rec.flags = (data == NULL) ? 0u : DYAD_SEGMENT_LIVE;
+    rec.reserved = 0u;
+    rec.data_len = (data == NULL) ? 0ull : (uint64_t)data_len;
+    rec.stamp = stamp;
+    iov[0].iov_base = &rec;
+    iov[0].iov_len = sizeof (rec);
+    iov[1].iov_base = (void *)path;
+    iov[1].iov_len = rec.path_len;
+    iov[2].iov_base = (void *)data;
+    iov[2].iov_len = (data == NULL) ? 0ul : data_len;
+    total = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+    if (fstat (fd, &st) != 0) {
+        return -1;
+    }
+    // The whole record in a single system call, unless it is cut short
+    while (done < total) {
+        ssize_t n = pwritev (fd, iov + i, 3 - i, st.st_size + (off_t)done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            int saved_errno = (n < 0) ? errno : EIO;
+            if (ftruncate (fd, st.st_size) != 0) {
+                // Cannot take the partial record back, so keep any more
+                // records from following it
+                saved_errno = EIO;
+            }
+            errno = saved_errno;
+            return -1;
+        }
+        done += (size_t)n;
+        while (i < 3 && (size_t)n >= iov[i].iov_len) {
+            n -= (ssize_t)iov[i].iov_len;
+            i++;
+        }
+        if (i < 3) {
+            iov[i].iov_base = (char *)iov[i].iov_base + n;
+            iov[i].iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+int dyad_segment_read (int fd,
+                       off_t end,
+                       off_t *offset,
+                       char *path,
+                       size_t path_max,
+                       off_t *data_offset,
+                       size_t *data_len,
+                       uint64_t *stamp,
+                       bool *live)
+{
+    dyad_segment_record_t rec;
+    off_t next = 0;
+
+    if (*offset + (off_t)sizeof (rec) > end) {
+        return 0;
+    }
+    if (pread_all (fd, &rec, sizeof (rec), *offset) != (ssize_t)sizeof (rec)) {
+        return 0;
+    }
+    if (rec.magic != DYAD_SEGMENT_MAGIC || (size_t)rec.path_len >= path_max
+        || rec.data_len > (uint64_t)INT64_MAX
+        || (!(rec.flags & DYAD_SEGMENT_LIVE) && rec.data_len != 0ull)) {
+        return -1;
+    }
+    if (rec.data_len > (uint64_t)end) {
+        return 0;
+    }
+    next = *offset + (off_t)sizeof (rec) + (off_t)rec.path_len + (off_t)rec.data_len;
+    if (next > end) {
+        return 0;
+    }
+    if (pread_all (fd, path, rec.path_len, *offset + (off_t)sizeof (rec))
+        != (ssize_t)rec.path_len) {
+        return 0;
+    }
+    path[rec.path_len] = '\0';
+    *data_offset = *offset + (off_t)sizeof (rec) + (off_t)rec.path_len;
+    *data_len = (size_t)rec.data_len;
+    *stamp = rec.stamp;
+    *live = (rec.flags & DYAD_SEGMENT_LIVE) != 0u;
+    *offset = next;
+    return 1;
+}
@@ -0,0 +1,108 @@
+#ifndef DYAD_UTILS_SEGMENT_STORE_H
+#define DYAD_UTILS_SEGMENT_STORE_H
+
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#if defined(__cplusplus)
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif
+#include <sys/types.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+// Directory of the segments, within the producer-managed directory
+#define DYAD_SEGMENT_DIR ".dyad_segments"
+// Suffix of the name of a segment
+#define DYAD_SEGMENT_SUFFIX ".seg"
+#define DYAD_SEGMENT_MAGIC 0x44594144u
+// Flag of a record that holds the data of its file
+#define DYAD_SEGMENT_LIVE 0x1u
+
+/**
+ * Producers pack the small files they commit into an append-only segment
+ * of their own, so that the module can serve them from a descriptor it
+ * keeps open. A segment is a sequence of records, each made of this
+ * header, the path of the file relative to the producer-managed directory
+ * (without its terminating NUL), then the data of the file.
+ */
+typedef struct dyad_segment_record {
+    uint32_t magic;
+    uint32_t path_len;
+    // DYAD_SEGMENT_LIVE, unless the record has no data and drops the
+    // earlier records of the path, e.g., once the file was committed again
+    // and is now too large
+    uint32_t flags;
+    uint32_t reserved;
+    // Bytes of data, which may be 0 for an empty file
+    uint64_t data_len;
+    // Nanoseconds since the epoch when the record was first appended. Of
+    // the records of a path, in any segment, the newest one counts.
+    uint64_t stamp;
+} dyad_segment_record_t;
+
+/**
+ * Create a new segment for the calling producer in the DYAD_SEGMENT_DIR
+ * directory of managed_path, creating the directory as needed. Returns the
+ * descriptor of the segment, or -1 with errno set. The descriptor holds a
+ * shared flock(2) on the segment until it is closed, which tells readers
+ * that more records may follow (see dyad_segment_is_sealed).
+ */
+int dyad_segment_create (const char *managed_path, uint32_t rank);
+
+/* Whether the writer of the segment behind fd (opened by a reader) closed
+ * it, so that no more records can follow. Returns 1 or 0, or -1 with errno
+ * set. */
+int dyad_segment_is_sealed (int fd);
+
+/**
+ * Append a record of path with data_len bytes of data to the segment, or
+ * a record dropping path if data is NULL. A segment has a single writer,
+ * and a record that could not be written in full is cut off again, so
+ * readers never see a partial record followed by another one. Returns 0
+ * or -1 with errno set.
+ */
+int dyad_segment_append (int fd, const char *path, const void *data, size_t data_len);
+
+/* Same as dyad_segment_append, for a copy of a record made at stamp, e.g.,
+ * when compacting segments */
+int dyad_segment_append_stamped (int fd,
+                                 const char *path,
+                                 const void *data,
+                                 size_t data_len,
+                                 uint64_t stamp);
+
+/**
+ * Read the record at *offset of a segment that is end bytes long. On
+ * success, path holds the NUL-terminated path of the record, its data is
+ * *data_len bytes at *data_offset, it was made at *stamp and *live tells
+ * whether it holds the file or drops it (see dyad_segment_record_t),
+ * *offset moves past the record and 1 is returned. Returns 0 if no
+ * complete record starts at *offset yet, or -1 if the record is invalid or
+ * its path does not fit in path_max bytes.
+ */
+int dyad_segment_read (int fd,
+                       off_t end,
+                       off_t *offset,
+                       char *path,
+                       size_t path_max,
+                       off_t *data_offset,
+                       size_t *data_len,
+                       uint64_t *stamp,
+                       bool *live);
+
+#if defined(__cplusplus)
+};
+#endif  // defined(__cplusplus)
+
+#endif /* DYAD_UTILS_SEGMENT_STORE_H */
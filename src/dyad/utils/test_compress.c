@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dyad/utils/compress.h"
+
+/* Checks that payloads survive framing, that data that compresses well is
+ * compressed if DYAD was built with a compression library, and that data
+ * that does not is passed on as is. */
+
+static int round_trip (const char* name, const void* src, size_t len, uint32_t expected_codec)
+{
+    char* frame = malloc (dyad_compress_bound (len));
+    char* out = malloc (len + 1ul);
+    uint32_t codec = 0u;
+    size_t raw_len = 0ul;
+    size_t flen = 0ul;
+    int failures = 0;
+
+    if (frame == NULL || out == NULL) {
+        printf ("Cannot allocate buffers for %s\n", name);
+        free (frame);
+        free (out);
+        return 1;
+    }
+    flen = dyad_compress_frame (1, src, len, frame);
+    if (dyad_compress_frame_info (frame, flen, &codec, &raw_len) < 0 || codec != expected_codec
+        || raw_len != len) {
+        printf ("FAIL: %s framed with codec %u and %zu bytes (expected %u and %zu)\n",
+                name,
+                codec,
+                raw_len,
+                expected_codec,
+                len);
+        failures++;
+    } else if (dyad_decompress_frame (frame, flen, out) < 0 || memcmp (out, src, len) != 0) {
+        printf ("FAIL: %s does not decode to its data\n", name);
+        failures++;
+    } else {
+        printf ("%-12s %10zu -> %10zu bytes\n", name, len, flen);
+    }
+    // A payload cut short is refused
+    if (dyad_compress_frame_info (frame, sizeof (dyad_compress_frame_t) - 1ul, &codec, &raw_len)
+        == 0) {
+        printf ("FAIL: %s accepted a partial frame\n", name);
+        failures++;
+    }
+    free (frame);
+    free (out);
+    return failures;
+}
+
+int main (void)
+{
+    const size_t n = 1ul << 18;
+    const uint32_t packed = dyad_compress_available () ? DYAD_CODEC_ZSTD : DYAD_CODEC_NONE;
+    float* floats = malloc (n * sizeof (float));
+    unsigned char* noise = malloc (n * sizeof (float));
+    unsigned int seed = 12345u;
+    int failures = 0;
+    size_t i = 0ul;
+
+    if (floats == NULL || noise == NULL) {
+        printf ("Cannot allocate the data\n");
+        return EXIT_FAILURE;
+    }
+    // A smooth field, as in simulation output
+    for (i = 0ul; i < n; i++) {
+        floats[i] = (float)(i / 64ul) * 0.5f;
+    }
+    for (i = 0ul; i < n * sizeof (float); i++) {
+        seed = seed * 1103515245u + 12345u;
+        noise[i] = (unsigned char)(seed >> 16);
+    }
+
+    failures += round_trip ("floats", floats, n * sizeof (float), packed);
+    failures += round_trip ("noise", noise, n * sizeof (float), DYAD_CODEC_NONE);
+    failures += round_trip ("small", floats, 100ul, DYAD_CODEC_NONE);
+    failures += round_trip ("empty", floats, 0ul, DYAD_CODEC_NONE);
+
+    free (floats);
+    free (noise);
+    printf ("%s\n", (failures == 0) ? "PASS" : "FAIL");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
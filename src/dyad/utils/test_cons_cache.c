@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dyad/utils/cons_cache.h"
+
+// Records the evicted files and refuses to evict "busy"
+static char evicted[256];
+
+static int evict (const char* path, void* arg)
+{
+    (void)arg;
+    if (strcmp (path, "busy") == 0) {
+        return 1;
+    }
+    strcat (evicted, path);
+    strcat (evicted, " ");
+    return 0;
+}
+
+static int check (dyad_cons_cache_h cache, const char* expected_evicted, size_t expected_used)
+{
+    size_t used = dyad_cons_cache_used (cache);
+    if (strcmp (evicted, expected_evicted) != 0 || used != expected_used) {
+        printf ("FAIL: evicted '%s' (expected '%s'), used %zu (expected %zu)\n",
+                evicted,
+                expected_evicted,
+                used,
+                expected_used);
+        evicted[0] = '\0';
+        return 1;
+    }
+    evicted[0] = '\0';
+    return 0;
+}
+
+int main (void)
+{
+    dyad_cons_cache_h cache = NULL;
+    int failures = 0;
+
+    if (dyad_cons_cache_init (100ul, &cache) < 0) {
+        printf ("Cannot create the consumer cache\n");
+        return EXIT_FAILURE;
+    }
+    evicted[0] = '\0';
+    dyad_cons_cache_insert (cache, "a", 40ul, evict, NULL);
+    dyad_cons_cache_insert (cache, "b", 40ul, evict, NULL);
+    failures += check (cache, "", 80ul);
+    // "a" becomes the most recently used file, so "b" goes first
+    dyad_cons_cache_touch (cache, "a");
+    dyad_cons_cache_insert (cache, "c", 40ul, evict, NULL);
+    failures += check (cache, "b ", 80ul);
+    // Files in use are skipped
+    dyad_cons_cache_insert (cache, "busy", 10ul, evict, NULL);
+    failures += check (cache, "", 90ul);
+    dyad_cons_cache_touch (cache, "c");
+    dyad_cons_cache_insert (cache, "d", 30ul, evict, NULL);
+    failures += check (cache, "a ", 80ul);
+    // The new file is kept even if it does not fit alone
+    dyad_cons_cache_insert (cache, "e", 200ul, evict, NULL);
+    failures += check (cache, "c d ", 210ul);
+    dyad_cons_cache_remove (cache, "e");
+    failures += check (cache, "", 10ul);
+    if (dyad_cons_cache_touch (cache, "e") != 0) {
+        printf ("FAIL: e is still tracked\n");
+        failures++;
+    }
+    dyad_cons_cache_finalize (&cache);
+
+    printf ("%s\n", (failures == 0) ? "PASS" : "FAIL");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "dyad/utils/mdata_cache.h"
+
+static int check (dyad_mdata_cache_h cache, const char* upath, int hit, bool found, uint32_t rank)
+{
+    bool f = false;
+    uint32_t r = 0u;
+    int h = dyad_mdata_cache_lookup (cache, upath, &f, &r);
+    if (h != hit || (hit && (f != found || (found && r != rank)))) {
+        printf ("FAIL: %s: hit %d found %d rank %u\n", upath, h, (int)f, r);
+        return 1;
+    }
+    return 0;
+}
+
+int main (void)
+{
+    dyad_mdata_cache_h cache = NULL;
+    int failures = 0;
+
+    // LRU eviction with a capacity of two entries
+    if (dyad_mdata_cache_init (2ul, 0.0, &cache) < 0) {
+        printf ("Cannot create the metadata cache\n");
+        return EXIT_FAILURE;
+    }
+    dyad_mdata_cache_insert (cache, "a", true, 1u);
+    dyad_mdata_cache_insert (cache, "b", true, 2u);
+    failures += check (cache, "a", 1, true, 1u);  // "b" becomes the LRU entry
+    dyad_mdata_cache_insert (cache, "c", true, 3u);
+    failures += check (cache, "b", 0, false, 0u);
+    failures += check (cache, "a", 1, true, 1u);
+    failures += check (cache, "c", 1, true, 3u);
+    // Missing files are not recorded without a TTL
+    dyad_mdata_cache_insert (cache, "d", false, 0u);
+    failures += check (cache, "d", 0, false, 0u);
+    dyad_mdata_cache_remove (cache, "a");
+    failures += check (cache, "a", 0, false, 0u);
+    dyad_mdata_cache_finalize (&cache);
+
+    // Expiration
+    if (dyad_mdata_cache_init (4ul, 0.1, &cache) < 0) {
+        printf ("Cannot create the metadata cache\n");
+        return EXIT_FAILURE;
+    }
+    dyad_mdata_cache_insert (cache, "a", true, 1u);
+    dyad_mdata_cache_insert (cache, "d", false, 0u);
+    failures += check (cache, "d", 1, false, 0u);
+    usleep (200000);
+    failures += check (cache, "a", 0, false, 0u);
+    failures += check (cache, "d", 0, false, 0u);
+    dyad_mdata_cache_finalize (&cache);
+
+    printf ("%s\n", (failures == 0) ? "PASS" : "FAIL");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
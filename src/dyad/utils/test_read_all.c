@@ -0,0 +1,159 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif  // _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dyad/utils/read_all.h"
+
+/* Checks pread_all and copy_range, and times copying a file the ways the
+ * module and the client can move data around:
+ *   test_read_all [dir [size_in_MiB [iterations]]]
+ */
+
+typedef ssize_t (*copy_fn) (int src, int dst, size_t len);
+
+static double now (void)
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Through a user buffer, as the module and the client used to
+static ssize_t copy_read_write (int src, int dst, size_t len)
+{
+    char* buf = malloc (len);
+    ssize_t n = -1l;
+    if (buf != NULL && pread_all (src, buf, len, 0) == (ssize_t)len) {
+        n = write_all (dst, buf, len);
+    }
+    free (buf);
+    return n;
+}
+
+static ssize_t copy_mmap_write (int src, int dst, size_t len)
+{
+    ssize_t n = -1l;
+    void* buf = mmap (NULL, len, PROT_READ, MAP_PRIVATE, src, 0);
+    if (buf != MAP_FAILED) {
+        n = write_all (dst, buf, len);
+        munmap (buf, len);
+    }
+    return n;
+}
+
+static ssize_t copy_kernel (int src, int dst, size_t len)
+{
+    return copy_range (src, 0, dst, NULL, len);
+}
+
+// File to memfd to file, as with the SHM DTL on both ends
+static ssize_t copy_via_memfd (int src, int dst, size_t len)
+{
+    ssize_t n = -1l;
+    off_t off = 0;
+    int mfd = memfd_create ("test_read_all", MFD_CLOEXEC);
+    if (mfd >= 0 && ftruncate (mfd, (off_t)len) == 0
+        && copy_range (src, 0, mfd, &off, len) == (ssize_t)len) {
+        n = copy_range (mfd, 0, dst, NULL, len);
+    }
+    if (mfd >= 0) {
+        close (mfd);
+    }
+    return n;
+}
+
+static int same_content (int a, int b, size_t len)
+{
+    char* buf_a = malloc (len);
+    char* buf_b = malloc (len);
+    int same = buf_a != NULL && buf_b != NULL && pread_all (a, buf_a, len, 0) == (ssize_t)len
+               && pread_all (b, buf_b, len, 0) == (ssize_t)len && memcmp (buf_a, buf_b, len) == 0;
+    free (buf_a);
+    free (buf_b);
+    return same;
+}
+
+static int run (const char* name, copy_fn fn, int src, const char* dst_path, size_t len, int iters)
+{
+    double best = 0.0;
+    int i = 0;
+    for (i = 0; i < iters; i++) {
+        int dst = open (dst_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        double start = now ();
+        ssize_t n = (dst < 0) ? -1l : fn (src, dst, len);
+        double elapsed = now () - start;
+        if (n != (ssize_t)len || !same_content (src, dst, len)) {
+            printf ("FAIL: %s copied %zd of %zu bytes\n", name, n, len);
+            if (dst >= 0) {
+                close (dst);
+            }
+            return 1;
+        }
+        close (dst);
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    printf ("%-20s %10.3f ms %10.1f MiB/s\n",
+            name,
+            best * 1e3,
+            (double)len / (1024.0 * 1024.0) / best);
+    return 0;
+}
+
+int main (int argc, char** argv)
+{
+    const char* dir = (argc > 1) ? argv[1] : "/tmp";
+    size_t len = ((argc > 2) ? strtoul (argv[2], NULL, 10) : 64ul) << 20;
+    int iters = (argc > 3) ? atoi (argv[3]) : 3;
+    char src_path[4096];
+    char dst_path[4096];
+    char* buf = NULL;
+    char small[16];
+    int failures = 0;
+    int src = -1;
+    size_t i = 0ul;
+
+    snprintf (src_path, sizeof (src_path), "%s/test_read_all.%d.src", dir, (int)getpid ());
+    snprintf (dst_path, sizeof (dst_path), "%s/test_read_all.%d.dst", dir, (int)getpid ());
+    buf = malloc (len);
+    src = open (src_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (buf == NULL || src < 0) {
+        printf ("Cannot create %s\n", src_path);
+        return EXIT_FAILURE;
+    }
+    for (i = 0ul; i < len; i++) {
+        buf[i] = (char)(i * 31u + (i >> 12));
+    }
+    if (write_all (src, buf, len) != (ssize_t)len) {
+        printf ("Cannot write %s\n", src_path);
+        failures++;
+    }
+    free (buf);
+
+    // pread_all stops at the end of the file
+    if (pread_all (src, small, sizeof (small), (off_t)len - 4) != 4) {
+        printf ("FAIL: pread_all past the end of the file\n");
+        failures++;
+    }
+
+    printf ("Copying %zu MiB, best of %d\n", len >> 20, iters);
+    failures += run ("read/write", copy_read_write, src, dst_path, len, iters);
+    failures += run ("mmap/write", copy_mmap_write, src, dst_path, len, iters);
+    failures += run ("copy_range", copy_kernel, src, dst_path, len, iters);
+    failures += run ("copy_range (memfd)", copy_via_memfd, src, dst_path, len, iters);
+
+    close (src);
+    unlink (src_path);
+    unlink (dst_path);
+    printf ("%s\n", (failures == 0) ? "PASS" : "FAIL");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
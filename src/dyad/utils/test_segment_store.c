@@ -0,0 +1,165 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dyad/utils/read_all.h"
+#include "dyad/utils/segment_store.h"
+
+/* Checks that records appended to a segment read back in order with
+ * increasing stamps, that records of empty files are told apart from the
+ * ones dropping a file, that a record still being written is not seen, and
+ * that a segment is sealed once its writer closed it:
+ *   test_segment_store [dir]
+ */
+
+static uint64_t last_stamp = 0ull;
+
+static int expect (int fd,
+                   off_t end,
+                   off_t* offset,
+                   int expected_ret,
+                   const char* expected_path,
+                   const char* expected_data,
+                   size_t expected_len,
+                   bool expected_live)
+{
+    char path[256];
+    char data[256];
+    off_t data_offset = 0;
+    size_t data_len = 0ul;
+    uint64_t stamp = 0ull;
+    bool live = false;
+    int ret = dyad_segment_read (fd,
+                                 end,
+                                 offset,
+                                 path,
+                                 sizeof (path),
+                                 &data_offset,
+                                 &data_len,
+                                 &stamp,
+                                 &live);
+
+    if (ret != expected_ret) {
+        printf ("FAIL: read returned %d (expected %d)\n", ret, expected_ret);
+        return 1;
+    }
+    if (ret != 1) {
+        return 0;
+    }
+    if (strcmp (path, expected_path) != 0 || data_len != expected_len) {
+        printf ("FAIL: read '%s' of %zu bytes (expected '%s' of %zu bytes)\n",
+                path,
+                data_len,
+                expected_path,
+                expected_len);
+        return 1;
+    }
+    if (live != expected_live) {
+        printf ("FAIL: '%s' %s\n", path, live ? "is not dropped" : "is dropped");
+        return 1;
+    }
+    if (stamp < last_stamp) {
+        printf ("FAIL: '%s' is older than the record before it\n", path);
+        return 1;
+    }
+    last_stamp = stamp;
+    if (data_len > 0ul
+        && (pread_all (fd, data, data_len, data_offset) != (ssize_t)data_len
+            || memcmp (data, expected_data, data_len) != 0)) {
+        printf ("FAIL: wrong data for '%s'\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+int main (int argc, char** argv)
+{
+    const char* dir = (argc > 1) ? argv[1] : "/tmp";
+    char managed[1024];
+    char seg_path[4096];
+    char seg_name[4096];
+    off_t offset = 0;
+    off_t end = 0;
+    int failures = 0;
+    int fd = -1;
+    int reader = -1;
+
+    snprintf (managed, sizeof (managed), "%s/test_segment_store.%d", dir, (int)getpid ());
+    fd = dyad_segment_create (managed, 7u);
+    if (fd < 0) {
+        printf ("Cannot create a segment in %s\n", managed);
+        return EXIT_FAILURE;
+    }
+
+    if (dyad_segment_append (fd, "a/small", "hello", 5ul) < 0
+        || dyad_segment_append (fd, "b", "", 0ul) < 0
+        || dyad_segment_append (fd, "a/small", NULL, 1000ul) < 0) {
+        printf ("FAIL: append\n");
+        failures++;
+    }
+    end = lseek (fd, 0, SEEK_END);
+    failures += expect (fd, end, &offset, 1, "a/small", "hello", 5ul, true);
+    // An empty file is still there
+    failures += expect (fd, end, &offset, 1, "b", "", 0ul, true);
+    // The record dropping "a/small" has no data
+    failures += expect (fd, end, &offset, 1, "a/small", NULL, 0ul, false);
+    failures += expect (fd, end, &offset, 0, NULL, NULL, 0ul, false);
+
+    // Only part of the next record is visible yet
+    if (dyad_segment_append (fd, "c", "world", 5ul) < 0) {
+        printf ("FAIL: append\n");
+        failures++;
+    }
+    failures += expect (fd, lseek (fd, 0, SEEK_END) - 2, &offset, 0, NULL, NULL, 0ul, false);
+    failures += expect (fd, lseek (fd, 0, SEEK_END), &offset, 1, "c", "world", 5ul, true);
+
+    // A copy keeps the stamp of the original record
+    if (dyad_segment_append_stamped (fd, "d", "copy", 4ul, last_stamp + 1000ull) < 0) {
+        printf ("FAIL: append\n");
+        failures++;
+    }
+    uint64_t copied = last_stamp + 1000ull;
+    failures += expect (fd, lseek (fd, 0, SEEK_END), &offset, 1, "d", "copy", 4ul, true);
+    if (last_stamp != copied) {
+        printf ("FAIL: the copy of 'd' lost its stamp\n");
+        failures++;
+    }
+
+    // Anything but a record is refused
+    if (lseek (fd, 0, SEEK_END) < 0
+        || write_all (fd, "garbage, not a record of a file at all", 38ul) != 38) {
+        printf ("FAIL: write\n");
+        failures++;
+    }
+    end = lseek (fd, 0, SEEK_END);
+    failures += expect (fd, end, &offset, -1, NULL, NULL, 0ul, false);
+
+    snprintf (seg_path, sizeof (seg_path), "/proc/self/fd/%d", fd);
+    ssize_t n = readlink (seg_path, seg_name, sizeof (seg_name) - 1ul);
+    if (n > 0) {
+        seg_name[n] = '\0';
+        reader = open (seg_name, O_RDONLY);
+        unlink (seg_name);
+    }
+    // Sealed only once the writer is done with it
+    if (reader < 0 || dyad_segment_is_sealed (reader) != 0) {
+        printf ("FAIL: segment sealed while its writer has it open\n");
+        failures++;
+    }
+    close (fd);
+    if (reader >= 0 && dyad_segment_is_sealed (reader) != 1) {
+        printf ("FAIL: segment not sealed after its writer closed it\n");
+        failures++;
+    }
+    if (reader >= 0) {
+        close (reader);
+    }
+    snprintf (seg_path, sizeof (seg_path), "%s/%s", managed, DYAD_SEGMENT_DIR);
+    rmdir (seg_path);
+    rmdir (managed);
+    printf ("%s\n", (failures == 0) ? "PASS" : "FAIL");
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
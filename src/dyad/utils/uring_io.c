@@ -0,0 +1,486 @@
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif  // _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "uring_io.h"
+
+#if defined(DYAD_ENABLE_IO_URING)
+#include <liburing.h>
+#include <sys/eventfd.h>
+
+// A single read or write is limited to what fits in the 32-bit length of
+// a submission. Anything longer is resumed like a short transfer.
+#define URING_MAX_IO (1ul << 30)
+
+struct uring_op {
+    bool write;
+    int fd;
+    char *buf;
+    size_t len;
+    off_t offset;
+    size_t done;
+    dyad_uring_cb cb;
+    void *arg;
+    bool failed;                 // Callback already run, entry turned into a no-op
+    struct io_uring_sqe *sqe;    // Entry filled for op, until submitted
+    struct uring_op *next;       // Next transfer waiting for an entry
+    struct uring_op *prep_next;  // Next entry filled, in submission order
+};
+
+struct dyad_uring {
+    struct io_uring ring;
+    int efd;
+    unsigned int depth;
+    unsigned int inflight;  // Submission entries filled, submitted or not
+    unsigned int waiting;   // Transfers waiting for a free entry
+    struct uring_op *wait_head;
+    struct uring_op *wait_tail;
+    struct uring_op *prep_head;  // Entries filled but not submitted yet
+    struct uring_op *prep_tail;
+};
+
+/* Fill a submission entry for the rest of op, or keep op waiting if the
+ * ring is full */
+static void uring_prep (struct dyad_uring *r, struct uring_op *op)
+{
+    struct io_uring_sqe *sqe = NULL;
+    size_t len = op->len - op->done;
+    if (r->inflight < r->depth)
+        sqe = io_uring_get_sqe (&r->ring);
+    if (sqe == NULL) {
+        op->next = NULL;
+        if (r->wait_tail == NULL)
+            r->wait_head = op;
+        else
+            r->wait_tail->next = op;
+        r->wait_tail = op;
+        r->waiting++;
+        return;
+    }
+    if (len > URING_MAX_IO)
+        len = URING_MAX_IO;
+    if (op->write)
+        io_uring_prep_write (sqe, op->fd, op->buf + op->done, (unsigned)len, op->offset + op->done);
+    else
+        io_uring_prep_read (sqe, op->fd, op->buf + op->done, (unsigned)len, op->offset + op->done);
+    io_uring_sqe_set_data (sqe, op);
+    r->inflight++;
+    op->sqe = sqe;
+    op->prep_next = NULL;
+    if (r->prep_tail == NULL)
+        r->prep_head = op;
+    else
+        r->prep_tail->prep_next = op;
+    r->prep_tail = op;
+}
+
+/* The kernel refused the filled entries, so fail their transfers and those
+ * waiting for an entry with errnum right away. The entries become no-ops
+ * that go out with the next submission, which is when their op is freed. */
+static void uring_fail_unsubmitted (struct dyad_uring *r, int errnum)
+{
+    struct uring_op *head = NULL;
+    struct uring_op *tail = NULL;
+    struct uring_op *waiting = r->wait_head;
+    struct uring_op *op = NULL;
+
+    for (op = r->prep_head; op != NULL; op = op->prep_next) {
+        if (op->failed)
+            continue;
+        io_uring_prep_nop (op->sqe);
+        io_uring_sqe_set_data (op->sqe, op);
+        op->failed = true;
+        op->next = NULL;
+        if (tail == NULL)
+            head = op;
+        else
+            tail->next = op;
+        tail = op;
+    }
+    // Callbacks may queue and submit new transfers, which are not failed
+    r->wait_head = NULL;
+    r->wait_tail = NULL;
+    r->waiting = 0u;
+    while ((op = head) != NULL) {
+        head = op->next;
+        op->cb (op->arg, -(ssize_t)errnum);
+    }
+    while ((op = waiting) != NULL) {
+        waiting = op->next;
+        op->cb (op->arg, -(ssize_t)errnum);
+        free (op);
+    }
+}
+
+static int uring_queue (struct dyad_uring *r,
+                        bool write,
+                        int fd,
+                        char *buf,
+                        size_t len,
+                        off_t offset,
+                        dyad_uring_cb cb,
+                        void *arg)
+{
+    struct uring_op *op = (struct uring_op *)calloc (1, sizeof (*op));
+    if (op == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    op->write = write;
+    op->fd = fd;
+    op->buf = buf;
+    op->len = len;
+    op->offset = offset;
+    op->cb = cb;
+    op->arg = arg;
+    uring_prep (r, op);
+    return 0;
+}
+
+int dyad_uring_init (unsigned int depth, dyad_uring_h *ring)
+{
+    struct dyad_uring *r = NULL;
+    int ret = 0;
+
+    *ring = NULL;
+    if (depth == 0u) {
+        errno = EINVAL;
+        return -1;
+    }
+    r = (struct dyad_uring *)calloc (1, sizeof (*r));
+    if (r == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    ret = io_uring_queue_init (depth, &r->ring, 0u);
+    if (ret < 0) {
+        // Old kernels and seccomp profiles refuse io_uring altogether
+        free (r);
+        errno = (ret == -ENOMEM) ? ENOMEM : ENOSYS;
+        return -1;
+    }
+    r->depth = depth;
+    r->efd = eventfd (0u, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->efd < 0 || io_uring_register_eventfd (&r->ring, r->efd) < 0) {
+        if (r->efd >= 0)
+            close (r->efd);
+        io_uring_queue_exit (&r->ring);
+        free (r);
+        errno = ENOSYS;
+        return -1;
+    }
+    *ring = r;
+    return 0;
+}
+
+void dyad_uring_finalize (dyad_uring_h *ring)
+{
+    struct dyad_uring *r = NULL;
+    struct uring_op *op = NULL;
+    if (ring == NULL || *ring == NULL)
+        return;
+    r = (struct dyad_uring *)*ring;
+    // The kernel may still write into the buffers of the transfers in
+    // flight, so they have to finish first
+    dyad_uring_submit (r);
+    while (r->inflight > 0u && dyad_uring_complete (r, true) >= 0)
+        ;
+    while ((op = r->wait_head) != NULL) {
+        r->wait_head = op->next;
+        op->cb (op->arg, -ECANCELED);
+        free (op);
+    }
+    // Left over only if the kernel refused them
+    while ((op = r->prep_head) != NULL) {
+        r->prep_head = op->prep_next;
+        if (!op->failed)
+            op->cb (op->arg, -ECANCELED);
+        free (op);
+    }
+    io_uring_unregister_eventfd (&r->ring);
+    close (r->efd);
+    io_uring_queue_exit (&r->ring);
+    free (r);
+    *ring = NULL;
+}
+
+int dyad_uring_event_fd (dyad_uring_h ring)
+{
+    return ((struct dyad_uring *)ring)->efd;
+}
+
+int dyad_uring_read (dyad_uring_h ring,
+                     int fd,
+                     void *buf,
+                     size_t len,
+                     off_t offset,
+                     dyad_uring_cb cb,
+                     void *arg)
+{
+    return uring_queue ((struct dyad_uring *)ring, false, fd, (char *)buf, len, offset, cb, arg);
+}
+
+int dyad_uring_write (dyad_uring_h ring,
+                      int fd,
+                      const void *buf,
+                      size_t len,
+                      off_t offset,
+                      dyad_uring_cb cb,
+                      void *arg)
+{
+    return uring_queue ((struct dyad_uring *)ring, true, fd, (char *)buf, len, offset, cb, arg);
+}
+
+int dyad_uring_submit (dyad_uring_h ring)
+{
+    struct dyad_uring *r = (struct dyad_uring *)ring;
+    struct uring_op *op = NULL;
+    int ret = 0;
+    do {
+        ret = io_uring_submit (&r->ring);
+    } while (ret == -EINTR);
+    if (ret < 0) {
+        uring_fail_unsubmitted (r, -ret);
+        errno = -ret;
+        return -1;
+    }
+    // The kernel takes the entries in the order they were filled
+    while (ret-- > 0 && (op = r->prep_head) != NULL) {
+        r->prep_head = op->prep_next;
+        if (r->prep_head == NULL)
+            r->prep_tail = NULL;
+        op->sqe = NULL;
+    }
+    return 0;
+}
+
+int dyad_uring_complete (dyad_uring_h ring, bool wait)
+{
+    struct dyad_uring *r = (struct dyad_uring *)ring;
+    struct io_uring_cqe *cqe = NULL;
+    struct uring_op *op = NULL;
+    int count = 0;
+    int ret = 0;
+    int res = 0;
+
+    for (;;) {
+        ret = io_uring_peek_cqe (&r->ring, &cqe);
+        if (ret == -EAGAIN) {
+            if (!wait || count > 0 || r->inflight == 0u)
+                break;
+            // Resumed transfers are not in the kernel yet
+            if (io_uring_sq_ready (&r->ring) > 0u && dyad_uring_submit (r) < 0)
+                return -1;
+            ret = io_uring_wait_cqe (&r->ring, &cqe);
+        }
+        if (ret == -EINTR)
+            continue;
+        if (ret < 0) {
+            errno = -ret;
+            return -1;
+        }
+        op = (struct uring_op *)io_uring_cqe_get_data (cqe);
+        res = cqe->res;
+        io_uring_cqe_seen (&r->ring, cqe);
+        r->inflight--;
+        if (op->failed) {
+            // No-op left by uring_fail_unsubmitted
+            free (op);
+        } else if (res == -EINTR || res == -EAGAIN) {
+            uring_prep (r, op);
+        } else if (res > 0 && op->done + (size_t)res < op->len) {
+            op->done += (size_t)res;
+            uring_prep (r, op);
+        } else {
+            op->cb (op->arg, (res < 0) ? (ssize_t)res : (ssize_t)(op->done + (size_t)res));
+            free (op);
+            count++;
+        }
+        // Transfers that waited for an entry take the ones just freed
+        while (r->wait_head != NULL && r->inflight < r->depth) {
+            op = r->wait_head;
+            r->wait_head = op->next;
+            if (r->wait_head == NULL)
+                r->wait_tail = NULL;
+            r->waiting--;
+            uring_prep (r, op);
+            if (r->wait_tail == op)
+                break;
+        }
+    }
+    if (io_uring_sq_ready (&r->ring) > 0u && dyad_uring_submit (r) < 0)
+        return -1;
+    return count;
+}
+
+unsigned int dyad_uring_pending (dyad_uring_h ring)
+{
+    struct dyad_uring *r = (struct dyad_uring *)ring;
+    return r->inflight + r->waiting;
+}
+
+#else  // defined(DYAD_ENABLE_IO_URING)
+
+int dyad_uring_init (unsigned int depth, dyad_uring_h *ring)
+{
+    (void)depth;
+    *ring = NULL;
+    errno = ENOSYS;
+    return -1;
+}
+
+void dyad_uring_finalize (dyad_uring_h *ring)
+{
+    (void)ring;
+}
+
+int dyad_uring_event_fd (dyad_uring_h ring)
+{
+    (void)ring;
+    return -1;
+}
+
+int dyad_uring_read (dyad_uring_h ring,
+                     int fd,
+                     void *buf,
+                     size_t len,
+                     off_t offset,
+                     dyad_uring_cb cb,
+                     void *arg)
+{
+    (void)ring, (void)fd, (void)buf, (void)len, (void)offset, (void)cb, (void)arg;
+    errno = ENOSYS;
+    return -1;
+}
+
+int dyad_uring_write (dyad_uring_h ring,
+                      int fd,
+                      const void *buf,
+                      size_t len,
+                      off_t offset,
+                      dyad_uring_cb cb,
+                      void *arg)
+{
+    (void)ring, (void)fd, (void)buf, (void)len, (void)offset, (void)cb, (void)arg;
+    errno = ENOSYS;
+    return -1;
+}
+
+int dyad_uring_submit (dyad_uring_h ring)
+{
+    (void)ring;
+    errno = ENOSYS;
+    return -1;
+}
+
+int dyad_uring_complete (dyad_uring_h ring, bool wait)
+{
+    (void)ring, (void)wait;
+    errno = ENOSYS;
+    return -1;
+}
+
+unsigned int dyad_uring_pending (dyad_uring_h ring)
+{
+    (void)ring;
+    return 0u;
+}
+
+#endif  // defined(DYAD_ENABLE_IO_URING)
+
+/* Outcome of the segments of dyad_uring_pwrite_all */
+struct uring_batch {
+    unsigned int pending;
+    size_t written;
+    int errnum;
+};
+
+static void uring_batch_cb (void *arg, ssize_t result)
+{
+    struct uring_batch *batch = (struct uring_batch *)arg;
+    batch->pending--;
+    if (result < 0)
+        batch->errnum = (int)-result;
+    else
+        batch->written += (size_t)result;
+}
+
+static ssize_t uring_pwrite_segments (dyad_uring_h ring,
+                                      int fd,
+                                      const char *buf,
+                                      size_t len,
+                                      off_t offset)
+{
+    struct uring_batch batch = {0u, 0ul, 0};
+    size_t queued = 0ul;
+
+    while (queued < len && batch.errnum == 0) {
+        size_t seg = len - queued;
+        if (seg > DYAD_URING_SEGMENT_SIZE)
+            seg = DYAD_URING_SEGMENT_SIZE;
+        if (dyad_uring_write (ring, fd, buf + queued, seg, offset + queued, uring_batch_cb, &batch)
+            < 0) {
+            batch.errnum = errno;
+            break;
+        }
+        batch.pending++;
+        queued += seg;
+    }
+    if (dyad_uring_submit (ring) < 0 && batch.errnum == 0)
+        batch.errnum = errno;
+    // The segments already queued point into buf, so they must all be
+    // done before returning, even after a failure
+    while (batch.pending > 0u) {
+        if (dyad_uring_complete (ring, true) < 0) {
+            batch.errnum = errno;
+            break;
+        }
+    }
+    if (batch.errnum != 0) {
+        errno = batch.errnum;
+        return -1;
+    }
+    return (ssize_t)batch.written;
+}
+
+ssize_t dyad_uring_pwrite_all (dyad_uring_h ring,
+                               int fd,
+                               const void *buf,
+                               size_t len,
+                               off_t offset,
+                               bool direct)
+{
+    size_t body = 0ul;
+    ssize_t n = 0l;
+    int flags = 0;
+
+    if (ring == NULL || fd < 0 || (buf == NULL && len != 0ul)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (direct && dyad_uring_direct_aligned (buf, len, offset)
+        && (flags = fcntl (fd, F_GETFL)) >= 0 && fcntl (fd, F_SETFL, flags | O_DIRECT) == 0) {
+        body = len & ~(DYAD_URING_DIRECT_ALIGN - 1ul);
+        n = uring_pwrite_segments (ring, fd, buf, body, offset);
+        fcntl (fd, F_SETFL, flags);
+        // Some file systems refuse O_DIRECT, so write it all through the
+        // page cache instead
+        if (n != (ssize_t)body)
+            body = 0ul;
+    }
+    n = uring_pwrite_segments (ring, fd, (const char *)buf + body, len - body, offset + body);
+    if (n < 0)
+        return -1;
+    return (ssize_t)body + n;
+}
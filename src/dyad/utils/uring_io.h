@@ -0,0 +1,110 @@
+#ifndef DYAD_UTILS_URING_IO_H
+#define DYAD_UTILS_URING_IO_H
+
+#if defined(DYAD_HAS_CONFIG)
+#include <dyad/dyad_config.hpp>
+#else
+#error "no config"
+#endif
+
+#if defined(__cplusplus)
+#include <cstddef>
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#endif
+#include <sys/types.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif  // defined(__cplusplus)
+
+// Large transfers are split into pieces of this size, so that the kernel
+// can work on several of them at once
+#define DYAD_URING_SEGMENT_SIZE (4ul << 20)
+// Alignment of the buffer, offset and length of an O_DIRECT transfer
+#define DYAD_URING_DIRECT_ALIGN 4096ul
+
+typedef void *dyad_uring_h;
+
+/**
+ * Called once a queued transfer is complete. Short reads and writes are
+ * resumed by the ring itself, so result is the full length unless the
+ * end of the file was reached, or -errno on failure.
+ */
+typedef void (*dyad_uring_cb) (void *arg, ssize_t result);
+
+/**
+ * io_uring with room for depth transfers in flight. Transfers beyond that
+ * wait in the ring until an entry is free. Returns 0 on success, or -1
+ * with errno set to ENOSYS if DYAD was built without io_uring or the
+ * kernel does not allow it, in which case the caller uses POSIX I/O.
+ * A ring must only be used by one thread at a time.
+ */
+int dyad_uring_init (unsigned int depth, dyad_uring_h *ring);
+
+/* Wait for the transfers in flight, then release the ring */
+void dyad_uring_finalize (dyad_uring_h *ring);
+
+/* eventfd that becomes readable when transfers complete. Reading it is
+ * up to the caller. */
+int dyad_uring_event_fd (dyad_uring_h ring);
+
+/* Queue a read or a write of len bytes at offset of fd. Nothing is sent
+ * to the kernel until dyad_uring_submit. Returns 0 or -1 with errno set. */
+int dyad_uring_read (dyad_uring_h ring,
+                     int fd,
+                     void *buf,
+                     size_t len,
+                     off_t offset,
+                     dyad_uring_cb cb,
+                     void *arg);
+
+int dyad_uring_write (dyad_uring_h ring,
+                      int fd,
+                      const void *buf,
+                      size_t len,
+                      off_t offset,
+                      dyad_uring_cb cb,
+                      void *arg);
+
+/* Hand all queued transfers to the kernel with a single system call. If
+ * the kernel refuses them, returns -1 with errno set, after running the
+ * callbacks of all transfers not in the kernel yet with -errno. */
+int dyad_uring_submit (dyad_uring_h ring);
+
+/**
+ * Run the callbacks of the completed transfers. With wait, block until at
+ * least one transfer completes, unless none is in flight. Returns the
+ * number of callbacks run, or -1 with errno set.
+ */
+int dyad_uring_complete (dyad_uring_h ring, bool wait);
+
+/* Number of transfers queued or in flight */
+unsigned int dyad_uring_pending (dyad_uring_h ring);
+
+/**
+ * Write len bytes of buf at offset of fd, in segments that are all in
+ * flight at once, and wait for them. If direct is set and the transfer
+ * is aligned, the aligned part goes through O_DIRECT. Returns the number
+ * of bytes written, or -1 with errno set.
+ */
+ssize_t dyad_uring_pwrite_all (dyad_uring_h ring,
+                               int fd,
+                               const void *buf,
+                               size_t len,
+                               off_t offset,
+                               bool direct);
+
+/* Whether a transfer of len bytes at offset into buf can use O_DIRECT */
+static inline bool dyad_uring_direct_aligned (const void *buf, size_t len, off_t offset)
+{
+    return ((size_t)buf % DYAD_URING_DIRECT_ALIGN) == 0ul
+           && ((size_t)offset % DYAD_URING_DIRECT_ALIGN) == 0ul && len >= DYAD_URING_DIRECT_ALIGN;
+}
+
+#if defined(__cplusplus)
+};
+#endif  // defined(__cplusplus)
+
+#endif /* DYAD_UTILS_URING_IO_H */
@@ -0,0 +1,1336 @@
+#include <dyad/client/dyad_client_int.h>
+#include <dyad/common/dyad_rc.h>
+#include <dyad/core/dyad_ctx.h>
+#include <dyad/dtl/dyad_dtl_api.h>
+#include <dyad/utils/cons_cache.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Helpers
+ */
+// Byte at offset of the file_idx'th file of fetch_create_files, so that
+// consumers can check both the data and where it came from
+char fetch_pattern(size_t file_idx, size_t offset) {
+  return (char)('a' + (offset * 7 + file_idx) % 26);
+}
+
+bool fetch_check_data(const char *data, size_t len, size_t file_idx,
+                      size_t offset) {
+  for (size_t i = 0; i < len; ++i) {
+    if (data[i] != fetch_pattern(file_idx, offset + i)) return false;
+  }
+  return true;
+}
+
+// Name of the file_idx'th file produced by broker_idx, relative to the
+// managed directory
+std::string fetch_upath(uint32_t broker_idx, size_t file_idx) {
+  return args.filename + "_" + std::to_string(broker_idx) + "_" +
+         std::to_string(file_idx) + ".bat";
+}
+
+// Write the files of the brokers of this node into the managed directory
+int fetch_create_files(size_t file_size) {
+  size_t node_idx = info.rank / args.process_per_node;
+  bool first_rank_per_node = info.rank % args.process_per_node == 0;
+  if (first_rank_per_node) {
+    fs::create_directories(args.dyad_managed_dir);
+    std::string data(file_size, '\0');
+    for (size_t broker_idx = 0; broker_idx < args.brokers_per_node;
+         ++broker_idx) {
+      uint32_t global_broker_idx =
+          (uint32_t)(node_idx * args.brokers_per_node + broker_idx);
+      for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+        for (size_t i = 0; i < file_size; ++i)
+          data[i] = fetch_pattern(file_idx, i);
+        auto path = args.dyad_managed_dir.string() + "/" +
+                    fetch_upath(global_broker_idx, file_idx);
+        FILE *fp = fopen(path.c_str(), "w");
+        if (fp == NULL) return -1;
+        size_t written = fwrite(data.data(), 1, file_size, fp);
+        fclose(fp);
+        if (written != file_size) return -1;
+      }
+    }
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  return 0;
+}
+
+// Publish the files of fetch_create_files, so that consumers can look up
+// their owner
+int fetch_commit_files(dyad_ctx_t *ctx) {
+  size_t node_idx = info.rank / args.process_per_node;
+  bool first_rank_per_node = info.rank % args.process_per_node == 0;
+  if (first_rank_per_node) {
+    for (size_t broker_idx = 0; broker_idx < args.brokers_per_node;
+         ++broker_idx) {
+      uint32_t global_broker_idx =
+          (uint32_t)(node_idx * args.brokers_per_node + broker_idx);
+      for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+        auto path = args.dyad_managed_dir.string() + "/" +
+                    fetch_upath(global_broker_idx, file_idx);
+        if (DYAD_IS_ERROR(dyad_commit(ctx, path.c_str()))) return -1;
+      }
+    }
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  return 0;
+}
+
+// Whether the consumed file at path holds the file_size bytes of the
+// file_idx'th file
+bool fetch_check_file(const std::string &path, size_t file_idx,
+                      size_t file_size) {
+  std::string data(file_size + 1, '\0');
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  ssize_t bytes = read(fd, &data[0], file_size + 1);
+  close(fd);
+  return (size_t)bytes == file_size &&
+         fetch_check_data(data.data(), file_size, file_idx, 0);
+}
+
+// Whether addr lies in a mapping of the shared buffers of the SHM DTL
+bool fetch_in_shm_buffer(const void *addr) {
+  std::ifstream maps("/proc/self/maps");
+  std::string line;
+  uintptr_t p = (uintptr_t)addr;
+  while (std::getline(maps, line)) {
+    std::istringstream fields(line);
+    uintptr_t start = 0, end = 0;
+    char dash = '\0';
+    fields >> std::hex >> start >> dash >> end;
+    if (p >= start && p < end)
+      return line.find("memfd:dyad_shm") != std::string::npos;
+  }
+  return false;
+}
+
+// Consumed paths of the files of fetch_create_files produced by broker_idx
+std::vector<std::string> fetch_filenames(uint32_t broker_idx) {
+  std::vector<std::string> filenames;
+  for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+    filenames.push_back(args.dyad_managed_dir.string() + "/" +
+                        fetch_upath(broker_idx, file_idx));
+  }
+  return filenames;
+}
+
+// What every test case starts from: a clean managed directory holding the
+// files of fetch_create_files, unless file_size is 0, and a consumer
+// context initialized from the environment. Catch runs a test case once
+// per section, and so sets up and tears down one of these every time.
+struct FetchTest {
+  size_t file_size;
+  dyad_ctx_t *ctx = nullptr;
+  // The broker whose files this rank fetches
+  uint32_t neighbour_broker_idx = (info.broker_idx + 1) % info.broker_size;
+
+  explicit FetchTest(size_t size) : file_size(size) {
+    REQUIRE(pretest() == 0);
+    REQUIRE(clean_directories() == 0);
+    if (file_size > 0) REQUIRE(fetch_create_files(file_size) == 0);
+    REQUIRE(dyad_init_env(DYAD_COMM_RECV, info.flux_handle) >= 0);
+    ctx = dyad_ctx_get();
+    REQUIRE(ctx != nullptr);
+  }
+  ~FetchTest() {
+    CHECK(dyad_finalize() >= 0);
+    CHECK(clean_directories() == 0);
+    CHECK(posttest() == 0);
+  }
+};
+
+/**
+ * Test cases
+ */
+// clang-format off
+TEST_CASE("RemoteDataIOThreads", "[files= " + std::to_string(args.number_of_files) +"]"
+                                 "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                                 "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                                 "[module=dyad][option=io_threads]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should read every file in full while others are in flight") {
+    // All the ranks of a node fetch the same files at once, so the
+    // workers of the neighbour serve many requests concurrently
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      mdata.fpath = (char *)upath.c_str();
+      char *file_data = NULL;
+      size_t data_len = 0;
+      rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == file_size);
+      REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+      REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+    }
+  }
+  SECTION("should fail the request of a file a worker cannot open") {
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(DYAD_IS_ERROR(rc));
+    // The workers keep serving requests after a failed one
+    upath = fetch_upath(neighbour_broker_idx, 0);
+    mdata.fpath = (char *)upath.c_str();
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(fetch_check_data(file_data, data_len, 0, 0));
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  }
+}
+// clang-format off
+TEST_CASE("RemoteDataChunked", "[files= " + std::to_string(args.number_of_files) +"]"
+                               "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                               "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                               "[module=dyad][env=DYAD_DTL_CHUNK_SIZE]") {
+  // clang-format on
+  // Not a multiple of the chunk size, so the last chunk is a short one
+  FetchTest t(args.request_size * args.iteration + 123);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->dtl_chunk_size > 0);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should store every file in full from its chunks") {
+    std::string data(file_size + 1, '\0');
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      auto filename = args.dyad_managed_dir.string() + "/" + upath;
+      mdata.fpath = (char *)upath.c_str();
+      rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+      REQUIRE(rc >= 0);
+      int fd = open(filename.c_str(), O_RDONLY);
+      REQUIRE(fd != -1);
+      ssize_t bytes = read(fd, &data[0], file_size + 1);
+      close(fd);
+      REQUIRE((size_t)bytes == file_size);
+      REQUIRE(fetch_check_data(data.data(), file_size, file_idx, 0));
+    }
+  }
+  SECTION("should fail the stream of a missing file") {
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    auto filename = args.dyad_managed_dir.string() + "/" + upath;
+    mdata.fpath = (char *)upath.c_str();
+    rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+    REQUIRE(DYAD_IS_ERROR(rc));
+  }
+}
+// clang-format off
+TEST_CASE("RemoteDataZeroCopy", "[files= " + std::to_string(args.number_of_files) +"]"
+                                "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                                "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                                "[module=dyad][env=DYAD_DTL_ZERO_COPY]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->dtl_zero_copy);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should store every file straight from the received messages") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      auto filename = args.dyad_managed_dir.string() + "/" + upath;
+      mdata.fpath = (char *)upath.c_str();
+      rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filename, file_idx, file_size));
+    }
+  }
+  SECTION("should release the messages of a failed fetch") {
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    auto filename = args.dyad_managed_dir.string() + "/" + upath;
+    mdata.fpath = (char *)upath.c_str();
+    rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+    REQUIRE(DYAD_IS_ERROR(rc));
+    // The next fetch still gets its own data
+    upath = fetch_upath(neighbour_broker_idx, 0);
+    filename = args.dyad_managed_dir.string() + "/" + upath;
+    mdata.fpath = (char *)upath.c_str();
+    rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+    REQUIRE(rc >= 0);
+    REQUIRE(fetch_check_file(filename, 0, file_size));
+  }
+}
+// clang-format off
+TEST_CASE("RemoteMetadataBatch", "[number_of_lookups= " + std::to_string(args.number_of_files) +"]"
+                                 "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                                 "[method=dyad_get_metadata_batch]") {
+  // clang-format on
+  FetchTest t(0);
+  auto ctx = t.ctx;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  // Each rank looks up what the rank with the same index on the next node
+  // produced
+  int neighbour_rank =
+      (info.rank + (int)args.process_per_node) % info.comm_size;
+  auto md_upath = [](int rank, size_t file_idx) {
+    return args.filename + "_md_" + std::to_string(rank) + "_" +
+           std::to_string(file_idx) + ".bat";
+  };
+  for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+    auto filename =
+        args.dyad_managed_dir.string() + "/" + md_upath(info.rank, file_idx);
+    rc = dyad_commit(ctx, filename.c_str());
+    REQUIRE(rc >= 0);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  std::vector<std::string> upaths, filenames;
+  for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+    upaths.push_back(md_upath(neighbour_rank, file_idx));
+    filenames.push_back(args.dyad_managed_dir.string() + "/" + upaths.back());
+  }
+  SECTION("should return the owner of every file in order") {
+    std::vector<const char *> fnames;
+    for (auto &filename : filenames) fnames.push_back(filename.c_str());
+    std::vector<dyad_metadata_t *> mdata(fnames.size(), nullptr);
+    rc = dyad_get_metadata_batch(ctx, fnames.data(), fnames.size(), true,
+                                 mdata.data());
+    REQUIRE(rc >= 0);
+    for (size_t i = 0; i < mdata.size(); ++i) {
+      REQUIRE(mdata[i] != nullptr);
+      REQUIRE(mdata[i]->owner_rank == neighbour_broker_idx);
+      REQUIRE(upaths[i] == mdata[i]->fpath);
+      dyad_free_metadata(&mdata[i]);
+    }
+  }
+  SECTION("should leave out the files it cannot resolve") {
+    // Never produced, and outside of the managed directory
+    auto missing = args.dyad_managed_dir.string() + "/" +
+                   md_upath(neighbour_rank, args.number_of_files);
+    const char *fnames[] = {filenames[0].c_str(), missing.c_str(),
+                            "/dev/null", filenames.back().c_str()};
+    dyad_metadata_t *mdata[4] = {nullptr, nullptr, nullptr, nullptr};
+    rc = dyad_get_metadata_batch(ctx, fnames, 4, false, mdata);
+    REQUIRE(DYAD_IS_ERROR(rc));
+    REQUIRE(mdata[0] != nullptr);
+    REQUIRE(mdata[0]->owner_rank == neighbour_broker_idx);
+    REQUIRE(mdata[1] == nullptr);
+    REQUIRE(mdata[2] == nullptr);
+    REQUIRE(mdata[3] != nullptr);
+    REQUIRE(upaths.back() == mdata[3]->fpath);
+    dyad_free_metadata(&mdata[0]);
+    dyad_free_metadata(&mdata[3]);
+  }
+  SECTION("should do nothing for an empty batch") {
+    rc = dyad_get_metadata_batch(ctx, nullptr, 0, false, nullptr);
+    REQUIRE(rc == DYAD_RC_OK);
+  }
+}
+// clang-format off
+TEST_CASE("RemotePublishBatch", "[number_of_keys= " + std::to_string(args.number_of_files) +"]"
+                                "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                                "[env=DYAD_PUBLISH_BATCH][env=DYAD_PUBLISH_MAX_DELAY]") {
+  // clang-format on
+  FetchTest t(0);
+  auto ctx = t.ctx;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->publish_batch == args.number_of_files);
+  int neighbour_rank =
+      (info.rank + (int)args.process_per_node) % info.comm_size;
+  // The keys outlive the test case, so every section publishes its own
+  auto pub_path = [](const std::string &tag, int rank, size_t file_idx) {
+    return args.dyad_managed_dir.string() + "/" + args.filename + "_" + tag +
+           "_" + std::to_string(rank) + "_" + std::to_string(file_idx) +
+           ".bat";
+  };
+  auto commit = [&](const std::string &tag, size_t n) {
+    for (size_t file_idx = 0; file_idx < n; ++file_idx) {
+      auto path = pub_path(tag, info.rank, file_idx);
+      REQUIRE(dyad_commit(ctx, path.c_str()) >= 0);
+    }
+  };
+  auto check_published = [&](const std::string &tag, size_t n) {
+    for (size_t file_idx = 0; file_idx < n; ++file_idx) {
+      auto path = pub_path(tag, neighbour_rank, file_idx);
+      dyad_metadata_t *mdata = nullptr;
+      REQUIRE(dyad_get_metadata(ctx, path.c_str(), true, &mdata) >= 0);
+      REQUIRE(mdata != nullptr);
+      REQUIRE(mdata->owner_rank == neighbour_broker_idx);
+      dyad_free_metadata(&mdata);
+    }
+  };
+  auto check_unpublished = [&](const std::string &tag) {
+    auto path = pub_path(tag, neighbour_rank, 0);
+    dyad_metadata_t *mdata = nullptr;
+    REQUIRE(DYAD_IS_ERROR(dyad_get_metadata(ctx, path.c_str(), false, &mdata)));
+  };
+  if (ctx->publish_max_delay > 0.0) {
+    SECTION("should publish a batch that stops growing after its delay") {
+      commit("delay", args.number_of_files - 1);
+      // Waiting for the keys, which no one flushes
+      check_published("delay", args.number_of_files - 1);
+      MPI_Barrier(MPI_COMM_WORLD);
+    }
+  } else {
+    SECTION("should publish a batch once it is full") {
+      commit("full", args.number_of_files - 1);
+      MPI_Barrier(MPI_COMM_WORLD);
+      check_unpublished("full");
+      MPI_Barrier(MPI_COMM_WORLD);
+      auto path = pub_path("full", info.rank, args.number_of_files - 1);
+      REQUIRE(dyad_commit(ctx, path.c_str()) >= 0);
+      check_published("full", args.number_of_files);
+      MPI_Barrier(MPI_COMM_WORLD);
+    }
+    SECTION("should publish a partial batch once it is flushed") {
+      commit("flush", args.number_of_files / 2);
+      MPI_Barrier(MPI_COMM_WORLD);
+      check_unpublished("flush");
+      MPI_Barrier(MPI_COMM_WORLD);
+      rc = dyad_flush_publish(ctx);
+      REQUIRE(rc >= 0);
+      check_published("flush", args.number_of_files / 2);
+      MPI_Barrier(MPI_COMM_WORLD);
+    }
+    SECTION("should do nothing when no key is batched") {
+      rc = dyad_flush_publish(ctx);
+      REQUIRE(rc == DYAD_RC_OK);
+    }
+  }
+}
+// clang-format off
+TEST_CASE("RemotePrefetch", "[files= " + std::to_string(args.number_of_files) +"]"
+                            "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                            "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                            "[method=dyad_prefetch]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(fetch_commit_files(ctx) == 0);
+  auto filenames = fetch_filenames(neighbour_broker_idx);
+  std::vector<const char *> fnames;
+  for (auto &filename : filenames) fnames.push_back(filename.c_str());
+  SECTION("should fetch the queued files in the background") {
+    rc = dyad_prefetch_list(ctx, fnames.data(), fnames.size());
+    REQUIRE(rc >= 0);
+    rc = dyad_prefetch_wait(ctx);
+    REQUIRE(rc >= 0);
+    // Complete without consuming them again
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+    }
+  }
+  SECTION("should hand the queued files over to dyad_consume") {
+    rc = dyad_prefetch_list(ctx, fnames.data(), fnames.size());
+    REQUIRE(rc >= 0);
+    // The last files are likely still queued, the first one in flight
+    for (size_t i = filenames.size(); i > 0; --i) {
+      rc = dyad_consume(ctx, fnames[i - 1]);
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filenames[i - 1], i - 1, file_size));
+    }
+    rc = dyad_prefetch_wait(ctx);
+    REQUIRE(rc >= 0);
+  }
+  SECTION("should drop the queued files when finalized") {
+    rc = dyad_prefetch_list(ctx, fnames.data(), fnames.size());
+    REQUIRE(rc >= 0);
+  }
+  SECTION("should refuse an empty file name") {
+    rc = dyad_prefetch(ctx, "");
+    REQUIRE(DYAD_IS_ERROR(rc));
+    // Nothing was queued
+    rc = dyad_prefetch_wait(ctx);
+    REQUIRE(rc >= 0);
+  }
+}
+// clang-format off
+TEST_CASE("RemoteNodeDedup", "[files= " + std::to_string(args.number_of_files) +"]"
+                             "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                             "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                             "[module=dyad][env=DYAD_NODE_DEDUP]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->node_dedup);
+  REQUIRE(fetch_commit_files(ctx) == 0);
+  auto filenames = fetch_filenames(neighbour_broker_idx);
+  SECTION("should store every file fetched once for the node") {
+    // All the ranks of a node consume the same files at once
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      rc = dyad_consume(ctx, filenames[file_idx].c_str());
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+    }
+    // The module of the broker coordinated the fetches
+    REQUIRE(ctx->node_dedup);
+  }
+  SECTION("should hand a failed fetch over to the next consumer") {
+    // Published, but gone from the producer by the time it is fetched
+    if (info.rank % args.process_per_node == 0) {
+      auto path = args.dyad_managed_dir.string() + "/" +
+                  fetch_upath(info.broker_idx, args.number_of_files);
+      REQUIRE(dyad_commit(ctx, path.c_str()) >= 0);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto missing = args.dyad_managed_dir.string() + "/" +
+                   fetch_upath(neighbour_broker_idx, args.number_of_files);
+    // Every consumer of the node tries in turn instead of waiting forever
+    rc = dyad_consume(ctx, missing.c_str());
+    REQUIRE(DYAD_IS_ERROR(rc));
+    rc = dyad_consume(ctx, filenames[0].c_str());
+    REQUIRE(rc >= 0);
+    REQUIRE(fetch_check_file(filenames[0], 0, file_size));
+  }
+}
+// clang-format off
+TEST_CASE("RemoteConsCache", "[files= " + std::to_string(args.number_of_files) +"]"
+                             "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                             "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                             "[env=DYAD_CONS_CACHE_BYTES]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->cons_cache != nullptr);
+  size_t capacity = strtoull(getenv("DYAD_CONS_CACHE_BYTES"), NULL, 10);
+  size_t cached_files = capacity / file_size;
+  REQUIRE(cached_files > 1);
+  REQUIRE(cached_files < args.number_of_files);
+  auto filenames = fetch_filenames(neighbour_broker_idx);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  auto consume = [&](size_t file_idx) {
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    mdata.fpath = (char *)upath.c_str();
+    rc = dyad_consume_w_metadata(ctx, filenames[file_idx].c_str(), &mdata);
+    REQUIRE(rc >= 0);
+    REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+  };
+  SECTION("should keep the fetched files within its budget") {
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      consume(file_idx);
+      REQUIRE(dyad_cons_cache_used(ctx->cons_cache) <= capacity);
+    }
+    // Only the most recently fetched files are left
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      bool kept = file_idx >= filenames.size() - cached_files;
+      REQUIRE((access(filenames[file_idx].c_str(), F_OK) == 0) == kept);
+    }
+  }
+  SECTION("should evict the least recently used file first") {
+    for (size_t file_idx = 0; file_idx < cached_files; ++file_idx) {
+      consume(file_idx);
+    }
+    // Consumed again from the managed directory, which makes the second
+    // file the least recently used one
+    consume(0);
+    consume(cached_files);
+    REQUIRE(access(filenames[0].c_str(), F_OK) == 0);
+    REQUIRE(access(filenames[1].c_str(), F_OK) != 0);
+    // An evicted file is fetched again
+    consume(1);
+  }
+}
+// clang-format off
+TEST_CASE("RemoteUcxEpCache", "[files= " + std::to_string(args.number_of_files) +"]"
+                              "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                              "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                              "[module=dyad][option=ep_cache_size][option=ep_cache_ttl]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  auto get_data = [&](size_t file_idx) {
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  };
+  SECTION("should serve more consumers than it keeps endpoints for") {
+    // The producer replaces the endpoints of the ranks of a node with each
+    // other's all along
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      get_data(file_idx);
+    }
+  }
+  SECTION("should reconnect the endpoints that expired") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      get_data(file_idx);
+      // Longer than the TTL the module was loaded with
+      if (file_idx % 4 == 3) usleep(600000);
+    }
+  }
+}
+// clang-format off
+TEST_CASE("RemoteUcxReconnect", "[files= " + std::to_string(args.number_of_files) +"]"
+                                "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                                "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                                "[module=dyad][rc=DYAD_RC_NOCONN]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  size_t local_rank = (size_t)info.rank % args.process_per_node;
+  SECTION("should resend a request the producer lost the connection of") {
+    // The ranks of a node take turns, so that each of them connects to
+    // the producer, is evicted from its endpoint cache by the next one,
+    // and then comes back with a request that only names its connection
+    for (size_t round = 0; round < 3; ++round) {
+      for (size_t turn = 0; turn < args.process_per_node; ++turn) {
+        if (turn == local_rank) {
+          size_t file_idx = (round * args.process_per_node + turn) %
+                            args.number_of_files;
+          auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+          mdata.fpath = (char *)upath.c_str();
+          char *file_data = NULL;
+          size_t data_len = 0;
+          rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+          REQUIRE(rc >= 0);
+          REQUIRE(data_len == file_size);
+          REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+          REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+      }
+    }
+  }
+}
+// clang-format off
+TEST_CASE("RemoteUcxStaging", "[files= " + std::to_string(args.number_of_files) +"]"
+                              "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                              "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                              "[module=dyad][option=staging_bufs]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  auto get_data = [&](size_t file_idx) {
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  };
+  SECTION("should send every file from the staging buffers") {
+    // More requests in flight at the producer than it has buffers
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      get_data(file_idx);
+    }
+  }
+  SECTION("should return the buffer of a file it cannot read") {
+    // More failures than the producer has buffers, each of which would
+    // otherwise keep one of them
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    for (size_t i = 0; i < args.number_of_files; ++i) {
+      mdata.fpath = (char *)upath.c_str();
+      char *file_data = NULL;
+      size_t data_len = 0;
+      rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+      REQUIRE(DYAD_IS_ERROR(rc));
+    }
+    get_data(0);
+  }
+}
+// clang-format off
+TEST_CASE("RemoteUcxSpin", "[files= " + std::to_string(args.number_of_files) +"]"
+                           "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                           "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                           "[env=DYAD_UCX_SPIN_COUNT]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should receive every file however long it spins first") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      mdata.fpath = (char *)upath.c_str();
+      char *file_data = NULL;
+      size_t data_len = 0;
+      rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == file_size);
+      REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+      REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+    }
+  }
+  SECTION("should stop waiting for a file the producer failed to send") {
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(DYAD_IS_ERROR(rc));
+  }
+}
+// clang-format off
+TEST_CASE("RemoteUcxRmaSlots", "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                               "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                               "[env=DYAD_UCX_RMA_SLOTS][env=DYAD_UCX_RMA_SLOT_SIZE]") {
+  // clang-format on
+  // Spans many slots, and ends with a short piece
+  FetchTest t(args.request_size * args.iteration + 123);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  size_t slot_size = ctx->dtl_handle->max_transfer_size;
+  REQUIRE(slot_size > 0);
+  REQUIRE(slot_size < file_size);
+  REQUIRE(ctx->dtl_handle->max_inflight > 1);
+  size_t file_idx = (size_t)info.rank % args.number_of_files;
+  auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  mdata.fpath = (char *)upath.c_str();
+  char *file_data = NULL;
+  size_t data_len = 0;
+  SECTION("should fetch a file larger than a slot in pieces") {
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+  }
+  SECTION("should fetch a range across slots") {
+    off_t offset = (off_t)(slot_size / 2);
+    size_t length = 3 * slot_size;
+    rc = dyad_get_data_range(ctx, &mdata, offset, length, &file_data,
+                             &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == length);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, (size_t)offset));
+  }
+  SECTION("should reuse the slots of returned data") {
+    for (size_t i = 0; i < 2 * ctx->dtl_handle->max_inflight; ++i) {
+      rc = dyad_get_data_range(ctx, &mdata, 0, slot_size, &file_data,
+                               &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == slot_size);
+      REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+      REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+    }
+  }
+  if (file_data != NULL) REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+}
+// clang-format off
+TEST_CASE("RemoteMargoBulk", "[files= " + std::to_string(args.number_of_files) +"]"
+                             "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                             "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                             "[env=DYAD_MARGO_BULK_REGIONS][env=DYAD_MARGO_REGION_MAX]"
+                             "[env=DYAD_MARGO_PULL_SEGMENT][env=DYAD_MARGO_PULL_DEPTH]") {
+  // clang-format on
+  // Not a multiple of the pull segment, so the last pull is a short one
+  FetchTest t(args.request_size * args.iteration + 123);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  auto get_data = [&](size_t file_idx) {
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  };
+  SECTION("should pull every file into reused bulk regions") {
+    // Many more transfers than there are regions
+    for (size_t round = 0; round < 2; ++round) {
+      for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+        get_data(file_idx);
+      }
+    }
+  }
+  SECTION("should keep the data of a file while pulling the next one") {
+    std::vector<char *> file_data(args.number_of_files, nullptr);
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      mdata.fpath = (char *)upath.c_str();
+      size_t data_len = 0;
+      rc = dyad_get_data(ctx, &mdata, &file_data[file_idx], &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == file_size);
+    }
+    // Every region is held, so the later files got one-off buffers
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      REQUIRE(fetch_check_data(file_data[file_idx], file_size, file_idx, 0));
+      REQUIRE(dyad_release_data(ctx, &file_data[file_idx]) >= 0);
+    }
+  }
+  SECTION("should release the region of a failed transfer") {
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    for (size_t i = 0; i < args.number_of_files; ++i) {
+      mdata.fpath = (char *)upath.c_str();
+      char *file_data = NULL;
+      size_t data_len = 0;
+      rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+      REQUIRE(DYAD_IS_ERROR(rc));
+    }
+    get_data(0);
+  }
+}
+// clang-format off
+TEST_CASE("RemoteMargoProtocol", "[files= " + std::to_string(args.number_of_files) +"]"
+                                 "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                                 "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                                 "[module=dyad][option=na_protocol][env=DYAD_MARGO_PROTOCOL]"
+                                 "[env=DYAD_MARGO_PROGRESS_THREAD][env=DYAD_MARGO_RPC_THREADS]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->dtl_handle->mode == DYAD_DTL_MARGO);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should transfer every file over the selected transport") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      auto filename = args.dyad_managed_dir.string() + "/" + upath;
+      mdata.fpath = (char *)upath.c_str();
+      rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filename, file_idx, file_size));
+    }
+  }
+}
+// clang-format off
+TEST_CASE("RemoteDataShm", "[files= " + std::to_string(args.number_of_files) +"]"
+                           "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                           "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                           "[module=dyad][mode=SHM]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->dtl_handle->mode == DYAD_DTL_SHM);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should map the data of a broker on the same node") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      mdata.fpath = (char *)upath.c_str();
+      char *file_data = NULL;
+      size_t data_len = 0;
+      rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == file_size);
+      // Handed over by the producer, not copied through a Flux RPC
+      REQUIRE(fetch_in_shm_buffer(file_data));
+      REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+      REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+    }
+  }
+  SECTION("should fail the request of a missing file") {
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(DYAD_IS_ERROR(rc));
+    // A message of the failed request must not be taken for the next one
+    upath = fetch_upath(neighbour_broker_idx, 0);
+    mdata.fpath = (char *)upath.c_str();
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(fetch_in_shm_buffer(file_data));
+    REQUIRE(fetch_check_data(file_data, data_len, 0, 0));
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  }
+}
+// clang-format off
+TEST_CASE("RemoteDataCopy", "[files= " + std::to_string(args.number_of_files) +"]"
+                            "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                            "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                            "[module=dyad][env=DYAD_POSIX_IO]") {
+  // clang-format on
+  // Not a multiple of the page size
+  FetchTest t(args.request_size * args.iteration + 123);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  // Stored apart from the files of the producers on the same node
+  fs::path cons_dir = ctx->cons_managed_path;
+  REQUIRE(cons_dir != args.dyad_managed_dir);
+  fs::create_directories(cons_dir);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should store every file with or without the kernel copying it") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      auto filename = cons_dir.string() + "/" + upath;
+      mdata.fpath = (char *)upath.c_str();
+      rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filename, file_idx, file_size));
+    }
+  }
+  SECTION("should store an empty file") {
+    auto upath = fetch_upath(info.broker_idx, args.number_of_files);
+    if (info.rank % args.process_per_node == 0) {
+      auto path = args.dyad_managed_dir.string() + "/" + upath;
+      FILE *fp = fopen(path.c_str(), "w");
+      REQUIRE(fp != NULL);
+      fclose(fp);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    auto filename = cons_dir.string() + "/" + upath;
+    mdata.fpath = (char *)upath.c_str();
+    rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+    REQUIRE(rc >= 0);
+    REQUIRE(fetch_check_file(filename, 0, 0));
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  if (info.rank % args.process_per_node == 0) fs::remove_all(cons_dir);
+}
+// clang-format off
+TEST_CASE("RemoteDataUring", "[files= " + std::to_string(args.number_of_files) +"]"
+                             "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                             "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                             "[module=dyad][option=uring_depth][env=DYAD_URING_DEPTH]"
+                             "[env=DYAD_URING_DIRECT_MIN]") {
+  // clang-format on
+  // Not a multiple of the block size, so O_DIRECT cannot move all of it
+  FetchTest t(args.request_size * args.iteration + 123);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->uring != nullptr);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should store every file read and written through io_uring") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      auto filename = args.dyad_managed_dir.string() + "/" + upath;
+      mdata.fpath = (char *)upath.c_str();
+      rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filename, file_idx, file_size));
+    }
+  }
+  SECTION("should read only the requested range through io_uring") {
+    size_t file_idx = (size_t)info.rank % args.number_of_files;
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    off_t offset = (off_t)(file_size / 3);
+    rc = dyad_get_data_range(ctx, &mdata, offset, 4097, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == 4097);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, (size_t)offset));
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  }
+  SECTION("should fail the queued read of a missing file") {
+    auto upath = fetch_upath(neighbour_broker_idx, args.number_of_files);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(DYAD_IS_ERROR(rc));
+  }
+}
+// clang-format off
+TEST_CASE("RemoteInlineData", "[files= " + std::to_string(args.number_of_files) +"]"
+                              "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                              "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                              "[env=DYAD_INLINE_MAX]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->inline_max > 0);
+  bool inlined = file_size <= ctx->inline_max;
+  REQUIRE(fetch_commit_files(ctx) == 0);
+  auto filenames = fetch_filenames(neighbour_broker_idx);
+  SECTION("should publish the data of the small files only") {
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      dyad_metadata_t *mdata = nullptr;
+      rc = dyad_get_metadata(ctx, filenames[file_idx].c_str(), true, &mdata);
+      REQUIRE(rc >= 0);
+      REQUIRE(mdata != nullptr);
+      REQUIRE(mdata->owner_rank == neighbour_broker_idx);
+      REQUIRE((mdata->inline_data != nullptr) == inlined);
+      if (inlined) {
+        REQUIRE(mdata->inline_len == file_size);
+        REQUIRE(fetch_check_data(mdata->inline_data, mdata->inline_len,
+                                 file_idx, 0));
+      }
+      dyad_free_metadata(&mdata);
+    }
+  }
+  SECTION("should store the small files without asking their producer") {
+    if (inlined) {
+      // Only their KVS entries are left to fetch them from
+      if (info.rank % args.process_per_node == 0) {
+        for (auto &filename : fetch_filenames(info.broker_idx))
+          REQUIRE(unlink(filename.c_str()) == 0);
+      }
+      MPI_Barrier(MPI_COMM_WORLD);
+    }
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      rc = dyad_consume(ctx, filenames[file_idx].c_str());
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+    }
+  }
+}
+// clang-format off
+TEST_CASE("RemoteHybridRoute", "[files= " + std::to_string(args.number_of_files) +"]"
+                               "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                               "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                               "[env=DYAD_DTL_RPC_MAX]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  bool calibrate = std::string(getenv("DYAD_DTL_RPC_MAX")) == "auto";
+  REQUIRE(ctx->dtl_rpc_calibrate == calibrate);
+  REQUIRE(ctx->dtl_rpc_max > 0);
+  REQUIRE(ctx->dtl_rpc_max < file_size);
+  size_t file_idx = (size_t)info.rank % args.number_of_files;
+  auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  mdata.fpath = (char *)upath.c_str();
+  char *file_data = NULL;
+  size_t data_len = 0;
+  SECTION("should fetch a file too large for the RPC stream with the DTL") {
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+  }
+  SECTION("should fetch ranges on either side of the crossover") {
+    size_t lengths[] = {1, ctx->dtl_rpc_max, ctx->dtl_rpc_max + 1};
+    for (size_t length : lengths) {
+      off_t offset = (off_t)(file_size - length) / 2;
+      rc = dyad_get_data_range(ctx, &mdata, offset, length, &file_data,
+                               &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == length);
+      REQUIRE(fetch_check_data(file_data, data_len, file_idx, (size_t)offset));
+      REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+    }
+  }
+  if (calibrate) {
+    SECTION("should measure the crossover on the first file it stores") {
+      auto filename = args.dyad_managed_dir.string() + "/" + upath;
+      rc = dyad_consume_w_metadata(ctx, filename.c_str(), &mdata);
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filename, file_idx, file_size));
+      REQUIRE_FALSE(ctx->dtl_rpc_calibrate);
+      // Up to the largest probe, or 0 if the DTL always wins
+      REQUIRE(ctx->dtl_rpc_max <= (1ul << 20));
+    }
+  }
+  if (file_data != NULL) REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+}
+// clang-format off
+TEST_CASE("RemoteSegmentData", "[files= " + std::to_string(args.number_of_files) +"]"
+                               "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                               "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                               "[module=dyad][option=segment_max][env=DYAD_SEGMENT_MAX]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->segment_max > 0);
+  bool packed = file_size <= ctx->segment_max;
+  size_t node_idx = info.rank / args.process_per_node;
+  bool first_rank_per_node = info.rank % args.process_per_node == 0;
+  REQUIRE(fetch_commit_files(ctx) == 0);
+  if (first_rank_per_node) {
+    for (size_t broker_idx = 0; broker_idx < args.brokers_per_node;
+         ++broker_idx) {
+      uint32_t global_broker_idx =
+          (uint32_t)(node_idx * args.brokers_per_node + broker_idx);
+      // An empty file, published after the others
+      auto empty_path = args.dyad_managed_dir.string() + "/" +
+                        fetch_upath(global_broker_idx, args.number_of_files);
+      FILE *fp = fopen(empty_path.c_str(), "w");
+      REQUIRE(fp != NULL);
+      fclose(fp);
+      REQUIRE(dyad_commit(ctx, empty_path.c_str()) >= 0);
+      // Only their copies in the segments are left to serve packed files from
+      if (packed) {
+        for (auto &filename : fetch_filenames(global_broker_idx))
+          REQUIRE(unlink(filename.c_str()) == 0);
+        REQUIRE(unlink(empty_path.c_str()) == 0);
+      }
+    }
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  auto filenames = fetch_filenames(neighbour_broker_idx);
+  SECTION("should store the files packed by their producer") {
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      rc = dyad_consume(ctx, filenames[file_idx].c_str());
+      REQUIRE(rc >= 0);
+      REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+    }
+  }
+  SECTION("should store a packed empty file") {
+    auto filename = args.dyad_managed_dir.string() + "/" +
+                    fetch_upath(neighbour_broker_idx, args.number_of_files);
+    rc = dyad_consume(ctx, filename.c_str());
+    REQUIRE(rc >= 0);
+    REQUIRE(fetch_check_file(filename, 0, 0));
+  }
+  SECTION("should read a range of a packed file") {
+    size_t file_idx = (size_t)info.rank % args.number_of_files;
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    dyad_metadata_t mdata = {};
+    mdata.owner_rank = neighbour_broker_idx;
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data_range(ctx, &mdata, 100, 1000, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == 1000);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, 100));
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  }
+}
+// clang-format off
+TEST_CASE("RemoteCompressedData", "[files= " + std::to_string(args.number_of_files) +"]"
+                                  "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                                  "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                                  "[module=dyad][option=compress_level][env=DYAD_COMPRESS_LEVEL]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(ctx->compress_level != 0);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  SECTION("should read every file compressed by the module") {
+    for (size_t file_idx = 0; file_idx < args.number_of_files; ++file_idx) {
+      auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+      mdata.fpath = (char *)upath.c_str();
+      char *file_data = NULL;
+      size_t data_len = 0;
+      rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == file_size);
+      REQUIRE(fetch_check_data(file_data, data_len, file_idx, 0));
+      REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+    }
+  }
+  SECTION("should read ranges too short or too long to compress") {
+    size_t file_idx = (size_t)info.rank % args.number_of_files;
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    mdata.fpath = (char *)upath.c_str();
+    for (size_t length : {(size_t)1, (size_t)100, file_size / 2}) {
+      char *file_data = NULL;
+      size_t data_len = 0;
+      rc = dyad_get_data_range(ctx, &mdata, 1, length, &file_data, &data_len);
+      REQUIRE(rc >= 0);
+      REQUIRE(data_len == length);
+      REQUIRE(fetch_check_data(file_data, data_len, file_idx, 1));
+      REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+    }
+  }
+  SECTION("should read a file that does not compress") {
+    // The module sends it raw rather than in a frame larger than the data
+    size_t file_idx = args.number_of_files + 1;
+    std::string data(file_size, '\0');
+    std::minstd_rand gen(file_size);
+    for (auto &c : data) c = (char)(gen() & 0xff);
+    if (info.rank % args.process_per_node == 0) {
+      auto path = args.dyad_managed_dir.string() + "/" +
+                  fetch_upath(info.broker_idx, file_idx);
+      FILE *fp = fopen(path.c_str(), "w");
+      REQUIRE(fp != NULL);
+      REQUIRE(fwrite(data.data(), 1, file_size, fp) == file_size);
+      fclose(fp);
+      REQUIRE(dyad_commit(ctx, path.c_str()) >= 0);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+    mdata.fpath = (char *)upath.c_str();
+    char *file_data = NULL;
+    size_t data_len = 0;
+    rc = dyad_get_data(ctx, &mdata, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size);
+    REQUIRE(memcmp(file_data, data.data(), file_size) == 0);
+    REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+  }
+  SECTION("should store files fetched compressed in one request") {
+    REQUIRE(fetch_commit_files(ctx) == 0);
+    auto filenames = fetch_filenames(neighbour_broker_idx);
+    std::vector<const char *> fnames;
+    for (auto &filename : filenames) fnames.push_back(filename.c_str());
+    rc = dyad_consume_many(ctx, fnames.data(), fnames.size());
+    REQUIRE(rc >= 0);
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+    }
+  }
+}
+// clang-format off
+TEST_CASE("RemoteDataRange", "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                             "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                             "[method=dyad_get_data_range]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  size_t file_idx = (size_t)info.rank % args.number_of_files;
+  auto upath = fetch_upath(neighbour_broker_idx, file_idx);
+  dyad_metadata_t mdata = {};
+  mdata.owner_rank = neighbour_broker_idx;
+  mdata.fpath = (char *)upath.c_str();
+  char *file_data = NULL;
+  size_t data_len = 0;
+  SECTION("should read only the requested range") {
+    off_t offset = (off_t)(file_size / 3);
+    rc = dyad_get_data_range(ctx, &mdata, offset, 4097, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == 4097);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, (size_t)offset));
+  }
+  SECTION("should read up to the end of the file with a length of 0") {
+    rc = dyad_get_data_range(ctx, &mdata, 100, 0, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == file_size - 100);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, 100));
+  }
+  SECTION("should cut a range at the end of the file") {
+    off_t offset = (off_t)(file_size - 10);
+    rc = dyad_get_data_range(ctx, &mdata, offset, 100, &file_data, &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == 10);
+    REQUIRE(fetch_check_data(file_data, data_len, file_idx, (size_t)offset));
+  }
+  SECTION("should read nothing at the end of the file") {
+    rc = dyad_get_data_range(ctx, &mdata, (off_t)file_size, 0, &file_data,
+                             &data_len);
+    REQUIRE(rc >= 0);
+    REQUIRE(data_len == 0);
+  }
+  SECTION("should refuse a range past the end of the file") {
+    rc = dyad_get_data_range(ctx, &mdata, (off_t)file_size + 1, 10,
+                             &file_data, &data_len);
+    REQUIRE(DYAD_IS_ERROR(rc));
+  }
+  if (file_data != NULL) REQUIRE(dyad_release_data(ctx, &file_data) >= 0);
+}
+// clang-format off
+TEST_CASE("RemoteConsumeMany", "[files= " + std::to_string(args.number_of_files) +"]"
+                               "[file_size= " + std::to_string(args.request_size*args.iteration) +"]"
+                               "[parallel_req= " + std::to_string(info.comm_size) +"]"
+                               "[method=dyad_consume_many]") {
+  // clang-format on
+  FetchTest t(args.request_size * args.iteration);
+  auto ctx = t.ctx;
+  auto file_size = t.file_size;
+  auto neighbour_broker_idx = t.neighbour_broker_idx;
+  dyad_rc_t rc = DYAD_RC_OK;
+  REQUIRE(fetch_commit_files(ctx) == 0);
+  auto filenames = fetch_filenames(neighbour_broker_idx);
+  std::vector<const char *> fnames;
+  for (auto &filename : filenames) fnames.push_back(filename.c_str());
+  SECTION("should store every file of the batch") {
+    rc = dyad_consume_many(ctx, fnames.data(), fnames.size());
+    REQUIRE(rc >= 0);
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+    }
+  }
+  SECTION("should store the other files when one of them fails") {
+    // Published, but gone from the producer by the time it is fetched
+    if (info.rank % args.process_per_node == 0) {
+      auto path = args.dyad_managed_dir.string() + "/" +
+                  fetch_upath(info.broker_idx, args.number_of_files);
+      REQUIRE(dyad_commit(ctx, path.c_str()) >= 0);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto missing = args.dyad_managed_dir.string() + "/" +
+                   fetch_upath(neighbour_broker_idx, args.number_of_files);
+    fnames.insert(fnames.begin() + fnames.size() / 2, missing.c_str());
+    rc = dyad_consume_many(ctx, fnames.data(), fnames.size());
+    REQUIRE(DYAD_IS_ERROR(rc));
+    for (size_t file_idx = 0; file_idx < filenames.size(); ++file_idx) {
+      REQUIRE(fetch_check_file(filenames[file_idx], file_idx, file_size));
+    }
+  }
+  SECTION("should do nothing for an empty batch") {
+    rc = dyad_consume_many(ctx, fnames.data(), 0);
+    REQUIRE(rc == DYAD_RC_OK);
+  }
+}
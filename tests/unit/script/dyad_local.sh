@@ -0,0 +1,11 @@
+# Run the arguments in a Flux instance of DYAD_LOCAL_BROKERS brokers on
+# this node, each with the DYAD module loaded
+if [ -z "${DYAD_LOCAL_INSTANCE}" ]; then
+    DYAD_LOCAL_INSTANCE=1 exec flux start --test-size=${DYAD_LOCAL_BROKERS} $0 "$@"
+fi
+flux kvs namespace create ${DYAD_KVS_NAMESPACE}
+flux exec -r all flux module load ${DYAD_MODULE_SO} --info_log=${DYAD_LOG_DIR}/dyad-local-broker --error_log=${DYAD_LOG_DIR}/dyad-local-broker --mode=${DYAD_DTL_MODE} $DYAD_PATH
+"$@"
+rc=$?
+flux exec -r all flux module unload dyad
+exit $rc
@@ -0,0 +1 @@
+flux exec -r all flux module reload ${DYAD_MODULE_SO} --info_log=${DYAD_LOG_DIR}/dyad-broker --error_log=${DYAD_LOG_DIR}/dyad-broker --mode=${DYAD_DTL_MODE} "$@" $DYAD_PATH
\ No newline at end of file
@@ -164,4 +164,5 @@ int clean_directories() {
 }
 #include "data_plane/data_plane.cpp"
 #include "dyad_core/core_functions.cpp"
+#include "fetch/fetch.cpp"
 #include "mdm/mdm.cpp"